@@ -18,15 +18,37 @@
 #include "time_utils.h"
 #include "schedule.h"
 #include "custom_rules.h"
+#include "tz_rules.h"
+#include "sun_times.h"
+#include "exceptions.h"
+#include "stats.h"
+#include "program_table.h"
+#include "sensors.h"
+#include "mqtt.h"
+#include "webhooks.h"
+#include "clock_sync.h"
+#include "discovery.h"
+#include "modbus.h"
+#include "hal.h"
+#include "logbuf.h"
+#include "tasks.h"
+#include "metrics.h"
+#include "button.h"
+#include "controller.h"
+#include "status_led.h"
+#include "output.h"
+#include "engine.h"
+#include "simulator.h"
 #include "webserver.h"
 
 // ===== Defaults por plataforma =====
+// Pino padrão de cada canal (-1 = não atribuído até ser configurado)
 #if defined(SONOFF_BASIC)
-static constexpr int defaultFeederPin = 12;
+static constexpr int defaultFeederPins[MAX_CHANNELS] = { 12 };
 #elif defined(ESP8266)
-static constexpr int defaultFeederPin = 14;  // D5 no NodeMCU
+static constexpr int defaultFeederPins[MAX_CHANNELS] = { 14, 12, 13, 4 };  // D5, D6, D7, D2
 #else
-static constexpr int defaultFeederPin = 5;
+static constexpr int defaultFeederPins[MAX_CHANNELS] = { 5, 18, 19, 21, 22, 23, 25, 26 };
 #endif
 
 #if defined(SONOFF_BASIC)
@@ -40,26 +62,24 @@ static constexpr int STATUS_LED_PIN = 2;
 static constexpr int BUTTON_PIN     = -1;
 #endif
 
-static constexpr char NTP_SERVER[] = "time.google.com";
+static constexpr char   NTP_SERVER[] = "time.google.com";
+static constexpr time_t NTP_MIN_UTC  = 1600000000;   // abaixo disso: hora ainda não recebida
+// Firmwares sem TZ configurável gravavam no RTC a hora local fixa UTC–4
+static constexpr long   RTC_LEGACY_OFFSET_SEC = -4L * 3600L;
+
+static constexpr unsigned long ENGINE_PERIOD_MS = 10;
 
 // ===== Estado Global =====
 Config           cfg;
 WebSrv           server(80);
 RTC_DS3231       rtc;
 bool             rtcInitialized   = false;
-unsigned long    lastTriggerMs    = 0;
-String           eventLog         = "";
-bool             isOutputActive   = false;
-time_t           ruleHighDT       = 0;
-time_t           ruleLowDT        = 0;
 WiFiManager      wifiManager;
 
 // Prototipos de funções auxiliares
 void setupHardware();
 void setupNetwork();
-void updateStatusLED();
-void startOutput(unsigned long durationSec);
-void stopOutput();
+void setupTasks();
 
 void setup() {
   Serial.begin(115200);
@@ -67,19 +87,44 @@ void setup() {
   Serial.println("\n=== Iniciando Temporizador Inteligente ===");
 
   // 1) Valores default antes de tentar carregar
-  cfg.feederPin          = defaultFeederPin;
-  cfg.manualDurationSec  = 5;
-  cfg.customSchedule[0]  = '\0';
-  cfg.customEnabled      = false;
-  cfg.scheduleCount      = 0;
+  cfg.channelCount       = 1;
+  for (int ch = 0; ch < MAX_CHANNELS; ch++) {
+    defaultChannel(cfg.channels[ch], defaultFeederPins[ch]);
+  }
+  strncpy(cfg.tz, DEFAULT_TZ, sizeof(cfg.tz) - 1);
+  cfg.tz[sizeof(cfg.tz) - 1] = '\0';
+  cfg.hasLocation        = false;
+  cfg.latitude           = 0;
+  cfg.longitude          = 0;
+  cfg.sensorPeriodSec    = 10;
+  cfg.extPin             = -1;
+  cfg.extScale           = 1.0f;
+  cfg.extOffset          = 0;
+  memset(&cfg.mqtt, 0, sizeof(cfg.mqtt));
+  cfg.mqtt.port          = 1883;
+  cfg.mqtt.stateSec      = 60;
+  memset(cfg.webhooks, 0, sizeof(cfg.webhooks));
+  cfg.syncRole           = 0;
+  cfg.beaconSec          = 30;
+  cfg.beaconChannels     = MAX_CHANNELS;
+  cfg.modbusPort         = 0;
+  cfg.rtcUtc             = false;
 
   // 2) Load / Save config
   if (loadConfig(cfg)) {
     Serial.println("Configurações carregadas do FS.");
   } else {
     Serial.println("Usando configurações padrão e criando arquivo.");
-    saveConfig(cfg);
+    if (!saveConfig(cfg)) ledSetError(LED_ERR_FS);
   }
+  if (!tzSet(cfg.tz)) {
+    Serial.printf("TZ inválido '%s', usando %s\n", cfg.tz, DEFAULT_TZ);
+    tzSet(DEFAULT_TZ);
+  }
+  if (cfg.hasLocation) sunSetLocation(cfg.latitude, cfg.longitude);
+  excBegin();
+  statsBegin();
+  progBegin();
 
   // 3) GPIOs
   setupHardware();
@@ -92,82 +137,127 @@ void setup() {
   } else {
     Serial.println("RTC DS3231 não encontrado.");
   }
+  sensorsBegin(cfg, rtcInitialized);
 
   // 5) Rede e NTP/RTC Sync
   setupNetwork();
+  mqttBegin();
+  webhooksBegin();
+  syncBegin(cfg);
+  discoveryBegin(cfg);
 
   // 6) HTTP server
   initWebServer(server, cfg);
+
+  // 7) Tarefas do loop
+  setupTasks();
 }
 
+// Subsistemas do loop como tarefas (ver tasks.h); o tempo livre vai para
+// delay() dentro de tasksRun().
 void loop() {
-  server.handleClient();
-  updateStatusLED();
-
-  // sincronização periódica RTC -> TimeLib (a cada 5min)
-  static unsigned long lastSync = 0;
-  if (rtcInitialized && millis() - lastSync >= 300000UL) {
-    lastSync = millis();
-    syncTimeLibWithRTC();
-  }
+  metricsLoopTick();
+  tasksRun();
+}
 
-  // processa regras customizadas ou schedules
-  if (cfg.customEnabled) {
-    checkCustomRules(cfg, cfg.feederPin,
-      [&](bool relayVal, unsigned long dur){
-        if (relayVal) startOutput(dur);
-        else          stopOutput();
-      }
-    );
-  } else {
-    checkSchedules(cfg,
-      [&](unsigned long dur){
-        startOutput(dur);
-      }
-    );
+// ===== Implementações Auxiliares =====
+
+static int s_engineTask = -1;
+
+// Motor a cada ENGINE_PERIOD_MS; com o relógio comum ativo, acorda também
+// logo antes da virada do segundo para que syncAlignSecond() a alcance.
+static void engineTask() {
+  syncAlignSecond();
+  engineTick(cfg);
+  modbusPublish();
+  long us = syncUsToNextSecond();
+  if (us >= 0 && us / 1000 < (long)ENGINE_PERIOD_MS) {
+    taskWakeIn(s_engineTask, us > (long)SYNC_EDGE_SPIN_US ? (us - SYNC_EDGE_SPIN_US) / 1000 : 0);
   }
+}
 
-  // evita bloqueio excessivo
-  delay(1);
+// Migração única do RTC para UTC, marcada em cfg.rtcUtc: com NTP o RTC é
+// regravado em UTC (applyNtpTime); sem NTP, a hora local antiga é
+// convertida uma vez pelo deslocamento fixo dos firmwares anteriores.
+// Um RTC que já guardava UTC sem a marca (config perdida) e arranca sem
+// NTP fica RTC_LEGACY_OFFSET_SEC fora até a primeira resposta do NTP.
+static void rtcMarkUtc() {
+  if (cfg.rtcUtc) return;
+  cfg.rtcUtc = true;
+  if (!saveConfig(cfg)) ledSetError(LED_ERR_FS);
 }
 
-// ===== Implementações Auxiliares =====
+static void rtcMigrateToUtc() {
+  if (cfg.rtcUtc) return;
+  DateTime local = rtc.now();
+  rtc.adjust(DateTime((uint32_t)(local.unixtime() - RTC_LEGACY_OFFSET_SEC)));
+  Serial.println("RTC convertido de hora local (UTC-4) para UTC.");
+  rtcMarkUtc();
+}
 
-void setupHardware() {
-  pinMode(cfg.feederPin, OUTPUT);
-  digitalWrite(cfg.feederPin, LOW);
+// TimeLib e RTC guardam UTC; o fuso é aplicado na leitura (tz_rules)
+static void applyNtpTime(time_t t) {
+  setTime(t);
+  Serial.print("Hora NTP aplicada: ");
+  Serial.println(getCurrentDateTimeString());
+
+  if (rtcInitialized) {
+    rtc.adjust(DateTime(year(t),
+                       month(t),
+                       day(t),
+                       hour(t),
+                       minute(t),
+                       second(t)));
+    Serial.println("RTC ajustado com NTP (UTC).");
+    rtcMarkUtc();
+  }
+}
 
-  pinMode(STATUS_LED_PIN, OUTPUT);
-  digitalWrite(STATUS_LED_PIN, HIGH);
+// Hora válida chegando depois do boot (SNTP atrasado, RTC, relógio comum do
+// sincronismo): aplica o NTP e apaga o erro de relógio do LED
+static void clockTask() {
+  if (halUtcNow() >= NTP_MIN_UTC) {
+    ledClearError(LED_ERR_CLOCK);
+    return;
+  }
+  time_t t = time(nullptr);
+  if (t >= NTP_MIN_UTC) {
+    applyNtpTime(t);
+    ledClearError(LED_ERR_CLOCK);
+  }
+}
 
-  #ifdef SONOFF_BASIC
-  pinMode(BUTTON_PIN, INPUT_PULLUP);
-  #endif
+void setupTasks() {
+  taskAdd("http",      [](){ server.handleClient(); },     2,      TASK_HIGH);
+  taskAdd("control",   ctlService,                         10,     TASK_HIGH);
+  s_engineTask = taskAdd("engine", engineTask, ENGINE_PERIOD_MS, TASK_HIGH, 5);
+  taskAdd("sync",      syncService,                        2,      TASK_HIGH);
+  taskAdd("sensors",   [](){ sensorsService(cfg); },       100,    TASK_NORMAL);
+  taskAdd("mqtt",      mqttService,                        10,     TASK_NORMAL);
+  taskAdd("webhooks",  webhooksService,                    10,     TASK_NORMAL);
+  taskAdd("program",   progService,                        50,     TASK_NORMAL);
+  taskAdd("modbus",    modbusService,                      5,      TASK_NORMAL);
+  taskAdd("discovery", [](){ discoveryService(cfg); },     100,    TASK_LOW);
+  taskAdd("stats",     statsTick,                          1000,   TASK_LOW);
+  taskAdd("log",       logService,                         20,     TASK_LOW);
+  taskAdd("simulate",  simulateService,                    20,     TASK_LOW);
+  taskAdd("clock",     clockTask,                          1000,   TASK_LOW);
+  // RTC -> TimeLib a cada 5 min
+  if (rtcInitialized) taskAdd("rtc", [](){ syncTimeLibWithRTC(); }, 300000, TASK_LOW, 1000);
 }
 
-void updateStatusLED() {
-  static unsigned long prev = 0;
-  static bool state = false;
-  unsigned long nowMs = millis();
-
-  if (isOutputActive) {
-    // pisca rápido
-    if (nowMs - prev >= 200) {
-      state = !state;
-      digitalWrite(STATUS_LED_PIN, state ? LOW : HIGH);
-      prev = nowMs;
-    }
-  } else {
-    if (WiFi.status() == WL_CONNECTED) {
-      digitalWrite(STATUS_LED_PIN, LOW);
-    } else {
-      // pisca devagar se sem Wi-Fi
-      if (nowMs - prev >= 1000) {
-        state = !state;
-        digitalWrite(STATUS_LED_PIN, state ? LOW : HIGH);
-        prev = nowMs;
-      }
-    }
+void setupHardware() {
+  outputsBegin(cfg);
+
+  // LED de status: padrões tocados por Ticker, trocados só por eventos
+  ledBegin(STATUS_LED_PIN, true);
+  bool anyRules = false;
+  for (int ch = 0; ch < cfg.channelCount; ch++) anyRules |= cfg.channels[ch].customEnabled;
+  ledSetFlag(LED_F_RULES, anyRules);
+
+  // botão local: gestos tratados fora do loop (ver button.h / controller.h)
+  if (BUTTON_PIN >= 0) {
+    buttonBegin(BUTTON_PIN, ctlOnButton);
   }
 }
 
@@ -188,52 +278,21 @@ void setupNetwork() {
   Serial.println("Aguardando NTP...");
   time_t t = 0;
   int tries = 0;
-  while (tries++ < 30 && (t = time(nullptr)) < 1600000000UL) {
+  while (tries++ < 30 && (t = time(nullptr)) < NTP_MIN_UTC) {
     delay(500);
     Serial.print(".");
   }
   Serial.println();
-  if (t < 1600000000UL) {
+  if (t < NTP_MIN_UTC) {
     Serial.println("NTP falhou.");
-    if (rtcInitialized && !rtc.lostPower()) {
+    bool rtcOk = rtcInitialized && !rtc.lostPower();
+    if (rtcOk) {
       Serial.println("Usando RTC como fallback.");
-      syncTimeLibWithRTC();
+      rtcMigrateToUtc();
     }
+    // sem hora até o SNTP responder ou o RTC valer (ver clockTask)
+    if (!rtcOk || !syncTimeLibWithRTC()) ledSetError(LED_ERR_CLOCK);
   } else {
-    // aplica fuso e salva em TimeLib
-    time_t local = t + GMT_OFFSET_SEC + DAYLIGHT_OFFSET_SEC;
-    setTime(local);
-    Serial.print("Hora NTP aplicada: ");
-    Serial.println(getCurrentDateTimeString());
-
-    if (rtcInitialized) {
-      rtc.adjust(DateTime(year(local),
-                         month(local),
-                         day(local),
-                         hour(local),
-                         minute(local),
-                         second(local)));
-      Serial.println("RTC ajustado com NTP.");
-    }
+    applyNtpTime(t);
   }
 }
-
-void startOutput(unsigned long durationSec) {
-  if (isOutputActive) return;
-  unsigned long nowMs = millis();
-  if (lastTriggerMs && nowMs - lastTriggerMs < (unsigned long)FEED_COOLDOWN * 1000UL) return;
-
-  digitalWrite(cfg.feederPin, HIGH);
-  isOutputActive   = true;
-  lastTriggerMs    = nowMs;
-  eventLog        += timeStr(now()) + " -> Saída LIGADA\n";
-}
-
-void stopOutput() {
-  if (!isOutputActive) return;
-  digitalWrite(cfg.feederPin, LOW);
-  isOutputActive = false;
-  eventLog      += timeStr(now()) + " -> Saída DESLIGADA\n";
-}
-
-
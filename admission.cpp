@@ -0,0 +1,152 @@
+// admission.cpp
+
+#include "admission.h"
+
+struct AdmClient {
+  uint32_t      ip;          // 0 = livre
+  unsigned long lastMs;
+  uint32_t      milli[ADM_LANES];   // fichas × 1000
+};
+
+struct AdmLaneStats {
+  uint32_t admitted;
+  uint32_t throttled;
+  uint32_t shed;
+  uint64_t busyUs;
+  uint32_t maxUs;
+};
+
+static AdmClient     s_clients[ADM_CLIENTS];
+static AdmLaneStats  s_lanes[ADM_LANES];
+static uint32_t      s_evictions   = 0;
+
+static unsigned long s_winStart    = 0;
+static unsigned long s_winUsedUs   = 0;
+static bool          s_winOver     = false;   // janela atual já estourou
+static uint32_t      s_windowsOver = 0;
+
+static const uint16_t RATE[ADM_LANES]  = { ADM_CTL_RATE,  ADM_READ_RATE };
+static const uint16_t BURST[ADM_LANES] = { ADM_CTL_BURST, ADM_READ_BURST };
+
+// Rotas GET que montam respostas grandes ou bloqueiam o loop
+static const char* const HEAVY[] = { "/", "/simulate", "/bench", "/events", "/stats", "/config" };
+
+AdmLane admClassify(const char* path, bool mutating, uint8_t* cost) {
+  *cost = 1;
+  if (mutating) return ADM_CONTROL;
+  for (const char* h : HEAVY) {
+    if (strcmp(path, h) == 0) { *cost = ADM_HEAVY_COST; break; }
+  }
+  return ADM_READ;
+}
+
+static void windowRoll(unsigned long nowMs) {
+  if (nowMs - s_winStart < ADM_WINDOW_MS) return;
+  s_winStart  = nowMs;
+  s_winUsedUs = 0;
+  s_winOver   = false;
+}
+
+// Entrada do cliente, recarregada até agora; recicla a mais antiga
+static AdmClient& clientFor(uint32_t ip, unsigned long nowMs) {
+  AdmClient* slot = nullptr;
+  for (AdmClient& c : s_clients) {
+    if (c.ip == ip) { slot = &c; break; }
+  }
+  if (!slot) {
+    slot = &s_clients[0];
+    for (AdmClient& c : s_clients) {
+      if (!c.ip) { slot = &c; break; }
+      if (nowMs - c.lastMs > nowMs - slot->lastMs) slot = &c;
+    }
+    if (slot->ip) s_evictions++;
+    slot->ip = ip;
+    for (uint8_t l = 0; l < ADM_LANES; l++) slot->milli[l] = BURST[l] * 1000UL;
+    slot->lastMs = nowMs;
+    return *slot;
+  }
+
+  unsigned long dt = nowMs - slot->lastMs;
+  slot->lastMs = nowMs;
+  for (uint8_t l = 0; l < ADM_LANES; l++) {
+    uint32_t cap = BURST[l] * 1000UL;
+    // dt × taxa já está em milésimos de ficha; limita antes de multiplicar
+    uint32_t add = dt >= 60000UL ? cap : dt * RATE[l];
+    slot->milli[l] = (cap - slot->milli[l] < add) ? cap : slot->milli[l] + add;
+  }
+  return *slot;
+}
+
+AdmVerdict admCheck(AdmLane lane, uint8_t cost, uint32_t ip, uint16_t* retryS) {
+  unsigned long nowMs = millis();
+  AdmLaneStats& st = s_lanes[lane];
+  windowRoll(nowMs);
+
+  // orçamento só corta leituras: comandos passam mesmo com a janela cheia
+  if (lane == ADM_READ && s_winUsedUs >= ADM_BUDGET_US) {
+    st.shed++;
+    *retryS = 1;   // a janela vira em menos de 1 s
+    return ADM_SHED;
+  }
+
+  AdmClient& c   = clientFor(ip, nowMs);
+  uint32_t   need = cost * 1000UL;
+  if (c.milli[lane] < need) {
+    st.throttled++;
+    uint32_t rate = RATE[lane] * 1000UL;
+    *retryS = (uint16_t)((need - c.milli[lane] + rate - 1) / rate);
+    return ADM_THROTTLE;
+  }
+  c.milli[lane] -= need;
+  st.admitted++;
+  *retryS = 0;
+  return ADM_OK;
+}
+
+void admDone(AdmLane lane, unsigned long us) {
+  AdmLaneStats& st = s_lanes[lane];
+  st.busyUs += us;
+  if (us > st.maxUs) st.maxUs = us;
+
+  windowRoll(millis());
+  s_winUsedUs += us;
+  if (!s_winOver && s_winUsedUs >= ADM_BUDGET_US) {
+    s_winOver = true;
+    s_windowsOver++;
+  }
+}
+
+void admReset() {
+  memset(s_lanes, 0, sizeof(s_lanes));
+  s_evictions   = 0;
+  s_windowsOver = 0;
+}
+
+String admJson() {
+  static const char* const NAMES[ADM_LANES] = { "control", "read" };
+  uint8_t clients = 0;
+  for (const AdmClient& c : s_clients) if (c.ip) clients++;
+
+  String out;
+  out.reserve(320);
+  out += "{\"window_ms\":" + String(ADM_WINDOW_MS);
+  out += ",\"budget_us\":" + String(ADM_BUDGET_US);
+  out += ",\"window_used_us\":" + String(s_winUsedUs);
+  out += ",\"windows_over\":" + String(s_windowsOver);
+  out += ",\"clients\":" + String(clients);
+  out += ",\"evictions\":" + String(s_evictions);
+  out += ",\"lanes\":{";
+  for (uint8_t l = 0; l < ADM_LANES; l++) {
+    const AdmLaneStats& st = s_lanes[l];
+    if (l) out += ",";
+    out += "\"" + String(NAMES[l]) + "\":{\"rate\":" + String(RATE[l]);
+    out += ",\"burst\":" + String(BURST[l]);
+    out += ",\"admitted\":" + String(st.admitted);
+    out += ",\"throttled\":" + String(st.throttled);
+    out += ",\"shed\":" + String(st.shed);
+    out += ",\"busy_us\":" + String((uint32_t)st.busyUs);
+    out += ",\"max_us\":" + String(st.maxUs) + "}";
+  }
+  out += "}}";
+  return out;
+}
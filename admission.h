@@ -0,0 +1,57 @@
+// admission.h
+#ifndef ADMISSION_H
+#define ADMISSION_H
+
+#include <Arduino.h>
+
+// Controle de admissão do servidor HTTP, para que painéis em polling ou um
+// cliente descontrolado não roubem o loop do motor. Decidido antes do
+// handler (onRoute em webserver.cpp), com resposta curta e sem corpo:
+//   - balde de fichas por IP (ADM_CLIENTS entradas, a mais antiga é
+//     reciclada): leituras gastam 1 ficha, páginas pesadas ADM_HEAVY_COST;
+//     sem fichas → 429 com Retry-After;
+//   - orçamento de tempo de handler por janela de ADM_WINDOW_MS: passado
+//     ADM_BUDGET_US, leituras recebem 503 até a janela virar;
+//   - faixa prioritária: comandos (POST: /feedNow, /stopFeedNow, /set...)
+//     não entram no orçamento e têm balde próprio, então continuam sendo
+//     atendidos enquanto as leituras são cortadas.
+// O WebServer atende uma conexão por handleClient(), na ordem de chegada,
+// e não permite adiar uma resposta; a prioridade é obtida descartando
+// barato as leituras em excesso, não reordenando a fila.
+// Contadores por faixa em GET /admission.
+
+enum AdmLane : uint8_t {
+  ADM_CONTROL = 0,   // comandos e alterações de config
+  ADM_READ,          // leituras (GET)
+  ADM_LANES
+};
+
+enum AdmVerdict : uint8_t {
+  ADM_OK = 0,
+  ADM_THROTTLE,      // 429: balde do cliente vazio
+  ADM_SHED           // 503: orçamento da janela esgotado
+};
+
+static constexpr uint8_t       ADM_CLIENTS      = 8;
+static constexpr uint16_t      ADM_READ_RATE    = 5;      // fichas/s por cliente
+static constexpr uint16_t      ADM_READ_BURST   = 20;
+static constexpr uint16_t      ADM_CTL_RATE     = 2;
+static constexpr uint16_t      ADM_CTL_BURST    = 10;
+static constexpr uint8_t       ADM_HEAVY_COST   = 4;      // "/", /simulate, /bench...
+static constexpr unsigned long ADM_WINDOW_MS    = 100;
+static constexpr unsigned long ADM_BUDGET_US    = 40000;  // 40% da janela em handlers
+
+// Faixa e custo (fichas) de uma rota; chamado uma vez no registro.
+AdmLane admClassify(const char* path, bool mutating, uint8_t* cost);
+
+// Antes do handler. `ip` é o IPv4 do cliente; `retryS` recebe o
+// Retry-After sugerido quando a resposta não é ADM_OK.
+AdmVerdict admCheck(AdmLane lane, uint8_t cost, uint32_t ip, uint16_t* retryS);
+
+// Depois do handler admitido: tempo gasto, descontado do orçamento.
+void admDone(AdmLane lane, unsigned long us);
+
+void   admReset();
+String admJson();
+
+#endif // ADMISSION_H
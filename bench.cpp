@@ -0,0 +1,229 @@
+// bench.cpp
+
+#include "bench.h"
+#include "hal.h"
+#include "schedule.h"
+#include "custom_rules.h"
+#include "time_utils.h"
+#include "output.h"
+#include <TimeLib.h>
+
+// Print que só conta bytes (saveConfig sem destino)
+struct CountPrint : public Print {
+  size_t n = 0;
+  size_t write(uint8_t) override { n++; return 1; }
+  size_t write(const uint8_t*, size_t len) override { n += len; return len; }
+};
+
+// Print sobre um buffer fixo
+struct BufPrint : public Print {
+  char*  buf;
+  size_t cap;
+  size_t n = 0;
+  BufPrint(char* b, size_t c) : buf(b), cap(c) {}
+  size_t write(uint8_t b) override { return write(&b, 1); }
+  size_t write(const uint8_t* p, size_t len) override {
+    if (len > cap - n) len = cap - n;
+    memcpy(buf + n, p, len);
+    n += len;
+    return len;
+  }
+};
+
+static volatile int32_t s_sink;   // impede o compilador de descartar o resultado
+
+struct BenchRun {
+  String*       out;
+  const String* only;
+  unsigned long caseMs;
+  bool          first;
+};
+
+// Repete fn() em lotes dobrados até caseMs e acrescenta o resultado
+template <typename F>
+static void measure(BenchRun& run, const char* name, int n, F fn) {
+  if (run.only->length() && *run.only != name) return;
+  fn();   // aquecimento (caches, alocações de primeira vez)
+  yield();
+
+  uint32_t heap0  = ESP.getFreeHeap();
+#ifdef HOST_BUILD
+  uint64_t allocs0 = hostAllocCount();
+#endif
+  uint32_t iters  = 0;
+  uint32_t batch  = 1;
+  uint32_t t0     = micros();
+  uint32_t us     = 0;
+  do {
+    for (uint32_t i = 0; i < batch; i++) fn();
+    iters += batch;
+    if (batch < 4096) batch *= 2;
+    us = micros() - t0;
+    yield();
+  } while (us < run.caseMs * 1000UL);
+  int32_t heapOp = (int32_t)(heap0 - ESP.getFreeHeap()) / (int32_t)iters;
+#ifdef HOST_BUILD
+  // o laço de medida não aloca: tudo vem de fn()
+  float allocsOp = (float)(hostAllocCount() - allocs0) / (float)iters;
+#endif
+
+  String& out = *run.out;
+  if (!run.first) out += ",";
+  run.first = false;
+  out += "{\"name\":\"" + String(name) + "\"";
+  out += ",\"n\":" + String(n);
+  out += ",\"iters\":" + String(iters);
+  out += ",\"ns_op\":" + String((uint32_t)((uint64_t)us * 1000ULL / iters));
+  out += ",\"heap_b_op\":" + String(heapOp);
+#ifdef HOST_BUILD
+  out += ",\"allocs_op\":" + String(allocsOp, 2);
+#endif
+  out += "}";
+}
+
+// Regras DH/DL de hora em hora até ~len caracteres
+static void buildRules(char* dst, size_t size, size_t len) {
+  size_t n = 0;
+  dst[0] = '\0';
+  for (int i = 0; n + 11 <= len && n + 11 < size; i++) {
+    n += snprintf(dst + n, size - n, "D%c%02d:%02d:00 ", (i & 1) ? 'L' : 'H',
+                  (i / 2) % 24, (i & 1) ? 5 : 0);
+  }
+}
+
+// Slots espalhados pelo dia
+static void buildSlots(ChannelConfig& c, int count) {
+  c.scheduleCount = count;
+  for (int i = 0; i < count; i++) {
+    c.schedules[i].timeSec     = (int)(86400L * i / count) + 3600;
+    c.schedules[i].durationSec = 10;
+    c.schedules[i].lastFireDay = -1;
+  }
+}
+
+static void engineCases(BenchRun& run, const Config& base) {
+  // a cópia vai para o heap: Config não cabe na pilha do ESP8266
+  Config* sim = new Config(base);
+  sim->channelCount = 1;
+  ChannelConfig& c = sim->channels[0];
+  auto noTrigger = [](int, unsigned long) {};
+  auto noAction  = [](int, bool, unsigned long) { return true; };
+
+  static const size_t RULE_LEN[] = { 32, 128, 256, sizeof(c.customSchedule) - 1 };
+  ChannelConfig* tmp = new ChannelConfig;   // também fora da pilha
+  for (size_t len : RULE_LEN) {
+    *tmp = c;
+    buildRules(tmp->customSchedule, sizeof(tmp->customSchedule), len);
+    int    errPos;
+    String errMsg;
+    if (!compileCustomRules(*tmp, errPos, errMsg)) continue;
+    c = *tmp;
+    c.customEnabled = true;
+    measure(run, "checkCustomRules", strlen(c.customSchedule), [&]() {
+      halSimAdvance(1);
+      checkCustomRules(*sim, noAction);
+    });
+  }
+  delete tmp;
+
+  c.customEnabled = false;
+  static const int SLOTS[] = { 1, 4, MAX_SLOTS };
+  for (int slots : SLOTS) {
+    buildSlots(c, slots);
+    measure(run, "checkSchedules", slots, [&]() {
+      halSimAdvance(1);
+      checkSchedules(*sim, noTrigger);
+    });
+  }
+  for (int slots : SLOTS) {
+    buildSlots(c, slots);
+    measure(run, "getNextTriggerTimeString", slots, [&]() {
+      halSimAdvance(1);
+      s_sink = getNextTriggerTimeString(*sim, 0).length();
+    });
+  }
+  delete sim;
+}
+
+static void configCases(BenchRun& run, const Config& base) {
+  Config* tmp = new Config(base);
+
+  CountPrint count;
+  configToJson(base, count);
+  char* json = (char*)malloc(count.n + 1);
+  if (json) {
+    BufPrint buf(json, count.n);
+    configToJson(base, buf);
+    json[buf.n] = '\0';
+    measure(run, "loadConfig(json)", base.channelCount, [&]() {
+      s_sink = configFromJson(*tmp, json, buf.n);
+    });
+    free(json);
+  }
+  measure(run, "saveConfig(json)", base.channelCount, [&]() {
+    CountPrint sink;
+    s_sink = configToJson(base, sink);
+  });
+  delete tmp;
+}
+
+String benchRun(const Config& base, const String& only, unsigned long caseMs) {
+  if (caseMs == 0) caseMs = BENCH_CASE_MS;
+#ifndef HOST_BUILD
+  if (caseMs > BENCH_MAX_CASE_MS) caseMs = BENCH_MAX_CASE_MS;
+#endif
+
+  String out;
+  out.reserve(256 + 16 * 96);
+#if defined(HOST_BUILD)
+  out += "{\"platform\":\"host\"";
+#elif defined(ESP8266)
+  out += "{\"platform\":\"esp8266\"";
+#else
+  out += "{\"platform\":\"esp32\"";
+#endif
+  out += ",\"cpu_mhz\":" + String(ESP.getCpuFreqMHz());
+  out += ",\"case_ms\":" + String(caseMs);
+  out += ",\"results\":[";
+  BenchRun run = { &out, &only, caseMs, true };
+
+  // funções puras
+  String hms = "12:34:56";
+  measure(run, "parseHHMMSS", 0, [&]() { s_sink = parseHHMMSS(hms); });
+  int secs = 0;
+  measure(run, "formatHHMMSS", 0, [&]() {
+    secs = (secs + 7919) % 86400;
+    s_sink = formatHHMMSS(secs).length();
+  });
+  measure(run, "formatHHMMSS(buf)", 0, [&]() {
+    char buf[12];
+    secs = (secs + 7919) % 86400;
+    formatHHMMSS(secs, buf, sizeof(buf));
+    s_sink = buf[7];
+  });
+  int doy = 0;
+  measure(run, "calculateDayOfYear", 0, [&]() {
+    doy = (doy + 1) % 365;
+    s_sink = calculateDayOfYear(2024 + (doy & 3), 1 + doy % 12, 1 + doy % 28);
+  });
+
+  // motor no relógio virtual; estado real salvo e restaurado
+  ChannelState savedState = chState;
+  ScheduleTick savedTick  = scheduleTick;
+  time_t       savedCheck = ruleLastCheck;
+  memset(&chState, 0, sizeof(chState));
+  scheduleTick  = { 0, 0 };
+  ruleLastCheck = 0;
+  halSimBegin(now(), nullptr);
+
+  engineCases(run, base);
+  configCases(run, base);   // simulação ativa: nada vai para o flash
+
+  halSimEnd();
+  chState       = savedState;
+  scheduleTick  = savedTick;
+  ruleLastCheck = savedCheck;
+
+  out += "]}";
+  return out;
+}
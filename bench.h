@@ -0,0 +1,34 @@
+// bench.h
+#ifndef BENCH_H
+#define BENCH_H
+
+#include "config.h"
+
+// Microbenchmarks dos caminhos quentes do motor, medidos no próprio
+// dispositivo (GET /bench) para comparar versões do firmware:
+//   checkCustomRules     n = tamanho das regras (caracteres)
+//   checkSchedules       n = slots
+//   getNextTriggerTimeString  n = slots
+//   parseHHMMSS, formatHHMMSS, formatHHMMSS(buf), calculateDayOfYear
+//   loadConfig(json), saveConfig(json)  n = canais; o JSON de config.json
+//                        de/para memória (configFromJson/configToJson)
+// Os casos do motor rodam sobre uma cópia da config no relógio virtual da
+// simulação (hal.h): cada operação é a avaliação de um segundo, nada é
+// acionado nem gravado e o estado do motor é restaurado ao final.
+// Cada caso repete a operação em lotes crescentes até BENCH_CASE_MS e
+// informa ns/op e a variação líquida do heap livre por operação
+// (heap_b_op > 0: memória retida). O Arduino não expõe um contador de
+// alocações; no host (host/bench, `make -C host bench`) a suíte inteira
+// roda sem limite de tempo e cada resultado traz também allocs_op, as
+// alocações (new/malloc) por operação.
+// No dispositivo o loop fica parado durante a medida: GET /bench exige
+// ?case= (um nome, até 4 tamanhos) e limita o caso a BENCH_MAX_CASE_MS.
+
+static constexpr unsigned long BENCH_CASE_MS     = 20;    // padrão por caso
+static constexpr unsigned long BENCH_MAX_CASE_MS = 50;    // bloqueio do loop: ≤ 4 × 50 ms
+
+// JSON {"platform","cpu_mhz","case_ms","results":[{"name","n","iters",
+// "ns_op","heap_b_op"[,"allocs_op"]}...]}. `only` filtra pelo nome ("" = todos).
+String benchRun(const Config& base, const String& only, unsigned long caseMs);
+
+#endif // BENCH_H
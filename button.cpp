@@ -0,0 +1,125 @@
+// button.cpp
+
+#include "button.h"
+#include "hal.h"
+#ifndef ESP8266
+#include <Ticker.h>
+#else
+static_assert(BUTTON_TICK_MS == HAL_TICK_MS, "o botão roda no tick do hal");
+#endif
+
+struct ButtonEdge {
+  uint32_t us;
+  uint8_t  level;
+};
+
+static constexpr uint8_t EDGE_QUEUE = 16;   // potência de 2
+
+static int                 s_pin     = -1;
+static ButtonHandler       s_handler = nullptr;
+#ifndef ESP8266
+static Ticker              s_ticker;
+#endif
+
+// fila ISR -> timer (produtor único, consumidor único)
+static volatile ButtonEdge s_edges[EDGE_QUEUE];
+static volatile uint8_t    s_head    = 0;
+static volatile uint8_t    s_tail    = 0;
+static volatile uint32_t   s_dropped = 0;
+
+// estado do classificador (só acessado no tick)
+static uint8_t  s_rawLevel    = HIGH;
+static uint32_t s_rawUs       = 0;
+static uint8_t  s_stable      = HIGH;
+static uint32_t s_downUs      = 0;
+static bool     s_longFired   = false;
+static bool     s_pendingShort = false;
+static uint32_t s_releaseUs   = 0;
+static uint32_t s_maxDispatchUs = 0;
+
+static void IRAM_ATTR onEdge() {
+  uint8_t h    = s_head;
+  uint8_t next = (h + 1) & (EDGE_QUEUE - 1);
+  if (next == s_tail) { s_dropped++; return; }
+  s_edges[h].us    = micros();
+  s_edges[h].level = (uint8_t)digitalRead(s_pin);
+  s_head = next;
+}
+
+// entrega o gesto; dueUs é o instante em que ele ficou definido
+static void IRAM_ATTR dispatch(ButtonEvent ev, uint32_t dueUs, uint32_t nowUs) {
+  uint32_t lat = nowUs - dueUs;
+  if ((int32_t)lat > 0 && lat > s_maxDispatchUs) s_maxDispatchUs = lat;
+  if (s_handler) s_handler(ev);
+}
+
+static void IRAM_ATTR onRelease(uint32_t us, uint32_t nowUs) {
+  if (s_longFired) return;                  // gesto longo já entregue
+  if (s_pendingShort) {
+    s_pendingShort = false;
+    dispatch(BTN_DOUBLE, us, nowUs);
+  } else {
+    s_pendingShort = true;
+    s_releaseUs    = us;
+  }
+}
+
+static void IRAM_ATTR classify() {
+  uint32_t nowUs = micros();
+
+  // 1) drena as bordas carimbadas pela ISR
+  while (s_tail != s_head) {
+    uint8_t t  = s_tail;
+    s_rawLevel = s_edges[t].level;
+    s_rawUs    = s_edges[t].us;
+    s_tail     = (t + 1) & (EDGE_QUEUE - 1);
+  }
+
+  // 2) debounce: aceita o nível bruto após BUTTON_DEBOUNCE_MS sem bordas;
+  //    o gesto usa o carimbo da última borda, não o instante do tick
+  if (s_rawLevel != s_stable && nowUs - s_rawUs >= BUTTON_DEBOUNCE_MS * 1000UL) {
+    s_stable = s_rawLevel;
+    if (s_stable == LOW) {
+      s_downUs    = s_rawUs;
+      s_longFired = false;
+    } else {
+      onRelease(s_rawUs, nowUs);
+    }
+  }
+
+  // 3) longo: entregue ainda pressionado
+  if (s_stable == LOW && !s_longFired && nowUs - s_downUs >= BUTTON_LONG_MS * 1000UL) {
+    s_longFired    = true;
+    s_pendingShort = false;
+    dispatch(BTN_LONG, s_downUs + BUTTON_LONG_MS * 1000UL, nowUs);
+  }
+
+  // 4) curto: confirmado quando a janela do duplo clique expira
+  if (s_pendingShort && s_stable == HIGH &&
+      nowUs - s_releaseUs >= BUTTON_DOUBLE_MS * 1000UL) {
+    s_pendingShort = false;
+    dispatch(BTN_SHORT, s_releaseUs + BUTTON_DOUBLE_MS * 1000UL, nowUs);
+  }
+}
+
+void buttonBegin(int pin, ButtonHandler handler) {
+  if (pin < 0) return;
+  s_pin     = pin;
+  s_handler = handler;
+  pinMode(pin, INPUT_PULLUP);
+  s_rawLevel = s_stable = (uint8_t)digitalRead(pin);
+  attachInterrupt(digitalPinToInterrupt(pin), onEdge, CHANGE);
+#ifdef ESP8266
+  halTickAttach(classify);   // timer1 (Ticker do ESP8266 é cooperativo)
+#else
+  s_ticker.attach_ms(BUTTON_TICK_MS, classify);   // task do esp_timer
+#endif
+}
+
+uint32_t buttonDroppedEdges() {
+  return s_dropped;
+}
+
+uint32_t buttonMaxDispatchUs() {
+  return s_maxDispatchUs;
+}
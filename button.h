@@ -0,0 +1,37 @@
+// button.h
+#ifndef BUTTON_H
+#define BUTTON_H
+
+#include <Arduino.h>
+
+// Botão local (ativo em LOW, ex.: GPIO0 do Sonoff Basic).
+// A ISR apenas carimba cada borda com micros() numa fila circular; o
+// debounce e a classificação do gesto rodam a cada BUTTON_TICK_MS,
+// independente do que o loop() estiver fazendo, e o gesto reconhecido é
+// entregue ao callback no mesmo tick. ESP8266: tick do timer1 dividido com
+// o LED (halTickAttach, hal.h; o Ticker de lá só roda quando o loop cede),
+// então o callback roda em interrupção e precisa estar na IRAM; ESP32:
+// Ticker (task do esp_timer).
+
+static constexpr uint32_t BUTTON_TICK_MS     = 5;
+static constexpr uint32_t BUTTON_DEBOUNCE_MS = 25;
+static constexpr uint32_t BUTTON_DOUBLE_MS   = 350;   // janela do 2º clique
+static constexpr uint32_t BUTTON_LONG_MS     = 1000;  // dispara ainda pressionado
+
+enum ButtonEvent : uint8_t {
+  BTN_SHORT = 1,
+  BTN_DOUBLE,
+  BTN_LONG
+};
+
+typedef void (*ButtonHandler)(ButtonEvent ev);
+
+// Configura o pino (INPUT_PULLUP), a interrupção e o timer do tick.
+void buttonBegin(int pin, ButtonHandler handler);
+
+// Diagnóstico: bordas perdidas por fila cheia e pior atraso (µs) entre a
+// borda que definiu o gesto e a entrega ao callback.
+uint32_t buttonDroppedEdges();
+uint32_t buttonMaxDispatchUs();
+
+#endif // BUTTON_H
@@ -0,0 +1,188 @@
+// cbor.cpp
+
+#include "cbor.h"
+
+// ===== Escrita =====
+
+static void put(CborOut& o, uint8_t b) {
+  if (o.n == sizeof(o.buf)) cborFlush(o);
+  o.buf[o.n++] = b;
+}
+
+static void putBytes(CborOut& o, const void* data, size_t len) {
+  const uint8_t* p = (const uint8_t*)data;
+  while (len) {
+    if (o.n == sizeof(o.buf)) cborFlush(o);
+    size_t k = sizeof(o.buf) - o.n;
+    if (k > len) k = len;
+    memcpy(o.buf + o.n, p, k);
+    o.n += k;
+    p   += k;
+    len -= k;
+  }
+}
+
+// Cabeçalho: tipo maior nos 3 bits altos, valor no menor número de bytes
+static void head(CborOut& o, uint8_t major, uint64_t v) {
+  uint8_t m = major << 5;
+  if (v < 24) {
+    put(o, m | (uint8_t)v);
+  } else if (v <= 0xFF) {
+    put(o, m | 24);
+    put(o, (uint8_t)v);
+  } else if (v <= 0xFFFF) {
+    put(o, m | 25);
+    put(o, v >> 8);
+    put(o, v & 0xFF);
+  } else if (v <= 0xFFFFFFFFULL) {
+    put(o, m | 26);
+    for (int s = 24; s >= 0; s -= 8) put(o, (v >> s) & 0xFF);
+  } else {
+    put(o, m | 27);
+    for (int s = 56; s >= 0; s -= 8) put(o, (v >> s) & 0xFF);
+  }
+}
+
+void cborBegin(CborOut& o, Print& out) {
+  o.out = &out;
+  o.n   = 0;
+}
+
+void cborMap(CborOut& o, uint32_t pairs)  { head(o, CBOR_MAP, pairs); }
+void cborArray(CborOut& o, uint32_t items) { head(o, CBOR_ARRAY, items); }
+void cborArrayOpen(CborOut& o)            { put(o, 0x9F); }
+void cborClose(CborOut& o)                { put(o, 0xFF); }
+void cborUint(CborOut& o, uint64_t v)     { head(o, CBOR_UINT, v); }
+void cborBool(CborOut& o, bool b)         { put(o, b ? 0xF5 : 0xF4); }
+void cborNull(CborOut& o)                 { put(o, 0xF6); }
+
+void cborInt(CborOut& o, int64_t v) {
+  if (v < 0) head(o, CBOR_NEGINT, (uint64_t)(-1 - v));
+  else       head(o, CBOR_UINT, (uint64_t)v);
+}
+
+void cborText(CborOut& o, const char* s) {
+  cborText(o, s, strlen(s));
+}
+
+void cborText(CborOut& o, const char* s, size_t len) {
+  head(o, CBOR_TEXT, len);
+  putBytes(o, s, len);
+}
+
+void cborFlush(CborOut& o) {
+  if (o.n) o.out->write(o.buf, o.n);
+  o.n = 0;
+}
+
+// ===== Leitura =====
+
+void cborInBegin(CborIn& in, const uint8_t* data, size_t len) {
+  in.p   = data;
+  in.end = data + len;
+  in.err = false;
+}
+
+CborMajor cborPeek(const CborIn& in) {
+  if (in.err || in.p >= in.end) return CBOR_END;
+  return (CborMajor)(*in.p >> 5);
+}
+
+// Lê o cabeçalho do próximo item; recusa tamanhos indefinidos.
+static bool readHead(CborIn& in, uint8_t& major, uint64_t& v) {
+  if (in.err || in.p >= in.end) return in.err = true, false;
+  uint8_t b   = *in.p++;
+  uint8_t add = b & 0x1F;
+  major = b >> 5;
+  if (add < 24) {
+    v = add;
+    return true;
+  }
+  if (add > 27) return in.err = true, false;
+  size_t len = (size_t)1 << (add - 24);
+  if ((size_t)(in.end - in.p) < len) return in.err = true, false;
+  v = 0;
+  while (len--) v = (v << 8) | *in.p++;
+  return true;
+}
+
+static bool expect(CborIn& in, uint8_t want, uint64_t& v) {
+  uint8_t major;
+  if (!readHead(in, major, v)) return false;
+  if (major != want) return in.err = true, false;
+  return true;
+}
+
+bool cborReadMap(CborIn& in, uint32_t& pairs) {
+  uint64_t v;
+  if (!expect(in, CBOR_MAP, v) || v > 0xFFFF) return in.err = true, false;
+  pairs = (uint32_t)v;
+  return true;
+}
+
+bool cborReadArray(CborIn& in, uint32_t& items) {
+  uint64_t v;
+  if (!expect(in, CBOR_ARRAY, v) || v > 0xFFFF) return in.err = true, false;
+  items = (uint32_t)v;
+  return true;
+}
+
+bool cborReadInt(CborIn& in, int64_t& v) {
+  uint8_t  major;
+  uint64_t u;
+  if (!readHead(in, major, u)) return false;
+  if ((major != CBOR_UINT && major != CBOR_NEGINT) || u > (uint64_t)INT64_MAX) {
+    return in.err = true, false;
+  }
+  v = major == CBOR_UINT ? (int64_t)u : -1 - (int64_t)u;
+  return true;
+}
+
+bool cborReadBool(CborIn& in, bool& b) {
+  uint8_t  major;
+  uint64_t v;
+  if (!readHead(in, major, v)) return false;
+  if (major != CBOR_SIMPLE || (v != 20 && v != 21)) return in.err = true, false;
+  b = v == 21;
+  return true;
+}
+
+bool cborReadText(CborIn& in, char* dst, size_t cap) {
+  uint64_t len;
+  if (!expect(in, CBOR_TEXT, len)) return false;
+  if (len >= cap || (uint64_t)(in.end - in.p) < len) return in.err = true, false;
+  memcpy(dst, in.p, (size_t)len);
+  dst[len] = '\0';
+  in.p += len;
+  return true;
+}
+
+static bool skipItem(CborIn& in, uint8_t depth) {
+  uint8_t  major;
+  uint64_t v;
+  if (!readHead(in, major, v)) return false;
+  switch (major) {
+    case CBOR_UINT:
+    case CBOR_NEGINT:
+    case CBOR_SIMPLE:
+      return true;
+    case CBOR_BYTES:
+    case CBOR_TEXT:
+      if ((uint64_t)(in.end - in.p) < v) return in.err = true, false;
+      in.p += v;
+      return true;
+    case CBOR_ARRAY:
+    case CBOR_MAP: {
+      if (depth >= CBOR_MAX_DEPTH) return in.err = true, false;
+      uint64_t items = major == CBOR_MAP ? v * 2 : v;
+      while (items--) if (!skipItem(in, depth + 1)) return false;
+      return true;
+    }
+    default:
+      return in.err = true, false;   // tags
+  }
+}
+
+bool cborSkip(CborIn& in) {
+  return skipItem(in, 0);
+}
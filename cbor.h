@@ -0,0 +1,105 @@
+// cbor.h
+#ifndef CBOR_H
+#define CBOR_H
+
+#include <Arduino.h>
+
+// Codificação CBOR (RFC 8949) mínima para a API binária.
+// Escrita: os itens vão para um buffer de CBOR_BUF_LEN bytes que é
+// despejado num Print (o corpo chunked da resposta HTTP), sem documento
+// intermediário nem String. Leitura: inteiros, bool, null, texto, arrays
+// e mapas de tamanho definido sobre um buffer em memória; tamanhos
+// indefinidos, floats e tags são recusados.
+
+static constexpr size_t CBOR_BUF_LEN   = 128;
+static constexpr uint8_t CBOR_MAX_DEPTH = 4;    // aninhamento aceito por cborSkip()
+
+enum CborMajor : uint8_t {
+  CBOR_UINT = 0,
+  CBOR_NEGINT,
+  CBOR_BYTES,
+  CBOR_TEXT,
+  CBOR_ARRAY,
+  CBOR_MAP,
+  CBOR_TAG,
+  CBOR_SIMPLE,
+  CBOR_END = 0xFF   // fim da entrada ou erro
+};
+
+// ===== Escrita =====
+struct CborOut {
+  Print*  out;
+  uint8_t buf[CBOR_BUF_LEN];
+  size_t  n;
+};
+
+void cborBegin(CborOut& o, Print& out);
+void cborMap(CborOut& o, uint32_t pairs);
+void cborArray(CborOut& o, uint32_t items);
+void cborArrayOpen(CborOut& o);                 // tamanho indefinido...
+void cborClose(CborOut& o);                     // ...terminado aqui
+void cborUint(CborOut& o, uint64_t v);
+void cborInt(CborOut& o, int64_t v);
+void cborBool(CborOut& o, bool b);
+void cborNull(CborOut& o);
+void cborText(CborOut& o, const char* s);
+void cborText(CborOut& o, const char* s, size_t len);
+void cborFlush(CborOut& o);                     // obrigatório ao final
+
+// ===== Leitura =====
+struct CborIn {
+  const uint8_t* p;
+  const uint8_t* end;
+  bool           err;
+};
+
+void      cborInBegin(CborIn& in, const uint8_t* data, size_t len);
+CborMajor cborPeek(const CborIn& in);
+bool      cborReadMap(CborIn& in, uint32_t& pairs);
+bool      cborReadArray(CborIn& in, uint32_t& items);
+bool      cborReadInt(CborIn& in, int64_t& v);
+bool      cborReadBool(CborIn& in, bool& b);
+// Copia o texto terminado em '\0'; erro se não couber em `cap`.
+bool      cborReadText(CborIn& in, char* dst, size_t cap);
+bool      cborSkip(CborIn& in);
+
+// ===== Chaves da API binária =====
+// Mapas com chaves inteiras; a mesma chave tem o mesmo sentido em todas
+// as rotas. Pedido com "Accept: application/cbor" (ou ?fmt=cbor).
+//
+//   GET  /status          {1 canal, 2 ligado, 3 regras, 4 regra ativa,
+//                          5 restante s, 6 [[pino, ligado, regras]...],
+//                          7 utc, 8 [temp, ext] (décimos ou null),
+//                          9 mqtt conectado}
+//   GET  /config          {16 canais em uso, 17 tz, 6 [{18 pino,
+//                          19 duração manual, 3 regras ativas,
+//                          20 [[início, duração]...], 21 regras, 22 W}...]}
+//   POST /config          {1 canal, depois qualquer de 3, 19, 20, 21, 22;
+//                          17 dispensa o canal} (Content-Type: application/cbor)
+//   GET  /events?since=N  {32 último seq, 33 perdidos,
+//                          34 [[seq, utc, id, canal, a, b, texto]...]}
+//                          (id e argumentos conforme logbuf.h)
+//   GET  /nextTriggerTime [[utc ou null, duração s]...] por canal
+enum CborKey : uint8_t {
+  CK_CHANNEL       = 1,
+  CK_ON            = 2,
+  CK_CUSTOM        = 3,
+  CK_RULE          = 4,
+  CK_REMAINING     = 5,
+  CK_CHANNELS      = 6,
+  CK_UTC           = 7,
+  CK_SENSORS       = 8,
+  CK_MQTT          = 9,
+  CK_CHANNEL_COUNT = 16,
+  CK_TZ            = 17,
+  CK_PIN           = 18,
+  CK_MANUAL_SEC    = 19,
+  CK_SCHEDULES     = 20,
+  CK_RULES         = 21,
+  CK_LOAD_W        = 22,
+  CK_HEAD          = 32,
+  CK_LOST          = 33,
+  CK_RECORDS       = 34
+};
+
+#endif // CBOR_H
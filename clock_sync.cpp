@@ -0,0 +1,412 @@
+// clock_sync.cpp
+
+#include "clock_sync.h"
+#include "hal.h"
+#include "logbuf.h"
+#include "time_utils.h"
+#include <TimeLib.h>
+#include <sys/time.h>
+
+#ifdef ESP8266
+  #include <ESP8266WiFi.h>
+#else
+  #include <WiFi.h>
+#endif
+#include <WiFiUdp.h>
+
+static constexpr uint32_t SYNC_MAGIC       = 0x31595354UL;   // "TSY1"
+static constexpr int64_t  US_PER_SEC       = 1000000LL;
+static constexpr unsigned long SYNC_ACQUIRE_MS = 500;        // intervalo até travar
+static constexpr int64_t  SYNC_FREQ_MIN_BASE_US = 16LL * 1000000LL;
+static constexpr int64_t  SYNC_FREQ_MAX_BASE_US = 256LL * 1000000LL;
+
+enum : uint8_t { SYNC_PKT_REQ = 1, SYNC_PKT_RESP = 2 };
+
+// Mesmo layout nos dois chips (little-endian)
+struct __attribute__((packed)) SyncPkt {
+  uint32_t magic;
+  uint8_t  type;
+  uint8_t  locked;     // seguidor travado (REQ)
+  uint16_t seq;
+  int64_t  t1;         // relógio local do seguidor (µs), ecoado na resposta
+  int64_t  t2;         // UTC do líder na recepção (µs)
+  int64_t  t3;         // UTC do líder no envio (µs)
+  int32_t  errUs;      // último erro medido pelo seguidor (REQ)
+  uint32_t delayUs;    // último atraso de ida e volta (REQ)
+};
+
+// utc(mono) = refUtc + (mono - refMono) * (1 + ppb / 1e9) + slew, onde slew
+// vai de 0 a slewUs (<= 0) a -1/SYNC_SLEW_DIV µs por µs
+struct Model {
+  int64_t refMono;
+  int64_t refUtc;
+  int32_t ppb;
+  int64_t slewUs;
+};
+
+struct Sample {
+  int64_t  mid;        // relógio local no meio da troca
+  int64_t  offset;     // UTC do líder - relógio local
+  uint32_t delay;
+};
+
+struct Peer {
+  uint32_t      ip;
+  int32_t       errUs;
+  uint32_t      delayUs;
+  bool          locked;
+  unsigned long seenMs;
+};
+
+static WiFiUDP           s_udp;
+static uint8_t           s_role       = SYNC_OFF;
+
+// relógio local: micros() estendido para 64 bits pelo loop
+static volatile uint32_t s_monoHigh   = 0;
+static volatile uint32_t s_monoLast   = 0;
+
+// modelo publicado em dois buffers: leitura sem trava
+static Model             s_model[2];
+static volatile uint8_t  s_modelIdx   = 0;
+
+// seguidor
+static bool              s_locked     = false;
+static bool              s_haveLeader = false;
+static IPAddress         s_leader;
+static uint16_t          s_seq        = 0;
+static uint16_t          s_pendSeq    = 0;
+static int64_t           s_pendT1     = 0;
+static unsigned long     s_lastReqMs  = 0;
+static unsigned long     s_lastRespMs = 0;
+static Sample            s_samp[SYNC_FILTER_N];
+static uint8_t           s_sampCount  = 0;
+static uint8_t           s_sampIdx    = 0;
+static int64_t           s_lastUsedMid = 0;
+static Sample            s_anchor;       // base da estimativa de frequência
+static int32_t           s_errUs      = 0;
+static uint32_t          s_jitterUs   = 0;
+static uint32_t          s_delayUs    = 0;
+static uint32_t          s_steps      = 0;
+static uint32_t          s_samplesOk  = 0;
+static uint32_t          s_samplesBad = 0;
+
+// líder
+static Peer              s_peers[SYNC_MAX_PEERS];
+
+// atraso do motor em relação à virada do segundo
+static time_t            s_edgeSec    = 0;
+static uint32_t          s_edgeAvgUs  = 0;
+static uint32_t          s_edgeMaxUs  = 0;
+static uint32_t          s_edgeMaxPrev = 0;
+static uint8_t           s_edgeCount  = 0;
+
+static int64_t monoUs() {
+  uint32_t hi  = s_monoHigh;
+  uint32_t lo  = micros();
+  if (lo < s_monoLast) hi++;   // virou e o loop ainda não viu
+  return ((int64_t)hi << 32) | lo;
+}
+
+static void monoTick() {
+  uint32_t lo = micros();
+  if (lo < s_monoLast) s_monoHigh++;
+  s_monoLast = lo;
+}
+
+// UTC do sistema (SNTP) com resolução de µs; sem SNTP, segundos do TimeLib
+static int64_t systemUtcUs(bool* valid = nullptr) {
+  struct timeval tv;
+  gettimeofday(&tv, nullptr);
+  bool ok = tv.tv_sec >= 1600000000L;
+  if (valid) *valid = ok;
+  if (ok) return (int64_t)tv.tv_sec * US_PER_SEC + tv.tv_usec;
+  return (int64_t)now() * US_PER_SEC;
+}
+
+static int64_t modelAt(const Model& m, int64_t mono) {
+  int64_t d = mono - m.refMono;
+  int64_t s = 0;
+  if (m.slewUs < 0 && d > 0) {
+    s = d >= -m.slewUs * SYNC_SLEW_DIV ? m.slewUs : -d / SYNC_SLEW_DIV;
+  }
+  return m.refUtc + d + d * m.ppb / 1000000000LL + s;
+}
+
+static void publishModel(const Model& m) {
+  uint8_t next = s_modelIdx ^ 1;
+  s_model[next] = m;
+  s_modelIdx    = next;
+}
+
+int64_t syncUtcUs() {
+  if (s_role == SYNC_FOLLOWER) return modelAt(s_model[s_modelIdx], monoUs());
+  return systemUtcUs();
+}
+
+bool syncActive() {
+  if (s_role == SYNC_FOLLOWER) return s_locked;
+  if (s_role == SYNC_LEADER) {
+    bool valid;
+    systemUtcUs(&valid);
+    return valid;
+  }
+  return false;
+}
+
+void syncBegin(const Config& cfg) {
+  s_udp.stop();
+  s_role       = cfg.syncRole;
+  s_locked     = false;
+  s_haveLeader = false;
+  s_sampCount  = 0;
+  s_sampIdx    = 0;
+  s_lastUsedMid = 0;
+  s_steps      = 0;
+  s_samplesOk  = 0;
+  s_samplesBad = 0;
+  s_errUs      = 0;
+  s_jitterUs   = 0;
+  s_edgeSec    = 0;
+  memset(s_peers, 0, sizeof(s_peers));
+  if (s_role == SYNC_OFF) return;
+
+  // economia de energia do rádio atrasa pacotes em dezenas de ms
+#ifdef ESP8266
+  WiFi.setSleepMode(WIFI_NONE_SLEEP);
+#else
+  WiFi.setSleep(false);
+#endif
+  s_udp.begin(SYNC_PORT);
+  Model m = { monoUs(), systemUtcUs(), 0, 0 };
+  publishModel(m);
+}
+
+// ===== Seguidor =====
+
+static void sendRequest() {
+  SyncPkt p;
+  memset(&p, 0, sizeof(p));
+  p.magic   = SYNC_MAGIC;
+  p.type    = SYNC_PKT_REQ;
+  p.locked  = s_locked;
+  p.seq     = ++s_seq;
+  p.errUs   = s_errUs;
+  p.delayUs = s_delayUs;
+
+  IPAddress to = s_haveLeader ? s_leader : WiFi.broadcastIP();
+  s_udp.beginPacket(to, SYNC_PORT);
+  s_pendSeq = p.seq;
+  s_pendT1  = p.t1 = monoUs();
+  s_udp.write((const uint8_t*)&p, sizeof(p));
+  s_udp.endPacket();
+}
+
+// Corrige o modelo com a amostra de menor atraso da janela
+static void discipline() {
+  const Sample* best = nullptr;
+  for (uint8_t i = 0; i < s_sampCount; i++) {
+    if (!best || s_samp[i].delay < best->delay) best = &s_samp[i];
+  }
+  if (!best || best->mid <= s_lastUsedMid) return;   // a melhor já foi usada
+
+  Model   m   = s_model[s_modelIdx];
+  int64_t est = best->mid + best->offset;
+  int64_t err = est - modelAt(m, best->mid);
+  int64_t mag = err < 0 ? -err : err;
+  s_errUs    = (int32_t)(mag > 0x7FFFFFFF ? (err < 0 ? -0x7FFFFFFF : 0x7FFFFFFF) : err);
+  s_jitterUs = (s_jitterUs * 7 + (uint32_t)(mag > 0xFFFFFFF ? 0xFFFFFFF : mag)) / 8;
+
+  if (!s_locked || mag > SYNC_STEP_US) {
+    m.refMono = best->mid;
+    m.refUtc  = est;
+    m.slewUs  = 0;
+    s_steps++;
+    if (!s_locked) logEvent(LOG_SYNC_LOCKED, -1, 0, 0, s_leader.toString().c_str());
+    s_locked = true;
+    s_anchor = *best;
+  } else {
+    // fase: metade do erro. O modelo é rebaseado no instante atual (com a
+    // correção pendente já incluída) para que o novo traçado parta do valor
+    // que os leitores veem agora: adiantar salta err/2; atrasar vira slewUs,
+    // absorvido devagar, sem que modelAt() diminua.
+    int64_t nowMono = monoUs();
+    m.refUtc  = modelAt(m, nowMono);
+    m.refMono = nowMono;
+    m.slewUs  = 0;
+    if (err >= 0) m.refUtc += err / 2;
+    else          m.slewUs  = err / 2;
+
+    // frequência: inclinação do offset desde a âncora; base longa dilui o
+    // ruído de cada amostra (100 µs em 60 s ~ 2 ppm)
+    int64_t base = best->mid - s_anchor.mid;
+    if (base >= SYNC_FREQ_MIN_BASE_US) {
+      int64_t ppb = (best->offset - s_anchor.offset) * 1000000000LL / base;
+      ppb = (m.ppb * 3LL + ppb) / 4;
+      if (ppb >  SYNC_MAX_PPB) ppb =  SYNC_MAX_PPB;
+      if (ppb < -SYNC_MAX_PPB) ppb = -SYNC_MAX_PPB;
+      m.ppb = (int32_t)ppb;
+      if (base >= SYNC_FREQ_MAX_BASE_US) s_anchor = *best;
+    }
+  }
+  s_lastUsedMid = best->mid;
+  publishModel(m);
+}
+
+static void onResponse(const SyncPkt& p, int64_t t4) {
+  if (p.seq != s_pendSeq || p.t1 != s_pendT1) return;   // atrasada ou de outra troca
+  s_pendSeq = 0;
+
+  int64_t delay = (t4 - p.t1) - (p.t3 - p.t2);
+  if (delay < 0 || delay > SYNC_MAX_DELAY_US) {
+    s_samplesBad++;
+    return;
+  }
+  s_leader     = s_udp.remoteIP();
+  s_haveLeader = true;
+  s_lastRespMs = millis();
+  s_delayUs    = (uint32_t)delay;
+  s_samplesOk++;
+
+  Sample& s = s_samp[s_sampIdx];
+  s.mid    = p.t1 + (t4 - p.t1) / 2;
+  s.offset = ((p.t2 - p.t1) + (p.t3 - t4)) / 2;
+  s.delay  = (uint32_t)delay;
+  s_sampIdx = (s_sampIdx + 1) % SYNC_FILTER_N;
+  if (s_sampCount < SYNC_FILTER_N) s_sampCount++;
+  discipline();
+}
+
+// ===== Líder =====
+
+static void onRequest(SyncPkt& p, int64_t t2) {
+  uint32_t      ip    = (uint32_t)s_udp.remoteIP();
+  unsigned long nowMs = millis();
+  Peer*         slot  = nullptr;
+  for (uint8_t i = 0; i < SYNC_MAX_PEERS && !slot; i++) {
+    if (s_peers[i].ip == ip) slot = &s_peers[i];
+  }
+  // novo seguidor: ocupa o registro livre ou o visto há mais tempo
+  for (uint8_t i = 0; i < SYNC_MAX_PEERS && !slot; i++) {
+    if (!s_peers[i].ip) slot = &s_peers[i];
+  }
+  if (!slot) {
+    slot = &s_peers[0];
+    for (uint8_t i = 1; i < SYNC_MAX_PEERS; i++) {
+      if (nowMs - s_peers[i].seenMs > nowMs - slot->seenMs) slot = &s_peers[i];
+    }
+  }
+  slot->ip      = ip;
+  slot->errUs   = p.errUs;
+  slot->delayUs = p.delayUs;
+  slot->locked  = p.locked;
+  slot->seenMs  = nowMs;
+
+  p.type = SYNC_PKT_RESP;
+  p.t2   = t2;
+  s_udp.beginPacket(s_udp.remoteIP(), s_udp.remotePort());
+  p.t3   = systemUtcUs();
+  s_udp.write((const uint8_t*)&p, sizeof(p));
+  s_udp.endPacket();
+}
+
+// ===== Loop =====
+
+void syncService() {
+  monoTick();
+  if (s_role == SYNC_OFF) return;
+
+  while (s_udp.parsePacket() > 0) {
+    int64_t t = s_role == SYNC_LEADER ? systemUtcUs() : monoUs();   // marca de recepção
+    SyncPkt p;
+    int n = s_udp.read((uint8_t*)&p, sizeof(p));
+    if (n != (int)sizeof(p) || p.magic != SYNC_MAGIC) continue;
+    if      (s_role == SYNC_LEADER   && p.type == SYNC_PKT_REQ)  onRequest(p, t);
+    else if (s_role == SYNC_FOLLOWER && p.type == SYNC_PKT_RESP) onResponse(p, t);
+  }
+
+  if (s_role != SYNC_FOLLOWER || WiFi.status() != WL_CONNECTED) return;
+  unsigned long nowMs = millis();
+  if (s_haveLeader && nowMs - s_lastRespMs > SYNC_LOST_MS) {
+    s_haveLeader = false;
+    logEvent(LOG_SYNC_HOLDOVER);
+  }
+  unsigned long interval = s_locked ? SYNC_INTERVAL_MS : SYNC_ACQUIRE_MS;
+  if (nowMs - s_lastReqMs >= interval) {
+    s_lastReqMs = nowMs;
+    sendRequest();
+  }
+}
+
+void syncAlignSecond() {
+  if (!syncActive()) return;
+  int64_t us  = syncUtcUs();
+  time_t  sec = (time_t)(us / US_PER_SEC);
+  if (US_PER_SEC - us % US_PER_SEC <= SYNC_EDGE_SPIN_US) {
+    uint32_t t0 = micros();
+    while ((time_t)((us = syncUtcUs()) / US_PER_SEC) == sec &&
+           micros() - t0 < SYNC_EDGE_SPIN_US + 500) {
+    }
+    sec = (time_t)(us / US_PER_SEC);
+  }
+  if (sec == s_edgeSec) return;
+
+  // primeira passada do motor no novo segundo: quanto depois da virada
+  uint32_t late = (uint32_t)(us % US_PER_SEC);
+  if (s_edgeSec) {
+    s_edgeAvgUs = (s_edgeAvgUs * 15 + late) / 16;
+    if (late > s_edgeMaxUs) s_edgeMaxUs = late;
+    if (++s_edgeCount == 60) {   // máximo por janela de um minuto
+      s_edgeMaxPrev = s_edgeMaxUs;
+      s_edgeMaxUs   = 0;
+      s_edgeCount   = 0;
+    }
+  }
+  s_edgeSec = sec;
+}
+
+long syncUsToNextSecond() {
+  if (!syncActive()) return -1;
+  return (long)(US_PER_SEC - syncUtcUs() % US_PER_SEC);
+}
+
+int32_t syncOffsetUs() {
+  return s_role == SYNC_FOLLOWER ? s_errUs : 0;
+}
+
+void syncToJson(JsonObject dst) {
+  static const char* const ROLES[] = { "off", "leader", "follower" };
+  dst["role"]   = ROLES[s_role <= SYNC_FOLLOWER ? s_role : 0];
+  dst["active"] = syncActive();
+  if (s_role == SYNC_OFF) return;
+
+  dst["edge_avg_us"] = s_edgeAvgUs;
+  dst["edge_max_us"] = s_edgeMaxUs > s_edgeMaxPrev ? s_edgeMaxUs : s_edgeMaxPrev;
+
+  unsigned long nowMs = millis();
+  if (s_role == SYNC_FOLLOWER) {
+    dst["locked"]     = s_locked;
+    dst["leader"]     = s_haveLeader ? s_leader.toString() : String("");
+    dst["offset_us"]  = s_errUs;
+    dst["jitter_us"]  = s_jitterUs;
+    dst["delay_us"]   = s_delayUs;
+    dst["ppb"]        = s_model[s_modelIdx].ppb;
+    dst["steps"]      = s_steps;
+    dst["samples"]    = s_samplesOk;
+    dst["rejected"]   = s_samplesBad;
+    dst["last_s"]     = s_samplesOk ? (nowMs - s_lastRespMs) / 1000UL : 0;
+    return;
+  }
+
+  // líder: desvio de cada seguidor em relação a ele
+  JsonArray peers = dst.createNestedArray("peers");
+  for (uint8_t i = 0; i < SYNC_MAX_PEERS; i++) {
+    const Peer& q = s_peers[i];
+    if (!q.ip || nowMs - q.seenMs > SYNC_LOST_MS) continue;
+    JsonObject o = peers.createNestedObject();
+    o["ip"]       = IPAddress(q.ip).toString();
+    o["locked"]   = q.locked;
+    o["skew_us"]  = q.errUs;
+    o["delay_us"] = q.delayUs;
+    o["age_s"]    = (nowMs - q.seenMs) / 1000UL;
+  }
+}
@@ -0,0 +1,71 @@
+// clock_sync.h
+#ifndef CLOCK_SYNC_H
+#define CLOCK_SYNC_H
+
+#include "config.h"
+#include <ArduinoJson.h>
+
+// Alinhamento de relógio entre unidades na mesma LAN (PTP-lite sobre UDP).
+// O líder responde com o próprio relógio UTC (SNTP, em µs); cada seguidor
+// faz trocas de 4 marcas de tempo a cada SYNC_INTERVAL_MS:
+//   t1 envio (seguidor)   t2 recepção (líder)
+//   t3 resposta (líder)   t4 recepção (seguidor)
+//   offset = ((t2 - t1) + (t3 - t4)) / 2     atraso = (t4 - t1) - (t3 - t2)
+// Das últimas SYNC_FILTER_N amostras usa a de menor atraso (menos fila na
+// rede) e disciplina um relógio local sobre micros(): fase corrigida pela
+// metade do erro a cada amostra (adiantar salta; atrasar desacelera o
+// relógio a 1/SYNC_SLEW_DIV do ritmo até absorver a correção, sem nunca
+// voltar, para que um segundo não se repita); frequência (ppb) pela
+// inclinação do offset numa base de 16 s a 256 s.
+// Erros acima de SYNC_STEP_US saltam direto. O líder é descoberto por
+// broadcast e depois consultado por unicast; sem respostas por
+// SYNC_LOST_MS o seguidor segue no próprio modelo (holdover) e volta a
+// procurar.
+// Com o relógio ativo, halUtcNow() passa a vir dele e o loop espera a
+// virada do segundo (até SYNC_EDGE_SPIN_US) antes do motor, de modo que
+// agendamentos e regras comutam na virada do segundo comum às unidades.
+
+enum SyncRole : uint8_t {
+  SYNC_OFF = 0,
+  SYNC_LEADER,
+  SYNC_FOLLOWER
+};
+
+static constexpr uint16_t      SYNC_PORT          = 4123;
+static constexpr unsigned long SYNC_INTERVAL_MS   = 2000;
+static constexpr unsigned long SYNC_LOST_MS       = 30000;
+static constexpr uint8_t       SYNC_FILTER_N      = 8;
+static constexpr int64_t       SYNC_STEP_US       = 100000;
+static constexpr int64_t       SYNC_SLEW_DIV      = 20;      // atraso de fase a 5% (50 ms em 1 s)
+static constexpr uint32_t      SYNC_MAX_DELAY_US  = 50000;   // amostras piores são descartadas
+static constexpr int32_t       SYNC_MAX_PPB       = 500000;
+static constexpr uint32_t      SYNC_EDGE_SPIN_US  = 2000;
+static constexpr uint8_t       SYNC_MAX_PEERS     = 8;       // seguidores vistos pelo líder
+
+// Após a rede
+void syncBegin(const Config& cfg);
+
+// No loop: responde/consulta o líder e ajusta o modelo.
+void syncService();
+
+// No loop, antes do motor: se a virada do segundo está a menos de
+// SYNC_EDGE_SPIN_US, espera por ela. Também mede o atraso do motor em
+// relação à virada.
+void syncAlignSecond();
+
+// true se halUtcNow() deve usar syncUtcUs()
+bool syncActive();
+
+// µs até a próxima virada do segundo comum (-1 sem relógio ativo)
+long syncUsToNextSecond();
+
+// UTC em µs pelo relógio disciplinado (seguro fora do loop)
+int64_t syncUtcUs();
+
+// Último erro medido em relação ao líder (µs; 0 fora do papel de seguidor)
+int32_t syncOffsetUs();
+
+// Estado, erro medido e, no líder, o desvio informado por seguidor
+void syncToJson(JsonObject dst);
+
+#endif // CLOCK_SYNC_H
@@ -4,6 +4,8 @@
 #include <ArduinoJson.h>
 #include <FS.h>
 #include "time_utils.h"
+#include "hal.h"
+#include "custom_rules.h"
 
 #ifdef ESP8266
   #include <LittleFS.h>
@@ -13,6 +15,191 @@
   #define FS_INSTANCE SPIFFS
 #endif
 
+void defaultChannel(ChannelConfig& c, int pin) {
+  c.feederPin         = pin;
+  c.manualDurationSec = 5;
+  c.customSchedule[0] = '\0';
+  c.customEnabled     = false;
+  c.scheduleCount     = 0;
+  c.loadWatts         = 0;
+  c.cronCount         = 0;
+  c.exprCount         = 0;
+  c.dutyCount         = 0;
+  c.sunCount          = 0;
+}
+
+// Copia uma string opcional do JSON, mantendo o valor atual se ausente
+static void copyField(char* dst, size_t size, JsonVariant v) {
+  if (!v.is<const char*>()) return;
+  strncpy(dst, v.as<const char*>(), size - 1);
+  dst[size - 1] = '\0';
+}
+
+// Lê um canal de `src` (objeto do array "channels" ou, no formato antigo de
+// canal único, a própria raiz do documento).
+static void loadChannel(JsonVariant src, ChannelConfig& c) {
+  c.feederPin         = src["feederPin"]         | c.feederPin;
+  c.manualDurationSec = src["manualDuration"]    | c.manualDurationSec;
+  if (src.containsKey("customSchedule")) {
+    const char* ptr = src["customSchedule"];
+    strncpy(c.customSchedule, ptr, sizeof(c.customSchedule) - 1);
+    c.customSchedule[sizeof(c.customSchedule) - 1] = '\0';
+  }
+  c.customEnabled     = src["customEnabled"]     | c.customEnabled;
+  c.loadWatts         = src["watts"]             | c.loadWatts;
+
+  // expressões CH/CL, EH/EL, DC e AH/AL compiladas aqui, não a cada tick
+  int    errPos;
+  String errMsg;
+  c.cronCount = 0;
+  c.exprCount = 0;
+  c.dutyCount = 0;
+  c.sunCount  = 0;
+  if (!compileCustomRules(c, errPos, errMsg)) {
+    Serial.printf("Regras: erro na posição %d: %s\n", errPos, errMsg.c_str());
+  }
+
+  // schedules
+  c.scheduleCount = 0;
+  if (src.containsKey("schedules")) {
+    JsonArray arr = src["schedules"].as<JsonArray>();
+    for (JsonObject o : arr) {
+      if (c.scheduleCount >= MAX_SLOTS) break;
+      c.schedules[c.scheduleCount].timeSec        = o["time"]           | 0;
+      c.schedules[c.scheduleCount].durationSec    = o["duration"]       | 0;
+      c.schedules[c.scheduleCount].lastFireDay    = o["lastFireDay"]    | -1L;
+      c.scheduleCount++;
+    }
+  }
+}
+
+static void saveChannel(JsonObject dst, const ChannelConfig& c) {
+  dst["feederPin"]       = c.feederPin;
+  dst["manualDuration"]  = c.manualDurationSec;
+  dst["customSchedule"]  = c.customSchedule;
+  dst["customEnabled"]   = c.customEnabled;
+  if (c.loadWatts) dst["watts"] = c.loadWatts;
+
+  JsonArray arr = dst.createNestedArray("schedules");
+  for (int i = 0; i < c.scheduleCount && i < MAX_SLOTS; i++) {
+    JsonObject o = arr.createNestedObject();
+    o["time"]           = c.schedules[i].timeSec;
+    o["duration"]       = c.schedules[i].durationSec;
+    o["lastFireDay"]    = c.schedules[i].lastFireDay;
+  }
+}
+
+// Aplica o documento sobre cfg (campos ausentes mantêm o valor atual)
+static void applyDoc(Config& cfg, JsonDocument& doc) {
+  // carrega valores (ou mantém os que já estavam em cfg como default)
+  if (doc.containsKey("channels")) {
+    JsonArray arr = doc["channels"].as<JsonArray>();
+    int n = 0;
+    for (JsonObject o : arr) {
+      if (n >= MAX_CHANNELS) break;
+      if (n >= cfg.channelCount) defaultChannel(cfg.channels[n], -1);
+      loadChannel(o, cfg.channels[n]);
+      n++;
+    }
+    if (n > 0) cfg.channelCount = n;
+  } else {
+    // formato antigo: um único canal na raiz
+    loadChannel(doc.as<JsonVariant>(), cfg.channels[0]);
+  }
+  if (doc.containsKey("tz")) {
+    const char* ptr = doc["tz"];
+    if (tzValidate(ptr)) {
+      strncpy(cfg.tz, ptr, sizeof(cfg.tz) - 1);
+      cfg.tz[sizeof(cfg.tz) - 1] = '\0';
+    }
+  }
+  if (doc.containsKey("lat") && doc.containsKey("lon")) {
+    cfg.latitude    = doc["lat"] | 0.0f;
+    cfg.longitude   = doc["lon"] | 0.0f;
+    cfg.hasLocation = true;
+  }
+  cfg.sensorPeriodSec = doc["sensorPeriod"] | cfg.sensorPeriodSec;
+  cfg.extPin          = doc["extPin"]       | cfg.extPin;
+  cfg.extScale        = doc["extScale"]     | cfg.extScale;
+  cfg.extOffset       = doc["extOffset"]    | cfg.extOffset;
+  cfg.syncRole        = doc["syncRole"]     | cfg.syncRole;
+  cfg.beaconSec       = doc["beaconSec"]    | cfg.beaconSec;
+  cfg.beaconChannels  = doc["beaconChannels"] | cfg.beaconChannels;
+  cfg.modbusPort      = doc["modbusPort"]   | cfg.modbusPort;
+  cfg.rtcUtc          = doc["rtcUtc"]       | cfg.rtcUtc;
+  if (doc.containsKey("mqtt")) {
+    JsonObject m = doc["mqtt"];
+    MqttConfig& q = cfg.mqtt;
+    q.enabled  = m["enabled"]  | q.enabled;
+    q.port     = m["port"]     | q.port;
+    q.qos      = m["qos"]      | q.qos;
+    q.stateSec = m["stateSec"] | q.stateSec;
+    if (q.qos > 1) q.qos = 1;
+    copyField(q.host, sizeof(q.host), m["host"]);
+    copyField(q.user, sizeof(q.user), m["user"]);
+    copyField(q.pass, sizeof(q.pass), m["pass"]);
+    copyField(q.prefix, sizeof(q.prefix), m["prefix"]);
+  }
+
+  if (doc.containsKey("webhooks")) {
+    JsonArray arr = doc["webhooks"].as<JsonArray>();
+    int n = 0;
+    for (JsonVariant v : arr) {
+      if (n >= WEBHOOK_MAX_TARGETS) break;
+      copyField(cfg.webhooks[n++], WEBHOOK_URL_LEN, v);
+    }
+  }
+}
+
+static void fillDoc(JsonDocument& doc, const Config& cfg) {
+  doc["tz"]              = cfg.tz;
+  if (cfg.hasLocation) {
+    doc["lat"]           = cfg.latitude;
+    doc["lon"]           = cfg.longitude;
+  }
+  doc["sensorPeriod"]    = cfg.sensorPeriodSec;
+  doc["extPin"]          = cfg.extPin;
+  doc["extScale"]        = cfg.extScale;
+  doc["extOffset"]       = cfg.extOffset;
+  doc["syncRole"]        = cfg.syncRole;
+  doc["beaconSec"]       = cfg.beaconSec;
+  doc["beaconChannels"]  = cfg.beaconChannels;
+  doc["modbusPort"]      = cfg.modbusPort;
+  doc["rtcUtc"]          = cfg.rtcUtc;
+  if (cfg.mqtt.enabled || cfg.mqtt.host[0]) {
+    JsonObject m = doc.createNestedObject("mqtt");
+    m["enabled"]         = cfg.mqtt.enabled;
+    m["host"]            = cfg.mqtt.host;
+    m["port"]            = cfg.mqtt.port;
+    m["user"]            = cfg.mqtt.user;
+    m["pass"]            = cfg.mqtt.pass;
+    m["prefix"]          = cfg.mqtt.prefix;
+    m["qos"]             = cfg.mqtt.qos;
+    m["stateSec"]        = cfg.mqtt.stateSec;
+  }
+
+  JsonArray hooks = doc.createNestedArray("webhooks");
+  for (int i = 0; i < WEBHOOK_MAX_TARGETS; i++) hooks.add(cfg.webhooks[i]);
+
+  JsonArray chans = doc.createNestedArray("channels");
+  for (int ch = 0; ch < cfg.channelCount && ch < MAX_CHANNELS; ch++) {
+    saveChannel(chans.createNestedObject(), cfg.channels[ch]);
+  }
+}
+
+bool configFromJson(Config& cfg, const char* json, size_t len) {
+  DynamicJsonDocument doc(CONFIG_JSON_SIZE);
+  if (deserializeJson(doc, json, len)) return false;
+  applyDoc(cfg, doc);
+  return true;
+}
+
+size_t configToJson(const Config& cfg, Print& out) {
+  DynamicJsonDocument doc(CONFIG_JSON_SIZE);
+  fillDoc(doc, cfg);
+  return serializeJson(doc, out);
+}
+
 bool loadConfig(Config& cfg) {
   // monta o sistema de arquivos (formatando se necessário)
 #ifdef ESP8266
@@ -38,7 +225,7 @@ bool loadConfig(Config& cfg) {
     return false;
   }
 
-  DynamicJsonDocument doc(2048);
+  DynamicJsonDocument doc(CONFIG_JSON_SIZE);
   DeserializationError err = deserializeJson(doc, file);
   file.close();
   if (err) {
@@ -49,38 +236,21 @@ bool loadConfig(Config& cfg) {
     return false;
   }
 
-  // carrega valores (ou mantém os que já estavam em cfg como default)
-  cfg.feederPin         = doc["feederPin"]         | cfg.feederPin;
-  cfg.manualDurationSec = doc["manualDuration"]    | cfg.manualDurationSec;
-  if (doc.containsKey("customSchedule")) {
-    const char* ptr = doc["customSchedule"];
-    strncpy(cfg.customSchedule, ptr, sizeof(cfg.customSchedule) - 1);
-    cfg.customSchedule[sizeof(cfg.customSchedule) - 1] = '\0';
-  }
-  cfg.customEnabled     = doc["customEnabled"]     | cfg.customEnabled;
+  applyDoc(cfg, doc);
 
-  // schedules
-  cfg.scheduleCount = 0;
-  if (doc.containsKey("schedules")) {
-    JsonArray arr = doc["schedules"].as<JsonArray>();
-    for (JsonObject o : arr) {
-      if (cfg.scheduleCount >= MAX_SLOTS) break;
-      cfg.schedules[cfg.scheduleCount].timeSec        = o["time"]           | 0;
-      cfg.schedules[cfg.scheduleCount].durationSec    = o["duration"]       | 0;
-      cfg.schedules[cfg.scheduleCount].lastTriggerDay = o["lastTriggerDay"] | -1;
-      cfg.scheduleCount++;
-    }
+  Serial.printf("Config carregada: canais=%d, tz=%s\n", cfg.channelCount, cfg.tz);
+  for (int ch = 0; ch < cfg.channelCount; ch++) {
+    const ChannelConfig& c = cfg.channels[ch];
+    Serial.printf("  CH%d: pin=%d, manualDur=%lus, regrasAtivas=%d, slots=%d\n",
+                  ch, c.feederPin, c.manualDurationSec, c.customEnabled, c.scheduleCount);
   }
-
-  Serial.printf("Config carregada: pin=%d, manualDur=%lus, regrasAtivas=%d, slots=%d\n",
-                cfg.feederPin,
-                cfg.manualDurationSec,
-                cfg.customEnabled,
-                cfg.scheduleCount);
   return true;
 }
 
 bool saveConfig(const Config& cfg) {
+  // simulação roda sobre uma cópia da config: nada vai para o flash
+  if (!halPersistAllowed()) return true;
+
 #ifdef ESP8266
   if (!FS_INSTANCE.begin()) {
     Serial.println("Falha ao montar FS (ESP8266)");
@@ -93,19 +263,8 @@ bool saveConfig(const Config& cfg) {
   }
 #endif
 
-  DynamicJsonDocument doc(2048);
-  doc["feederPin"]       = cfg.feederPin;
-  doc["manualDuration"]  = cfg.manualDurationSec;
-  doc["customSchedule"]  = cfg.customSchedule;
-  doc["customEnabled"]   = cfg.customEnabled;
-
-  JsonArray arr = doc.createNestedArray("schedules");
-  for (int i = 0; i < cfg.scheduleCount && i < MAX_SLOTS; i++) {
-    JsonObject o = arr.createNestedObject();
-    o["time"]           = cfg.schedules[i].timeSec;
-    o["duration"]       = cfg.schedules[i].durationSec;
-    o["lastTriggerDay"] = cfg.schedules[i].lastTriggerDay;
-  }
+  DynamicJsonDocument doc(CONFIG_JSON_SIZE);
+  fillDoc(doc, cfg);
 
   File file = FS_INSTANCE.open(CONFIG_PATH, "w");
   if (!file) {
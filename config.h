@@ -4,33 +4,111 @@
 
 #include <ArduinoJson.h>
 #include <FS.h>
+#include "tz_rules.h"
+#include "cron.h"
+#include "rule_vm.h"
+#include "duty_cycle.h"
+#include "sun_times.h"
 
 // ===== Constantes Globais =====
 static constexpr char   CONFIG_PATH[]       = "/config.json";
 static constexpr int    MAX_SLOTS           = 10;
-static constexpr long   GMT_OFFSET_SEC      = -4L * 3600L;  // UTC–4
-static constexpr int    DAYLIGHT_OFFSET_SEC = 0;            // Horário de verão
+static constexpr int    MAX_CRON_RULES      = 8;            // CH(...)/CL(...) por canal
+static constexpr int    MAX_EXPR_RULES      = 4;            // EH(...)/EL(...) por canal
+static constexpr int    MAX_DUTY_PROGRAMS   = 2;            // DC(...) por canal
+static constexpr int    MAX_SUN_RULES       = 4;            // AH(...)/AL(...) por canal
+static constexpr int    WEBHOOK_MAX_TARGETS = 2;            // destinos de webhook
+static constexpr int    WEBHOOK_URL_LEN     = 96;
+static constexpr char   DEFAULT_TZ[]        = "<-04>4";     // TZ POSIX: UTC–4, sem horário de verão
 static constexpr int    FEED_COOLDOWN       = 10;           // s entre ativações
 static constexpr int    MAX_FEED_DURATION   = 300;          // s (5 min)
+static constexpr int    SCHEDULE_CATCHUP_SEC = 120;         // s recuperados após travas/saltos curtos
+
+// ===== Canais de saída (relés) =====
+#if defined(SONOFF_BASIC)
+static constexpr int    MAX_CHANNELS        = 1;
+#elif defined(ESP8266)
+static constexpr int    MAX_CHANNELS        = 4;
+#else
+static constexpr int    MAX_CHANNELS        = 8;            // placas de 4/8 relés
+#endif
+static constexpr size_t CONFIG_JSON_SIZE    = 512 + MAX_CHANNELS * 1536;
 
 // ===== Estruturas de Configuração =====
 struct Schedule {
-  int timeSec;        // segundos desde meia-noite
-  int durationSec;    // duração da ativação em segundos
-  int lastTriggerDay; // dia do ano do último acionamento
+  int  timeSec;       // segundos desde meia-noite
+  int  durationSec;   // duração da ativação em segundos
+  long lastFireDay;   // dia-época local (dias desde 1970-01-01) do último acionamento
 };
 
-struct Config {
-  int           feederPin;            // pino de saída
+// Regra AH(sunset-00:20) / AL(sunrise+01:00)
+struct SunRule {
+  int32_t offsetSec;     // deslocamento em relação ao evento
+  uint8_t event;         // SunEvent
+  bool    on;            // AH (liga) ou AL (desliga)
+};
+
+struct ChannelConfig {
+  int           feederPin;            // pino de saída (-1 = não atribuído)
   unsigned long manualDurationSec;    // duração manual padrão (s)
   char          customSchedule[512];  // regras avançadas em texto
   bool          customEnabled;        // se regras avançadas estão ativas
   Schedule      schedules[MAX_SLOTS]; // lista de agendamentos
   int           scheduleCount;        // total de agendamentos válidos
+  uint16_t      loadWatts;            // carga ligada à saída (W, 0 = não informada)
+
+  // Derivado de customSchedule ao salvar/carregar (não persistido)
+  CronSpec      cron[MAX_CRON_RULES]; // expressões CH/CL compiladas
+  uint8_t       cronCount;
+  ExprRule      expr[MAX_EXPR_RULES]; // condições EH/EL em bytecode
+  uint8_t       exprCount;
+  DutyProgram   duty[MAX_DUTY_PROGRAMS]; // programas cíclicos DC
+  uint8_t       dutyCount;
+  SunRule       sun[MAX_SUN_RULES];   // AH/AL relativos ao nascer/pôr do sol
+  uint8_t       sunCount;
+};
+
+// Cliente MQTT (ver mqtt.h)
+struct MqttConfig {
+  bool          enabled;
+  char          host[64];
+  uint16_t      port;
+  char          user[32];
+  char          pass[32];
+  char          prefix[48];               // tópico base ("" = temporizador/<MAC>)
+  uint8_t       qos;                      // 0 ou 1 (publicações e assinatura)
+  uint16_t      stateSec;                 // estado compacto periódico (0 = desligado)
+};
+
+struct Config {
+  int           channelCount;             // canais em uso (1..MAX_CHANNELS)
+  ChannelConfig channels[MAX_CHANNELS];
+  char          tz[TZ_MAX_LEN];           // fuso horário (string TZ POSIX)
+  bool          hasLocation;              // latitude/longitude configuradas
+  float         latitude;                 // graus, sul negativo
+  float         longitude;                // graus, oeste negativo
+  uint16_t      sensorPeriodSec;          // intervalo de amostragem dos sensores
+  int           extPin;                   // entrada analógica (-1 = desativada)
+  float         extScale;                 // ext = leitura ADC * extScale + extOffset
+  float         extOffset;
+  MqttConfig    mqtt;
+  char          webhooks[WEBHOOK_MAX_TARGETS][WEBHOOK_URL_LEN];   // "http://host[:porta]/caminho" ("" = livre)
+  uint8_t       syncRole;                 // SyncRole (clock_sync.h)
+  uint16_t      beaconSec;                // intervalo do beacon multicast (0 = desligado)
+  uint8_t       beaconChannels;           // canais incluídos no beacon
+  uint16_t      modbusPort;               // Modbus TCP (0 = desligado)
+  bool          rtcUtc;                   // RTC já em UTC (migração da hora local feita)
 };
 
 // ===== Protótipos =====
+// Preenche os valores padrão de um canal.
+void defaultChannel(ChannelConfig& c, int pin);
+
 bool loadConfig(Config& cfg);
 bool saveConfig(const Config& cfg);
 
+// O mesmo JSON de config.json, sem passar pelo FS (usado por bench.cpp)
+bool   configFromJson(Config& cfg, const char* json, size_t len);
+size_t configToJson(const Config& cfg, Print& out);
+
 #endif // CONFIG_H
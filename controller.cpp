@@ -0,0 +1,133 @@
+// controller.cpp
+
+#include "controller.h"
+#include "time_utils.h"
+#include "hal.h"
+#include "logbuf.h"
+#include "status_led.h"
+#include "output.h"
+
+// Configuração definida em main.cpp
+extern Config        cfg;
+
+static constexpr int BUTTON_CHANNEL = 0;
+
+// Pendências do botão para o loop (produtor: interrupção/timer; consumidor: loop)
+struct CtlPending {
+  ButtonEvent ev;
+  int8_t      output;   // 1 ligou, 0 desligou, -1 sem mudança
+};
+
+static constexpr uint8_t PENDING_QUEUE = 8;   // potência de 2
+static volatile CtlPending s_pending[PENDING_QUEUE];
+static volatile uint8_t    s_pendHead = 0;
+static volatile uint8_t    s_pendTail = 0;
+
+// LED: "regras armadas" quando qualquer canal usa regras customizadas
+static void updateRulesLed() {
+  bool any = false;
+  for (int ch = 0; ch < cfg.channelCount; ch++) any |= cfg.channels[ch].customEnabled;
+  ledSetFlag(LED_F_RULES, any);
+}
+
+CtlResult ctlFeedNow(int ch, const char* origin) {
+  if (cfg.channels[ch].feederPin < 0)     return CTL_NO_PIN;
+  if (channelActive(ch))                  return CTL_ACTIVE;
+  if (outputInCooldown(ch, halMillis()))  return CTL_COOLDOWN;
+  logEvent(LOG_FEED_NOW, ch, 0, 0, origin);
+  startOutput(cfg, ch, cfg.channels[ch].manualDurationSec, true);
+  return CTL_OK;
+}
+
+CtlResult ctlStop(int ch, const char* origin) {
+  if (!channelActive(ch)) return CTL_IDLE;
+  logEvent(LOG_STOP_NOW, ch, 0, 0, origin);
+  stopOutput(cfg, ch);
+  return CTL_OK;
+}
+
+bool ctlToggleRules(int ch, const char* origin) {
+  ChannelConfig& c = cfg.channels[ch];
+  c.customEnabled = !c.customEnabled;
+  updateRulesLed();
+  saveConfig(cfg);
+  logEvent(c.customEnabled ? LOG_RULES_ON : LOG_RULES_OFF, ch, 0, 0, origin);
+  return c.customEnabled;
+}
+
+int ctlSetSchedules(int ch, String list, const char* origin) {
+  ChannelConfig& c = cfg.channels[ch];
+  c.scheduleCount = 0;
+  for (int i = 0; i < MAX_SLOTS && list.length(); i++) {
+    int comma = list.indexOf(',');
+    String tok = comma > 0 ? list.substring(0, comma) : list;
+    int sep = tok.indexOf('|');
+    if (sep > 0) {
+      int t = parseHHMMSS(tok.substring(0, sep));
+      int d = parseHHMMSS(tok.substring(sep + 1));
+      if (t >= 0 && d > 0 && d <= MAX_FEED_DURATION) {
+        c.schedules[c.scheduleCount++] = { t, d, -1 };
+      }
+    }
+    if (comma < 0) break;
+    list = list.substring(comma + 1);
+  }
+  saveConfig(cfg);
+  logEvent(LOG_SCHEDULES_SAVED, ch, c.scheduleCount, 0, origin);
+  return c.scheduleCount;
+}
+
+void IRAM_ATTR ctlOnButton(ButtonEvent ev) {
+  // durante /simulate o estado global é o da simulação: ignora o gesto
+  if (halSimulating()) return;
+
+  // reserva a pendência antes de mexer no relé: sem vaga o gesto é
+  // descartado inteiro (um relé trocado sem outputNote() ficaria com o
+  // bit de isrMask preso e sem desligamento automático)
+  uint8_t h    = s_pendHead;
+  uint8_t next = (h + 1) & (PENDING_QUEUE - 1);
+  if (next == s_pendTail) return;
+
+  const int ch = BUTTON_CHANNEL;
+  int8_t out = -1;
+  switch (ev) {
+    case BTN_SHORT:
+      if (channelActive(ch)) out = outputOffIsr(cfg, ch) ? 0 : -1;
+      else                   out = outputOnIsr(cfg, ch, cfg.channels[ch].manualDurationSec) ? 1 : -1;
+      break;
+    case BTN_DOUBLE:
+      break;   // config: alternada em ctlService()
+    case BTN_LONG:
+      out = outputOffIsr(cfg, ch) ? 0 : -1;
+      break;
+  }
+
+  s_pending[h].ev     = ev;
+  s_pending[h].output = out;
+  s_pendHead = next;
+}
+
+void ctlService() {
+  while (s_pendTail != s_pendHead) {
+    uint8_t     t   = s_pendTail;
+    ButtonEvent ev  = s_pending[t].ev;
+    int8_t      out = s_pending[t].output;
+    s_pendTail = (t + 1) & (PENDING_QUEUE - 1);
+
+    ChannelConfig& c = cfg.channels[BUTTON_CHANNEL];
+    if (out >= 0) outputNote(BUTTON_CHANNEL, out == 1, out == 1);
+    if (ev == BTN_DOUBLE) {
+      c.customEnabled = !c.customEnabled;
+      updateRulesLed();
+      saveConfig(cfg);
+    }
+
+    const char* name = ev == BTN_SHORT ? "curto" : (ev == BTN_DOUBLE ? "duplo" : "longo");
+    LogId id;
+    if      (out == 1) id = LOG_BUTTON_ON;
+    else if (out == 0) id = LOG_BUTTON_OFF;
+    else if (ev == BTN_DOUBLE) id = c.customEnabled ? LOG_BUTTON_RULES_ON : LOG_BUTTON_RULES_OFF;
+    else               id = LOG_BUTTON_NOOP;
+    logEvent(id, BUTTON_CHANNEL, 0, 0, name);
+  }
+}
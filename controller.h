@@ -0,0 +1,39 @@
+// controller.h
+#ifndef CONTROLLER_H
+#define CONTROLLER_H
+
+#include "config.h"
+#include "button.h"
+
+// Ações do controlador compartilhadas pelos handlers HTTP e pelo botão local.
+enum CtlResult {
+  CTL_OK = 0,
+  CTL_ACTIVE,     // saída já ativa
+  CTL_COOLDOWN,   // dentro do intervalo FEED_COOLDOWN
+  CTL_IDLE,       // nenhuma saída ativa para desligar
+  CTL_NO_PIN      // canal sem pino atribuído
+};
+
+// Contexto do loop (registram log e persistem). `ch` é o canal (0..
+// cfg.channelCount-1, já validado pelo chamador); `origin` entra no log,
+// ex.: "manual", "botão".
+CtlResult ctlFeedNow(int ch, const char* origin);
+CtlResult ctlStop(int ch, const char* origin);
+bool      ctlToggleRules(int ch, const char* origin);
+// Substitui os agendamentos por "HH:MM:SS|HH:MM:SS,..." (horário|duração);
+// itens inválidos são ignorados. Retorna quantos foram salvos.
+int       ctlSetSchedules(int ch, String list, const char* origin);
+
+// Gesto do botão, chamado fora do loop (ESP8266: interrupção do timer1, em
+// IRAM; ESP32: task do Ticker): aciona ou desliga a saída do canal 0 na
+// hora, só com pino e máscaras (outputOnIsr/outputOffIsr). Registro da
+// mudança, log, config e LED ficam na fila para ctlService().
+//   curto  -> liga por manualDurationSec (ou desliga, se ativa)
+//   duplo  -> alterna regras customizadas (em ctlService)
+//   longo  -> desliga a saída
+void ctlOnButton(ButtonEvent ev);
+
+// Chamado no loop: completa as ações do botão (outputNote, regras, log).
+void ctlService();
+
+#endif // CONTROLLER_H
@@ -0,0 +1,162 @@
+// cron.cpp
+
+#include "cron.h"
+#include "time_utils.h"
+
+struct CronField {
+  uint8_t lo, hi;
+};
+
+static const CronField FIELDS[5] = {
+  { 0, 59 },   // minuto
+  { 0, 23 },   // hora
+  { 1, 31 },   // dia do mês
+  { 1, 12 },   // mês
+  { 0, 7 }     // dia da semana (7 = domingo)
+};
+
+static int readNum(const char*& p) {
+  if (*p < '0' || *p > '9') return -1;
+  int v = 0;
+  while (*p >= '0' && *p <= '9' && v < 1000) v = v * 10 + (*p++ - '0');
+  return v;
+}
+
+// Lê um campo (lista de itens) em `mask`; `star` indica "*" puro.
+static bool parseField(const char* base, const char*& p, const CronField& f,
+                       uint64_t& mask, bool& star, int& errPos, const char*& errMsg) {
+  mask = 0;
+  star = false;
+  for (;;) {
+    const char* itemStart = p;
+    int lo, hi, step = 1;
+    if (*p == '*') {
+      p++;
+      lo = f.lo;
+      hi = f.hi;
+      star = (*p != '/');
+    } else {
+      lo = readNum(p);
+      if (lo < 0) { errPos = p - base; errMsg = "número esperado"; return false; }
+      hi = lo;
+      if (*p == '-') {
+        p++;
+        hi = readNum(p);
+        if (hi < 0) { errPos = p - base; errMsg = "fim do intervalo esperado"; return false; }
+      }
+    }
+    if (*p == '/') {
+      p++;
+      step = readNum(p);
+      if (step <= 0) { errPos = p - base; errMsg = "passo inválido"; return false; }
+    }
+    if (lo < f.lo || hi > f.hi || lo > hi) {
+      errPos = itemStart - base;
+      errMsg = "valor fora da faixa";
+      return false;
+    }
+    for (int v = lo; v <= hi; v += step) mask |= (uint64_t)1 << v;
+
+    if (*p != ',') break;
+    p++;
+    star = false;
+  }
+  return true;
+}
+
+bool cronParse(const char* expr, CronSpec& out, int& errPos, const char*& errMsg) {
+  const char* p = expr;
+  uint64_t    masks[5];
+  bool        stars[5];
+
+  for (int i = 0; i < 5; i++) {
+    while (*p == ' ') p++;
+    if (*p == '\0' || *p == ')') {
+      errPos = p - expr;
+      errMsg = "faltam campos (min hora dia mês semana)";
+      return false;
+    }
+    if (!parseField(expr, p, FIELDS[i], masks[i], stars[i], errPos, errMsg)) return false;
+    if (*p != ' ' && *p != ')' && *p != '\0') {
+      errPos = p - expr;
+      errMsg = "caractere inesperado";
+      return false;
+    }
+  }
+  while (*p == ' ') p++;
+  if (*p != ')' && *p != '\0') {
+    errPos = p - expr;
+    errMsg = "campos demais";
+    return false;
+  }
+
+  out.minutes  = masks[0];
+  out.hours    = (uint32_t)masks[1];
+  out.days     = (uint32_t)masks[2];
+  out.months   = (uint16_t)masks[3];
+  out.weekdays = (uint8_t)((masks[4] | (masks[4] >> 7)) & 0x7F);   // 7 -> 0
+  out.flags    = (stars[2] ? CRON_F_DOM_ANY : 0)
+               | (stars[4] ? CRON_F_DOW_ANY : 0);
+  return true;
+}
+
+// dia (já no mês permitido) casa com dia do mês / semana?
+static bool dayMatches(const CronSpec& c, long epochDay, int dom) {
+  bool domOk = (c.days >> dom) & 1UL;
+  bool dowOk = (c.weekdays >> ((epochDay + 4) % 7)) & 1U;   // 1970-01-01 = quinta
+  bool domAny = c.flags & CRON_F_DOM_ANY;
+  bool dowAny = c.flags & CRON_F_DOW_ANY;
+  if (domAny && dowAny) return true;
+  if (domAny)           return dowOk;
+  if (dowAny)           return domOk;
+  return domOk || dowOk;
+}
+
+bool cronMatches(const CronSpec& c, time_t local) {
+  long day = localEpochDay(local);
+  int  sod = localSecOfDay(local);
+  if (!((c.minutes >> ((sod / 60) % 60)) & 1ULL)) return false;
+  if (!((c.hours   >> (sod / 3600)) & 1UL))       return false;
+
+  int y, m, d;
+  civilFromDays(day, y, m, d);
+  if (!((c.months >> m) & 1U)) return false;
+  return dayMatches(c, day, d);
+}
+
+time_t cronNext(const CronSpec& c, time_t local) {
+  time_t t   = (local / 60 + 1) * 60;
+  long   day = localEpochDay(t);
+  int    sod = localSecOfDay(t);
+  long   end = day + CRON_NEXT_MAX_DAYS;
+  if (!c.minutes || !c.hours || !c.months) return 0;
+
+  while (day < end) {
+    int y, m, d;
+    civilFromDays(day, y, m, d);
+
+    // mês fora da máscara: salta para o dia 1 do próximo mês permitido
+    if (!((c.months >> m) & 1U)) {
+      uint16_t later = c.months & (uint16_t)(0xFFFEU << m);
+      if (later) day = daysFromCivil(y, __builtin_ctz(later), 1);
+      else       day = daysFromCivil(y + 1, __builtin_ctz(c.months), 1);
+      sod = 0;
+      continue;
+    }
+
+    if (dayMatches(c, day, d)) {
+      int h  = sod / 3600;
+      int mi = (sod % 3600) / 60;
+      uint32_t hm = c.hours & (0xFFFFFFFFUL << h);
+      while (hm) {
+        int      hh = __builtin_ctz(hm);
+        uint64_t mm = c.minutes & (hh == h ? (~0ULL << mi) : ~0ULL);
+        if (mm) return (time_t)day * 86400L + hh * 3600L + __builtin_ctzll(mm) * 60L;
+        hm &= hm - 1;
+      }
+    }
+    day++;
+    sod = 0;
+  }
+  return 0;
+}
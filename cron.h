@@ -0,0 +1,43 @@
+// cron.h
+#ifndef CRON_H
+#define CRON_H
+
+#include <Arduino.h>
+#include <time.h>
+
+// Expressão estilo cron "min hora dia mês semana", compilada uma vez (ao
+// salvar as regras) em máscaras de bits. Cada campo aceita `*`, `N`, `A-B`,
+// `*/P`, `A-B/P` e listas separadas por vírgula. Semana: 0–7 (0 e 7 =
+// domingo). Como no cron, se dia e semana forem ambos restritos, basta um
+// deles casar.
+//   */15 6-17 * * 1-5   -> a cada 15 min, 06:00–17:45, seg–sex
+
+enum CronFlag : uint8_t {
+  CRON_F_DOM_ANY = 1 << 0,   // dia do mês = *
+  CRON_F_DOW_ANY = 1 << 1,   // dia da semana = *
+  CRON_F_ON      = 1 << 2    // regra liga (CH) em vez de desligar (CL)
+};
+
+struct CronSpec {
+  uint64_t minutes;    // bits 0..59
+  uint32_t hours;      // bits 0..23
+  uint32_t days;       // bits 1..31
+  uint16_t months;     // bits 1..12
+  uint8_t  weekdays;   // bits 0..6 (0 = domingo)
+  uint8_t  flags;      // CronFlag
+};
+
+// Compila `expr` (até o primeiro ')' ou fim da string); CRON_F_ON fica a
+// cargo do chamador. Em caso de erro retorna false com a posição (relativa
+// a expr) e uma descrição curta.
+bool cronParse(const char* expr, CronSpec& out, int& errPos, const char*& errMsg);
+
+// `local` cai num minuto que casa com a expressão? Só testes de bits.
+bool cronMatches(const CronSpec& c, time_t local);
+
+// Início do primeiro minuto após `local` que casa, por varredura de bits
+// (meses, horas e minutos); 0 se nenhum nos próximos CRON_NEXT_MAX_DAYS.
+static constexpr long CRON_NEXT_MAX_DAYS = 366L * 8;
+time_t cronNext(const CronSpec& c, time_t local);
+
+#endif // CRON_H
@@ -2,12 +2,18 @@
 
 #include "custom_rules.h"
 #include "time_utils.h"
+#include "tz_rules.h"
+#include "hal.h"
+#include "output.h"
+#include "metrics.h"
+#include "sun_times.h"
+#include "exceptions.h"
+#include "sensors.h"
+#include "events.h"
+#include "logbuf.h"
 #include <TimeLib.h>
 
-extern String   eventLog;
-extern bool     isOutputActive;
-extern time_t   ruleHighDT;
-extern time_t   ruleLowDT;
+time_t ruleLastCheck = 0;
 
 // Obtém número de segundos de IH/IL dentro da string de regras
 static int getRuleTime(const String& rules, const String& prefix) {
@@ -17,38 +23,214 @@ static int getRuleTime(const String& rules, const String& prefix) {
   return parseHHMMSS(t);
 }
 
-String checkCustomRules(const Config& cfg,
-                        int pin,
-                        std::function<void(bool relayVal, unsigned long durationSec)> onAction) {
-  if (!cfg.customEnabled) return "";
-  if (!onAction)          return "";
+// "sunrise|sunset[+-HH:MM[:SS]]" até ')'
+static bool parseSunRule(const char* src, SunRule& out, int& used,
+                         int& errPos, const char*& errMsg) {
+  const char* p = src;
+  if      (strncmp(p, "sunrise", 7) == 0) { out.event = SUN_RISE; p += 7; }
+  else if (strncmp(p, "sunset", 6) == 0)  { out.event = SUN_SET;  p += 6; }
+  else { errPos = 0; errMsg = "use sunrise ou sunset"; return false; }
 
-  time_t nowT = now();
-  static time_t lastCheck = 0;
-  if (nowT == lastCheck) return "";
-  lastCheck = nowT;
+  out.offsetSec = 0;
+  if (*p == '+' || *p == '-') {
+    int sign = (*p == '-') ? -1 : 1;
+    p++;
+    int h, m, s = 0, n = 0;
+    if (sscanf(p, "%2d:%2d%n", &h, &m, &n) != 2) {
+      errPos = p - src; errMsg = "deslocamento HH:MM esperado"; return false;
+    }
+    p += n;
+    if (*p == ':') {
+      if (sscanf(p + 1, "%2d%n", &s, &n) != 1) {
+        errPos = p - src; errMsg = "segundos inválidos"; return false;
+      }
+      p += 1 + n;
+    }
+    if (h > 12 || m > 59 || s > 59) {
+      errPos = p - src; errMsg = "deslocamento fora da faixa (máx. 12 h)"; return false;
+    }
+    out.offsetSec = sign * (h * 3600 + m * 60 + s);
+  }
+  if (*p != ')') { errPos = p - src; errMsg = "')' esperado"; return false; }
+  used = p - src;
+  return true;
+}
 
-  // monta "YYYY-MM-DD HH:MM"
-  char dtBuf[17];
-  snprintf(dtBuf, sizeof(dtBuf), "%04d-%02d-%02d %02d:%02d",
-           year(nowT), month(nowT), day(nowT),
-           hour(nowT), minute(nowT));
-  String dtStr(dtBuf);
+bool compileCustomRules(ChannelConfig& c, int& errPos, String& errMsg) {
+  const char* rules = c.customSchedule;
+  CronSpec    cron[MAX_CRON_RULES];
+  ExprRule    expr[MAX_EXPR_RULES];
+  DutyProgram duty[MAX_DUTY_PROGRAMS];
+  SunRule     sun[MAX_SUN_RULES];
+  uint8_t     n     = 0;
+  uint8_t     ne    = 0;
+  uint8_t     nd    = 0;
+  uint8_t     ns    = 0;
+
+  // CH(cron) / CL(cron)
+  for (const char* p = rules; (p = strchr(p, 'C')) != nullptr; p++) {
+    if ((p[1] != 'H' && p[1] != 'L') || p[2] != '(') continue;
+    if (n >= MAX_CRON_RULES) {
+      errPos = p - rules;
+      errMsg = "máximo de " + String(MAX_CRON_RULES) + " expressões CH/CL";
+      return false;
+    }
+    const char* expr  = p + 3;
+    const char* close = strchr(expr, ')');
+    if (!close) {
+      errPos = p - rules;
+      errMsg = "')' ausente";
+      return false;
+    }
+    int         pos;
+    const char* msg;
+    CronSpec    spec;
+    if (!cronParse(expr, spec, pos, msg)) {
+      errPos = (expr - rules) + pos;
+      errMsg = msg;
+      return false;
+    }
+    if (p[1] == 'H') spec.flags |= CRON_F_ON;
+    cron[n++] = spec;
+    p = close;
+  }
+
+  // EH(expr) / EL(expr)
+  for (const char* p = rules; (p = strchr(p, 'E')) != nullptr; p++) {
+    if ((p[1] != 'H' && p[1] != 'L') || p[2] != '(') continue;
+    if (ne >= MAX_EXPR_RULES) {
+      errPos = p - rules;
+      errMsg = "máximo de " + String(MAX_EXPR_RULES) + " expressões EH/EL";
+      return false;
+    }
+    const char* src = p + 3;
+    int         used, pos;
+    const char* msg;
+    if (!exprCompile(src, expr[ne], used, pos, msg)) {
+      errPos = (src - rules) + pos;
+      errMsg = msg;
+      return false;
+    }
+    if (src[used] != ')') {
+      errPos = (src - rules) + used;
+      errMsg = "')' ausente";
+      return false;
+    }
+    expr[ne].flags = (p[1] == 'H') ? EXPR_F_ON : 0;
+    ne++;
+    p = src + used;
+  }
+
+  // DC(on/off...[@âncora][ janela])
+  for (const char* p = rules; (p = strstr(p, "DC(")) != nullptr; p++) {
+    if (nd >= MAX_DUTY_PROGRAMS) {
+      errPos = p - rules;
+      errMsg = "máximo de " + String(MAX_DUTY_PROGRAMS) + " programas DC";
+      return false;
+    }
+    const char* src = p + 3;
+    int         used, pos;
+    const char* msg;
+    if (!dutyParse(src, duty[nd], used, pos, msg)) {
+      errPos = (src - rules) + pos;
+      errMsg = msg;
+      return false;
+    }
+    if (src[used] != ')') {
+      errPos = (src - rules) + used;
+      errMsg = "')' ausente";
+      return false;
+    }
+    nd++;
+    p = src + used;
+  }
+
+  // AH(sunset-00:20) / AL(sunrise+01:00)
+  for (const char* p = rules; (p = strchr(p, 'A')) != nullptr; p++) {
+    if ((p[1] != 'H' && p[1] != 'L') || p[2] != '(') continue;
+    if (ns >= MAX_SUN_RULES) {
+      errPos = p - rules;
+      errMsg = "máximo de " + String(MAX_SUN_RULES) + " regras AH/AL";
+      return false;
+    }
+    const char* src = p + 3;
+    int         used, pos;
+    const char* msg;
+    if (!parseSunRule(src, sun[ns], used, pos, msg)) {
+      errPos = (src - rules) + pos;
+      errMsg = msg;
+      return false;
+    }
+    sun[ns].on = (p[1] == 'H');
+    ns++;
+    p = src + used;
+  }
+
+  memcpy(c.cron, cron, n * sizeof(CronSpec));
+  memcpy(c.expr, expr, ne * sizeof(ExprRule));
+  memcpy(c.duty, duty, nd * sizeof(DutyProgram));
+  memcpy(c.sun,  sun,  ns * sizeof(SunRule));
+  c.cronCount = n;
+  c.exprCount = ne;
+  c.dutyCount = nd;
+  c.sunCount  = ns;
+  return true;
+}
+
+time_t nextCronTrigger(const ChannelConfig& c, time_t local, bool on) {
+  time_t best = 0;
+  for (int i = 0; i < c.cronCount; i++) {
+    if (((c.cron[i].flags & CRON_F_ON) != 0) != on) continue;
+    time_t t = cronNext(c.cron[i], local);
+    if (t && (!best || t < best)) best = t;
+  }
+  return best;
+}
 
-  String rules = cfg.customSchedule;
+// Fase DC aplicada ao canal (ver checkChannelRules)
+static void dcCommit(int ch, bool on) {
+  uint32_t bit = 1UL << ch;
+  chState.dcPrimed |= bit;
+  if (on) chState.dcState |= bit;
+  else    chState.dcState &= ~bit;
+}
+
+// Avalia as regras de um canal no segundo (utcT, nowT); newMinute indica o
+// primeiro tick de um minuto local (expressões CH/CL) e (winFromUtc, utcT]
+// é a janela coberta pelo tick (AH/AL). `vars` chega com os campos de
+// data/hora e recebe aqui os do canal (expressões EH/EL).
+static String checkChannelRules(const ChannelConfig& c,
+                                int ch,
+                                time_t utcT,
+                                time_t nowT,
+                                time_t winFromUtc,
+                                bool newMinute,
+                                int32_t* vars,
+                                const String& dtStr,
+                                const String& hmsStr,
+                                std::function<bool(int, bool, unsigned long)>& onAction) {
+  int    pin = c.feederPin;
+  String rules = c.customSchedule;
   String event;
   bool desiredState = false;
 
+  // Programas DC: estado calculado a cada tick por aritmética modular, mas
+  // só age quando o estado calculado muda (ou na primeira avaliação), para
+  // não brigar com acionamentos manuais entre as fases. A borda só é
+  // consumida (dcCommit) quando a regra DC é a escolhida no tick: se uma
+  // regra de prioridade maior dispara ou a troca é recusada, fica pendente.
+  bool dcEdge = false, dcOn = false, dcEvent = false;
+  if (c.dutyCount) {
+    for (int i = 0; i < c.dutyCount; i++) dcOn |= dutyStateAt(c.duty[i], nowT, nullptr);
+    uint32_t bit = 1UL << ch;
+    dcEdge = !(chState.dcPrimed & bit) || dcOn != ((chState.dcState & bit) != 0);
+  }
+
   // 1) Specific SH / SL
   if      (rules.indexOf("SH" + dtStr) != -1) { event = "SH" + dtStr; desiredState = true; }
   else if (rules.indexOf("SL" + dtStr) != -1) { event = "SL" + dtStr; desiredState = false; }
   else {
     // 2) Diário DH / DL (HH:MM:SS)
-    int nowSec = getCurrentTimeInSec();
-    char hmsBuf[9];
-    formatHHMMSS(nowSec, hmsBuf, sizeof(hmsBuf));
-    String hmsStr(hmsBuf);
-
     if      (rules.indexOf("DH" + hmsStr) != -1) { event = "DH" + hmsStr; desiredState = true; }
     else if (rules.indexOf("DL" + hmsStr) != -1) { event = "DL" + hmsStr; desiredState = false; }
     else {
@@ -57,20 +239,85 @@ String checkCustomRules(const Config& cfg,
       if      (rules.indexOf("WH" + dow) != -1) { event = "WH" + dow; desiredState = true; }
       else if (rules.indexOf("WL" + dow) != -1) { event = "WL" + dow; desiredState = false; }
       else {
-        int pinState = digitalRead(pin);
-        // 4) Intervalo IH: se HIGH há >= IH segundos
-        if (pinState == HIGH && ruleHighDT != 0) {
+        // 4) Cron CH(...) / CL(...): máscaras compiladas, uma vez por minuto
+        if (newMinute) {
+          for (int i = 0; i < c.cronCount; i++) {
+            if (!cronMatches(c.cron[i], nowT)) continue;
+            desiredState = c.cron[i].flags & CRON_F_ON;
+            event = String(desiredState ? "CH#" : "CL#") + String(i);
+            break;
+          }
+        }
+        // 5) Nascer/pôr do sol AH(...) / AL(...): consulta à tabela do ano;
+        //    ontem/amanhã cobrem deslocamentos que cruzam a meia-noite
+        if (event == "" && c.sunCount && sunHasLocation()) {
+          long today = localEpochDay(nowT);
+          for (int i = 0; i < c.sunCount && event == ""; i++) {
+            const SunRule& r = c.sun[i];
+            for (long d = today - 1; d <= today + 1; d++) {
+              time_t t;
+              if (!sunEventUtc(d, (SunEvent)r.event, t)) continue;
+              t += r.offsetSec;
+              if (t > winFromUtc && t <= utcT) {
+                desiredState = r.on;
+                event = String(r.on ? "AH#" : "AL#") + String(i);
+                break;
+              }
+            }
+          }
+        }
+        // 6) Programas DC(...): mudança de fase
+        if (event == "" && dcEdge) {
+          desiredState = dcOn;
+          dcEvent      = true;
+          event = dcOn ? "DC+" : "DC-";
+        }
+        int pinState = halOutputRead(pin);
+        // 7) Condições EH(...) / EL(...): a primeira verdadeira cuja ação
+        //    muda o estado do canal. Custo limitado a EXPR_MAX_CODE passos
+        //    por regra; ciclos medidos e expostos em /metrics.
+        if (event == "" && c.exprCount) {
+          bool   on   = channelActive(ch);
+          time_t since = utcT - chState.changedUtc[ch];
+          vars[EV_OUT]     = on;
+          vars[EV_ON_FOR]  = on ? (int32_t)since : 0;
+          vars[EV_OFF_FOR] = on ? 0 : (int32_t)since;
+          vars[EV_MANUAL]  = (chState.manualMask >> ch) & 1UL;
+          vars[EV_COUNT]   = chState.countDay[ch] == localEpochDay(nowT) ? chState.onCount[ch] : 0;
+          for (int i = 0; i < c.exprCount; i++) {
+            bool wantOn  = c.expr[i].flags & EXPR_F_ON;
+            bool changes = wantOn != (pinState == HIGH);
+            // regras com "for" são avaliadas sempre, para medir a duração
+            if (!changes && !c.expr[i].holdSec) continue;
+            uint32_t c0  = ESP.getCycleCount();
+            int32_t  res = exprEval(c.expr[i], vars);
+            uint32_t cyc = ESP.getCycleCount() - c0;
+            if (!halSimulating()) metricsRuleCost(ch, i, c.expr[i].len, cyc);
+            if (c.expr[i].holdSec) {
+              time_t& since = chState.exprSince[ch][i];
+              if (!res) { since = 0; continue; }
+              if (!since) since = utcT;
+              if (!changes || utcT - since < c.expr[i].holdSec) continue;
+            }
+            if (!res) continue;
+            desiredState = wantOn;
+            event = String(wantOn ? "EH#" : "EL#") + String(i);
+            break;
+          }
+        }
+        // 8) Intervalo IH: se HIGH há >= IH segundos
+        if (event == "" && pinState == HIGH && chState.ruleHighDT[ch] != 0) {
           int ih = getRuleTime(rules, "IH");
-          if (ih >= 0 && (nowT - ruleHighDT) >= ih) {
+          if (ih >= 0 && (utcT - chState.ruleHighDT[ch]) >= ih) {
             char buf[9]; formatHHMMSS(ih, buf, sizeof(buf));
             event = "IH" + String(buf);
             desiredState = false;
           }
         }
-        // 5) Intervalo IL: se LOW há >= IL segundos
-        if (event == "" && pinState == LOW && ruleLowDT != 0) {
+        // 9) Intervalo IL: se LOW há >= IL segundos
+        if (event == "" && pinState == LOW && chState.ruleLowDT[ch] != 0) {
           int il = getRuleTime(rules, "IL");
-          if (il >= 0 && (nowT - ruleLowDT) >= il) {
+          if (il >= 0 && (utcT - chState.ruleLowDT[ch]) >= il) {
             char buf[9]; formatHHMMSS(il, buf, sizeof(buf));
             event = "IL" + String(buf);
             desiredState = true;
@@ -80,29 +327,101 @@ String checkCustomRules(const Config& cfg,
     }
   }
 
+  // dia bloqueado no calendário de exceções: regras só desligam
+  if (desiredState && event.length() > 0 && excForDay(localEpochDay(nowT), ch).blackout) {
+    if (dcEvent) dcCommit(ch, dcOn);
+    return "";
+  }
+
   // se alguma regra disparou **e** a ação difere do estado atual do pino
-  int current = digitalRead(pin);
+  int current = halOutputRead(pin);
   if (event.length() > 0 && ((desiredState && current == LOW) || (!desiredState && current == HIGH))) {
-    // log
-    String log = timeStr(nowT)
-               + " -> Regra " + event
-               + " detectada para " + (desiredState ? "LIGAR" : "DESLIGAR") + " saída.";
-    Serial.println(log);
-    eventLog += log + "\n";
-
-    // executa ação: HIGH -> startOutput(infinito), LOW -> stopOutput()
+    // executa ação: HIGH -> startOutput(infinito), LOW -> stopOutput();
+    // recusada (cooldown), nada é registrado e a regra tenta de novo
+    if (!onAction(ch, desiredState, desiredState ? (unsigned long)MAX_FEED_DURATION + 1 : 0)) {
+      return "";
+    }
+    if (dcEvent) dcCommit(ch, dcOn);
+    logEvent(desiredState ? LOG_RULE_ON : LOG_RULE_OFF, ch, 0, 0, event.c_str());
+    eventPush(EVT_RULE, ch, desiredState, false, event.c_str());
+
     if (desiredState) {
-      onAction(true, (unsigned long)MAX_FEED_DURATION + 1);
-      ruleHighDT = nowT;
-      ruleLowDT  = 0;
+      chState.ruleHighDT[ch] = utcT;
+      chState.ruleLowDT[ch]  = 0;
     } else {
-      onAction(false, 0);
-      ruleLowDT  = nowT;
-      ruleHighDT = 0;
+      chState.ruleLowDT[ch]  = utcT;
+      chState.ruleHighDT[ch] = 0;
     }
 
     return event;
   }
 
+  // pino já no estado da fase DC
+  if (dcEvent) dcCommit(ch, dcOn);
   return "";
 }
+
+String checkCustomRules(const Config& cfg,
+                        std::function<bool(int ch, bool relayVal, unsigned long durationSec)> onAction) {
+  if (!onAction) return "";
+
+  // datas/horários das regras em hora local; intervalos IH/IL em UTC
+  time_t utcT = halUtcNow();
+  if (utcT == ruleLastCheck) return "";
+  time_t prevUtc = ruleLastCheck;
+  ruleLastCheck = utcT;
+
+  // canais fora do motor de regras perdem o estado DC (ao voltar, o
+  // programa reaplica a fase atual na primeira avaliação) e a contagem "for"
+  bool any = false;
+  for (int ch = 0; ch < cfg.channelCount; ch++) {
+    if (cfg.channels[ch].customEnabled && cfg.channels[ch].feederPin >= 0) {
+      any = true;
+    } else {
+      chState.dcPrimed &= ~(1UL << ch);
+      memset(chState.exprSince[ch], 0, sizeof(chState.exprSince[ch]));
+    }
+  }
+  if (!any) return "";
+
+  // campos de data/hora montados uma vez para todos os canais
+  time_t nowT = tzToLocal(utcT);
+  bool   newMinute = prevUtc ? (tzToLocal(prevUtc) / 60 != nowT / 60) : (nowT % 60 == 0);
+  // janela UTC coberta: recupera até SCHEDULE_CATCHUP_SEC após travas
+  time_t winFromUtc = (prevUtc && utcT > prevUtc && utcT - prevUtc <= SCHEDULE_CATCHUP_SEC)
+                      ? prevUtc : utcT - 1;
+
+  // monta "YYYY-MM-DD HH:MM"
+  char dtBuf[17];
+  snprintf(dtBuf, sizeof(dtBuf), "%04d-%02d-%02d %02d:%02d",
+           year(nowT), month(nowT), day(nowT),
+           hour(nowT), minute(nowT));
+  String dtStr(dtBuf);
+
+  char hmsBuf[9];
+  int  tod = localSecOfDay(nowT);
+  formatHHMMSS(tod, hmsBuf, sizeof(hmsBuf));
+  String hmsStr(hmsBuf);
+
+  // variáveis de tempo das expressões EH/EL (as do canal são preenchidas depois)
+  int32_t vars[EV__COUNT] = { 0 };
+  vars[EV_HOUR]   = tod / 3600;
+  vars[EV_MINUTE] = (tod / 60) % 60;
+  vars[EV_SECOND] = tod % 60;
+  vars[EV_TOD]    = tod;
+  vars[EV_WDAY]   = (localEpochDay(nowT) + 4) % 7;
+  vars[EV_DAY]    = day(nowT);
+  vars[EV_MONTH]  = month(nowT);
+  vars[EV_YEAR]   = year(nowT);
+  vars[EV_TEMP_OK] = sensorValue(SENSOR_RTC, vars[EV_TEMP]);
+  vars[EV_EXT_OK]  = sensorValue(SENSOR_EXT, vars[EV_EXT]);
+
+  String last;
+  for (int ch = 0; ch < cfg.channelCount; ch++) {
+    const ChannelConfig& c = cfg.channels[ch];
+    if (!c.customEnabled || c.feederPin < 0) continue;
+    String ev = checkChannelRules(c, ch, utcT, nowT, winFromUtc, newMinute, vars, dtStr, hmsStr, onAction);
+    if (ev.length() > 0) last = ev;
+  }
+  return last;
+}
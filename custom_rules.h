@@ -5,16 +5,31 @@
 #include "config.h"
 #include <functional>
 
-// Timestamps para controlar IH/IL
-extern time_t ruleHighDT;
-extern time_t ruleLowDT;
+// Timestamps (UTC) de IH/IL por canal ficam em chState (output.h)
 
-// Verifica regras avançadas (customSchedule) em cfg.
-// Sempre que encontra uma regra cuja ação difere do estado atual do pino,
-// chama onAction(relayVal, durationSec) e retorna o prefixo do evento (e.g. "DH12:00:00").
-// Se nada disparar, retorna "".
+// Último segundo UTC avaliado (salvo/restaurado pelo simulador)
+extern time_t ruleLastCheck;
+
+// Compila as expressões CH(cron)/CL(cron) de c.customSchedule em c.cron
+// (ver cron.h), as condições EH(expr)/EL(expr) em bytecode em c.expr (ver
+// rule_vm.h), os programas DC(...) em c.duty (ver duty_cycle.h) e as
+// regras solares AH/AL em c.sun (ver sun_times.h). Chamado ao salvar/
+// carregar as regras, nunca a cada tick.
+// Em caso de erro retorna false com a posição (índice em customSchedule) e
+// a mensagem; c.cron, c.expr, c.duty e c.sun ficam inalterados.
+bool compileCustomRules(ChannelConfig& c, int& errPos, String& errMsg);
+
+// Próximo instante local (> local) em que uma expressão CH (on) ou CL (!on)
+// do canal casa; 0 se nenhuma.
+time_t nextCronTrigger(const ChannelConfig& c, time_t local, bool on);
+
+// Verifica as regras avançadas (customSchedule) de todos os canais com
+// customEnabled, numa única passada por segundo. Sempre que encontra uma
+// regra cuja ação difere do estado atual do pino do canal, chama
+// onAction(ch, relayVal, durationSec) e retorna o prefixo do último evento
+// (e.g. "DH12:00:00"). Se nada disparar, retorna "". onAction retorna se o
+// canal mudou; log e evento da regra só são registrados nesse caso.
 String checkCustomRules(const Config& cfg,
-                        int pin,
-                        std::function<void(bool relayVal, unsigned long durationSec)> onAction);
+                        std::function<bool(int ch, bool relayVal, unsigned long durationSec)> onAction);
 
 #endif // CUSTOM_RULES_H
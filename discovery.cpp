@@ -0,0 +1,149 @@
+// discovery.cpp
+
+#include "discovery.h"
+#include "output.h"
+#include "schedule.h"
+#include "clock_sync.h"
+#include "mqtt.h"
+#include "hal.h"
+#include "time_utils.h"
+#include "tz_rules.h"
+
+#ifdef ESP8266
+  #include <ESP8266WiFi.h>
+  #include <ESP8266mDNS.h>
+#else
+  #include <WiFi.h>
+  #include <ESPmDNS.h>
+#endif
+#include <WiFiUdp.h>
+
+extern bool rtcInitialized;
+
+static constexpr uint32_t BEACON_MAGIC      = 0x31434254UL;   // "TBC1"
+static constexpr size_t   BEACON_HEADER_LEN = 32;
+static constexpr size_t   BEACON_RECORD_LEN = 8;
+static constexpr size_t   BEACON_MAX_LEN    = BEACON_HEADER_LEN + BEACON_RECORD_LEN * MAX_CHANNELS;
+
+static WiFiUDP       s_udp;
+static char          s_host[24];
+static uint8_t       s_mac[6];
+static bool          s_mdns     = false;
+static uint16_t      s_seq      = 0;
+static unsigned long s_lastMs   = 0;
+static unsigned long s_upMs     = 0;      // uptime estendido além do giro de millis()
+static uint32_t      s_upSec    = 0;
+
+const char* discoveryHostname() {
+  return s_host;
+}
+
+void discoveryBegin(const Config& cfg) {
+  WiFi.macAddress(s_mac);
+  snprintf(s_host, sizeof(s_host), "temporizador-%02x%02x%02x", s_mac[3], s_mac[4], s_mac[5]);
+
+  s_mdns = MDNS.begin(s_host);
+  if (!s_mdns) {
+    Serial.println("mDNS indisponível");
+    return;
+  }
+  char id[13];
+  char ch[4];
+  char beacon[24];
+  snprintf(id, sizeof(id), "%02x%02x%02x%02x%02x%02x",
+           s_mac[0], s_mac[1], s_mac[2], s_mac[3], s_mac[4], s_mac[5]);
+  snprintf(ch, sizeof(ch), "%d", cfg.channelCount);
+  snprintf(beacon, sizeof(beacon), "%u.%u.%u.%u:%u", BEACON_GROUP[0], BEACON_GROUP[1],
+           BEACON_GROUP[2], BEACON_GROUP[3], BEACON_PORT);
+
+  MDNS.addService("http", "tcp", 80);
+  MDNS.addService("temporizador", "tcp", 80);
+  MDNS.addServiceTxt("temporizador", "tcp", "id", id);
+  MDNS.addServiceTxt("temporizador", "tcp", "ch", ch);
+  MDNS.addServiceTxt("temporizador", "tcp", "caps",
+                     "sched,rules,cron,expr,duty,sun,exc,stats,sensors,mqtt,webhook,sync,beacon,modbus");
+  MDNS.addServiceTxt("temporizador", "tcp", "beacon", beacon);
+  MDNS.addServiceTxt("temporizador", "tcp", "proto", "1");
+  Serial.printf("mDNS: http://%s.local\n", s_host);
+}
+
+// ===== Beacon =====
+
+static void put16(uint8_t* p, uint16_t v) {
+  p[0] = v & 0xFF;
+  p[1] = v >> 8;
+}
+
+static void put32(uint8_t* p, uint32_t v) {
+  p[0] = v & 0xFF;
+  p[1] = (v >> 8) & 0xFF;
+  p[2] = (v >> 16) & 0xFF;
+  p[3] = v >> 24;
+}
+
+static size_t buildBeacon(const Config& cfg, uint8_t* buf) {
+  uint8_t n = cfg.beaconChannels < cfg.channelCount ? cfg.beaconChannels : cfg.channelCount;
+  memset(buf, 0, BEACON_HEADER_LEN + BEACON_RECORD_LEN * n);
+
+  time_t  utc   = halUtcNow();
+  uint8_t flags = 0;
+  if (syncActive())                   flags |= BEACON_F_SYNC;
+  if (cfg.syncRole == SYNC_LEADER)    flags |= BEACON_F_LEADER;
+  if (mqttConnected())                flags |= BEACON_F_MQTT;
+  if (rtcInitialized)                 flags |= BEACON_F_RTC;
+
+  put32(buf + 0, BEACON_MAGIC);
+  buf[4] = BEACON_VERSION;
+  buf[5] = n;
+  put16(buf + 6, ++s_seq);
+  memcpy(buf + 8, s_mac, 6);
+  buf[14] = flags;
+  buf[15] = (uint8_t)cfg.channelCount;
+  put32(buf + 16, (uint32_t)utc);
+  put32(buf + 20, s_upSec);
+  put32(buf + 24, ESP.getFreeHeap());
+  put32(buf + 28, (uint32_t)syncOffsetUs());
+
+  long today = localEpochDay(tzToLocal(utc));
+  for (uint8_t ch = 0; ch < n; ch++) {
+    uint8_t* r = buf + BEACON_HEADER_LEN + BEACON_RECORD_LEN * ch;
+    uint8_t  f = 0;
+    if (channelActive(ch))                       f |= BEACON_CH_ON;
+    if ((chState.manualMask >> ch) & 1UL)        f |= BEACON_CH_MANUAL;
+    if (cfg.channels[ch].customEnabled)          f |= BEACON_CH_RULES;
+    if (cfg.channels[ch].feederPin >= 0)         f |= BEACON_CH_PIN;
+    r[0] = f;
+    put16(r + 2, chState.countDay[ch] == today ? chState.onCount[ch] : 0);
+    long next = nextTriggerIn(cfg, ch);
+    put32(r + 4, next >= 0 ? (uint32_t)(utc + next) : 0);
+  }
+  return BEACON_HEADER_LEN + BEACON_RECORD_LEN * n;
+}
+
+static void sendBeacon(const Config& cfg) {
+  uint8_t   buf[BEACON_MAX_LEN];
+  size_t    len = buildBeacon(cfg, buf);
+  IPAddress group(BEACON_GROUP[0], BEACON_GROUP[1], BEACON_GROUP[2], BEACON_GROUP[3]);
+#ifdef ESP8266
+  s_udp.beginPacketMulticast(group, BEACON_PORT, WiFi.localIP());
+#else
+  s_udp.beginPacket(group, BEACON_PORT);
+#endif
+  s_udp.write(buf, len);
+  s_udp.endPacket();
+}
+
+void discoveryService(const Config& cfg) {
+  unsigned long nowMs = millis();
+  s_upSec += (nowMs - s_upMs) / 1000UL;
+  s_upMs  += ((nowMs - s_upMs) / 1000UL) * 1000UL;
+
+#ifdef ESP8266
+  if (s_mdns) MDNS.update();
+#endif
+
+  if (!cfg.beaconSec || WiFi.status() != WL_CONNECTED) return;
+  if (nowMs - s_lastMs < cfg.beaconSec * 1000UL) return;
+  s_lastMs = nowMs;
+  sendBeacon(cfg);
+}
@@ -0,0 +1,57 @@
+// discovery.h
+#ifndef DISCOVERY_H
+#define DISCOVERY_H
+
+#include "config.h"
+
+// Descoberta e monitoramento da frota na LAN, sem HTTP:
+//  - mDNS/DNS-SD: "temporizador-<MAC6>.local", serviços _http._tcp e
+//    _temporizador._tcp com TXT id, ch (canais), caps (recursos) e beacon
+//    (grupo:porta do beacon).
+//  - Beacon binário em UDP multicast (BEACON_GROUP:BEACON_PORT) a cada
+//    cfg.beaconSec segundos, largura fixa, little-endian:
+//
+//    cabeçalho (32 bytes)
+//      0  u32  magic "TBC1"          16  u32  utc (s)
+//      4  u8   versão (1)            20  u32  uptime (s)
+//      5  u8   n = registros         24  u32  heap livre (bytes)
+//      6  u16  seq                   28  i32  offset do relógio (µs, seguidor)
+//      8  u8[6] MAC
+//     14  u8   flags (BEACON_F_*)
+//     15  u8   canais configurados
+//    registro por canal (8 bytes, canais 0..n-1)
+//      0  u8   flags (BEACON_CH_*)
+//      1  u8   reservado
+//      2  u16  ativações hoje
+//      4  u32  próximo acionamento (UTC s, 0 = nenhum em 24 h)
+//
+// Tamanho = 32 + 8 * min(cfg.beaconChannels, canais configurados).
+
+static constexpr uint16_t BEACON_PORT          = 4124;
+static constexpr uint8_t  BEACON_GROUP[4]      = { 239, 255, 42, 99 };
+static constexpr uint8_t  BEACON_VERSION       = 1;
+static constexpr uint16_t BEACON_MIN_SEC       = 1;
+static constexpr uint16_t BEACON_MAX_SEC       = 3600;
+
+// flags do cabeçalho
+static constexpr uint8_t  BEACON_F_SYNC        = 0x01;   // relógio alinhado (clock_sync)
+static constexpr uint8_t  BEACON_F_LEADER      = 0x02;
+static constexpr uint8_t  BEACON_F_MQTT        = 0x04;   // MQTT conectado
+static constexpr uint8_t  BEACON_F_RTC         = 0x08;   // DS3231 presente
+
+// flags por canal
+static constexpr uint8_t  BEACON_CH_ON         = 0x01;
+static constexpr uint8_t  BEACON_CH_MANUAL     = 0x02;
+static constexpr uint8_t  BEACON_CH_RULES      = 0x04;   // regras customizadas ativas
+static constexpr uint8_t  BEACON_CH_PIN        = 0x08;   // pino atribuído
+
+// Após a rede: nome mDNS e serviços.
+void discoveryBegin(const Config& cfg);
+
+// No loop: mDNS (ESP8266) e beacon no intervalo.
+void discoveryService(const Config& cfg);
+
+// Nome mDNS ("temporizador-a1b2c3")
+const char* discoveryHostname();
+
+#endif // DISCOVERY_H
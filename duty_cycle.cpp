@@ -0,0 +1,139 @@
+// duty_cycle.cpp
+
+#include "duty_cycle.h"
+#include "config.h"
+#include "time_utils.h"
+
+static const char* s_base;
+
+static bool fail(const char* p, int& errPos, const char*& errMsg, const char* msg) {
+  errPos = p - s_base;
+  errMsg = msg;
+  return false;
+}
+
+static void skipSpaces(const char*& p) {
+  while (*p == ' ') p++;
+}
+
+static bool readUInt(const char*& p, uint32_t& v) {
+  if (*p < '0' || *p > '9') return false;
+  v = 0;
+  while (*p >= '0' && *p <= '9' && v < 10000000UL) v = v * 10 + (*p++ - '0');
+  return true;
+}
+
+// N[h|m|s][N[h|m|s]...]
+static bool readDuration(const char*& p, uint32_t& secs) {
+  secs = 0;
+  bool any = false;
+  uint32_t v;
+  while (readUInt(p, v)) {
+    any = true;
+    if      (*p == 'h') { p++; secs += v * 3600UL; }
+    else if (*p == 'm') { p++; secs += v * 60UL; }
+    else if (*p == 's') { p++; secs += v; }
+    else                { secs += v; break; }
+  }
+  return any && secs > 0 && secs <= 7UL * 86400UL;
+}
+
+// HH:MM[:SS] -> s desde 00:00
+static bool readTod(const char*& p, int32_t& tod) {
+  uint32_t h, m, s = 0;
+  if (!readUInt(p, h) || *p != ':') return false;
+  p++;
+  if (!readUInt(p, m)) return false;
+  if (*p == ':') {
+    p++;
+    if (!readUInt(p, s)) return false;
+  }
+  if (h > 23 || m > 59 || s > 59) return false;
+  tod = (int32_t)(h * 3600UL + m * 60UL + s);
+  return true;
+}
+
+bool dutyParse(const char* src, DutyProgram& out, int& consumed,
+               int& errPos, const char*& errMsg) {
+  const char* p = src;
+  s_base = src;
+
+  out.segCount = 0;
+  out.period   = 0;
+  out.winStart = out.winEnd = -1;
+  bool hasAnchor = false;
+
+  // segmentos on/off
+  skipSpaces(p);
+  for (;;) {
+    uint32_t d;
+    const char* at = p;
+    if (!readDuration(p, d)) return fail(p, errPos, errMsg, "duração inválida");
+    // mais curta que o cooldown: a fase seguinte seria recusada por startOutput
+    if (d < (uint32_t)FEED_COOLDOWN) return fail(at, errPos, errMsg, "fase menor que o cooldown");
+    if (out.segCount >= DUTY_MAX_SEGMENTS) return fail(p, errPos, errMsg, "fases demais (máx. 4 pares)");
+    out.seg[out.segCount++] = d;
+    out.period += d;
+    if (*p != '/') break;
+    p++;
+  }
+  if (out.segCount & 1) return fail(p, errPos, errMsg, "faltou a duração desligada");
+
+  // @âncora
+  skipSpaces(p);
+  if (*p == '@') {
+    p++;
+    if (!readTod(p, out.anchorTod)) return fail(p, errPos, errMsg, "âncora HH:MM inválida");
+    hasAnchor = true;
+  }
+
+  // janela HH:MM-HH:MM
+  skipSpaces(p);
+  if (*p >= '0' && *p <= '9') {
+    if (!readTod(p, out.winStart) || *p != '-') return fail(p, errPos, errMsg, "janela HH:MM-HH:MM inválida");
+    p++;
+    if (!readTod(p, out.winEnd)) return fail(p, errPos, errMsg, "janela HH:MM-HH:MM inválida");
+    if (out.winStart == out.winEnd) return fail(p, errPos, errMsg, "janela vazia");
+  }
+
+  skipSpaces(p);
+  if (*p != ')' && *p != '\0') return fail(p, errPos, errMsg, "caractere inesperado");
+
+  if (!hasAnchor) out.anchorTod = out.winStart >= 0 ? out.winStart : 0;
+  consumed = p - src;
+  return true;
+}
+
+bool dutyStateAt(const DutyProgram& p, time_t local, long* remainSec) {
+  int32_t tod = localSecOfDay(local);
+
+  // fora da janela: desligado até ela abrir
+  long toWinEnd = 0x7FFFFFFFL;
+  if (p.winStart >= 0) {
+    bool inWin = (p.winStart < p.winEnd) ? (tod >= p.winStart && tod < p.winEnd)
+                                         : (tod >= p.winStart || tod < p.winEnd);
+    if (!inWin) {
+      if (remainSec) *remainSec = (p.winStart - tod + 86400L) % 86400L;
+      return false;
+    }
+    toWinEnd = (p.winEnd - tod + 86400L) % 86400L;
+  }
+
+  // fase a partir da âncora mais recente (hoje ou ontem)
+  time_t anchor = local - tod + p.anchorTod;
+  if (anchor > local) anchor -= 86400L;
+  uint32_t phase = (uint32_t)((local - anchor) % p.period);
+
+  bool on     = false;
+  long remain = 0;
+  for (uint8_t i = 0; i < p.segCount; i++) {
+    if (phase < p.seg[i]) {
+      on     = !(i & 1);
+      remain = (long)(p.seg[i] - phase);
+      break;
+    }
+    phase -= p.seg[i];
+  }
+  if (remainSec) *remainSec = (on && remain > toWinEnd) ? toWinEnd : remain;
+  return on;
+}
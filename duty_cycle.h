@@ -0,0 +1,41 @@
+// duty_cycle.h
+#ifndef DUTY_CYCLE_H
+#define DUTY_CYCLE_H
+
+#include <Arduino.h>
+#include <time.h>
+
+// Programas cíclicos DC(on/off[/on/off...][@âncora][ janela]):
+//   DC(30s/10m)                    30 s ligado, 10 min desligado, o dia todo
+//   DC(5m/25m@06:00 06:00-18:00)   ciclo de 30 min a partir das 06:00, só de dia
+//   DC(1m/4m/1m/14m 22:00-06:00)   duas fases por ciclo, janela noturna
+// Durações: N[h|m|s], combináveis (1h30m); sem sufixo = segundos. Cada
+// fase dura ao menos FEED_COOLDOWN: o canal não religa antes disso.
+//
+// O estado em qualquer instante vem de aritmética modular sobre a hora
+// local: fase = (agora - âncora do dia) mod período. Não há temporizador
+// nem estado persistido; após reboot ou correção do relógio a fase exata
+// é retomada no próximo tick. A âncora é reaplicada a cada dia (padrão:
+// início da janela, ou 00:00); se o período divide 24 h o ciclo é contínuo.
+
+static constexpr uint8_t DUTY_MAX_SEGMENTS = 8;   // até 4 pares on/off
+
+struct DutyProgram {
+  uint32_t seg[DUTY_MAX_SEGMENTS];   // durações alternadas on, off, on, off... (s)
+  uint8_t  segCount;                 // sempre par
+  uint32_t period;                   // soma de seg
+  int32_t  anchorTod;                // s desde 00:00 local
+  int32_t  winStart;                 // s desde 00:00; -1 = dia inteiro
+  int32_t  winEnd;                   // fim exclusivo (pode virar a meia-noite)
+};
+
+// Compila o conteúdo entre parênteses (até ')' ou fim da string);
+// `consumed` recebe os caracteres lidos, sem o ')'.
+bool dutyParse(const char* src, DutyProgram& out, int& consumed,
+               int& errPos, const char*& errMsg);
+
+// Estado (ligado?) no instante local `local`. Se `remainSec` não for nulo,
+// recebe quanto falta para a próxima mudança.
+bool dutyStateAt(const DutyProgram& p, time_t local, long* remainSec);
+
+#endif // DUTY_CYCLE_H
@@ -0,0 +1,27 @@
+// engine.cpp
+
+#include "engine.h"
+#include "output.h"
+#include "custom_rules.h"
+#include "schedule.h"
+#include "program_table.h"
+
+void engineTick(Config& c) {
+  serviceOutputTimers(c);
+
+  checkCustomRules(c,
+    [&](int ch, bool relayVal, unsigned long dur){
+      return relayVal ? startOutput(c, ch, dur) : stopOutput(c, ch);
+    }
+  );
+  checkSchedules(c,
+    [&](int ch, unsigned long dur){
+      startOutput(c, ch, dur);
+    }
+  );
+  progTick(c,
+    [&](int ch, unsigned long dur){
+      startOutput(c, ch, dur);
+    }
+  );
+}
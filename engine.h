@@ -0,0 +1,15 @@
+// engine.h
+#ifndef ENGINE_H
+#define ENGINE_H
+
+#include "config.h"
+
+// Um passo do motor: temporizadores das saídas + regras customizadas e
+// schedules, cada um numa única passada sobre todos os canais (cada canal usa
+// um ou outro conforme customEnabled), + tabelas de programa em flash (só
+// das páginas já em RAM).
+// Também usado pelo simulador (simulator.cpp) sobre uma cópia da config;
+// as tabelas de programa ficam de fora da simulação.
+void engineTick(Config& c);
+
+#endif // ENGINE_H
@@ -0,0 +1,39 @@
+// events.cpp
+
+#include "events.h"
+#include "hal.h"
+
+static Event    s_ring[EVENT_QUEUE_LEN];
+static uint32_t s_head = 0;   // seq do último evento (0 = nenhum)
+
+void eventPush(EventType type, int ch, bool on, bool manual, const char* name) {
+  if (halSimulating()) return;
+  uint32_t seq = s_head + 1;
+  Event&   e   = s_ring[seq & (EVENT_QUEUE_LEN - 1)];
+  e.seq    = seq;
+  e.utc    = halUtcNow();
+  e.type   = type;
+  e.ch     = (uint8_t)ch;
+  e.on     = on;
+  e.manual = manual;
+  strncpy(e.name, name ? name : "", EVENT_NAME_LEN - 1);
+  e.name[EVENT_NAME_LEN - 1] = '\0';
+  s_head = seq;
+}
+
+bool eventNext(uint32_t& cursor, Event& out, uint32_t& lost) {
+  uint32_t head = s_head;
+  if (cursor == head) return false;
+  // atrasado demais: pula para o mais antigo ainda no anel
+  if (head - cursor > EVENT_QUEUE_LEN) {
+    lost  += head - cursor - EVENT_QUEUE_LEN;
+    cursor = head - EVENT_QUEUE_LEN;
+  }
+  cursor++;
+  out = s_ring[cursor & (EVENT_QUEUE_LEN - 1)];
+  return true;
+}
+
+uint32_t eventHead() {
+  return s_head;
+}
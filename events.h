@@ -0,0 +1,43 @@
+// events.h
+#ifndef EVENTS_H
+#define EVENTS_H
+
+#include <Arduino.h>
+#include <time.h>
+
+// Barramento de eventos do motor para os consumidores de rede (MQTT, ...).
+// Os produtores (outputOn/outputOff, outputNote, disparo de regras) só
+// copiam um registro POD num anel fixo, sem String nem rede; todos rodam no
+// loop (o botão deixa o registro para ctlService). Cada consumidor guarda o próprio cursor (número de
+// sequência) e lê no seu ritmo; quem ficar mais de EVENT_QUEUE_LEN eventos
+// para trás perde os mais antigos e é avisado pela contagem `lost`.
+// Nada é registrado durante a simulação.
+
+static constexpr uint8_t EVENT_QUEUE_LEN  = 16;   // potência de 2
+static constexpr uint8_t EVENT_NAME_LEN   = 12;
+
+enum EventType : uint8_t {
+  EVT_OUTPUT = 0,   // saída ligou/desligou
+  EVT_RULE          // regra disparou (name = "IH00:05:00", "EH#0", "CH#1"...)
+};
+
+struct Event {
+  uint32_t seq;
+  time_t   utc;
+  uint8_t  type;     // EventType
+  uint8_t  ch;
+  bool     on;
+  bool     manual;
+  char     name[EVENT_NAME_LEN];
+};
+
+// Chamado do loop via outputNote() e pelas regras; fora de halLock().
+void eventPush(EventType type, int ch, bool on, bool manual, const char* name);
+
+// Próximo evento após `cursor` (que é avançado). false se não há novos.
+bool eventNext(uint32_t& cursor, Event& out, uint32_t& lost);
+
+// Sequência do último evento (cursor inicial de quem só quer os novos)
+uint32_t eventHead();
+
+#endif // EVENTS_H
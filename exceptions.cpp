@@ -0,0 +1,422 @@
+// exceptions.cpp
+
+#include "exceptions.h"
+#include "time_utils.h"
+#include "tz_rules.h"
+#include "hal.h"
+#include <FS.h>
+#include <limits.h>
+
+#ifdef ESP8266
+  #include <LittleFS.h>
+  #define FS_INSTANCE LittleFS
+#else
+  #include <SPIFFS.h>
+  #define FS_INSTANCE SPIFFS
+#endif
+
+static constexpr uint32_t EXC_MAGIC     = 0x32435845UL;   // "EXC2"
+static constexpr uint32_t EXC_MAGIC_V1  = 0x31435845UL;   // "EXC1", sem horários
+static constexpr uint8_t  EXC_F_BLACKOUT = 1 << 0;
+static constexpr uint8_t  EXC_ALL_CH    = 0xFF;
+static constexpr uint16_t EXC_ALL_SLOTS = 0xFFFF;
+
+struct ExcOverride {
+  int32_t  day;        // dia-época local
+  uint16_t slotMask;
+  uint8_t  chMask;
+  uint8_t  flags;
+  uint8_t  repCount;   // > 0: horários próprios no lugar dos slots
+  uint8_t  reserved[3];
+  ExcSlot  rep[EXC_REP_SLOTS];
+};
+
+// registro do formato EXC1, convertido na leitura
+struct ExcOverrideV1 {
+  int32_t  day;
+  uint16_t slotMask;
+  uint8_t  chMask;
+  uint8_t  flags;
+};
+
+struct ExcFileHeader {
+  uint32_t magic;
+  int16_t  baseYear;
+  uint8_t  overCount;
+  uint8_t  reserved;
+};
+
+typedef uint32_t ExcYearBits[12];   // 384 bits >= 366 dias
+
+static int16_t     s_baseYear  = 0;           // 0 = calendário vazio
+static ExcYearBits s_blackout[EXC_YEARS];
+static ExcOverride s_over[EXC_MAX_OVERRIDES];
+static uint8_t     s_overCount = 0;
+
+// resultado do último dia consultado
+static long        s_cacheDay  = LONG_MIN;
+static ExcDay      s_cache[MAX_CHANNELS];
+
+// índice (ano relativo, dia do ano) de `day` numa janela que começa em `base`
+static bool dayIndex(int base, long day, int& yi, int& doy) {
+  int y, m, d;
+  civilFromDays(day, y, m, d);
+  yi = y - base;
+  if (yi < 0 || yi >= EXC_YEARS) return false;
+  doy = (int)(day - daysFromCivil(y, 1, 1));
+  return true;
+}
+
+static bool testBit(const ExcYearBits* bits, int base, long day) {
+  int yi, doy;
+  if (!dayIndex(base, day, yi, doy)) return false;
+  return (bits[yi][doy >> 5] >> (doy & 31)) & 1UL;
+}
+
+static void fillCache(long day) {
+  bool all = s_baseYear && testBit(s_blackout, s_baseYear, day);
+  for (int ch = 0; ch < MAX_CHANNELS; ch++) {
+    s_cache[ch].slotMask = all ? 0 : EXC_ALL_SLOTS;
+    s_cache[ch].blackout = all;
+    s_cache[ch].repCount = 0;
+    s_cache[ch].rep      = nullptr;
+  }
+
+  // primeira entrada do dia (busca binária) e as seguintes do mesmo dia
+  int lo = 0, hi = s_overCount;
+  while (lo < hi) {
+    int mid = (lo + hi) / 2;
+    if (s_over[mid].day < day) lo = mid + 1;
+    else                       hi = mid;
+  }
+  for (int i = lo; i < s_overCount && s_over[i].day == day; i++) {
+    const ExcOverride& o = s_over[i];
+    for (int ch = 0; ch < MAX_CHANNELS; ch++) {
+      if (!((o.chMask >> ch) & 1)) continue;
+      if (o.flags & EXC_F_BLACKOUT) {
+        s_cache[ch].slotMask = 0;
+        s_cache[ch].blackout = true;
+        s_cache[ch].repCount = 0;
+      } else if (o.repCount) {
+        // a entrada do dia manda nos horários, mesmo sob bloqueio geral
+        s_cache[ch].slotMask = 0;
+        s_cache[ch].repCount = o.repCount;
+        s_cache[ch].rep      = o.rep;
+      } else {
+        s_cache[ch].slotMask &= o.slotMask;
+      }
+    }
+  }
+  s_cacheDay = day;
+}
+
+const ExcDay& excForDay(long day, int ch) {
+  if (day != s_cacheDay) fillCache(day);
+  return s_cache[ch];
+}
+
+int excBaseYear() {
+  return s_baseYear;
+}
+
+// ===== Persistência =====
+
+void excBegin() {
+  s_baseYear  = 0;
+  s_overCount = 0;
+  s_cacheDay  = LONG_MIN;
+  File f = FS_INSTANCE.open(EXC_PATH, "r");
+  if (!f) return;
+  ExcFileHeader h;
+  bool ok = f.read((uint8_t*)&h, sizeof(h)) == sizeof(h) &&
+            (h.magic == EXC_MAGIC || h.magic == EXC_MAGIC_V1) &&
+            h.overCount <= EXC_MAX_OVERRIDES &&
+            f.read((uint8_t*)s_blackout, sizeof(s_blackout)) == sizeof(s_blackout);
+  if (ok && h.magic == EXC_MAGIC) {
+    ok = f.read((uint8_t*)s_over, h.overCount * sizeof(ExcOverride)) ==
+           h.overCount * sizeof(ExcOverride);
+  }
+  for (int i = 0; ok && h.magic == EXC_MAGIC_V1 && i < h.overCount; i++) {
+    ExcOverrideV1 v;
+    ok = f.read((uint8_t*)&v, sizeof(v)) == sizeof(v);
+    memset(&s_over[i], 0, sizeof(ExcOverride));
+    s_over[i].day      = v.day;
+    s_over[i].slotMask = v.slotMask;
+    s_over[i].chMask   = v.chMask;
+    s_over[i].flags    = v.flags;
+  }
+  f.close();
+  if (!ok) {
+    Serial.println("exceptions.bin inválido; calendário de exceções vazio");
+    return;
+  }
+  s_baseYear  = h.baseYear;
+  s_overCount = h.overCount;
+  Serial.printf("Exceções: janela %d-%d, %u substituições\n",
+                s_baseYear, s_baseYear + EXC_YEARS - 1, s_overCount);
+}
+
+static void excSave() {
+  if (!halPersistAllowed()) return;
+  File f = FS_INSTANCE.open(EXC_PATH, "w");
+  if (!f) {
+    Serial.println("Não foi possível gravar exceptions.bin");
+    return;
+  }
+  ExcFileHeader h = { EXC_MAGIC, s_baseYear, s_overCount, 0 };
+  f.write((const uint8_t*)&h, sizeof(h));
+  f.write((const uint8_t*)s_blackout, sizeof(s_blackout));
+  f.write((const uint8_t*)s_over, s_overCount * sizeof(ExcOverride));
+  f.close();
+}
+
+// ===== Texto =====
+
+static bool isSep(char c) {
+  return c == ' ' || c == ',' || c == ';' || c == '\n' || c == '\r' || c == '\t';
+}
+
+// AAAA-MM-DD; nullptr se inválida
+static const char* parseDate(const char* p, long& day) {
+  int y, m, d, n = 0;
+  if (sscanf(p, "%4d-%2d-%2d%n", &y, &m, &d, &n) != 3 || n != 10) return nullptr;
+  if (m < 1 || m > 12 || d < 1 || d > 31) return nullptr;
+  day = daysFromCivil(y, m, d);
+  int yy, mm, dd;
+  civilFromDays(day, yy, mm, dd);
+  if (yy != y || mm != m || dd != d) return nullptr;   // 31/04, 29/02 fora de bissexto
+  return p + n;
+}
+
+// HH:MM:SS/HH:MM:SS[+...] (início/duração); nullptr se inválida
+static const char* parseSlots(const char* p, ExcSlot* rep, uint8_t& count, String& why) {
+  count = 0;
+  do {
+    int h, m, s, dh, dm, ds, n = 0;
+    if (sscanf(p, "%2d:%2d:%2d/%2d:%2d:%2d%n", &h, &m, &s, &dh, &dm, &ds, &n) != 6 ||
+        n != 17 || (h | m | s | dh | dm | ds) < 0 ||
+        h > 23 || m > 59 || s > 59 || dm > 59 || ds > 59) {
+      why = "horário HH:MM:SS/HH:MM:SS esperado";
+      return nullptr;
+    }
+    long dur = dh * 3600L + dm * 60L + ds;
+    if (dur < 1 || dur > MAX_FEED_DURATION) {
+      why = "duração entre 1 e " + String(MAX_FEED_DURATION) + " s";
+      return nullptr;
+    }
+    if (count >= EXC_REP_SLOTS) {
+      why = "máximo de " + String(EXC_REP_SLOTS) + " horários por dia";
+      return nullptr;
+    }
+    rep[count].timeSec     = h * 3600 + m * 60 + s;
+    rep[count].durationSec = (uint16_t)dur;
+    rep[count].reserved    = 0;
+    count++;
+    p += n;
+  } while (*p == '+' && ++p);
+  return p;
+}
+
+// N[+N...] com N < limit; nullptr se inválida
+static const char* parseList(const char* p, int limit, uint32_t& mask) {
+  mask = 0;
+  do {
+    if (*p < '0' || *p > '9') return nullptr;
+    int v = 0;
+    while (*p >= '0' && *p <= '9') {
+      v = v * 10 + (*p++ - '0');
+      if (v >= limit) return nullptr;
+    }
+    mask |= 1UL << v;
+  } while (*p == '+' && ++p);
+  return p;
+}
+
+bool excSet(const String& text, int& errPos, String& errMsg) {
+  const char* s = text.c_str();
+  const char* p = s;
+
+  int y, m, d;
+  civilFromDays(localEpochDay(localNow()), y, m, d);
+  int16_t base = (int16_t)y;
+
+  static ExcYearBits bits[EXC_YEARS];
+  static ExcOverride over[EXC_MAX_OVERRIDES];
+  memset(bits, 0, sizeof(bits));
+  int n = 0;
+
+  auto fail = [&](const char* at, const String& msg) {
+    errPos = at - s;
+    errMsg = msg;
+    return false;
+  };
+
+  for (;;) {
+    while (isSep(*p)) p++;
+    if (!*p) break;
+
+    long from, to;
+    const char* q = parseDate(p, from);
+    if (!q) return fail(p, "data AAAA-MM-DD esperada");
+    to = from;
+    if (q[0] == '.' && q[1] == '.') {
+      const char* r = parseDate(q + 2, to);
+      if (!r) return fail(q + 2, "data final AAAA-MM-DD esperada");
+      if (to < from) return fail(q + 2, "intervalo invertido");
+      q = r;
+    }
+    int yi, doy;
+    if (!dayIndex(base, from, yi, doy) || !dayIndex(base, to, yi, doy)) {
+      return fail(p, "data fora da janela " + String(base) + "-" +
+                     String(base + EXC_YEARS - 1));
+    }
+
+    uint32_t slots = 0, chans = EXC_ALL_CH;
+    bool     hasSlots = false, hasChans = false;
+    ExcSlot  rep[EXC_REP_SLOTS];
+    uint8_t  repCount = 0;
+    if (*q == '=') {
+      // índices de slot (=0+2) ou horários próprios (=07:00:00/00:00:30+...)
+      const char* r = q + 1;
+      while (*r >= '0' && *r <= '9') r++;
+      if (*r == ':') {
+        String why;
+        r = parseSlots(q + 1, rep, repCount, why);
+        if (!r) return fail(q + 1, why);
+      } else {
+        r = parseList(q + 1, MAX_SLOTS, slots);
+        if (!r) return fail(q + 1, "lista de slots inválida (0-" + String(MAX_SLOTS - 1) + ")");
+      }
+      q = r;
+      hasSlots = true;
+    }
+    if (*q == '@') {
+      const char* r = parseList(q + 1, MAX_CHANNELS, chans);
+      if (!r) return fail(q + 1, "lista de canais inválida (0-" + String(MAX_CHANNELS - 1) + ")");
+      q = r;
+      hasChans = true;
+    }
+    if (*q && !isSep(*q)) return fail(q, "separador esperado");
+
+    for (long day = from; day <= to; day++) {
+      if (!hasSlots && !hasChans) {
+        dayIndex(base, day, yi, doy);
+        bits[yi][doy >> 5] |= 1UL << (doy & 31);
+        continue;
+      }
+      if (n >= EXC_MAX_OVERRIDES) {
+        return fail(p, "máximo de " + String(EXC_MAX_OVERRIDES) + " dias com '=' ou '@'");
+      }
+      memset(&over[n], 0, sizeof(ExcOverride));
+      over[n].day      = (int32_t)day;
+      over[n].slotMask = hasSlots ? (uint16_t)slots : 0;
+      over[n].chMask   = (uint8_t)chans;
+      over[n].flags    = hasSlots ? 0 : EXC_F_BLACKOUT;
+      over[n].repCount = repCount;
+      memcpy(over[n].rep, rep, repCount * sizeof(ExcSlot));
+      n++;
+    }
+    p = q;
+  }
+
+  // ordena por dia (estável: entradas do mesmo dia mantêm a ordem do texto)
+  for (int i = 1; i < n; i++) {
+    ExcOverride o = over[i];
+    int j = i - 1;
+    while (j >= 0 && over[j].day > o.day) { over[j + 1] = over[j]; j--; }
+    over[j + 1] = o;
+  }
+
+  memcpy(s_blackout, bits, sizeof(bits));
+  memcpy(s_over, over, n * sizeof(ExcOverride));
+  s_overCount = n;
+  s_baseYear  = base;
+  s_cacheDay  = LONG_MIN;
+  excSave();
+  return true;
+}
+
+static void appendDate(String& out, long day) {
+  int y, m, d;
+  char buf[11];
+  civilFromDays(day, y, m, d);
+  snprintf(buf, sizeof(buf), "%04d-%02d-%02d", y, m, d);
+  out += buf;
+}
+
+static void appendList(String& out, uint32_t mask) {
+  bool first = true;
+  for (int i = 0; mask; i++, mask >>= 1) {
+    if (!(mask & 1)) continue;
+    if (!first) out += '+';
+    out += String(i);
+    first = false;
+  }
+}
+
+static void appendSlots(String& out, const ExcOverride& o) {
+  char buf[20];
+  for (int i = 0; i < o.repCount; i++) {
+    if (i) out += '+';
+    formatHHMMSS(o.rep[i].timeSec, buf, sizeof(buf));
+    out += buf;
+    out += '/';
+    formatHHMMSS(o.rep[i].durationSec, buf, sizeof(buf));
+    out += buf;
+  }
+}
+
+static bool sameEntry(const ExcOverride& a, const ExcOverride& b) {
+  return a.slotMask == b.slotMask && a.chMask == b.chMask && a.flags == b.flags &&
+         a.repCount == b.repCount &&
+         !memcmp(a.rep, b.rep, a.repCount * sizeof(ExcSlot));
+}
+
+static void appendRange(String& out, long from, long to) {
+  if (out.length()) out += ' ';
+  appendDate(out, from);
+  if (to != from) {
+    out += "..";
+    appendDate(out, to);
+  }
+}
+
+String excToString() {
+  String out;
+  if (!s_baseYear) return out;
+
+  // bloqueios gerais: sequências de bits reagrupadas em intervalos
+  long first = daysFromCivil(s_baseYear, 1, 1);
+  long last  = daysFromCivil(s_baseYear + EXC_YEARS, 1, 1);
+  long runFrom = -1;
+  for (long day = first; day <= last; day++) {
+    bool set = day < last && testBit(s_blackout, s_baseYear, day);
+    if (set && runFrom < 0) runFrom = day;
+    if (!set && runFrom >= 0) {
+      appendRange(out, runFrom, day - 1);
+      runFrom = -1;
+    }
+  }
+
+  // substituições: dias consecutivos iguais viram um intervalo
+  for (int i = 0; i < s_overCount; ) {
+    const ExcOverride& o = s_over[i];
+    int j = i + 1;
+    while (j < s_overCount && s_over[j].day == s_over[j - 1].day + 1 &&
+           sameEntry(s_over[j], o)) {
+      j++;
+    }
+    appendRange(out, o.day, s_over[j - 1].day);
+    if (!(o.flags & EXC_F_BLACKOUT)) {
+      out += '=';
+      if (o.repCount) appendSlots(out, o);
+      else            appendList(out, o.slotMask);
+    }
+    if (o.chMask != EXC_ALL_CH) {
+      out += '@';
+      appendList(out, o.chMask);
+    }
+    i = j;
+  }
+  return out;
+}
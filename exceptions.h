@@ -0,0 +1,62 @@
+// exceptions.h
+#ifndef EXCEPTIONS_H
+#define EXCEPTIONS_H
+
+#include "config.h"
+
+// Calendário de exceções (feriados, manutenção), fora de Config:
+//  - bloqueio geral: bitset por ano (bit = dia do ano), EXC_YEARS anos a
+//    partir de excBaseYear(); 48 bytes por ano;
+//  - mapa de substituições: até EXC_MAX_OVERRIDES entradas ordenadas por
+//    dia, cada uma restringindo os slots de agendamento de alguns canais,
+//    trocando-os por até EXC_REP_SLOTS horários próprios do dia (programa
+//    de substituição) ou bloqueando só esses canais.
+// O resultado de um dia é montado uma vez na virada do dia; por tick a
+// consulta é uma comparação e um acesso a array.
+//
+// Formato texto (entradas separadas por espaço, vírgula, ';' ou quebra):
+//   2026-12-25                bloqueio de todos os canais
+//   2026-12-24..2026-12-31    bloqueio de um intervalo
+//   2026-12-31=0+2            só os slots #0 e #2 disparam (todos os canais)
+//   2026-04-03=1@0+2          só o slot #1, nos canais 0 e 2
+//   2026-12-24=07:00:00/00:00:30+17:00:00/00:01:00
+//                             só estes horários (início/duração) disparam
+//   2026-11-02@1              bloqueio só do canal 1
+// Em dia bloqueado nenhum slot dispara e as regras não ligam a saída
+// (desligar continua permitido); o acionamento manual não é afetado. Uma
+// entrada com horários próprios vale também num dia de bloqueio geral: só
+// os horários dela disparam (as regras continuam sem ligar a saída).
+
+static constexpr char EXC_PATH[]         = "/exceptions.bin";
+static constexpr int  EXC_YEARS          = 4;
+static constexpr int  EXC_MAX_OVERRIDES  = 16;
+static constexpr int  EXC_REP_SLOTS      = 4;    // horários por substituição
+
+struct ExcSlot {
+  int32_t  timeSec;       // segundo do dia local
+  uint16_t durationSec;   // 1..MAX_FEED_DURATION
+  uint16_t reserved;
+};
+
+struct ExcDay {
+  uint16_t       slotMask;   // bit i: schedules[i] pode disparar
+  bool           blackout;   // regras não ligam a saída
+  uint8_t        repCount;   // horários de substituição do dia
+  const ExcSlot* rep;        // válido até o próximo excSet()
+};
+
+// Carrega EXC_PATH (FS já montado por loadConfig)
+void excBegin();
+
+// Restrições do dia local `day` (dia-época) para o canal `ch`
+const ExcDay& excForDay(long day, int ch);
+
+// Substitui o calendário pelo texto (janela a partir do ano local atual) e
+// grava. Em erro retorna false com a posição no texto; nada é alterado.
+bool excSet(const String& text, int& errPos, String& errMsg);
+
+// Calendário atual no formato texto (intervalos reagrupados)
+String excToString();
+int    excBaseYear();
+
+#endif // EXCEPTIONS_H
@@ -0,0 +1,128 @@
+// hal.cpp
+
+#include "hal.h"
+#include <TimeLib.h>
+#include "clock_sync.h"
+
+static bool          s_sim       = false;
+static time_t        s_simUtc    = 0;
+static unsigned long s_simMs     = 0;
+static uint64_t      s_simOutput = 0;       // bit = pino ligado
+static HalTraceFn    s_trace     = nullptr;
+
+#ifdef ESP8266
+static uint32_t      s_savedPs   = 0;       // PS de antes de halLock()
+static HalTickFn     s_tickFn[HAL_TICK_MAX];
+static volatile uint8_t s_tickCount = 0;
+#else
+static portMUX_TYPE  s_mux       = portMUX_INITIALIZER_UNLOCKED;
+#endif
+
+time_t halUtcNow() {
+  if (s_sim)        return s_simUtc;
+  if (syncActive()) return (time_t)(syncUtcUs() / 1000000LL);   // relógio comum às unidades
+  return now();
+}
+
+// halMillis, halOutputWrite, halLock/halUnlock e halSimulating rodam também
+// na interrupção do botão (ver output.h): IRAM_ATTR.
+unsigned long IRAM_ATTR halMillis() {
+  return s_sim ? s_simMs : millis();
+}
+
+void IRAM_ATTR halOutputWrite(int pin, bool on) {
+  if (s_sim) {
+    if (pin < 0 || pin >= 64) return;
+    uint64_t bit = (uint64_t)1 << pin;
+    bool     was = (s_simOutput & bit) != 0;
+    if (on != was && s_trace) s_trace(s_simUtc, pin, on);
+    if (on) s_simOutput |= bit;
+    else    s_simOutput &= ~bit;
+    return;
+  }
+  digitalWrite(pin, on ? HIGH : LOW);
+}
+
+int halOutputRead(int pin) {
+  if (s_sim) return (pin >= 0 && pin < 64 && ((s_simOutput >> pin) & 1)) ? HIGH : LOW;
+  return digitalRead(pin);
+}
+
+// ESP8266: o botão roda na interrupção do timer1, então a seção crítica
+// mascara interrupções (sem aninhar). ESP32: o Ticker roda em outra task.
+// Na simulação o trace aloca String e o botão é ignorado: sem seção crítica.
+void IRAM_ATTR halLock() {
+  if (s_sim) return;
+#ifdef ESP8266
+  s_savedPs = xt_rsil(15);
+#else
+  portENTER_CRITICAL(&s_mux);
+#endif
+}
+
+void IRAM_ATTR halUnlock() {
+  if (s_sim) return;
+#ifdef ESP8266
+  xt_wsr_ps(s_savedPs);
+#else
+  portEXIT_CRITICAL(&s_mux);
+#endif
+}
+
+#ifdef ESP8266
+static void IRAM_ATTR onTick() {
+  uint8_t n = s_tickCount;
+  for (uint8_t i = 0; i < n; i++) s_tickFn[i]();
+}
+
+bool halTickAttach(HalTickFn fn) {
+  uint8_t n = s_tickCount;
+  if (n >= HAL_TICK_MAX) return false;
+  s_tickFn[n] = fn;   // entrada completa antes de a ISR contá-la
+  s_tickCount = n + 1;
+  if (n == 0) {
+    timer1_isr_init();
+    timer1_attachInterrupt(onTick);
+    timer1_enable(TIM_DIV256, TIM_EDGE, TIM_LOOP);
+    timer1_write(HAL_TICK_MS * 3125UL / 10UL);
+  }
+  return true;
+}
+#endif
+
+bool halPersistAllowed() {
+  return !s_sim;
+}
+
+void halSimBegin(time_t startUtc, HalTraceFn trace) {
+  HalSimState st = { startUtc, 1, 0 };   // ms = 1: 0 é "nunca" para lastTriggerMs
+  halSimResume(st, trace);
+}
+
+void halSimSave(HalSimState& st) {
+  st.utc    = s_simUtc;
+  st.ms     = s_simMs;
+  st.output = s_simOutput;
+}
+
+void halSimResume(const HalSimState& st, HalTraceFn trace) {
+  s_sim       = true;
+  s_simUtc    = st.utc;
+  s_simMs     = st.ms;
+  s_simOutput = st.output;
+  s_trace     = trace;
+}
+
+void halSimAdvance(unsigned long seconds) {
+  s_simUtc += seconds;
+  s_simMs  += seconds * 1000UL;
+}
+
+void halSimEnd() {
+  s_sim   = false;
+  s_trace = nullptr;
+}
+
+bool IRAM_ATTR halSimulating() {
+  return s_sim;
+}
@@ -0,0 +1,63 @@
+// hal.h
+#ifndef HAL_H
+#define HAL_H
+
+#include <Arduino.h>
+#include <time.h>
+
+// Camada fina entre o motor (agendamentos, regras, saída) e o hardware:
+// relógio, GPIO da saída e persistência. Em modo simulação o relógio é
+// virtual, a saída é registrada em vez de acionada e nada é gravado no FS.
+
+// ===== Relógio =====
+time_t        halUtcNow();   // UTC (TimeLib ou relógio virtual)
+unsigned long halMillis();   // millis() ou equivalente virtual
+
+// ===== GPIO das saídas =====
+void halOutputWrite(int pin, bool on);
+int  halOutputRead(int pin);
+
+// Seção crítica curta em torno do estado da saída, que também é alterado
+// pelo botão (ESP8266: interrupção do timer1; ESP32: task do Ticker).
+// Não aninha.
+void halLock();
+void halUnlock();
+
+// ===== Tick de hardware (ESP8266) =====
+// O Ticker do ESP8266 é um os_timer que só roda quando o loop cede; o botão
+// e o LED de status dividem uma interrupção do timer1 a cada HAL_TICK_MS
+// (80 MHz / 256). Os callbacks rodam em interrupção: IRAM_ATTR, curtos.
+// No ESP32 cada módulo usa o próprio Ticker (task do esp_timer).
+#ifdef ESP8266
+static constexpr uint32_t HAL_TICK_MS  = 5;
+static constexpr uint8_t  HAL_TICK_MAX = 2;   // botão e LED
+
+typedef void (*HalTickFn)();
+
+// Registra fn no tick (liga o timer1 no primeiro); false se já há HAL_TICK_MAX.
+bool halTickAttach(HalTickFn fn);
+#endif
+
+// ===== Persistência =====
+bool halPersistAllowed();          // false durante simulação (log: logbuf.h)
+
+// ===== Simulação =====
+typedef void (*HalTraceFn)(time_t utc, int pin, bool on);
+
+void halSimBegin(time_t startUtc, HalTraceFn trace);
+void halSimAdvance(unsigned long seconds);
+void halSimEnd();
+bool halSimulating();
+
+// Relógio e saídas virtuais de uma simulação fatiada (simulator.h): salvos
+// com halSimSave() antes de halSimEnd() e retomados na fatia seguinte.
+struct HalSimState {
+  time_t        utc;
+  unsigned long ms;
+  uint64_t      output;
+};
+
+void halSimSave(HalSimState& st);
+void halSimResume(const HalSimState& st, HalTraceFn trace);
+
+#endif // HAL_H
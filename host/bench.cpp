@@ -0,0 +1,62 @@
+// bench.cpp (host)
+// Suíte de bench.h no Linux, sem o limite de tempo do GET /bench e com
+// allocs_op (alocações por operação) em cada resultado.
+//
+//   build/bench [-c config.json] [-k caso] [-m ms_por_caso] [-o saida.json]
+//
+// Imprime o JSON de benchRun() (e grava em -o).
+// allocs_op conta as alocações do host: a String dos stubs (std::string)
+// guarda até 15 caracteres sem alocar, e os casos de config medem o
+// subconjunto de stubs/ArduinoJson.h salvo com ARDUINOJSON=dir.
+
+#include <Arduino.h>
+#include <TimeLib.h>
+#include <unistd.h>
+#include <string>
+#include "../bench.h"
+#include "../tz_rules.h"
+#include "fw_globals.h"
+
+int main(int argc, char** argv) {
+  const char*   cfgPath = nullptr;
+  const char*   only    = "";
+  const char*   outPath = nullptr;
+  unsigned long caseMs  = 200;
+  for (int opt; (opt = getopt(argc, argv, "c:k:m:o:")) != -1;) {
+    switch (opt) {
+      case 'c': cfgPath = optarg; break;
+      case 'k': only    = optarg; break;
+      case 'm': caseMs  = strtoul(optarg, nullptr, 10); break;
+      case 'o': outPath = optarg; break;
+      default:
+        fprintf(stderr, "uso: %s [-c config.json] [-k caso] [-m ms_por_caso] [-o saida.json]\n", argv[0]);
+        return 2;
+    }
+  }
+
+  hostDefaults(cfg);
+  if (cfgPath) {
+    std::string json;
+    FILE* f = fopen(cfgPath, "rb");
+    char  buf[4096];
+    for (size_t n; f && (n = fread(buf, 1, sizeof(buf), f)) > 0;) json.append(buf, n);
+    if (f) fclose(f);
+    if (!f || !configFromJson(cfg, json.data(), json.size())) {
+      fprintf(stderr, "config inválida: %s\n", cfgPath);
+      return 1;
+    }
+  }
+  tzSet(cfg.tz);
+  setTime(1767225600);   // 2026-01-01 00:00 UTC
+
+  String out = benchRun(cfg, only, caseMs);
+  puts(out.c_str());
+  if (outPath) {
+    FILE* f = fopen(outPath, "w");
+    if (!f) return 1;
+    fputs(out.c_str(), f);
+    fputc('\n', f);
+    fclose(f);
+  }
+  return 0;
+}
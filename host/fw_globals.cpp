@@ -0,0 +1,29 @@
+// fw_globals.cpp (host)
+// Globais que o firmware define no .ino, para as ferramentas de host que não
+// o incluem (sim, testes). hostDefaults() repete os defaults do setup().
+
+#include <Arduino.h>
+#include <RTClib.h>
+#include "../config.h"
+#include "../webserver.h"
+#include "fw_globals.h"
+
+Config      cfg;
+WebSrv      server(80);
+RTC_DS3231  rtc;
+bool        rtcInitialized = false;
+
+void hostDefaults(Config& c) {
+  static constexpr int PINS[MAX_CHANNELS] = { 5, 18, 19, 21, 22, 23, 25, 26 };
+  memset(&c, 0, sizeof(c));
+  c.channelCount = 1;
+  for (int ch = 0; ch < MAX_CHANNELS; ch++) defaultChannel(c.channels[ch], PINS[ch]);
+  strncpy(c.tz, DEFAULT_TZ, sizeof(c.tz) - 1);
+  c.sensorPeriodSec = 10;
+  c.extPin          = -1;
+  c.extScale        = 1.0f;
+  c.mqtt.port       = 1883;
+  c.mqtt.stateSec   = 60;
+  c.beaconSec       = 30;
+  c.beaconChannels  = MAX_CHANNELS;
+}
@@ -0,0 +1,12 @@
+// fw_globals.h (host)
+#ifndef HOST_FW_GLOBALS_H
+#define HOST_FW_GLOBALS_H
+
+#include "../config.h"
+
+extern Config cfg;
+
+// Config padrão do setup() (pinos do ESP32, TZ DEFAULT_TZ, um canal)
+void hostDefaults(Config& c);
+
+#endif // HOST_FW_GLOBALS_H
@@ -0,0 +1,312 @@
+#!/usr/bin/env python3
+# loadtest.py
+# Teste de carga HTTP do firmware: o padrão de polling da UI (webpage.h) e
+# rajadas de /setSchedules, contra build/timer_host (o .ino no Linux) ou
+# contra um aparelho na rede (--url).
+#
+#   python3 loadtest.py --server build/timer_host [--mix poll|burst|mixed]
+#                       [--clients N] [--duration S] [--speed X] [--out f.json]
+#   python3 loadtest.py --url http://192.168.0.50 --mix poll --clients 3
+#
+# Cada cliente da UI repete os timers da página (/time 1 s, /events 2 s,
+# /status 2,5 s, /rssi 5 s, /nextTriggerTime 30 s), divididos por --speed.
+# As rajadas postam --burst-size /setSchedules seguidos a cada
+# --burst-every segundos, sempre a mesma lista: horários fixados no início,
+# espaçados ao longo do teste, para que os disparos caiam durante a carga e
+# o atraso deles seja medido.
+#
+# Resultado (JSON em --out e resumo no stdout):
+#   client  latência p50/p99/max por rota e contagem de status, medidas aqui
+#   server  /metrics, /tasks e /admission do firmware ao fim (zerados no
+#           início): latência por rota no handler, gap do loop, menor heap
+#           livre e atraso dos disparos
+# Sai com 1 se houve erro de transporte ou 5xx fora o 503 da admissão.
+# No host cada cliente usa um IP de origem próprio (127.0.0.x) para ter o
+# seu balde na admissão, como aparelhos distintos na rede.
+
+import argparse
+import http.client
+import json
+import os
+import random
+import shutil
+import signal
+import socket
+import subprocess
+import sys
+import tempfile
+import threading
+import time
+import urllib.parse
+
+UI_TIMERS = [            # (rota, período em s) como em webpage.h
+    ("/time",            1.0),
+    ("/events",          2.0),
+    ("/status",          2.5),
+    ("/rssi",            5.0),
+    ("/nextTriggerTime", 30.0),
+]
+SLOT_LEAD_S    = 10      # primeiro horário das rajadas: início + isto
+SLOT_SPACING_S = 15      # > FEED_COOLDOWN entre horários
+SLOT_MAX       = 10      # MAX_SLOTS
+SLOT_DUR_S     = 3
+
+
+def percentile(sorted_vals, p):
+    if not sorted_vals:
+        return 0.0
+    k = min(len(sorted_vals) - 1, max(0, int(round(p / 100.0 * len(sorted_vals) + 0.5)) - 1))
+    return sorted_vals[k]
+
+
+class Stats:
+    def __init__(self):
+        self.lock   = threading.Lock()
+        self.lat    = {}   # rota -> [ms]
+        self.status = {}   # rota -> {código: n}
+        self.errors = {}   # rota -> n (timeout, conexão recusada...)
+
+    def add(self, route, ms, code):
+        with self.lock:
+            self.lat.setdefault(route, []).append(ms)
+            st = self.status.setdefault(route, {})
+            st[code] = st.get(code, 0) + 1
+
+    def error(self, route):
+        with self.lock:
+            self.errors[route] = self.errors.get(route, 0) + 1
+
+    def report(self):
+        out = {}
+        for route in sorted(set(self.lat) | set(self.errors)):
+            v = sorted(self.lat.get(route, []))
+            out[route] = {
+                "count":  len(v),
+                "p50_ms": round(percentile(v, 50), 2),
+                "p99_ms": round(percentile(v, 99), 2),
+                "max_ms": round(v[-1], 2) if v else 0.0,
+                "status": {str(k): n for k, n in sorted(self.status.get(route, {}).items())},
+                "errors": self.errors.get(route, 0),
+            }
+        return out
+
+
+class Target:
+    def __init__(self, host, port, timeout):
+        self.host    = host
+        self.port    = port
+        self.timeout = timeout
+        self.local   = host in ("127.0.0.1", "localhost")
+
+    def request(self, method, path, body=None, source=None, headers=None):
+        src = (source, 0) if source and self.local else None
+        conn = http.client.HTTPConnection(self.host, self.port, timeout=self.timeout,
+                                          source_address=src)
+        try:
+            hdrs = dict(headers or {})
+            if body is not None:
+                hdrs.setdefault("Content-Type", "application/x-www-form-urlencoded")
+            t0 = time.perf_counter()
+            conn.request(method, path, body=body, headers=hdrs)
+            resp = conn.getresponse()
+            data = resp.read()
+            ms = (time.perf_counter() - t0) * 1000.0
+            return resp.status, data, ms
+        finally:
+            conn.close()
+
+    def get_json(self, path):
+        code, data, _ = self.request("GET", path)
+        if code != 200:
+            raise RuntimeError("%s: HTTP %d" % (path, code))
+        return json.loads(data.decode("utf-8"))
+
+
+def ui_client(target, stats, stop, idx, speed):
+    source = "127.0.0.%d" % (10 + idx)
+    due = {route: time.monotonic() + random.uniform(0, period / speed)
+           for route, period in UI_TIMERS}
+    while not stop.is_set():
+        now = time.monotonic()
+        for route, period in UI_TIMERS:
+            if now < due[route]:
+                continue
+            due[route] += period / speed
+            if due[route] < now:           # atrasado: não acumula disparos
+                due[route] = now + period / speed
+            try:
+                code, _, ms = target.request("GET", route, source=source)
+                stats.add(route, ms, code)
+            except (OSError, http.client.HTTPException):
+                stats.error(route)
+        nxt = min(due.values()) - time.monotonic()
+        if nxt > 0:
+            stop.wait(nxt)
+
+
+def local_now(target):
+    code, data, _ = target.request("GET", "/time")
+    h, m, s = (int(x) for x in data.decode().strip().split(":"))
+    return h * 3600 + m * 60 + s
+
+
+def schedules_body(base_s, duration):
+    slots = []
+    count = max(1, min(SLOT_MAX, int((duration - SLOT_LEAD_S) // SLOT_SPACING_S) + 1))
+    for i in range(count):
+        t = (base_s + SLOT_LEAD_S + i * SLOT_SPACING_S) % 86400
+        slots.append("%02d:%02d:%02d|00:00:%02d" % (t // 3600, t // 60 % 60, t % 60, SLOT_DUR_S))
+    return urllib.parse.urlencode({"ch": 0, "schedules": ",".join(slots)})
+
+
+def burst_client(target, stats, stop, idx, size, every, body):
+    source = "127.0.0.%d" % (100 + idx)
+    while not stop.is_set():
+        for _ in range(size):
+            if stop.is_set():
+                break
+            try:
+                code, _, ms = target.request("POST", "/setSchedules", body=body, source=source)
+                stats.add("/setSchedules", ms, code)
+            except (OSError, http.client.HTTPException):
+                stats.error("/setSchedules")
+        stop.wait(every)
+
+
+def free_port():
+    with socket.socket() as s:
+        s.bind(("127.0.0.1", 0))
+        return s.getsockname()[1]
+
+
+def start_server(path, port):
+    fs = tempfile.mkdtemp(prefix="timer_fs_")
+    env = dict(os.environ, HOST_FS=fs, HOST_HTTP_PORT=str(port), HOST_SERIAL="off")
+    log = tempfile.TemporaryFile()   # não PIPE: um pipe cheio travaria o loop
+    proc = subprocess.Popen([path], env=env, stdout=subprocess.DEVNULL, stderr=log)
+    target = Target("127.0.0.1", port, 5.0)
+    deadline = time.monotonic() + 15
+    while time.monotonic() < deadline:
+        if proc.poll() is not None:
+            log.seek(0)
+            raise RuntimeError("servidor saiu com %d: %s" % (proc.returncode, log.read().decode()))
+        try:
+            if target.request("GET", "/time")[0] == 200:
+                return proc, fs, target
+        except OSError:
+            time.sleep(0.1)
+    proc.kill()
+    raise RuntimeError("servidor não respondeu em /time")
+
+
+def stop_server(proc, fs):
+    proc.send_signal(signal.SIGTERM)
+    try:
+        proc.wait(5)
+    except subprocess.TimeoutExpired:
+        proc.kill()
+    shutil.rmtree(fs, ignore_errors=True)
+
+
+def main():
+    ap = argparse.ArgumentParser(description="Teste de carga HTTP do temporizador")
+    src = ap.add_mutually_exclusive_group(required=True)
+    src.add_argument("--server", help="executável do host (build/timer_host)")
+    src.add_argument("--url", help="aparelho já em execução (http://ip[:porta])")
+    ap.add_argument("--mix", choices=("poll", "burst", "mixed"), default="mixed")
+    ap.add_argument("--clients", type=int, default=4, help="clientes da UI (poll/mixed)")
+    ap.add_argument("--burst-clients", type=int, default=1)
+    ap.add_argument("--burst-size", type=int, default=10)
+    ap.add_argument("--burst-every", type=float, default=5.0)
+    ap.add_argument("--duration", type=float, default=60.0, help="segundos")
+    ap.add_argument("--speed", type=float, default=1.0, help="divide os períodos da UI")
+    ap.add_argument("--seed", type=int, default=1)
+    ap.add_argument("--out", help="arquivo JSON com o resultado")
+    args = ap.parse_args()
+    random.seed(args.seed)
+
+    proc = fs = None
+    if args.server:
+        proc, fs, target = start_server(args.server, free_port())
+    else:
+        u = urllib.parse.urlparse(args.url)
+        target = Target(u.hostname, u.port or 80, 5.0)
+
+    try:
+        for path in ("/metrics?reset=1", "/tasks?reset=1", "/admission?reset=1"):
+            target.get_json(path)
+
+        stats, stop, threads = Stats(), threading.Event(), []
+        if args.mix in ("poll", "mixed"):
+            for i in range(args.clients):
+                threads.append(threading.Thread(target=ui_client,
+                                                args=(target, stats, stop, i, args.speed)))
+        if args.mix in ("burst", "mixed"):
+            body = schedules_body(local_now(target), args.duration)
+            for i in range(args.burst_clients):
+                threads.append(threading.Thread(target=burst_client,
+                                                args=(target, stats, stop, i,
+                                                      args.burst_size, args.burst_every, body)))
+        t0 = time.monotonic()
+        for t in threads:
+            t.start()
+        stop.wait(args.duration)
+        stop.set()
+        for t in threads:
+            t.join()
+        elapsed = time.monotonic() - t0
+
+        server = {
+            "metrics":   target.get_json("/metrics"),
+            "tasks":     target.get_json("/tasks"),
+            "admission": target.get_json("/admission"),
+        }
+    finally:
+        if proc:
+            stop_server(proc, fs)
+
+    routes = stats.report()
+    every  = sorted(ms for v in stats.lat.values() for ms in v)
+    total  = sum(r["count"] for r in routes.values())
+    errors = sum(r["errors"] for r in routes.values())
+    bad5xx = sum(n for r in routes.values() for c, n in r["status"].items()
+                 if c.startswith("5") and c != "503")
+    m = server["metrics"]
+    summary = {
+        "requests":        total,
+        "rps":             round(total / elapsed, 1) if elapsed else 0,
+        "p50_ms":          round(percentile(every, 50), 2),
+        "p99_ms":          round(percentile(every, 99), 2),
+        "errors":          errors,
+        "status_5xx":      bad5xx,
+        "throttled_429":   sum(r["status"].get("429", 0) for r in routes.values()),
+        "shed_503":        sum(r["status"].get("503", 0) for r in routes.values()),
+        "heap_min_free":   m.get("heap_min_free"),
+        "loop_gap_p99_us": m.get("loop_gap", {}).get("p99_us"),
+        "triggers":        m.get("triggers", {}).get("count"),
+        "trigger_late":    m.get("triggers", {}).get("late"),
+        "trigger_late_max_s": m.get("triggers", {}).get("late_max_s"),
+    }
+    result = {
+        "mix": args.mix, "clients": args.clients, "burst_clients": args.burst_clients,
+        "burst_size": args.burst_size, "burst_every_s": args.burst_every,
+        "duration_s": round(elapsed, 2), "speed": args.speed,
+        "target": args.url or "host",
+        "summary": summary, "client": routes, "server": server,
+    }
+    if args.out:
+        with open(args.out, "w") as f:
+            json.dump(result, f, indent=1)
+
+    print("%-18s %7s %9s %9s %9s  status" % ("rota", "n", "p50 ms", "p99 ms", "max ms"))
+    for route, r in routes.items():
+        st = " ".join("%s:%d" % kv for kv in r["status"].items())
+        if r["errors"]:
+            st += " err:%d" % r["errors"]
+        print("%-18s %7d %9.2f %9.2f %9.2f  %s" % (route, r["count"], r["p50_ms"], r["p99_ms"], r["max_ms"], st))
+    print(" ".join("%s=%s" % kv for kv in summary.items()))
+    return 1 if errors or bad5xx else 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,105 @@
+// sim.cpp (host)
+// Replay acelerado da config no Linux, com o mesmo engineTick() do firmware
+// (o GET /simulate do dispositivo, sem orçamento de CPU nem fatias).
+//
+//   build/sim [-c config.json] [-s "AAAA-MM-DD HH:MM"] [-d dias]
+//             [-n canal -r "regras"] [-q]
+//
+// -c lê o formato de config.json; -s é hora local no fuso da config
+// (padrão: 2026-01-01 00:00); -r substitui as regras do canal -n e as ativa.
+// Imprime o trace (até SIM_MAX_TRACE linhas, -q omite) e a linha "# ..." do
+// resumo. Sai com 1 se a config ou as regras forem inválidas.
+
+#include <Arduino.h>
+#include <limits.h>
+#include <unistd.h>
+#include <string>
+#include "../config.h"
+#include "../custom_rules.h"
+#include "../exceptions.h"
+#include "../simulator.h"
+#include "../sun_times.h"
+#include "../time_utils.h"
+#include "../tz_rules.h"
+#include "fw_globals.h"
+
+static bool readFile(const char* path, std::string& out) {
+  FILE* f = fopen(path, "rb");
+  if (!f) return false;
+  char buf[4096];
+  for (size_t n; (n = fread(buf, 1, sizeof(buf), f)) > 0;) out.append(buf, n);
+  fclose(f);
+  return true;
+}
+
+int main(int argc, char** argv) {
+  const char* cfgPath = nullptr;
+  const char* start   = "2026-01-01 00:00";
+  const char* rules   = nullptr;
+  long        days    = 1;
+  int         ch      = 0;
+  bool        quiet   = false;
+  for (int opt; (opt = getopt(argc, argv, "c:s:d:n:r:q")) != -1;) {
+    switch (opt) {
+      case 'c': cfgPath = optarg; break;
+      case 's': start   = optarg; break;
+      case 'd': days    = atol(optarg); break;
+      case 'n': ch      = atoi(optarg); break;
+      case 'r': rules   = optarg; break;
+      case 'q': quiet   = true; break;
+      default:
+        fprintf(stderr, "uso: %s [-c config.json] [-s \"AAAA-MM-DD HH:MM\"] [-d dias] [-n canal -r regras] [-q]\n", argv[0]);
+        return 2;
+    }
+  }
+
+  hostDefaults(cfg);
+  if (cfgPath) {
+    std::string json;
+    if (!readFile(cfgPath, json) || !configFromJson(cfg, json.data(), json.size())) {
+      fprintf(stderr, "config inválida: %s\n", cfgPath);
+      return 1;
+    }
+  }
+  if (!tzSet(cfg.tz)) {
+    fprintf(stderr, "TZ inválido: %s\n", cfg.tz);
+    return 1;
+  }
+  if (cfg.hasLocation) sunSetLocation(cfg.latitude, cfg.longitude);
+  excBegin();
+
+  Config* sim = new Config(cfg);
+  if (ch < 0 || ch >= sim->channelCount) {
+    fprintf(stderr, "canal inválido: %d\n", ch);
+    return 1;
+  }
+  if (rules) {
+    ChannelConfig& c = sim->channels[ch];
+    strncpy(c.customSchedule, rules, sizeof(c.customSchedule) - 1);
+    c.customSchedule[sizeof(c.customSchedule) - 1] = '\0';
+    int    errPos;
+    String errMsg;
+    if (!compileCustomRules(c, errPos, errMsg)) {
+      fprintf(stderr, "Erro na posição %d: %s\n", errPos, errMsg.c_str());
+      return 1;
+    }
+    c.customEnabled = true;
+  }
+
+  int y, mo, d, h, mi;
+  if (sscanf(start, "%d-%d-%d %d:%d", &y, &mo, &d, &h, &mi) != 5 || days < 1) {
+    fprintf(stderr, "use -s \"AAAA-MM-DD HH:MM\" e -d >= 1\n");
+    return 2;
+  }
+  time_t local    = (time_t)daysFromCivil(y, mo, d) * 86400L + h * 3600L + mi * 60L;
+  time_t startUtc = local - tzOffsetAt(local);
+  setTime(startUtc);
+
+  String    trace;
+  SimResult r = simulateRun(*sim, startUtc, (unsigned long)days * 86400UL, ULONG_MAX, trace);
+  delete sim;
+  if (!quiet) fputs(trace.c_str(), stdout);
+  printf("# simulado_s=%lu real_ms=%lu transicoes=%lu truncado=%d\n",
+         r.simulatedSec, r.wallMs, r.transitions, r.truncated ? 1 : 0);
+  return 0;
+}
@@ -0,0 +1,227 @@
+// Arduino.cpp (host)
+
+#include <Arduino.h>
+#include <stdarg.h>
+#include <chrono>
+#include <malloc.h>
+#include <new>
+#include <poll.h>
+#include <thread>
+#include <vector>
+
+HardwareSerial Serial;
+EspClass       ESP;
+
+static const auto s_t0 = std::chrono::steady_clock::now();
+static int        s_pins[64];
+static std::vector<void (*)()>    s_polls;
+static std::vector<struct pollfd> s_fds;
+
+unsigned long millis() {
+  return (unsigned long)std::chrono::duration_cast<std::chrono::milliseconds>(
+           std::chrono::steady_clock::now() - s_t0).count();
+}
+
+unsigned long micros() {
+  return (unsigned long)std::chrono::duration_cast<std::chrono::microseconds>(
+           std::chrono::steady_clock::now() - s_t0).count();
+}
+
+void hostAddPoll(void (*fn)()) {
+  s_polls.push_back(fn);
+}
+
+void hostWatchFd(int fd, short events) {
+  for (size_t i = 0; i < s_fds.size(); i++) {
+    if (s_fds[i].fd != fd) continue;
+    if (events) s_fds[i].events = events;
+    else        s_fds.erase(s_fds.begin() + i);
+    return;
+  }
+  if (events) s_fds.push_back({ fd, events, 0 });
+}
+
+static void service() {
+  for (size_t i = 0; i < s_polls.size(); i++) s_polls[i]();
+}
+
+// Dorme até `ms` ou até um descritor vigiado ficar pronto
+static void waitIo(unsigned long ms) {
+  if (s_fds.empty()) std::this_thread::sleep_for(std::chrono::milliseconds(ms));
+  else               ::poll(s_fds.data(), s_fds.size(), (int)ms);
+}
+
+void delay(unsigned long ms) {
+  unsigned long t0 = millis();
+  service();
+  while (millis() - t0 < ms) {
+    waitIo(std::min<unsigned long>(ms - (millis() - t0), 10));
+    service();
+  }
+}
+
+void delayMicroseconds(unsigned int us) {
+  std::this_thread::sleep_for(std::chrono::microseconds(us));
+}
+
+void yield() {
+  service();
+}
+
+long map(long x, long inMin, long inMax, long outMin, long outMax) {
+  return (x - inMin) * (outMax - outMin) / (inMax - inMin) + outMin;
+}
+
+void pinMode(int, int) {}
+
+void digitalWrite(int pin, int val) {
+  if (pin >= 0 && pin < 64) s_pins[pin] = val;
+}
+
+int digitalRead(int pin) {
+  return pin >= 0 && pin < 64 ? s_pins[pin] : LOW;
+}
+
+int hostPin(int pin) {
+  return digitalRead(pin);
+}
+
+int  analogRead(int) { return 0; }
+void attachInterrupt(int, void (*)(), int) {}
+void detachInterrupt(int) {}
+
+size_t Print::printf(const char* fmt, ...) {
+  char    buf[256];
+  va_list ap;
+  va_start(ap, fmt);
+  int n = vsnprintf(buf, sizeof(buf), fmt, ap);
+  va_end(ap);
+  if (n < 0) return 0;
+  if ((size_t)n < sizeof(buf)) return write((const uint8_t*)buf, n);
+  std::vector<char> big(n + 1);
+  va_start(ap, fmt);
+  vsnprintf(big.data(), big.size(), fmt, ap);
+  va_end(ap);
+  return write((const uint8_t*)big.data(), n);
+}
+
+static FILE* serialOut() {
+  static FILE* out = []() -> FILE* {
+    const char* e = getenv("HOST_SERIAL");
+    if (e && strcmp(e, "off") == 0)    return nullptr;
+    if (e && strcmp(e, "stderr") == 0) return stderr;
+    return stdout;
+  }();
+  return out;
+}
+
+size_t HardwareSerial::write(uint8_t b) {
+  return write(&b, 1);
+}
+
+size_t HardwareSerial::write(const uint8_t* buf, size_t n) {
+  FILE* out = serialOut();
+  if (!out) return n;
+  fwrite(buf, 1, n, out);
+  if (memchr(buf, '\n', n)) fflush(out);
+  return n;
+}
+
+void EspClass::restart() {
+  Serial.println("ESP.restart() no host: encerrando");
+  fflush(stdout);
+  exit(3);
+}
+
+uint32_t EspClass::getCycleCount() {
+  return (uint32_t)(micros() * (uint64_t)getCpuFreqMHz());
+}
+
+void configTime(long, int, const char*, const char*, const char*) {}
+
+// ===== Contador de alocações e heap =====
+// O heap "livre" é o de um ESP32 típico menos os bytes vivos alocados pelo
+// código compilado aqui, para que /metrics e o heap_b_op do bench meçam
+// retenção e pico como no dispositivo.
+
+static constexpr size_t HOST_HEAP_BYTES = 160 * 1024;
+
+static uint64_t s_allocs  = 0;
+static size_t   s_live    = 0;
+static size_t   s_minFree = HOST_HEAP_BYTES;
+
+uint64_t hostAllocCount() {
+  return s_allocs;
+}
+
+extern "C" {
+void* __real_malloc(size_t n);
+void* __real_calloc(size_t k, size_t n);
+void* __real_realloc(void* p, size_t n);
+void  __real_free(void* p);
+}
+
+static void* track(void* p) {
+  if (!p) return p;
+  s_allocs++;
+  s_live += malloc_usable_size(p);
+  size_t freeNow = s_live < HOST_HEAP_BYTES ? HOST_HEAP_BYTES - s_live : 0;
+  if (freeNow < s_minFree) s_minFree = freeNow;
+  return p;
+}
+
+static void untrack(void* p) {
+  if (!p) return;
+  size_t n = malloc_usable_size(p);
+  s_live = n < s_live ? s_live - n : 0;   // blocos de fora (libc) não somaram
+}
+
+extern "C" {
+void* __wrap_malloc(size_t n) {
+  return track(__real_malloc(n));
+}
+
+void* __wrap_calloc(size_t k, size_t n) {
+  return track(__real_calloc(k, n));
+}
+
+void* __wrap_realloc(void* p, size_t n) {
+  untrack(p);
+  return track(__real_realloc(p, n));
+}
+
+void __wrap_free(void* p) {
+  untrack(p);
+  __real_free(p);
+}
+}
+
+void* operator new(size_t n) {
+  if (void* p = track(__real_malloc(n ? n : 1))) return p;
+  throw std::bad_alloc();
+}
+
+void* operator new[](size_t n) {
+  return operator new(n);
+}
+
+void* operator new(size_t n, const std::nothrow_t&) noexcept {
+  return track(__real_malloc(n ? n : 1));
+}
+
+void* operator new[](size_t n, const std::nothrow_t& t) noexcept {
+  return operator new(n, t);
+}
+
+void operator delete(void* p) noexcept { __wrap_free(p); }
+void operator delete[](void* p) noexcept { __wrap_free(p); }
+void operator delete(void* p, size_t) noexcept { __wrap_free(p); }
+void operator delete[](void* p, size_t) noexcept { __wrap_free(p); }
+
+uint32_t EspClass::getFreeHeap() {
+  return s_live < HOST_HEAP_BYTES ? (uint32_t)(HOST_HEAP_BYTES - s_live) : 0;
+}
+
+uint32_t EspClass::getMinFreeHeap()      { return (uint32_t)s_minFree; }
+uint32_t EspClass::getMaxAllocHeap()     { return getFreeHeap() * 7 / 10; }
+uint32_t EspClass::getMaxFreeBlockSize() { return getMaxAllocHeap(); }
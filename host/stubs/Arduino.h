@@ -0,0 +1,323 @@
+// Arduino.h (host)
+// Núcleo Arduino mínimo para compilar o firmware no Linux (host/Makefile).
+// Compila como ESP32 (sem ESP8266 definido); relógio, GPIO e heap são do
+// processo: millis()/micros() vêm do relógio monotônico, os pinos são um
+// vetor em memória e delay() dorme atendendo os sockets dos stubs de rede.
+#ifndef HOST_ARDUINO_H
+#define HOST_ARDUINO_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+#include <string>
+#include <algorithm>
+#include <functional>
+
+typedef uint8_t byte;
+typedef bool    boolean;
+
+#define HIGH          1
+#define LOW           0
+#define INPUT         0
+#define OUTPUT        1
+#define INPUT_PULLUP  2
+#define RISING        1
+#define FALLING       2
+#define CHANGE        3
+#define LED_BUILTIN   2
+
+#define PROGMEM
+#define PGM_P             const char*
+#define IRAM_ATTR
+#define ICACHE_RAM_ATTR
+#define F(s)              (s)
+#define PSTR(s)           (s)
+#define FPSTR(s)          (s)
+#define pgm_read_byte(p)  (*(const uint8_t*)(p))
+#define pgm_read_word(p)  (*(const uint16_t*)(p))
+#define pgm_read_dword(p) (*(const uint32_t*)(p))
+#define pgm_read_ptr(p)   (*(void* const*)(p))
+#define strlen_P          strlen
+#define strcmp_P          strcmp
+#define strncmp_P         strncmp
+#define memcpy_P          memcpy
+#define snprintf_P        snprintf
+
+#define digitalPinToInterrupt(p) (p)
+#define constrain(x, lo, hi)     ((x) < (lo) ? (lo) : ((x) > (hi) ? (hi) : (x)))
+#define noInterrupts()
+#define interrupts()
+
+static const uint8_t A0 = 36;
+
+class __FlashStringHelper;
+
+unsigned long millis();
+unsigned long micros();
+void          delay(unsigned long ms);
+void          delayMicroseconds(unsigned int us);
+void          yield();
+long          map(long x, long inMin, long inMax, long outMin, long outMax);
+
+void pinMode(int pin, int mode);
+void digitalWrite(int pin, int val);
+int  digitalRead(int pin);
+int  analogRead(int pin);
+void attachInterrupt(int irq, void (*fn)(), int mode);
+void detachInterrupt(int irq);
+
+// ===== String (sobre std::string) =====
+class String {
+ public:
+  String() {}
+  String(const char* c) { if (c) s_ = c; }
+  String(const std::string& s) : s_(s) {}
+  String(const char* c, size_t n) : s_(c, n) {}
+  explicit String(char c) : s_(1, c) {}
+  String(int v)                { s_ = std::to_string(v); }
+  String(unsigned int v)       { s_ = std::to_string(v); }
+  String(long v)               { s_ = std::to_string(v); }
+  String(unsigned long v)      { s_ = std::to_string(v); }
+  String(long long v)          { s_ = std::to_string(v); }
+  String(unsigned long long v) { s_ = std::to_string(v); }
+  String(float v, unsigned int dec = 2)  { fmt(v, dec); }
+  String(double v, unsigned int dec = 2) { fmt(v, dec); }
+
+  unsigned int length() const { return (unsigned int)s_.size(); }
+  bool         isEmpty() const { return s_.empty(); }
+  const char*  c_str() const { return s_.c_str(); }
+  bool         reserve(unsigned int n) { s_.reserve(n); return true; }
+
+  char charAt(unsigned int i) const { return i < s_.size() ? s_[i] : 0; }
+  char operator[](unsigned int i) const { return charAt(i); }
+  char& operator[](unsigned int i) { return s_[i]; }
+  void setCharAt(unsigned int i, char c) { if (i < s_.size()) s_[i] = c; }
+
+  int indexOf(char c, unsigned int from = 0) const { return pos(s_.find(c, from)); }
+  int indexOf(const String& x, unsigned int from = 0) const { return pos(s_.find(x.s_, from)); }
+  int lastIndexOf(char c) const { return pos(s_.rfind(c)); }
+  int lastIndexOf(const String& x) const { return pos(s_.rfind(x.s_)); }
+
+  String substring(unsigned int from) const {
+    return from >= s_.size() ? String() : String(s_.substr(from));
+  }
+  String substring(unsigned int from, unsigned int to) const {
+    if (from > to) std::swap(from, to);
+    if (from >= s_.size()) return String();
+    return String(s_.substr(from, to - from));
+  }
+
+  bool startsWith(const String& x) const { return s_.compare(0, x.s_.size(), x.s_) == 0; }
+  bool endsWith(const String& x) const {
+    return s_.size() >= x.s_.size() && s_.compare(s_.size() - x.s_.size(), x.s_.size(), x.s_) == 0;
+  }
+  bool equals(const String& x) const { return s_ == x.s_; }
+  bool equalsIgnoreCase(const String& x) const {
+    if (s_.size() != x.s_.size()) return false;
+    for (size_t i = 0; i < s_.size(); i++) {
+      if (tolower((unsigned char)s_[i]) != tolower((unsigned char)x.s_[i])) return false;
+    }
+    return true;
+  }
+  int compareTo(const String& x) const { return s_.compare(x.s_); }
+
+  long   toInt() const { return strtol(s_.c_str(), nullptr, 10); }
+  float  toFloat() const { return strtof(s_.c_str(), nullptr); }
+  double toDouble() const { return strtod(s_.c_str(), nullptr); }
+
+  void toCharArray(char* buf, unsigned int size) const {
+    if (!size) return;
+    size_t n = std::min<size_t>(size - 1, s_.size());
+    memcpy(buf, s_.data(), n);
+    buf[n] = '\0';
+  }
+  void getBytes(unsigned char* buf, unsigned int size) const { toCharArray((char*)buf, size); }
+
+  void replace(char a, char b) { std::replace(s_.begin(), s_.end(), a, b); }
+  void replace(const String& a, const String& b) {
+    if (a.s_.empty()) return;
+    for (size_t p = 0; (p = s_.find(a.s_, p)) != std::string::npos; p += b.s_.size()) {
+      s_.replace(p, a.s_.size(), b.s_);
+    }
+  }
+  void remove(unsigned int from) { if (from < s_.size()) s_.erase(from); }
+  void remove(unsigned int from, unsigned int n) { if (from < s_.size()) s_.erase(from, n); }
+  void toLowerCase() { for (char& c : s_) c = (char)tolower((unsigned char)c); }
+  void toUpperCase() { for (char& c : s_) c = (char)toupper((unsigned char)c); }
+  void trim() {
+    size_t a = s_.find_first_not_of(" \t\r\n");
+    size_t b = s_.find_last_not_of(" \t\r\n");
+    s_ = a == std::string::npos ? std::string() : s_.substr(a, b - a + 1);
+  }
+
+  bool concat(const char* c, unsigned int n) { s_.append(c, n); return true; }
+  bool concat(const String& x) { s_ += x.s_; return true; }
+  bool concat(const char* c) { if (c) s_ += c; return true; }
+  bool concat(char c) { s_ += c; return true; }
+
+  String& operator+=(const String& x) { s_ += x.s_; return *this; }
+  String& operator+=(const char* c) { if (c) s_ += c; return *this; }
+  String& operator+=(char c) { s_ += c; return *this; }
+  String& operator+=(int v) { s_ += std::to_string(v); return *this; }
+  String& operator+=(unsigned int v) { s_ += std::to_string(v); return *this; }
+  String& operator+=(long v) { s_ += std::to_string(v); return *this; }
+  String& operator+=(unsigned long v) { s_ += std::to_string(v); return *this; }
+
+  bool operator==(const String& x) const { return s_ == x.s_; }
+  bool operator==(const char* c) const { return s_ == (c ? c : ""); }
+  bool operator!=(const String& x) const { return s_ != x.s_; }
+  bool operator!=(const char* c) const { return !(*this == c); }
+  bool operator<(const String& x) const { return s_ < x.s_; }
+
+  const std::string& std() const { return s_; }
+
+ private:
+  std::string s_;
+  static int pos(size_t p) { return p == std::string::npos ? -1 : (int)p; }
+  void fmt(double v, unsigned int dec) {
+    char b[64];
+    snprintf(b, sizeof(b), "%.*f", (int)dec, v);
+    s_ = b;
+  }
+};
+
+inline String operator+(const String& a, const String& b) { String r(a); r += b; return r; }
+inline String operator+(const String& a, const char* b) { String r(a); r += b; return r; }
+inline String operator+(const char* a, const String& b) { String r(a); r += b; return r; }
+inline String operator+(const String& a, char b) { String r(a); r += b; return r; }
+inline String operator+(const String& a, int b) { String r(a); r += b; return r; }
+inline String operator+(const String& a, unsigned int b) { String r(a); r += b; return r; }
+inline String operator+(const String& a, long b) { String r(a); r += b; return r; }
+inline String operator+(const String& a, unsigned long b) { String r(a); r += b; return r; }
+
+// ===== IPAddress (IPv4, ordem de rede como no core) =====
+class IPAddress {
+ public:
+  IPAddress() : v_(0) {}
+  IPAddress(uint8_t a, uint8_t b, uint8_t c, uint8_t d)
+    : v_((uint32_t)a | (uint32_t)b << 8 | (uint32_t)c << 16 | (uint32_t)d << 24) {}
+  IPAddress(uint32_t v) : v_(v) {}
+  operator uint32_t() const { return v_; }
+  uint8_t operator[](int i) const { return (v_ >> (8 * i)) & 0xFF; }
+  bool operator==(const IPAddress& o) const { return v_ == o.v_; }
+  bool operator!=(const IPAddress& o) const { return v_ != o.v_; }
+  bool fromString(const char* s) {
+    unsigned a, b, c, d;
+    if (!s || sscanf(s, "%u.%u.%u.%u", &a, &b, &c, &d) != 4 || a > 255 || b > 255 || c > 255 || d > 255) return false;
+    *this = IPAddress(a, b, c, d);
+    return true;
+  }
+  bool   fromString(const String& s) { return fromString(s.c_str()); }
+  String toString() const {
+    char b[16];
+    snprintf(b, sizeof(b), "%u.%u.%u.%u", (*this)[0], (*this)[1], (*this)[2], (*this)[3]);
+    return String(b);
+  }
+ private:
+  uint32_t v_;
+};
+
+// ===== Print / Stream =====
+class Print {
+ public:
+  virtual ~Print() {}
+  virtual size_t write(uint8_t b) = 0;
+  virtual size_t write(const uint8_t* buf, size_t n) {
+    size_t k = 0;
+    while (k < n && write(buf[k])) k++;
+    return k;
+  }
+  size_t write(const char* s) { return s ? write((const uint8_t*)s, strlen(s)) : 0; }
+  size_t write(const char* s, size_t n) { return write((const uint8_t*)s, n); }
+  virtual void flush() {}
+
+  size_t print(const String& s) { return write((const uint8_t*)s.c_str(), s.length()); }
+  size_t print(const char* s) { return write(s); }
+  size_t print(char c) { return write((uint8_t)c); }
+  size_t print(int v) { return print(String(v)); }
+  size_t print(unsigned int v) { return print(String(v)); }
+  size_t print(long v) { return print(String(v)); }
+  size_t print(unsigned long v) { return print(String(v)); }
+  size_t print(double v, int dec = 2) { return print(String(v, dec)); }
+  size_t print(const IPAddress& ip) { return print(ip.toString()); }
+
+  size_t println() { return write("\r\n"); }
+  template <typename T>
+  size_t println(const T& v) { size_t n = print(v); return n + println(); }
+
+  size_t printf(const char* fmt, ...) __attribute__((format(printf, 2, 3)));
+};
+
+class Stream : public Print {
+ public:
+  virtual int available() { return 0; }
+  virtual int read() { return -1; }
+  virtual int peek() { return -1; }
+  void setTimeout(unsigned long) {}
+  size_t readBytes(uint8_t* buf, size_t n) {
+    size_t k = 0;
+    for (int c; k < n && (c = read()) >= 0; k++) buf[k] = (uint8_t)c;
+    return k;
+  }
+  size_t readBytes(char* buf, size_t n) { return readBytes((uint8_t*)buf, n); }
+  String readStringUntil(char end) {
+    String s;
+    for (int c; (c = read()) >= 0 && c != end;) s += (char)c;
+    return s;
+  }
+};
+
+// Serial vai para stdout (stderr com HOST_SERIAL=stderr, nada com =off)
+class HardwareSerial : public Stream {
+ public:
+  void begin(unsigned long) {}
+  size_t write(uint8_t b) override;
+  size_t write(const uint8_t* buf, size_t n) override;
+  using Print::write;
+  operator bool() const { return true; }
+};
+extern HardwareSerial Serial;
+
+// ===== ESP =====
+class EspClass {
+ public:
+  void     restart();
+  uint32_t getFreeHeap();
+  uint32_t getMinFreeHeap();
+  uint32_t getMaxAllocHeap();
+  uint32_t getMaxFreeBlockSize();
+  uint32_t getCycleCount();
+  uint32_t getCpuFreqMHz() { return 240; }
+  uint64_t getEfuseMac() { return 0x00A1B2C3D4E5ULL; }
+  uint32_t getChipId() { return 0xC3D4E5; }
+};
+extern EspClass ESP;
+
+void configTime(long gmtOffset, int dstOffset, const char* s1, const char* s2 = nullptr,
+                const char* s3 = nullptr);
+
+// FreeRTOS: seções críticas viram no-op (processo de uma thread)
+typedef int portMUX_TYPE;
+#define portMUX_INITIALIZER_UNLOCKED 0
+#define portENTER_CRITICAL(m)     ((void)(m))
+#define portEXIT_CRITICAL(m)      ((void)(m))
+#define portENTER_CRITICAL_ISR(m) ((void)(m))
+#define portEXIT_CRITICAL_ISR(m)  ((void)(m))
+
+// ===== Ganchos do host =====
+// Chamado por delay()/yield() (sem bloquear) para os stubs atenderem sockets
+// e timers; delay() dorme em poll(2) sobre os descritores vigiados.
+void hostAddPoll(void (*fn)());
+void hostWatchFd(int fd, short events);   // POLLIN/POLLOUT; 0 remove
+// Pino simulado (o vetor de digitalWrite/digitalRead)
+int  hostPin(int pin);
+// Alocações do processo até agora (operator new e malloc/calloc/realloc do
+// código compilado aqui; o Makefile liga com --wrap=malloc,...). Os bytes
+// vivos dessas alocações saem de ESP.getFreeHeap().
+uint64_t hostAllocCount();
+
+#endif // HOST_ARDUINO_H
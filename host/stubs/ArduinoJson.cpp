@@ -0,0 +1,467 @@
+// ArduinoJson.cpp (host): árvore, impressão compacta e parser
+
+#include <ArduinoJson.h>
+
+// ===== Árvore =====
+
+JsonNode* JsonNode::find(const char* key) const {
+  if (type != OBJ || !key) return nullptr;
+  for (size_t k = 0; k < members.size(); k++)
+    if (members[k].first == key) return members[k].second.get();
+  return nullptr;
+}
+
+JsonNode* JsonNode::member(const char* key) {
+  if (type == NUL) type = OBJ;
+  if (type != OBJ) return nullptr;
+  if (JsonNode* n = find(key)) return n;
+  members.emplace_back(key, std::unique_ptr<JsonNode>(new JsonNode));
+  return members.back().second.get();
+}
+
+JsonNode* JsonNode::append() {
+  if (type == NUL) type = ARR;
+  if (type != ARR) return nullptr;
+  items.emplace_back(new JsonNode);
+  return items.back().get();
+}
+
+static void copyNode(JsonNode* dst, const JsonNode* src) {
+  dst->clear();
+  if (!src) return;
+  dst->type = src->type;
+  dst->b    = src->b;
+  dst->i    = src->i;
+  dst->f    = src->f;
+  dst->f32  = src->f32;
+  dst->s    = src->s;
+  for (size_t k = 0; k < src->items.size(); k++) copyNode(dst->append(), src->items[k].get());
+  for (size_t k = 0; k < src->members.size(); k++)
+    copyNode(dst->member(src->members[k].first.c_str()), src->members[k].second.get());
+}
+
+JsonNode* JsonVariant::slot() {
+  if (!node_ && parent_) node_ = parent_->member(key_.c_str());
+  return node_;
+}
+
+JsonVariant& JsonVariant::operator=(const JsonVariant& v) {
+  if (JsonNode* n = slot()) {
+    if (n != v.node_) copyNode(n, v.node_);
+  }
+  return *this;
+}
+
+size_t JsonVariant::size() const {
+  if (!node_) return 0;
+  return node_->type == JsonNode::ARR ? node_->items.size()
+       : node_->type == JsonNode::OBJ ? node_->members.size() : 0;
+}
+
+JsonVariant JsonVariant::operator[](const char* key) const {
+  if (!node_) return JsonVariant();
+  return JsonVariant(node_, key);
+}
+
+JsonVariant JsonVariant::operator[](int index) const {
+  if (!node_ || node_->type != JsonNode::ARR || index < 0 || (size_t)index >= node_->items.size())
+    return JsonVariant();
+  return JsonVariant(node_->items[index].get());
+}
+
+JsonArray JsonVariant::createNestedArray(const char* key) {
+  JsonNode* n = slot();
+  if (!n) return JsonArray();
+  JsonNode* m = n->member(key);
+  if (!m) return JsonArray();
+  m->clear();
+  m->type = JsonNode::ARR;
+  return JsonArray(m);
+}
+
+JsonObject JsonVariant::createNestedObject(const char* key) {
+  JsonNode* n = slot();
+  if (!n) return JsonObject();
+  JsonNode* m = n->member(key);
+  if (!m) return JsonObject();
+  m->clear();
+  m->type = JsonNode::OBJ;
+  return JsonObject(m);
+}
+
+JsonArray JsonArray::createNestedArray() {
+  JsonNode* n = node_ ? node_->append() : nullptr;
+  if (!n) return JsonArray();
+  n->type = JsonNode::ARR;
+  return JsonArray(n);
+}
+
+JsonObject JsonArray::createNestedObject() {
+  JsonNode* n = node_ ? node_->append() : nullptr;
+  if (!n) return JsonObject();
+  n->type = JsonNode::OBJ;
+  return JsonObject(n);
+}
+
+JsonArray JsonObject::createNestedArray(const char* key) {
+  return node_ ? JsonVariant(node_).createNestedArray(key) : JsonArray();
+}
+
+JsonObject JsonObject::createNestedObject(const char* key) {
+  return node_ ? JsonVariant(node_).createNestedObject(key) : JsonObject();
+}
+
+JsonArray JsonDocument::createNestedArray() {
+  if (root_.type == JsonNode::NUL) root_.type = JsonNode::ARR;
+  return JsonArray(&root_).createNestedArray();
+}
+
+JsonObject JsonDocument::createNestedObject() {
+  if (root_.type == JsonNode::NUL) root_.type = JsonNode::ARR;
+  return JsonArray(&root_).createNestedObject();
+}
+
+const char* DeserializationError::c_str() const {
+  static const char* const NAMES[] = {"Ok", "EmptyInput", "IncompleteInput", "InvalidInput", "NoMemory", "TooDeep"};
+  return NAMES[code_];
+}
+
+// ===== Impressão =====
+
+namespace {
+
+// Conta bytes sem imprimir (measureJson)
+class CountPrint : public Print {
+ public:
+  size_t write(uint8_t) override { return 1; }
+  size_t write(const uint8_t*, size_t n) override { return n; }
+  using Print::write;
+};
+
+class StringPrint : public Print {
+ public:
+  explicit StringPrint(String& s) : s_(s) {}
+  size_t write(uint8_t b) override { s_ += (char)b; return 1; }
+  size_t write(const uint8_t* buf, size_t n) override { s_.concat((const char*)buf, n); return n; }
+  using Print::write;
+ private:
+  String& s_;
+};
+
+size_t put(Print& out, const char* s) {
+  return out.write((const uint8_t*)s, strlen(s));
+}
+
+size_t putString(Print& out, const std::string& s) {
+  size_t n = out.write('"');
+  for (size_t k = 0; k < s.size(); k++) {
+    unsigned char c = (unsigned char)s[k];
+    char          esc[8];
+    switch (c) {
+      case '"':  n += put(out, "\\\""); break;
+      case '\\': n += put(out, "\\\\"); break;
+      case '\n': n += put(out, "\\n");  break;
+      case '\r': n += put(out, "\\r");  break;
+      case '\t': n += put(out, "\\t");  break;
+      case '\b': n += put(out, "\\b");  break;
+      case '\f': n += put(out, "\\f");  break;
+      default:
+        if (c < 0x20) {
+          snprintf(esc, sizeof(esc), "\\u%04x", c);
+          n += put(out, esc);
+        } else {
+          n += out.write(c);
+        }
+    }
+  }
+  return n + out.write('"');
+}
+
+size_t putNode(Print& out, const JsonNode* n) {
+  char num[32];
+  if (!n) return put(out, "null");
+  switch (n->type) {
+    case JsonNode::NUL:  return put(out, "null");
+    case JsonNode::BOOL: return put(out, n->b ? "true" : "false");
+    case JsonNode::INT:
+      snprintf(num, sizeof(num), "%lld", (long long)n->i);
+      return put(out, num);
+    case JsonNode::FLOAT:
+      if (isnan(n->f) || isinf(n->f)) return put(out, "null");
+      snprintf(num, sizeof(num), n->f32 ? "%.7g" : "%.15g", n->f);
+      return put(out, num);
+    case JsonNode::STR:
+      return putString(out, n->s);
+    case JsonNode::ARR: {
+      size_t w = out.write('[');
+      for (size_t k = 0; k < n->items.size(); k++) {
+        if (k) w += out.write(',');
+        w += putNode(out, n->items[k].get());
+      }
+      return w + out.write(']');
+    }
+    case JsonNode::OBJ: {
+      size_t w = out.write('{');
+      for (size_t k = 0; k < n->members.size(); k++) {
+        if (k) w += out.write(',');
+        w += putString(out, n->members[k].first);
+        w += out.write(':');
+        w += putNode(out, n->members[k].second.get());
+      }
+      return w + out.write('}');
+    }
+  }
+  return 0;
+}
+
+}  // namespace
+
+size_t serializeJson(const JsonNode* n, Print& out) {
+  return putNode(out, n);
+}
+
+size_t measureJson(const JsonNode* n) {
+  CountPrint c;
+  return putNode(c, n);
+}
+
+size_t serializeJson(JsonDocument& doc, String& out) {
+  out = "";
+  StringPrint p(out);
+  return putNode(p, doc.node());
+}
+
+size_t serializeJson(JsonDocument& doc, char* buf, size_t size) {
+  String s;
+  serializeJson(doc, s);
+  if (!size) return 0;
+  size_t n = std::min((size_t)s.length(), size - 1);
+  memcpy(buf, s.c_str(), n);
+  buf[n] = '\0';
+  return n;
+}
+
+// ===== Parser =====
+
+namespace {
+
+static constexpr int JSON_MAX_NESTING = 10;  // como ARDUINOJSON_DEFAULT_NESTING_LIMIT
+
+class Reader {
+ public:
+  Reader(const char* p, size_t n) : p_(p), n_(n) {}
+  explicit Reader(Stream* s) : s_(s) {}
+
+  int peek() {
+    if (s_) {
+      if (ahead_ < 0) ahead_ = s_->read();
+      return ahead_;
+    }
+    return k_ < n_ ? (unsigned char)p_[k_] : -1;
+  }
+  int next() {
+    int c = peek();
+    if (s_) ahead_ = -1;
+    else if (c >= 0) k_++;
+    return c;
+  }
+
+ private:
+  const char* p_     = nullptr;
+  size_t      n_     = 0;
+  size_t      k_     = 0;
+  Stream*     s_     = nullptr;
+  int         ahead_ = -1;
+};
+
+typedef DeserializationError Err;
+
+// Espaços e comentários /* */ e // (a biblioteca aceita ambos)
+Err::Code skip(Reader& r) {
+  for (;;) {
+    int c = r.peek();
+    if (c == ' ' || c == '\t' || c == '\r' || c == '\n') {
+      r.next();
+    } else if (c == '/') {
+      r.next();
+      c = r.next();
+      if (c == '/') {
+        while ((c = r.next()) >= 0 && c != '\n') {}
+      } else if (c == '*') {
+        int prev = 0;
+        while ((c = r.next()) >= 0 && !(prev == '*' && c == '/')) prev = c;
+        if (c < 0) return Err::IncompleteInput;
+      } else {
+        return c < 0 ? Err::IncompleteInput : Err::InvalidInput;
+      }
+    } else {
+      return Err::Ok;
+    }
+  }
+}
+
+void putUtf8(std::string& s, uint32_t cp) {
+  if (cp < 0x80) {
+    s += (char)cp;
+  } else if (cp < 0x800) {
+    s += (char)(0xC0 | (cp >> 6));
+    s += (char)(0x80 | (cp & 0x3F));
+  } else if (cp < 0x10000) {
+    s += (char)(0xE0 | (cp >> 12));
+    s += (char)(0x80 | ((cp >> 6) & 0x3F));
+    s += (char)(0x80 | (cp & 0x3F));
+  } else {
+    s += (char)(0xF0 | (cp >> 18));
+    s += (char)(0x80 | ((cp >> 12) & 0x3F));
+    s += (char)(0x80 | ((cp >> 6) & 0x3F));
+    s += (char)(0x80 | (cp & 0x3F));
+  }
+}
+
+Err::Code parseHex4(Reader& r, uint32_t& v) {
+  v = 0;
+  for (int k = 0; k < 4; k++) {
+    int c = r.next();
+    if (c < 0) return Err::IncompleteInput;
+    if (!isxdigit(c)) return Err::InvalidInput;
+    v = v * 16 + (uint32_t)(isdigit(c) ? c - '0' : (tolower(c) - 'a' + 10));
+  }
+  return Err::Ok;
+}
+
+Err::Code parseString(Reader& r, std::string& s) {
+  int quote = r.next();
+  for (;;) {
+    int c = r.next();
+    if (c < 0) return Err::IncompleteInput;
+    if (c == quote) return Err::Ok;
+    if (c != '\\') {
+      s += (char)c;
+      continue;
+    }
+    c = r.next();
+    switch (c) {
+      case -1:  return Err::IncompleteInput;
+      case 'n': s += '\n'; break;
+      case 'r': s += '\r'; break;
+      case 't': s += '\t'; break;
+      case 'b': s += '\b'; break;
+      case 'f': s += '\f'; break;
+      case 'u': {
+        uint32_t cp;
+        Err::Code e = parseHex4(r, cp);
+        if (e) return e;
+        if (cp >= 0xD800 && cp < 0xDC00) {  // par substituto
+          uint32_t lo;
+          if (r.next() != '\\' || r.next() != 'u') return Err::InvalidInput;
+          if ((e = parseHex4(r, lo))) return e;
+          cp = 0x10000 + ((cp - 0xD800) << 10) + (lo - 0xDC00);
+        }
+        putUtf8(s, cp);
+        break;
+      }
+      default: s += (char)c;  // \" \\ \/
+    }
+  }
+}
+
+Err::Code parseValue(Reader& r, JsonNode* n, int depth);
+
+Err::Code parseContainer(Reader& r, JsonNode* n, int depth) {
+  if (depth >= JSON_MAX_NESTING) return Err::TooDeep;
+  bool obj = r.next() == '{';
+  char close = obj ? '}' : ']';
+  n->type = obj ? JsonNode::OBJ : JsonNode::ARR;
+  Err::Code e = skip(r);
+  if (e) return e;
+  if (r.peek() == close) {
+    r.next();
+    return Err::Ok;
+  }
+  for (;;) {
+    JsonNode* child;
+    if (obj) {
+      if ((e = skip(r))) return e;
+      int q = r.peek();
+      if (q < 0) return Err::IncompleteInput;
+      if (q != '"' && q != '\'') return Err::InvalidInput;
+      std::string key;
+      if ((e = parseString(r, key))) return e;
+      if ((e = skip(r))) return e;
+      int c = r.next();
+      if (c < 0) return Err::IncompleteInput;
+      if (c != ':') return Err::InvalidInput;
+      child = n->member(key.c_str());
+      child->clear();
+    } else {
+      child = n->append();
+    }
+    if ((e = parseValue(r, child, depth + 1))) return e;
+    if ((e = skip(r))) return e;
+    int c = r.next();
+    if (c == close) return Err::Ok;
+    if (c < 0) return Err::IncompleteInput;
+    if (c != ',') return Err::InvalidInput;
+  }
+}
+
+Err::Code parseValue(Reader& r, JsonNode* n, int depth) {
+  Err::Code e = skip(r);
+  if (e) return e;
+  int c = r.peek();
+  if (c < 0) return Err::IncompleteInput;
+  if (c == '{' || c == '[') return parseContainer(r, n, depth);
+  if (c == '"' || c == '\'') {
+    n->type = JsonNode::STR;
+    return parseString(r, n->s);
+  }
+
+  // literal ou número: lê até um delimitador
+  std::string tok;
+  while ((c = r.peek()) >= 0 && !strchr(",:]}/ \t\r\n", c)) tok += (char)r.next();
+  if (tok == "true" || tok == "false") {
+    n->type = JsonNode::BOOL;
+    n->b    = tok == "true";
+    return Err::Ok;
+  }
+  if (tok == "null") return Err::Ok;
+  if (tok.empty()) return Err::InvalidInput;
+
+  char*       end;
+  const char* p = tok.c_str();
+  if (tok.find_first_of(".eE") == std::string::npos) {
+    long long v = strtoll(p, &end, 10);
+    if (*end == '\0') {
+      n->type = JsonNode::INT;
+      n->i    = v;
+      return Err::Ok;
+    }
+  }
+  double d = strtod(p, &end);
+  if (*end != '\0') return Err::InvalidInput;
+  n->type = JsonNode::FLOAT;
+  n->f    = d;
+  return Err::Ok;
+}
+
+Err parse(JsonDocument& doc, Reader& r) {
+  doc.clear();
+  Err::Code e = skip(r);
+  if (e) return e;
+  if (r.peek() < 0) return Err::EmptyInput;
+  e = parseValue(r, doc.node(), 0);
+  if (e) doc.clear();
+  return e;
+}
+
+}  // namespace
+
+DeserializationError deserializeJson(JsonDocument& doc, const char* json, size_t len) {
+  Reader r(json, len);
+  return parse(doc, r);
+}
+
+DeserializationError deserializeJson(JsonDocument& doc, Stream& in) {
+  Reader r(&in);
+  return parse(doc, r);
+}
@@ -0,0 +1,272 @@
+// ArduinoJson.h (host)
+// Subconjunto da API 6.x usada pelo firmware, sobre uma árvore simples na
+// heap do processo. Com ARDUINOJSON=<dir> o Makefile põe a biblioteca real
+// no include path antes deste arquivo e ele deixa de ser usado.
+// A capacidade passada a DynamicJsonDocument é ignorada (não há estouro).
+#ifndef HOST_ARDUINOJSON_H
+#define HOST_ARDUINOJSON_H
+
+#include <Arduino.h>
+#include <memory>
+#include <type_traits>
+#include <vector>
+
+struct JsonNode {
+  enum Type { NUL, BOOL, INT, FLOAT, STR, ARR, OBJ };
+  Type        type = NUL;
+  bool        b    = false;
+  int64_t     i    = 0;
+  double      f    = 0;
+  bool        f32  = false;  // float de 32 bits: imprime com 7 dígitos
+  std::string s;
+  std::vector<std::unique_ptr<JsonNode>> items;                       // ARR
+  std::vector<std::pair<std::string, std::unique_ptr<JsonNode>>> members; // OBJ
+
+  void      clear() { type = NUL; s.clear(); items.clear(); members.clear(); }
+  JsonNode* find(const char* key) const;
+  JsonNode* member(const char* key);  // cria se faltar (vira objeto se nulo)
+  JsonNode* append();                 // idem para array
+};
+
+class JsonObject;
+class JsonArray;
+
+// Referência a um valor; `parent`+`key` guardam um membro ainda inexistente,
+// criado na primeira atribuição (como o MemberProxy da biblioteca).
+class JsonVariant {
+ public:
+  JsonVariant() {}
+  explicit JsonVariant(JsonNode* n) : node_(n) {}
+  JsonVariant(JsonNode* parent, const char* key) : node_(parent ? parent->find(key) : nullptr), parent_(parent), key_(key) {}
+
+  bool isNull() const { return !node_ || node_->type == JsonNode::NUL; }
+  bool containsKey(const char* key) const { return node_ && node_->find(key); }
+  size_t size() const;
+  JsonVariant operator[](const char* key) const;
+  JsonVariant operator[](const String& key) const { return (*this)[key.c_str()]; }
+  JsonVariant operator[](int index) const;
+
+  template <typename T> bool is() const;
+  template <typename T> T    as() const;
+  template <typename T> operator T() const { return as<T>(); }
+
+  template <typename T> JsonVariant& operator=(const T& v) { set(v); return *this; }
+  JsonVariant& operator=(const JsonVariant& v);
+  JsonVariant(const JsonVariant&) = default;
+
+  JsonArray  createNestedArray(const char* key);
+  JsonObject createNestedObject(const char* key);
+
+  JsonNode* node() const { return node_; }
+
+ protected:
+  JsonNode* slot();  // nó onde escrever (cria o membro pendente)
+
+  template <typename T> void set(const T& v) {
+    JsonNode* n = slot();
+    if (!n) return;
+    n->clear();
+    if constexpr (std::is_same<T, bool>::value) {
+      n->type = JsonNode::BOOL; n->b = v;
+    } else if constexpr (std::is_integral<T>::value || std::is_enum<T>::value) {
+      n->type = JsonNode::INT; n->i = (int64_t)v;
+    } else if constexpr (std::is_floating_point<T>::value) {
+      n->type = JsonNode::FLOAT; n->f = v; n->f32 = sizeof(T) == sizeof(float);
+    } else if constexpr (std::is_same<T, std::nullptr_t>::value) {
+      // fica nulo
+    } else if constexpr (std::is_same<T, String>::value) {
+      n->type = JsonNode::STR; n->s = v.c_str();
+    } else {
+      const char* p = v;  // const char*, char* e char[N]
+      if (p) { n->type = JsonNode::STR; n->s = p; }
+    }
+  }
+
+  JsonNode*   node_   = nullptr;
+  JsonNode*   parent_ = nullptr;
+  std::string key_;
+};
+
+class JsonArray {
+ public:
+  JsonArray() {}
+  explicit JsonArray(JsonNode* n) : node_(n && n->type == JsonNode::ARR ? n : nullptr) {}
+
+  class iterator {
+   public:
+    iterator(JsonNode* n, size_t i) : n_(n), i_(i) {}
+    JsonVariant operator*() const { return JsonVariant(n_->items[i_].get()); }
+    iterator&   operator++() { i_++; return *this; }
+    bool        operator!=(const iterator& o) const { return i_ != o.i_; }
+   private:
+    JsonNode* n_;
+    size_t    i_;
+  };
+  iterator begin() const { return iterator(node_, 0); }
+  iterator end() const { return iterator(node_, size()); }
+
+  bool   isNull() const { return !node_; }
+  size_t size() const { return node_ ? node_->items.size() : 0; }
+  JsonVariant operator[](size_t i) const { return i < size() ? JsonVariant(node_->items[i].get()) : JsonVariant(); }
+  template <typename T> bool add(const T& v) {
+    if (!node_) return false;
+    JsonVariant slot(node_->append());
+    slot = v;
+    return true;
+  }
+  JsonArray  createNestedArray();
+  JsonObject createNestedObject();
+  JsonNode*  node() const { return node_; }
+
+ private:
+  JsonNode* node_ = nullptr;
+};
+
+class JsonObject {
+ public:
+  JsonObject() {}
+  explicit JsonObject(JsonNode* n) : node_(n && n->type == JsonNode::OBJ ? n : nullptr) {}
+
+  bool   isNull() const { return !node_; }
+  size_t size() const { return node_ ? node_->members.size() : 0; }
+  bool   containsKey(const char* key) const { return node_ && node_->find(key); }
+  JsonVariant operator[](const char* key) const { return JsonVariant(node_, key); }
+  JsonVariant operator[](const String& key) const { return JsonVariant(node_, key.c_str()); }
+  JsonArray  createNestedArray(const char* key);
+  JsonObject createNestedObject(const char* key);
+  JsonNode*  node() const { return node_; }
+  operator JsonVariant() const { return JsonVariant(node_); }
+
+ private:
+  JsonNode* node_ = nullptr;
+};
+
+template <typename T> bool JsonVariant::is() const {
+  if (!node_) return false;
+  if constexpr (std::is_same<T, bool>::value) return node_->type == JsonNode::BOOL;
+  else if constexpr (std::is_integral<T>::value) return node_->type == JsonNode::INT;
+  else if constexpr (std::is_floating_point<T>::value) return node_->type == JsonNode::INT || node_->type == JsonNode::FLOAT;
+  else if constexpr (std::is_same<T, const char*>::value || std::is_same<T, String>::value) return node_->type == JsonNode::STR;
+  else if constexpr (std::is_same<T, JsonArray>::value) return node_->type == JsonNode::ARR;
+  else if constexpr (std::is_same<T, JsonObject>::value) return node_->type == JsonNode::OBJ;
+  else return true;
+}
+
+template <typename T> T JsonVariant::as() const {
+  if constexpr (std::is_same<T, JsonVariant>::value) {
+    return *this;
+  } else if constexpr (std::is_same<T, JsonArray>::value || std::is_same<T, JsonObject>::value) {
+    return T(node_);
+  } else if constexpr (std::is_same<T, const char*>::value) {
+    return is<const char*>() ? node_->s.c_str() : nullptr;
+  } else if constexpr (std::is_same<T, String>::value) {
+    return is<const char*>() ? String(node_->s.c_str()) : String();
+  } else if constexpr (std::is_same<T, bool>::value) {
+    if (!node_) return false;
+    return node_->type == JsonNode::BOOL ? node_->b : node_->type == JsonNode::INT ? node_->i != 0 : false;
+  } else if constexpr (std::is_arithmetic<T>::value || std::is_enum<T>::value) {
+    if (!node_) return T();
+    if (node_->type == JsonNode::INT) return (T)node_->i;
+    if (node_->type == JsonNode::FLOAT) return (T)node_->f;
+    if (node_->type == JsonNode::BOOL) return (T)node_->b;
+    return T();
+  } else {
+    return T();
+  }
+}
+
+// `v | padrão`: o valor se tiver o tipo do padrão, senão o padrão
+template <typename T>
+inline T operator|(const JsonVariant& v, T def) {
+  if constexpr (std::is_arithmetic<T>::value && !std::is_same<T, bool>::value) {
+    return v.is<double>() ? v.as<T>() : def;
+  } else {
+    return v.is<T>() ? v.as<T>() : def;
+  }
+}
+
+class DeserializationError {
+ public:
+  enum Code { Ok, EmptyInput, IncompleteInput, InvalidInput, NoMemory, TooDeep };
+  DeserializationError(Code c = Ok) : code_(c) {}
+  explicit operator bool() const { return code_ != Ok; }
+  bool operator==(Code c) const { return code_ == c; }
+  bool operator!=(Code c) const { return code_ != c; }
+  Code code() const { return code_; }
+  const char* c_str() const;
+
+ private:
+  Code code_;
+};
+
+class JsonDocument {
+ public:
+  JsonDocument() {}
+  JsonDocument(const JsonDocument&) = delete;
+  JsonDocument& operator=(const JsonDocument&) = delete;
+
+  void   clear() { root_.clear(); }
+  bool   isNull() const { return root_.type == JsonNode::NUL; }
+  size_t size() const { return JsonVariant((JsonNode*)&root_).size(); }
+  size_t memoryUsage() const { return 0; }
+  bool   overflowed() const { return false; }
+  bool   containsKey(const char* key) const { return root_.find(key); }
+
+  JsonVariant operator[](const char* key) { return JsonVariant(&root_, key); }
+  JsonVariant operator[](const String& key) { return JsonVariant(&root_, key.c_str()); }
+  JsonVariant operator[](int index) { return JsonVariant(&root_)[index]; }
+
+  template <typename T> T as() { return JsonVariant(&root_).as<T>(); }
+  template <typename T> bool is() const { return JsonVariant((JsonNode*)&root_).is<T>(); }
+  template <typename T> T to() {
+    root_.clear();
+    root_.type = std::is_same<T, JsonArray>::value ? JsonNode::ARR : JsonNode::OBJ;
+    return T(&root_);
+  }
+  template <typename T> bool add(const T& v) {
+    if (root_.type == JsonNode::NUL) root_.type = JsonNode::ARR;
+    return JsonArray(&root_).add(v);
+  }
+
+  JsonArray  createNestedArray(const char* key) { return JsonVariant(&root_).createNestedArray(key); }
+  JsonObject createNestedObject(const char* key) { return JsonVariant(&root_).createNestedObject(key); }
+  JsonArray  createNestedArray();
+  JsonObject createNestedObject();
+
+  JsonNode* node() { return &root_; }
+
+ private:
+  JsonNode root_;
+};
+
+class DynamicJsonDocument : public JsonDocument {
+ public:
+  explicit DynamicJsonDocument(size_t) {}
+};
+
+template <size_t N>
+class StaticJsonDocument : public JsonDocument {};
+
+// ===== Serialização =====
+
+size_t serializeJson(const JsonNode* n, Print& out);
+size_t measureJson(const JsonNode* n);
+
+inline size_t serializeJson(JsonDocument& doc, Print& out) { return serializeJson(doc.node(), out); }
+inline size_t serializeJson(const JsonVariant& v, Print& out) { return serializeJson(v.node(), out); }
+inline size_t serializeJson(const JsonObject& v, Print& out) { return serializeJson(v.node(), out); }
+inline size_t serializeJson(const JsonArray& v, Print& out) { return serializeJson(v.node(), out); }
+size_t serializeJson(JsonDocument& doc, String& out);
+size_t serializeJson(JsonDocument& doc, char* buf, size_t size);
+inline size_t measureJson(JsonDocument& doc) { return measureJson(doc.node()); }
+
+DeserializationError deserializeJson(JsonDocument& doc, const char* json, size_t len);
+DeserializationError deserializeJson(JsonDocument& doc, Stream& in);
+inline DeserializationError deserializeJson(JsonDocument& doc, const char* json) {
+  return deserializeJson(doc, json, json ? strlen(json) : 0);
+}
+inline DeserializationError deserializeJson(JsonDocument& doc, const String& json) {
+  return deserializeJson(doc, json.c_str(), json.length());
+}
+
+#endif // HOST_ARDUINOJSON_H
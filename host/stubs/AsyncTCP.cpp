@@ -0,0 +1,177 @@
+// AsyncTCP.cpp (host)
+
+#include "AsyncTCP.h"
+
+#include <arpa/inet.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <algorithm>
+#include <vector>
+
+static constexpr size_t HOST_TCP_SND_BUF = 5744;   // 4 × MSS, como o lwIP do core
+
+// nunca destruída: clientes estáticos saem depois dela
+static std::vector<AsyncClient*>& s_clients = *new std::vector<AsyncClient*>;
+
+static void pollClients() {
+  // cópia: um callback pode fechar/reabrir clientes
+  std::vector<AsyncClient*> list = s_clients;
+  for (AsyncClient* c : list) {
+    if (std::find(s_clients.begin(), s_clients.end(), c) != s_clients.end()) c->hostPoll();
+  }
+}
+
+// Clientes estáticos (mqtt.cpp, webhooks.cpp) são construídos antes das
+// listas dos stubs: o registro fica para a primeira conexão.
+AsyncClient::AsyncClient() {}
+
+static void track(AsyncClient* c) {
+  static bool hooked = false;
+  if (!hooked) {
+    hostAddPoll(pollClients);
+    hooked = true;
+  }
+  if (std::find(s_clients.begin(), s_clients.end(), c) == s_clients.end()) s_clients.push_back(c);
+}
+
+// sem callbacks nem hostWatchFd: na saída do processo o dono e as listas
+// dos stubs podem já ter sido destruídos
+AsyncClient::~AsyncClient() {
+  if (fd_ >= 0) ::close(fd_);
+  s_clients.erase(std::remove(s_clients.begin(), s_clients.end(), this), s_clients.end());
+}
+
+bool AsyncClient::connect(const char* host, uint16_t port) {
+  IPAddress ip;
+  if (ip.fromString(host)) return connect(ip, port);
+  addrinfo hints = {};
+  hints.ai_family   = AF_INET;
+  hints.ai_socktype = SOCK_STREAM;
+  addrinfo* res = nullptr;
+  if (getaddrinfo(host, nullptr, &hints, &res) != 0 || !res) {
+    if (errorCb_) errorCb_(errorArg_, this, -55);   // ERR DNS do AsyncTCP
+    return true;                                     // como no core: falha chega pelo callback
+  }
+  uint32_t a = ((sockaddr_in*)res->ai_addr)->sin_addr.s_addr;
+  freeaddrinfo(res);
+  return connect(IPAddress(a), port);
+}
+
+bool AsyncClient::connect(IPAddress ip, uint16_t port) {
+  if (state_ != IDLE) return false;
+  track(this);
+  int fd = ::socket(AF_INET, SOCK_STREAM, 0);
+  if (fd < 0) return false;
+  fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+  int one = 1;
+  setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+  sockaddr_in a = {};
+  a.sin_family      = AF_INET;
+  a.sin_port        = htons(port);
+  a.sin_addr.s_addr = (uint32_t)ip;
+  fd_    = fd;
+  state_ = CONNECTING;
+  tx_.clear();
+  if (::connect(fd, (sockaddr*)&a, sizeof(a)) < 0 && errno != EINPROGRESS) {
+    fail(-14);   // ERR_CONN
+    return true;
+  }
+  hostWatchFd(fd_, POLLOUT);
+  return true;
+}
+
+void AsyncClient::close(bool) {
+  if (fd_ < 0) return;
+  hostWatchFd(fd_, 0);
+  ::close(fd_);
+  fd_ = -1;
+  bool was = state_ != IDLE;
+  state_   = IDLE;
+  tx_.clear();
+  if (was && discCb_) discCb_(discArg_, this);
+}
+
+void AsyncClient::fail(int8_t err) {
+  if (fd_ >= 0) {
+    hostWatchFd(fd_, 0);
+    ::close(fd_);
+    fd_ = -1;
+  }
+  state_ = IDLE;
+  tx_.clear();
+  if (errorCb_) errorCb_(errorArg_, this, err);
+  if (discCb_)  discCb_(discArg_, this);
+}
+
+size_t AsyncClient::space() const {
+  return state_ == OPEN && tx_.size() < HOST_TCP_SND_BUF ? HOST_TCP_SND_BUF - tx_.size() : 0;
+}
+
+size_t AsyncClient::add(const char* data, size_t size, uint8_t) {
+  size_t n = std::min(size, space());
+  tx_.append(data, n);
+  return n;
+}
+
+bool AsyncClient::send() {
+  if (state_ != OPEN) return false;
+  flushTx();
+  return true;
+}
+
+void AsyncClient::flushTx() {
+  while (!tx_.empty() && fd_ >= 0) {
+    ssize_t k = ::send(fd_, tx_.data(), tx_.size(), MSG_NOSIGNAL);
+    if (k < 0) {
+      if (errno == EAGAIN || errno == EWOULDBLOCK) break;
+      fail(-14);
+      return;
+    }
+    tx_.erase(0, (size_t)k);
+  }
+  if (fd_ >= 0) hostWatchFd(fd_, tx_.empty() ? POLLIN : POLLIN | POLLOUT);
+}
+
+void AsyncClient::hostPoll() {
+  if (fd_ < 0) return;
+  pollfd p = { fd_, (short)(state_ == CONNECTING ? POLLOUT : POLLIN), 0 };
+  if (::poll(&p, 1, 0) <= 0) {
+    if (state_ == OPEN && !tx_.empty()) flushTx();
+    return;
+  }
+  if (state_ == CONNECTING) {
+    int err = 0;
+    socklen_t len = sizeof(err);
+    getsockopt(fd_, SOL_SOCKET, SO_ERROR, &err, &len);
+    if (err) {
+      fail(-14);
+      return;
+    }
+    state_ = OPEN;
+    hostWatchFd(fd_, POLLIN);
+    if (connectCb_) connectCb_(connectArg_, this);
+    return;
+  }
+  char buf[1460];
+  for (;;) {
+    ssize_t n = ::recv(fd_, buf, sizeof(buf), 0);
+    if (n > 0) {
+      if (dataCb_) dataCb_(dataArg_, this, buf, (size_t)n);
+      if (fd_ < 0) return;
+      continue;
+    }
+    if (n == 0) {
+      close(true);
+      return;
+    }
+    if (errno != EAGAIN && errno != EWOULDBLOCK) fail(-14);
+    break;
+  }
+  if (state_ == OPEN && !tx_.empty()) flushTx();
+}
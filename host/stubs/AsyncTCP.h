@@ -0,0 +1,63 @@
+// AsyncTCP.h (host)
+// AsyncClient sobre um socket não bloqueante. Abertura, recepção e envio
+// pendente andam dentro de delay()/yield() (como os callbacks do ESP8266,
+// que rodam quando o loop cede); os callbacks são chamados dali. Nomes
+// numéricos conectam sem bloquear; outros passam por getaddrinfo(), que
+// bloqueia (só no host).
+#ifndef HOST_ASYNCTCP_H
+#define HOST_ASYNCTCP_H
+
+#include <Arduino.h>
+#include <functional>
+#include <string>
+
+class AsyncClient;
+
+typedef std::function<void(void*, AsyncClient*)>                AcConnectHandler;
+typedef std::function<void(void*, AsyncClient*, void*, size_t)> AcDataHandler;
+typedef std::function<void(void*, AsyncClient*, int8_t)>        AcErrorHandler;
+
+#define ASYNC_WRITE_FLAG_COPY 0x01
+
+class AsyncClient {
+ public:
+  AsyncClient();
+  ~AsyncClient();
+  AsyncClient(const AsyncClient&) = delete;
+  AsyncClient& operator=(const AsyncClient&) = delete;
+
+  bool   connect(const char* host, uint16_t port);
+  bool   connect(IPAddress ip, uint16_t port);
+  void   close(bool now = false);
+  bool   connected() const { return state_ == OPEN; }
+  size_t space() const;
+  size_t add(const char* data, size_t size, uint8_t apiflags = ASYNC_WRITE_FLAG_COPY);
+  bool   send();
+  void   setNoDelay(bool) {}
+
+  void onConnect(AcConnectHandler cb, void* arg = nullptr)    { connectCb_ = cb; connectArg_ = arg; }
+  void onDisconnect(AcConnectHandler cb, void* arg = nullptr) { discCb_ = cb; discArg_ = arg; }
+  void onData(AcDataHandler cb, void* arg = nullptr)          { dataCb_ = cb; dataArg_ = arg; }
+  void onError(AcErrorHandler cb, void* arg = nullptr)        { errorCb_ = cb; errorArg_ = arg; }
+
+  // chamado pelos stubs em delay()/yield()
+  void hostPoll();
+
+ private:
+  enum State { IDLE, CONNECTING, OPEN };
+  void fail(int8_t err);
+  void flushTx();
+
+  State            state_ = IDLE;
+  int              fd_    = -1;
+  std::string      tx_;               // aceito por add() e ainda não escrito
+  AcConnectHandler connectCb_, discCb_;
+  AcDataHandler    dataCb_;
+  AcErrorHandler   errorCb_;
+  void*            connectArg_ = nullptr;
+  void*            discArg_    = nullptr;
+  void*            dataArg_    = nullptr;
+  void*            errorArg_   = nullptr;
+};
+
+#endif // HOST_ASYNCTCP_H
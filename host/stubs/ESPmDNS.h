@@ -0,0 +1,18 @@
+// ESPmDNS.h (host): sem anúncio
+#ifndef HOST_ESPMDNS_H
+#define HOST_ESPMDNS_H
+
+#include <Arduino.h>
+
+class MDNSResponder {
+ public:
+  bool begin(const char*) { return true; }
+  void end() {}
+  bool addService(const char*, const char*, uint16_t) { return true; }
+  bool addServiceTxt(const char*, const char*, const char*, const char*) { return true; }
+  bool update() { return true; }
+};
+
+extern MDNSResponder MDNS;
+
+#endif // HOST_ESPMDNS_H
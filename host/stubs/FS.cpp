@@ -0,0 +1,80 @@
+// FS.cpp (host)
+
+#include <FS.h>
+#include <SPIFFS.h>
+#include <LittleFS.h>
+#include <sys/stat.h>
+#include <dirent.h>
+#include <unistd.h>
+
+fs::FS SPIFFS;
+fs::FS LittleFS;
+
+namespace fs {
+
+int File::available() {
+  if (!f_) return 0;
+  long here = ftell(f_.get());
+  return (int)(size() - (here < 0 ? 0 : here));
+}
+
+int File::peek() {
+  if (!f_) return -1;
+  int c = fgetc(f_.get());
+  if (c >= 0) ungetc(c, f_.get());
+  return c;
+}
+
+size_t File::size() const {
+  struct stat st;
+  return f_ && fstat(fileno(f_.get()), &st) == 0 ? (size_t)st.st_size : 0;
+}
+
+static std::string rootDir() {
+  const char* e = getenv("HOST_FS");
+  return e && *e ? e : "host_fs";
+}
+
+std::string FS::real(const char* path) {
+  std::string p = rootDir();
+  if (!path || path[0] != '/') p += '/';
+  return p + (path ? path : "");
+}
+
+bool FS::begin(bool) {
+  std::string dir = rootDir();
+  return mkdir(dir.c_str(), 0755) == 0 || errno == EEXIST;
+}
+
+bool FS::format() {
+  std::string dir = rootDir();
+  DIR* d = opendir(dir.c_str());
+  if (!d) return begin();
+  while (struct dirent* e = readdir(d)) {
+    if (e->d_name[0] == '.') continue;
+    unlink((dir + "/" + e->d_name).c_str());
+  }
+  closedir(d);
+  return true;
+}
+
+File FS::open(const char* path, const char* mode) {
+  // "w"/"a" como no core; "r" não cria
+  const char* m = strcmp(mode, "w") == 0 ? "w+b" : strcmp(mode, "a") == 0 ? "a+b" : "rb";
+  FILE* f = fopen(real(path).c_str(), m);
+  return f ? File(f, path) : File();
+}
+
+bool FS::exists(const char* path) {
+  return access(real(path).c_str(), F_OK) == 0;
+}
+
+bool FS::remove(const char* path) {
+  return unlink(real(path).c_str()) == 0;
+}
+
+bool FS::rename(const char* from, const char* to) {
+  return ::rename(real(from).c_str(), real(to).c_str()) == 0;
+}
+
+}  // namespace fs
@@ -0,0 +1,62 @@
+// FS.h (host)
+// Sistema de arquivos num diretório do host: $HOST_FS ou ./host_fs.
+// "/config.json" vira "<dir>/config.json"; File é compartilhável como no core.
+#ifndef HOST_FS_H
+#define HOST_FS_H
+
+#include <Arduino.h>
+#include <memory>
+
+enum SeekMode { SeekSet = 0, SeekCur = 1, SeekEnd = 2 };
+
+namespace fs {
+
+class File : public Stream {
+ public:
+  File() {}
+  explicit File(FILE* f, const String& name) : f_(f, fclose), name_(name) {}
+
+  explicit operator bool() const { return (bool)f_; }
+  size_t write(uint8_t b) override { return write(&b, 1); }
+  size_t write(const uint8_t* buf, size_t n) override { return f_ ? fwrite(buf, 1, n, f_.get()) : 0; }
+  using Print::write;
+  int    available() override;
+  int    read() override { return f_ ? fgetc(f_.get()) : -1; }
+  int    peek() override;
+  size_t read(uint8_t* buf, size_t n) { return f_ ? fread(buf, 1, n, f_.get()) : 0; }
+  bool   seek(uint32_t pos, SeekMode mode = SeekSet) { return f_ && fseek(f_.get(), pos, mode) == 0; }
+  size_t position() const { return f_ ? (size_t)ftell(f_.get()) : 0; }
+  size_t size() const;
+  void   flush() override { if (f_) fflush(f_.get()); }
+  void   close() { f_.reset(); }
+  const char* name() const { return name_.c_str(); }
+
+ private:
+  std::shared_ptr<FILE> f_;
+  String                name_;
+};
+
+class FS {
+ public:
+  bool begin(bool formatOnFail = false);
+  void end() {}
+  bool format();
+  File open(const char* path, const char* mode = "r");
+  File open(const String& path, const char* mode = "r") { return open(path.c_str(), mode); }
+  bool exists(const char* path);
+  bool exists(const String& path) { return exists(path.c_str()); }
+  bool remove(const char* path);
+  bool remove(const String& path) { return remove(path.c_str()); }
+  bool rename(const char* from, const char* to);
+  bool rename(const String& from, const String& to) { return rename(from.c_str(), to.c_str()); }
+
+ private:
+  std::string real(const char* path);
+};
+
+}  // namespace fs
+
+using fs::File;
+using fs::FS;
+
+#endif // HOST_FS_H
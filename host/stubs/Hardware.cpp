@@ -0,0 +1,72 @@
+// Hardware.cpp (host): Wire, RTClib, Ticker e globais de rede
+
+#include <Arduino.h>
+#include <Wire.h>
+#include <RTClib.h>
+#include <Ticker.h>
+#include <vector>
+
+TwoWire Wire;
+
+DateTime::DateTime(int y, int mo, int d, int h, int mi, int s) {
+  struct tm tm = {};
+  tm.tm_year = y - 1900;
+  tm.tm_mon  = mo - 1;
+  tm.tm_mday = d;
+  tm.tm_hour = h;
+  tm.tm_min  = mi;
+  tm.tm_sec  = s;
+  t_ = (uint32_t)timegm(&tm);
+}
+
+static struct tm br(uint32_t t) {
+  time_t    tt = t;
+  struct tm r;
+  gmtime_r(&tt, &r);
+  return r;
+}
+
+int DateTime::year() const   { return br(t_).tm_year + 1900; }
+int DateTime::month() const  { return br(t_).tm_mon + 1; }
+int DateTime::day() const    { return br(t_).tm_mday; }
+int DateTime::hour() const   { return br(t_).tm_hour; }
+int DateTime::minute() const { return br(t_).tm_min; }
+int DateTime::second() const { return br(t_).tm_sec; }
+
+// ===== Ticker: disparado pelos ganchos de delay()/yield() =====
+
+static std::vector<Ticker*> s_tickers;
+
+static void tickerPoll() {
+  unsigned long now = millis();
+  for (size_t i = 0; i < s_tickers.size(); i++) {
+    Ticker* t = s_tickers[i];
+    if (!t->fn_ || now - t->lastMs_ < t->periodMs_) continue;
+    t->lastMs_ = now;
+    t->fn_();
+  }
+}
+
+void Ticker::attach_ms(uint32_t ms, callback_t fn) {
+  static bool hooked = false;
+  if (!hooked) {
+    hostAddPoll(tickerPoll);
+    hooked = true;
+  }
+  periodMs_ = ms ? ms : 1;
+  lastMs_   = millis();
+  fn_       = fn;
+  if (std::find(s_tickers.begin(), s_tickers.end(), this) == s_tickers.end()) s_tickers.push_back(this);
+}
+
+void Ticker::detach() {
+  fn_ = nullptr;
+}
+
+// ===== Rede: o host está sempre em 127.0.0.1 =====
+
+#include <WiFi.h>
+#include <ESPmDNS.h>
+
+WiFiClass     WiFi;
+MDNSResponder MDNS;
@@ -0,0 +1,9 @@
+// LittleFS.h (host): mesmo diretório do SPIFFS
+#ifndef HOST_LITTLEFS_H
+#define HOST_LITTLEFS_H
+
+#include <FS.h>
+
+extern fs::FS LittleFS;
+
+#endif // HOST_LITTLEFS_H
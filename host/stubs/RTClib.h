@@ -0,0 +1,34 @@
+// RTClib.h (host)
+// DS3231 ausente: begin() falha e o firmware segue só com NTP/TimeLib.
+#ifndef HOST_RTCLIB_H
+#define HOST_RTCLIB_H
+
+#include <Arduino.h>
+
+class DateTime {
+ public:
+  DateTime(uint32_t t = 0) : t_(t) {}
+  DateTime(int y, int mo, int d, int h = 0, int mi = 0, int s = 0);
+  uint32_t unixtime() const { return t_; }
+  int year() const;
+  int month() const;
+  int day() const;
+  int hour() const;
+  int minute() const;
+  int second() const;
+ private:
+  uint32_t t_;
+};
+
+class RTC_DS3231 {
+ public:
+  bool     begin() { return false; }
+  bool     lostPower() { return true; }
+  DateTime now() { return DateTime(t_); }
+  void     adjust(const DateTime& dt) { t_ = dt.unixtime(); }
+  float    getTemperature() { return 25.0f; }
+ private:
+  uint32_t t_ = 0;
+};
+
+#endif // HOST_RTCLIB_H
@@ -0,0 +1,9 @@
+// SPIFFS.h (host)
+#ifndef HOST_SPIFFS_H
+#define HOST_SPIFFS_H
+
+#include <FS.h>
+
+extern fs::FS SPIFFS;
+
+#endif // HOST_SPIFFS_H
@@ -0,0 +1,22 @@
+// Ticker.h (host)
+// Periódico cooperativo: roda dentro de delay()/yield(), como no ESP8266.
+#ifndef HOST_TICKER_H
+#define HOST_TICKER_H
+
+#include <Arduino.h>
+
+class Ticker {
+ public:
+  typedef void (*callback_t)();
+  ~Ticker() { detach(); }
+  void attach_ms(uint32_t ms, callback_t fn);
+  void attach(float sec, callback_t fn) { attach_ms((uint32_t)(sec * 1000), fn); }
+  void detach();
+  bool active() const { return fn_ != nullptr; }
+
+  callback_t    fn_       = nullptr;
+  unsigned long periodMs_ = 0;
+  unsigned long lastMs_   = 0;
+};
+
+#endif // HOST_TICKER_H
@@ -0,0 +1,30 @@
+// TimeLib.cpp (host)
+
+#include <Arduino.h>
+#include <TimeLib.h>
+
+static time_t        s_base   = 0;
+static unsigned long s_baseMs = 0;
+
+time_t now() {
+  return s_base + (time_t)((millis() - s_baseMs) / 1000UL);
+}
+
+void setTime(time_t t) {
+  s_base   = t;
+  s_baseMs = millis();
+}
+
+static struct tm utc(time_t t) {
+  struct tm r;
+  gmtime_r(&t, &r);
+  return r;
+}
+
+int year(time_t t)    { return utc(t).tm_year + 1900; }
+int month(time_t t)   { return utc(t).tm_mon + 1; }
+int day(time_t t)     { return utc(t).tm_mday; }
+int hour(time_t t)    { return utc(t).tm_hour; }
+int minute(time_t t)  { return utc(t).tm_min; }
+int second(time_t t)  { return utc(t).tm_sec; }
+int weekday(time_t t) { return utc(t).tm_wday + 1; }
@@ -0,0 +1,27 @@
+// TimeLib.h (host)
+// Relógio do TimeLib: segundos definidos por setTime() mais millis().
+#ifndef HOST_TIMELIB_H
+#define HOST_TIMELIB_H
+
+#include <time.h>
+
+time_t now();
+void   setTime(time_t t);
+
+int year(time_t t);
+int month(time_t t);
+int day(time_t t);
+int hour(time_t t);
+int minute(time_t t);
+int second(time_t t);
+int weekday(time_t t);   // 1 = domingo
+
+inline int year()    { return year(now()); }
+inline int month()   { return month(now()); }
+inline int day()     { return day(now()); }
+inline int hour()    { return hour(now()); }
+inline int minute()  { return minute(now()); }
+inline int second()  { return second(now()); }
+inline int weekday() { return weekday(now()); }
+
+#endif // HOST_TIMELIB_H
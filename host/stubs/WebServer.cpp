@@ -0,0 +1,407 @@
+// WebServer.cpp (host)
+// Ver WebServer.h. Um pedido por conexão (Connection: close), lido inteiro
+// antes de chamar a rota; suficiente para o teste de carga e para o
+// navegador apontado para o processo do host.
+#include "WebServer.h"
+
+#include <arpa/inet.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <strings.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+static constexpr size_t HOST_HTTP_MAX_HEAD = 8192;
+static constexpr size_t HOST_HTTP_MAX_BODY = 256 * 1024;
+
+static const char* statusText(int code) {
+  switch (code) {
+    case 200: return "OK";
+    case 202: return "Accepted";
+    case 204: return "No Content";
+    case 301: return "Moved Permanently";
+    case 302: return "Found";
+    case 304: return "Not Modified";
+    case 400: return "Bad Request";
+    case 401: return "Unauthorized";
+    case 403: return "Forbidden";
+    case 404: return "Not Found";
+    case 405: return "Method Not Allowed";
+    case 409: return "Conflict";
+    case 413: return "Payload Too Large";
+    case 415: return "Unsupported Media Type";
+    case 429: return "Too Many Requests";
+    case 500: return "Internal Server Error";
+    case 503: return "Service Unavailable";
+    default:  return "";
+  }
+}
+
+static int hexVal(char c) {
+  if (c >= '0' && c <= '9') return c - '0';
+  if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+  if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+  return -1;
+}
+
+static String urlDecode(const char* p, size_t n) {
+  std::string out;
+  out.reserve(n);
+  for (size_t i = 0; i < n; i++) {
+    if (p[i] == '+') {
+      out += ' ';
+    } else if (p[i] == '%' && i + 2 < n && hexVal(p[i + 1]) >= 0 && hexVal(p[i + 2]) >= 0) {
+      out += (char)(hexVal(p[i + 1]) << 4 | hexVal(p[i + 2]));
+      i += 2;
+    } else {
+      out += p[i];
+    }
+  }
+  return String(out);
+}
+
+// valor de um parâmetro de cabeçalho (`boundary=...`, `name="..."`)
+static String headerParam(const std::string& h, const char* key) {
+  std::string k = std::string(key) + "=";
+  size_t p = 0;
+  while ((p = h.find(k, p)) != std::string::npos) {
+    if (p == 0 || h[p - 1] == ' ' || h[p - 1] == ';') break;
+    p += k.size();
+  }
+  if (p == std::string::npos) return String();
+  p += k.size();
+  if (p < h.size() && h[p] == '"') {
+    size_t e = h.find('"', p + 1);
+    return String(h.substr(p + 1, e == std::string::npos ? std::string::npos : e - p - 1));
+  }
+  size_t e = h.find(';', p);
+  std::string v = h.substr(p, e == std::string::npos ? std::string::npos : e - p);
+  while (!v.empty() && v.back() == ' ') v.pop_back();
+  return String(v);
+}
+
+WebServer::WebServer(int port) : port_(port) {
+  const char* env = getenv("HOST_HTTP_PORT");
+  if (env && *env) port_ = atoi(env);
+  else if (port_ < 1024) port_ += 8000;
+}
+
+WebServer::~WebServer() { stop(); }
+
+void WebServer::on(const char* uri, HTTPMethod method, THandlerFunction fn) {
+  routes_.push_back({String(uri), method, fn, nullptr});
+}
+
+void WebServer::on(const char* uri, HTTPMethod method, THandlerFunction fn, THandlerFunction ufn) {
+  routes_.push_back({String(uri), method, fn, ufn});
+}
+
+void WebServer::begin() {
+  if (listenFd_ >= 0) return;
+  int fd = ::socket(AF_INET, SOCK_STREAM, 0);
+  if (fd < 0) return;
+  int one = 1;
+  setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+  sockaddr_in a = {};
+  a.sin_family      = AF_INET;
+  a.sin_port        = htons((uint16_t)port_);
+  a.sin_addr.s_addr = htonl(INADDR_ANY);
+  if (::bind(fd, (sockaddr*)&a, sizeof(a)) < 0 || ::listen(fd, 64) < 0) {
+    fprintf(stderr, "[host] http: porta %d: %s\n", port_, strerror(errno));
+    ::close(fd);
+    return;
+  }
+  fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+  listenFd_ = fd;
+  hostWatchFd(fd, POLLIN);
+  fprintf(stderr, "[host] http: escutando na porta %d\n", port_);
+}
+
+void WebServer::stop() {
+  if (listenFd_ < 0) return;
+  hostWatchFd(listenFd_, 0);
+  ::close(listenFd_);
+  listenFd_ = -1;
+}
+
+void WebServer::handleClient() {
+  if (listenFd_ < 0) return;
+  sockaddr_in peer = {};
+  socklen_t   plen = sizeof(peer);
+  int fd = ::accept(listenFd_, (sockaddr*)&peer, &plen);
+  if (fd < 0) return;
+
+  timeval tv = {(time_t)(HOST_HTTP_TIMEOUT_MS / 1000), (suseconds_t)(HOST_HTTP_TIMEOUT_MS % 1000) * 1000};
+  setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+  setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &tv, sizeof(tv));
+  int one = 1;
+  setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+
+  fd_ = fd;
+  client_.hostSetRemote(IPAddress((uint32_t)peer.sin_addr.s_addr), ntohs(peer.sin_port));
+  args_.clear();
+  headers_.clear();
+  respHeaders_.clear();
+  contentLength_ = CONTENT_LENGTH_NOT_SET;
+  headSent_ = chunked_ = chunkEnd_ = false;
+
+  std::string head, body;
+  if (!readRequest(head, body)) {
+    if (!head.empty()) send(400, "text/plain", "Pedido inválido");
+  } else {
+    // rota: caminho exato e método (HTTP_ANY casa com qualquer um)
+    const Route* route = nullptr;
+    for (const Route& r : routes_) {
+      if (r.uri == uri_ && (r.method == HTTP_ANY || r.method == method_)) { route = &r; break; }
+    }
+
+    String ctype = header("Content-Type");
+    if (ctype.startsWith("application/x-www-form-urlencoded")) {
+      parseQuery(body.data(), body.size());
+    } else if (ctype.startsWith("multipart/form-data")) {
+      parseMultipart(body, headerParam(ctype.c_str(), "boundary"), route);
+    } else if (route && route->ufn && route->method != HTTP_GET) {
+      feedRaw(body, *route);
+    } else if (!body.empty()) {
+      args_.push_back({String("plain"), String(body.c_str())});
+    }
+
+    if (route) route->fn();
+    else if (notFound_) notFound_();
+    else send(404, "text/plain", "Not found");
+
+    if (!headSent_) send(500, "text/plain", "");
+    else if (chunked_ && !chunkEnd_) sendContent("", 0);
+  }
+
+  ::shutdown(fd, SHUT_WR);
+  ::close(fd);
+  fd_ = -1;
+}
+
+bool WebServer::readRequest(std::string& head, std::string& body) {
+  char   buf[2048];
+  size_t end = std::string::npos;
+  while (end == std::string::npos) {
+    ssize_t n = ::recv(fd_, buf, sizeof(buf), 0);
+    if (n <= 0) return false;
+    head.append(buf, (size_t)n);
+    end = head.find("\r\n\r\n");
+    if (end == std::string::npos && head.size() > HOST_HTTP_MAX_HEAD) return false;
+  }
+  body = head.substr(end + 4);
+  head.resize(end + 2);
+  if (!parseHead(head)) return false;
+
+  size_t len = (size_t)strtoul(header("Content-Length").c_str(), nullptr, 10);
+  if (len > HOST_HTTP_MAX_BODY) return false;
+  while (body.size() < len) {
+    ssize_t n = ::recv(fd_, buf, std::min(sizeof(buf), len - body.size()), 0);
+    if (n <= 0) return false;
+    body.append(buf, (size_t)n);
+  }
+  body.resize(len);
+  return true;
+}
+
+bool WebServer::parseHead(const std::string& head) {
+  size_t eol = head.find("\r\n");
+  std::string line = head.substr(0, eol);
+  size_t s1 = line.find(' ');
+  size_t s2 = line.find(' ', s1 == std::string::npos ? 0 : s1 + 1);
+  if (s1 == std::string::npos || s2 == std::string::npos) return false;
+
+  std::string m = line.substr(0, s1);
+  if      (m == "GET")    method_ = HTTP_GET;
+  else if (m == "POST")   method_ = HTTP_POST;
+  else if (m == "PUT")    method_ = HTTP_PUT;
+  else if (m == "DELETE") method_ = HTTP_DELETE;
+  else                    method_ = HTTP_ANY;
+
+  std::string target = line.substr(s1 + 1, s2 - s1 - 1);
+  size_t q = target.find('?');
+  uri_ = urlDecode(target.data(), q == std::string::npos ? target.size() : q);
+  if (q != std::string::npos) parseQuery(target.data() + q + 1, target.size() - q - 1);
+
+  size_t p = eol + 2;
+  while (p < head.size()) {
+    size_t e = head.find("\r\n", p);
+    if (e == std::string::npos) e = head.size();
+    size_t c = head.find(':', p);
+    if (c != std::string::npos && c < e) {
+      size_t v = c + 1;
+      while (v < e && head[v] == ' ') v++;
+      headers_.push_back({String(head.substr(p, c - p)), String(head.substr(v, e - v))});
+    }
+    p = e + 2;
+  }
+  return true;
+}
+
+void WebServer::parseQuery(const char* q, size_t n) {
+  size_t i = 0;
+  while (i < n) {
+    size_t e = i;
+    while (e < n && q[e] != '&') e++;
+    size_t eq = i;
+    while (eq < e && q[eq] != '=') eq++;
+    if (e > i) {
+      args_.push_back({urlDecode(q + i, eq - i),
+                       eq < e ? urlDecode(q + eq + 1, e - eq - 1) : String()});
+    }
+    i = e + 1;
+  }
+}
+
+// Partes com filename vão ao handler de upload da rota em blocos de
+// HTTP_UPLOAD_BUFLEN; as demais viram args (como no core).
+void WebServer::parseMultipart(const std::string& body, const String& boundary, const Route* r) {
+  if (boundary.isEmpty()) return;
+  std::string delim = std::string("--") + boundary.c_str();
+  size_t p = body.find(delim);
+  while (p != std::string::npos) {
+    p += delim.size();
+    if (body.compare(p, 2, "--") == 0) break;
+    p += 2;  // \r\n
+    size_t he = body.find("\r\n\r\n", p);
+    if (he == std::string::npos) break;
+    std::string ph = body.substr(p, he - p);
+    size_t ds = he + 4;
+    size_t de = body.find("\r\n" + delim, ds);
+    if (de == std::string::npos) break;
+
+    String name     = headerParam(ph, "name");
+    String filename = headerParam(ph, "filename");
+    if (filename.isEmpty() && ph.find("filename=") == std::string::npos) {
+      args_.push_back({name, String(body.substr(ds, de - ds))});
+    } else if (r && r->ufn) {
+      upload_.name        = name;
+      upload_.filename    = filename;
+      size_t ct           = ph.find("Content-Type:");
+      upload_.type        = ct == std::string::npos ? String() : String(ph.substr(ct + 14, ph.find("\r\n", ct) - ct - 14));
+      upload_.totalSize   = 0;
+      upload_.currentSize = 0;
+      upload_.status      = UPLOAD_FILE_START;
+      r->ufn();
+      for (size_t k = ds; k < de; k += HTTP_UPLOAD_BUFLEN) {
+        size_t n = std::min<size_t>(HTTP_UPLOAD_BUFLEN, de - k);
+        memcpy(upload_.buf, body.data() + k, n);
+        upload_.currentSize = n;
+        upload_.totalSize  += n;
+        upload_.status      = UPLOAD_FILE_WRITE;
+        r->ufn();
+      }
+      upload_.currentSize = 0;
+      upload_.status      = UPLOAD_FILE_END;
+      r->ufn();
+    }
+    p = de + 2;
+  }
+}
+
+// Corpo cru em blocos, como o canRaw() das rotas com handler de upload
+void WebServer::feedRaw(const std::string& body, const Route& r) {
+  raw_.totalSize   = 0;
+  raw_.currentSize = 0;
+  raw_.data        = nullptr;
+  raw_.status      = RAW_START;
+  r.ufn();
+  for (size_t k = 0; k < body.size(); k += HTTP_RAW_BUFLEN) {
+    size_t n = std::min<size_t>(HTTP_RAW_BUFLEN, body.size() - k);
+    memcpy(raw_.buf, body.data() + k, n);
+    raw_.currentSize = n;
+    raw_.totalSize  += n;
+    raw_.status      = RAW_WRITE;
+    r.ufn();
+  }
+  raw_.currentSize = 0;
+  raw_.status      = RAW_END;
+  r.ufn();
+}
+
+void WebServer::writeAll(const char* p, size_t n) {
+  while (n && fd_ >= 0) {
+    ssize_t k = ::send(fd_, p, n, MSG_NOSIGNAL);
+    if (k <= 0) return;
+    p += k;
+    n -= (size_t)k;
+  }
+}
+
+void WebServer::writeHead(int code, const char* type, size_t len) {
+  std::string h = "HTTP/1.1 " + std::to_string(code) + " " + statusText(code) + "\r\n";
+  if (type && *type) h += std::string("Content-Type: ") + type + "\r\n";
+  if (len == CONTENT_LENGTH_UNKNOWN) {
+    h += "Transfer-Encoding: chunked\r\n";
+    chunked_ = true;
+  } else {
+    h += "Content-Length: " + std::to_string(len) + "\r\n";
+  }
+  for (const Pair& p : respHeaders_) h += std::string(p.first.c_str()) + ": " + p.second.c_str() + "\r\n";
+  h += "Connection: close\r\n\r\n";
+  writeAll(h.data(), h.size());
+  headSent_ = true;
+  respHeaders_.clear();
+}
+
+void WebServer::send(int code, const char* type, const String& content) {
+  if (headSent_) return;
+  // setContentLength() antes de send(): CONTENT_LENGTH_UNKNOWN abre um corpo
+  // chunked, um tamanho explícito fica para sendContent() completar
+  size_t len = contentLength_ == CONTENT_LENGTH_NOT_SET ? content.length() : contentLength_;
+  writeHead(code, type, len);
+  if (chunked_) {
+    if (content.length()) sendContent(content);
+  } else {
+    writeAll(content.c_str(), content.length());
+  }
+}
+
+void WebServer::send_P(int code, PGM_P type, PGM_P content, size_t len) {
+  if (headSent_) return;
+  writeHead(code, type, len);
+  writeAll(content, len);
+}
+
+void WebServer::sendContent(const char* content, size_t len) {
+  if (!headSent_) return;
+  if (!chunked_) {
+    writeAll(content, len);
+    return;
+  }
+  if (chunkEnd_) return;
+  char hdr[16];
+  int  n = snprintf(hdr, sizeof(hdr), "%zx\r\n", len);
+  writeAll(hdr, (size_t)n);
+  writeAll(content, len);
+  writeAll("\r\n", 2);
+  if (!len) chunkEnd_ = true;
+}
+
+void WebServer::sendHeader(const String& name, const String& value, bool first) {
+  if (first) respHeaders_.insert(respHeaders_.begin(), {name, value});
+  else respHeaders_.push_back({name, value});
+}
+
+bool WebServer::hasArg(const String& name) const {
+  for (const Pair& a : args_) if (a.first == name) return true;
+  return false;
+}
+
+String WebServer::arg(const String& name) const {
+  for (const Pair& a : args_) if (a.first == name) return a.second;
+  return String();
+}
+
+String WebServer::header(const String& name) const {
+  for (const Pair& h : headers_) if (h.first.equalsIgnoreCase(name)) return h.second;
+  return String();
+}
+
+bool WebServer::hasHeader(const String& name) const {
+  for (const Pair& h : headers_) if (h.first.equalsIgnoreCase(name)) return true;
+  return false;
+}
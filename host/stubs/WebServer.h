@@ -0,0 +1,127 @@
+// WebServer.h (host)
+// Servidor HTTP/1.1 num socket TCP real, com a mesma forma de uso do
+// WebServer do ESP32: handleClient() aceita no máximo uma conexão, lê o
+// pedido inteiro (bloqueando até HOST_HTTP_TIMEOUT_MS, como o core),
+// chama a rota e fecha a conexão. A porta é $HOST_HTTP_PORT ou, para
+// portas < 1024, a do construtor + 8000 (80 -> 8080).
+// Corpos multipart/form-data com arquivo vão ao handler de upload em
+// blocos de HTTP_UPLOAD_BUFLEN. Outros corpos (não formulário) vão crus,
+// em blocos HTTPRaw, ao handler de upload de rotas não-GET que o tenham;
+// senão ficam no arg "plain" cortados no primeiro 0x00, como no core.
+#ifndef HOST_WEBSERVER_H
+#define HOST_WEBSERVER_H
+
+#include <Arduino.h>
+#include <WiFi.h>
+#include <vector>
+
+enum HTTPMethod { HTTP_ANY, HTTP_GET, HTTP_POST, HTTP_PUT, HTTP_DELETE };
+enum HTTPUploadStatus { UPLOAD_FILE_START, UPLOAD_FILE_WRITE, UPLOAD_FILE_END, UPLOAD_FILE_ABORTED };
+
+#define HTTP_UPLOAD_BUFLEN 1436
+
+struct HTTPUpload {
+  HTTPUploadStatus status;
+  String           filename;
+  String           name;
+  String           type;
+  size_t           totalSize;
+  size_t           currentSize;
+  uint8_t          buf[HTTP_UPLOAD_BUFLEN];
+};
+
+enum HTTPRawStatus { RAW_START, RAW_WRITE, RAW_END, RAW_ABORTED };
+
+#define HTTP_RAW_BUFLEN 1436
+
+struct HTTPRaw {
+  HTTPRawStatus status;
+  size_t        totalSize;
+  size_t        currentSize;
+  uint8_t       buf[HTTP_RAW_BUFLEN];
+  void*         data;
+};
+
+#define CONTENT_LENGTH_UNKNOWN ((size_t)-1)
+#define CONTENT_LENGTH_NOT_SET ((size_t)-2)
+
+static constexpr unsigned long HOST_HTTP_TIMEOUT_MS = 2000;
+
+class WebServer {
+ public:
+  typedef std::function<void()> THandlerFunction;
+
+  explicit WebServer(int port);
+  ~WebServer();
+
+  void on(const char* uri, HTTPMethod method, THandlerFunction fn);
+  void on(const char* uri, HTTPMethod method, THandlerFunction fn, THandlerFunction ufn);
+  void onNotFound(THandlerFunction fn) { notFound_ = fn; }
+  void begin();
+  void stop();
+  void handleClient();
+
+  void send(int code, const char* type, const String& content);
+  void send(int code, const char* type = "", const char* content = "") { send(code, type, String(content)); }
+  void send(int code, const String& type, const String& content) { send(code, type.c_str(), content); }
+  void send_P(int code, PGM_P type, PGM_P content) { send(code, type, String(content)); }
+  void send_P(int code, PGM_P type, PGM_P content, size_t len);
+  void sendContent(const String& content) { sendContent(content.c_str(), content.length()); }
+  void sendContent(const char* content, size_t len);
+  void sendContent_P(PGM_P content, size_t len) { sendContent(content, len); }
+  void setContentLength(size_t len) { contentLength_ = len; }
+  void sendHeader(const String& name, const String& value, bool first = false);
+
+  bool   hasArg(const String& name) const;
+  String arg(const String& name) const;
+  String arg(int i) const { return i >= 0 && i < args() ? args_[i].second : String(); }
+  String argName(int i) const { return i >= 0 && i < args() ? args_[i].first : String(); }
+  int    args() const { return (int)args_.size(); }
+  String header(const String& name) const;
+  bool   hasHeader(const String& name) const;
+  void   collectHeaders(const char**, size_t) {}   // guarda todos
+  String uri() const { return uri_; }
+  HTTPMethod  method() const { return method_; }
+  WiFiClient& client() { return client_; }
+  HTTPUpload& upload() { return upload_; }
+  HTTPRaw&    raw() { return raw_; }
+
+ private:
+  struct Route {
+    String           uri;
+    HTTPMethod       method;
+    THandlerFunction fn;
+    THandlerFunction ufn;
+  };
+  typedef std::pair<String, String> Pair;
+
+  bool readRequest(std::string& head, std::string& body);
+  bool parseHead(const std::string& head);
+  void parseQuery(const char* q, size_t n);
+  void parseMultipart(const std::string& body, const String& boundary, const Route* r);
+  void feedRaw(const std::string& body, const Route& r);
+  void writeAll(const char* p, size_t n);
+  void writeHead(int code, const char* type, size_t len);
+
+  int                 port_;
+  int                 listenFd_ = -1;
+  int                 fd_       = -1;
+  std::vector<Route>  routes_;
+  THandlerFunction    notFound_;
+
+  // pedido atual
+  HTTPMethod          method_ = HTTP_GET;
+  String              uri_;
+  std::vector<Pair>   args_;
+  std::vector<Pair>   headers_;
+  std::vector<Pair>   respHeaders_;
+  size_t              contentLength_ = CONTENT_LENGTH_NOT_SET;
+  bool                headSent_ = false;
+  bool                chunked_  = false;
+  bool                chunkEnd_ = false;
+  WiFiClient          client_;
+  HTTPUpload          upload_;
+  HTTPRaw             raw_;
+};
+
+#endif // HOST_WEBSERVER_H
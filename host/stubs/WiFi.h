@@ -0,0 +1,81 @@
+// WiFi.h (host)
+// O host está sempre "conectado" em 127.0.0.1; eventos de rede nunca
+// disparam. WiFiClient/WiFiServer são inertes: o HTTP é servido por
+// WebServer.cpp e WiFiClient só carrega o IP do par para server.client().
+#ifndef HOST_WIFI_H
+#define HOST_WIFI_H
+
+#include <Arduino.h>
+#include <memory>
+
+#define WL_CONNECTED    3
+#define WL_DISCONNECTED 6
+#define WIFI_NONE_SLEEP 0
+typedef int wl_status_t;
+
+class WiFiClient : public Stream {
+ public:
+  int connect(const char*, uint16_t) { return 0; }
+  int connect(const char*, uint16_t, int32_t) { return 0; }
+  int connect(IPAddress, uint16_t) { return 0; }
+  size_t write(uint8_t) override { return 0; }
+  size_t write(const uint8_t*, size_t) override { return 0; }
+  using Print::write;
+  int     available() override { return 0; }
+  int     read() override { return -1; }
+  int     read(uint8_t*, size_t) { return 0; }
+  uint8_t connected() { return 0; }
+  void    stop() {}
+  explicit operator bool() { return false; }
+  void      setNoDelay(bool) {}
+  IPAddress remoteIP() { return remoteIp_; }
+  uint16_t  remotePort() { return remotePort_; }
+
+  // Par da conexão atual do WebServer do host (só para remoteIP())
+  void hostSetRemote(IPAddress ip, uint16_t port) { remoteIp_ = ip; remotePort_ = port; }
+
+ private:
+  IPAddress remoteIp_;
+  uint16_t  remotePort_ = 0;
+};
+
+class WiFiServer {
+ public:
+  WiFiServer(uint16_t) {}
+  void       begin() {}
+  void       begin(uint16_t) {}
+  void       stop() {}
+  WiFiClient available() { return WiFiClient(); }
+  WiFiClient accept() { return WiFiClient(); }
+  bool       hasClient() { return false; }
+  void       setNoDelay(bool) {}
+};
+
+typedef int WiFiEvent_t;
+struct WiFiEventInfo_t {};
+enum { ARDUINO_EVENT_WIFI_STA_GOT_IP, ARDUINO_EVENT_WIFI_STA_DISCONNECTED };
+struct WiFiEventStationModeGotIP {};
+struct WiFiEventStationModeDisconnected {};
+typedef std::shared_ptr<int> WiFiEventHandler;
+
+class WiFiClass {
+ public:
+  int onEvent(std::function<void(WiFiEvent_t, WiFiEventInfo_t)>, int) { return 0; }
+  WiFiEventHandler onStationModeGotIP(std::function<void(const WiFiEventStationModeGotIP&)>) { return nullptr; }
+  WiFiEventHandler onStationModeDisconnected(std::function<void(const WiFiEventStationModeDisconnected&)>) { return nullptr; }
+  wl_status_t status() { return WL_CONNECTED; }
+  int         RSSI() { return -50; }
+  bool        setSleep(bool) { return true; }
+  bool        setSleepMode(int) { return true; }
+  IPAddress   localIP() { return IPAddress(127, 0, 0, 1); }
+  IPAddress   subnetMask() { return IPAddress(255, 0, 0, 0); }
+  IPAddress   gatewayIP() { return IPAddress(127, 0, 0, 1); }
+  IPAddress   broadcastIP() { return IPAddress(127, 255, 255, 255); }
+  String      macAddress() { return String("02:00:00:00:00:01"); }
+  void        macAddress(uint8_t* mac) { static const uint8_t m[6] = {2, 0, 0, 0, 0, 1}; memcpy(mac, m, 6); }
+  String      hostname() { return String("timer-host"); }
+};
+
+extern WiFiClass WiFi;
+
+#endif // HOST_WIFI_H
@@ -0,0 +1,14 @@
+// WiFiManager.h (host): a "rede" já está de pé
+#ifndef HOST_WIFIMANAGER_H
+#define HOST_WIFIMANAGER_H
+
+#include <Arduino.h>
+
+class WiFiManager {
+ public:
+  void setConfigPortalTimeout(int) {}
+  void setConnectTimeout(int) {}
+  bool autoConnect(const char*) { return true; }
+};
+
+#endif // HOST_WIFIMANAGER_H
@@ -0,0 +1,28 @@
+// WiFiUdp.h (host): não envia nem recebe (sync e descoberta ficam sozinhos)
+#ifndef HOST_WIFIUDP_H
+#define HOST_WIFIUDP_H
+
+#include <Arduino.h>
+
+class WiFiUDP : public Stream {
+ public:
+  uint8_t begin(uint16_t) { return 1; }
+  void    stop() {}
+  int     beginPacket(IPAddress, uint16_t) { return 1; }
+  int     beginPacket(const char*, uint16_t) { return 1; }
+  int     beginPacketMulticast(IPAddress, uint16_t, IPAddress, int = 1) { return 1; }
+  uint8_t beginMulticast(IPAddress, uint16_t) { return 1; }
+  int     endPacket() { return 1; }
+  size_t  write(uint8_t) override { return 1; }
+  size_t  write(const uint8_t*, size_t n) override { return n; }
+  using Print::write;
+  int       parsePacket() { return 0; }
+  int       available() override { return 0; }
+  int       read() override { return -1; }
+  int       read(uint8_t*, size_t) { return 0; }
+  int       read(char*, size_t) { return 0; }
+  IPAddress remoteIP() { return IPAddress(); }
+  uint16_t  remotePort() { return 0; }
+};
+
+#endif // HOST_WIFIUDP_H
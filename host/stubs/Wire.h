@@ -0,0 +1,23 @@
+// Wire.h (host)
+// Barramento I2C sem dispositivos: toda transação falha (NACK).
+#ifndef HOST_WIRE_H
+#define HOST_WIRE_H
+
+#include <Arduino.h>
+
+class TwoWire {
+ public:
+  void    begin() {}
+  void    setClock(uint32_t) {}
+  void    setTimeOut(uint16_t) {}
+  void    setClockStretchLimit(uint32_t) {}
+  void    beginTransmission(uint8_t) {}
+  size_t  write(uint8_t) { return 1; }
+  uint8_t endTransmission(bool = true) { return 2; }
+  uint8_t requestFrom(uint8_t, uint8_t) { return 0; }
+  int     available() { return 0; }
+  int     read() { return -1; }
+};
+extern TwoWire Wire;
+
+#endif // HOST_WIRE_H
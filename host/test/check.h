@@ -0,0 +1,23 @@
+// check.h (host)
+// Verificações mínimas dos testes de host: contam falhas e seguem.
+#ifndef HOST_CHECK_H
+#define HOST_CHECK_H
+
+#include <stdio.h>
+
+static int s_checkFails = 0;
+
+#define CHECK(cond) \
+  do { if (!(cond)) { s_checkFails++; printf("%s:%d: falhou: %s\n", __FILE__, __LINE__, #cond); } } while (0)
+
+#define CHECK_EQ(what, got, want) \
+  do { long _g = (long)(got), _w = (long)(want); \
+       if (_g != _w) { s_checkFails++; printf("%s:%d: %s: %ld (esperado %ld)\n", __FILE__, __LINE__, (what), _g, _w); } } while (0)
+
+// Resumo e código de saída do main()
+static inline int checkReport(const char* name) {
+  printf("%s: %s (%d falha%s)\n", name, s_checkFails ? "FALHOU" : "ok", s_checkFails, s_checkFails == 1 ? "" : "s");
+  return s_checkFails ? 1 : 0;
+}
+
+#endif // HOST_CHECK_H
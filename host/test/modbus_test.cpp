@@ -0,0 +1,147 @@
+// modbus_test.cpp (host)
+// modbusHandle() com quadros MBAP montados à mão: leituras e escritas de
+// todas as funções (1, 2, 3, 4, 5, 6, 15, 16), as exceções de função,
+// endereço e valor, quadros com MBAP inconsistente (sem resposta) e a
+// escrita de um slot em holding seguida da leitura de volta.
+
+#include <Arduino.h>
+#include <TimeLib.h>
+#include <initializer_list>
+#include "config.h"
+#include "modbus.h"
+#include "output.h"
+#include "tz_rules.h"
+#include "../fw_globals.h"
+#include "check.h"
+
+static uint8_t s_resp[MODBUS_ADU_MAX];
+
+// Monta MBAP (transação 0x1234, unidade 1) + PDU e devolve o tamanho da
+// resposta; a PDU da resposta fica em s_resp + 7
+static size_t call(std::initializer_list<uint8_t> pdu, int lenFix = 0) {
+  uint8_t req[MODBUS_ADU_MAX];
+  size_t  n = 7;
+  for (uint8_t b : pdu) req[n++] = b;
+  uint16_t mbapLen = (uint16_t)(n - 6 + lenFix);
+  req[0] = 0x12; req[1] = 0x34;
+  req[2] = 0;    req[3] = 0;
+  req[4] = mbapLen >> 8;
+  req[5] = mbapLen & 0xFF;
+  req[6] = 1;
+  memset(s_resp, 0, sizeof(s_resp));
+  size_t r = modbusHandle(req, n, s_resp);
+  if (r >= 7) {
+    CHECK(s_resp[0] == 0x12 && s_resp[1] == 0x34);
+    CHECK_EQ("tamanho no MBAP", (s_resp[4] << 8) | s_resp[5], (long)r - 6);
+  }
+  return r;
+}
+
+static uint16_t reg(int i) {
+  return (uint16_t)(s_resp[9 + 2 * i] << 8 | s_resp[10 + 2 * i]);
+}
+
+// Resposta de exceção: função | 0x80 e o código
+static void expectException(const char* what, size_t r, uint8_t fc, uint8_t code) {
+  CHECK_EQ(what, (long)r, 9L);
+  CHECK_EQ(what, s_resp[7], fc | 0x80);
+  CHECK_EQ(what, s_resp[8], code);
+}
+
+static void testHolding() {
+  // FC 6: duração manual
+  CHECK_EQ("fc6", (long)call({ 0x06, 0x00, 0x00, 0x00, 30 }), 12L);
+  CHECK_EQ("fc6 eco", s_resp[11], 30);
+  CHECK_EQ("fc6 cfg", cfg.channels[0].manualDurationSec, 30);
+
+  // FC 16: um slot às 08:30:15 por 60 s (slots em uso + minuto, segundo, duração)
+  CHECK_EQ("fc16", (long)call({ 0x10, 0x00, 0x02, 0x00, 0x04, 8,
+                                0x00, 0x01, 0x01, 0xFE, 0x00, 0x0F, 0x00, 0x3C }), 12L);
+  CHECK_EQ("fc16 eco qtd", s_resp[11], 4);
+  CHECK_EQ("fc16 slots", cfg.channels[0].scheduleCount, 1);
+  CHECK_EQ("fc16 hora", cfg.channels[0].schedules[0].timeSec, 8L * 3600L + 30L * 60L + 15L);
+  CHECK_EQ("fc16 duração", cfg.channels[0].schedules[0].durationSec, 60);
+
+  // FC 3: leitura de volta
+  CHECK_EQ("fc3", (long)call({ 0x03, 0x00, 0x00, 0x00, 0x06 }), 9L + 12L);
+  CHECK_EQ("fc3 bytes", s_resp[8], 12);
+  CHECK_EQ("fc3 manual", reg(0), 30);
+  CHECK_EQ("fc3 slots", reg(2), 1);
+  CHECK_EQ("fc3 minuto", reg(3), 8 * 60 + 30);
+  CHECK_EQ("fc3 segundo", reg(4), 15);
+  CHECK_EQ("fc3 duração", reg(5), 60);
+
+  // valores inválidos não alteram nada
+  expectException("fc6 duração 0", call({ 0x06, 0x00, 0x00, 0x00, 0x00 }), 0x06, 0x03);
+  expectException("fc16 minuto 1440", call({ 0x10, 0x00, 0x03, 0x00, 0x01, 2, 0x05, 0xA0 }), 0x10, 0x03);
+  CHECK_EQ("sem alteração", cfg.channels[0].schedules[0].timeSec, 8L * 3600L + 30L * 60L + 15L);
+  // fora do bloco do canal e fora da imagem
+  expectException("fc6 canal inexistente", call({ 0x06, 0x00, 0x40, 0x00, 0x01 }), 0x06, 0x02);
+  expectException("fc3 endereço", call({ 0x03, 0x7F, 0xFF, 0x00, 0x02 }), 0x03, 0x02);
+  expectException("fc3 quantidade 0", call({ 0x03, 0x00, 0x00, 0x00, 0x00 }), 0x03, 0x03);
+}
+
+static void testCoils() {
+  // FC 5: liga a saída; FC 1 e FC 2 veem o estado
+  CHECK_EQ("fc5", (long)call({ 0x05, 0x00, 0x00, 0xFF, 0x00 }), 12L);
+  CHECK(channelActive(0));
+  CHECK_EQ("fc1", (long)call({ 0x01, 0x00, 0x00, 0x00, 0x04 }), 10L);
+  CHECK_EQ("fc1 bits", s_resp[9], 0x01);
+  CHECK_EQ("fc2", (long)call({ 0x02, 0x00, 0x00, 0x00, 0x04 }), 10L);
+  CHECK_EQ("fc2 bits", s_resp[9], 0x0F);   // ligada, manual, cooldown, pino
+
+  // desliga; o pulso FeedNow cai no cooldown
+  CHECK_EQ("fc5 off", (long)call({ 0x05, 0x00, 0x00, 0x00, 0x00 }), 12L);
+  CHECK(!channelActive(0));
+  expectException("fc5 cooldown", call({ 0x05, 0x00, 0x02, 0xFF, 0x00 }), 0x05, 0x06);
+  expectException("fc5 valor", call({ 0x05, 0x00, 0x00, 0x12, 0x34 }), 0x05, 0x03);
+  expectException("fc5 endereço", call({ 0x05, 0x00, 0x04, 0xFF, 0x00 }), 0x05, 0x02);
+
+  // FC 15: regras customizadas ligadas e desligadas
+  CHECK_EQ("fc15", (long)call({ 0x0F, 0x00, 0x01, 0x00, 0x01, 1, 0x01 }), 12L);
+  CHECK(cfg.channels[0].customEnabled);
+  CHECK_EQ("fc15 off", (long)call({ 0x0F, 0x00, 0x01, 0x00, 0x01, 1, 0x00 }), 12L);
+  CHECK(!cfg.channels[0].customEnabled);
+  expectException("fc15 bytes", call({ 0x0F, 0x00, 0x01, 0x00, 0x01, 2, 0x00, 0x00 }), 0x0F, 0x03);
+  expectException("fc1 endereço", call({ 0x01, 0x00, 0x3F, 0x00, 0x02 }), 0x01, 0x02);
+}
+
+static void testInputsAndFrames() {
+  CHECK_EQ("fc4", (long)call({ 0x04, 0x00, 0x00, 0x00, 0x07 }), 9L + 14L);
+  CHECK(((uint32_t)reg(0) << 16 | reg(1)) >= 1767268800UL);
+  CHECK_EQ("fc4 canais", reg(4), 1);
+  CHECK(reg(5) > 0);                        // pedidos atendidos
+
+  // contadores na imagem: republicados a cada escrita aceita
+  call({ 0x06, 0x00, 0x00, 0x00, 30 });
+  CHECK_EQ("fc4 exceções", (long)call({ 0x04, 0x00, 0x06, 0x00, 0x01 }), 11L);
+  long exceptions = reg(0);
+  CHECK(exceptions > 0);
+
+  expectException("função ilegal", call({ 0x07 }), 0x07, 0x01);
+  expectException("função 0x2B", call({ 0x2B, 0x0E, 0x01, 0x00, 0x00 }), 0x2B, 0x01);
+  expectException("pdu curta", call({ 0x03, 0x00 }), 0x03, 0x03);
+
+  // MBAP inconsistente: sem resposta
+  CHECK_EQ("mbap maior", (long)call({ 0x03, 0x00, 0x00, 0x00, 0x01 }, 1), 0L);
+  CHECK_EQ("mbap menor", (long)call({ 0x03, 0x00, 0x00, 0x00, 0x01 }, -1), 0L);
+  uint8_t bad[] = { 0, 1, 0, 1, 0, 6, 1, 0x03, 0x00, 0x00, 0x00, 0x01 };   // protocolo 1
+  CHECK_EQ("protocolo", (long)modbusHandle(bad, sizeof(bad), s_resp), 0L);
+  CHECK_EQ("quadro curto", (long)modbusHandle(bad, 7, s_resp), 0L);
+
+  call({ 0x06, 0x00, 0x00, 0x00, 30 });
+  CHECK_EQ("fc4 exceções", (long)call({ 0x04, 0x00, 0x06, 0x00, 0x01 }), 11L);
+  CHECK_EQ("exceções contadas", reg(0), exceptions + 3);   // MBAP inválido não conta
+}
+
+int main() {
+  hostDefaults(cfg);
+  CHECK(tzSet(cfg.tz));
+  outputsBegin(cfg);
+  setTime(1767268800);   // 2026-01-01 12:00 UTC
+  delay(5);              // lastTriggerMs = 0 significa "nunca": sai do ms 0
+  testHolding();
+  testCoils();
+  testInputsAndFrames();
+  return checkReport("modbus_test");
+}
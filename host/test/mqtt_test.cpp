@@ -0,0 +1,202 @@
+// mqtt_test.cpp (host)
+// mqttService() contra um broker local mínimo numa thread (127.0.0.1, porta
+// livre): CONNECT/CONNACK, SUBSCRIBE/SUBACK, "online" retido e um comando
+// P/0/cmd/rules respondido em P/0/result. Antes, com a porta fechada, a
+// tentativa de conexão não pode segurar o loop. Nenhuma chamada de
+// mqttService() pode passar de SERVICE_MAX_MS.
+
+#include <Arduino.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <unistd.h>
+#include <atomic>
+#include <mutex>
+#include <string>
+#include <thread>
+#include "config.h"
+#include "mqtt.h"
+#include "../fw_globals.h"
+#include "check.h"
+
+static constexpr unsigned long SERVICE_MAX_MS = 50;
+
+struct Broker {
+  int               listenFd = -1;
+  uint16_t          port     = 0;
+  std::atomic<bool> done{ false };
+  std::mutex        lock;
+  bool              gotConnect = false;
+  bool              gotSub     = false;
+  std::string       status;        // payload de t/status
+  std::string       result;        // payload de t/0/result
+};
+
+static bool readFull(int fd, uint8_t* p, size_t n) {
+  while (n) {
+    ssize_t r = recv(fd, p, n, 0);
+    if (r <= 0) return false;
+    p += r;
+    n -= r;
+  }
+  return true;
+}
+
+// Um pacote: tipo e corpo
+static bool readPacket(int fd, uint8_t& type, std::string& body) {
+  uint8_t  b;
+  uint32_t len = 0, mul = 1;
+  if (!readFull(fd, &type, 1)) return false;
+  do {
+    if (!readFull(fd, &b, 1)) return false;
+    len += (b & 0x7F) * mul;
+    mul *= 128;
+  } while (b & 0x80);
+  body.resize(len);
+  return len == 0 || readFull(fd, (uint8_t*)&body[0], len);
+}
+
+static void sendPacket(int fd, uint8_t type, const std::string& body) {
+  std::string p(1, (char)type);
+  p += (char)body.size();   // corpos curtos (< 128)
+  p += body;
+  send(fd, p.data(), p.size(), MSG_NOSIGNAL);
+}
+
+static std::string str16(const std::string& s) {
+  return std::string(1, (char)(s.size() >> 8)) + (char)(s.size() & 0xFF) + s;
+}
+
+// PUBLISH QoS 0: tópico e payload
+static bool splitPublish(const std::string& body, std::string& topic, std::string& payload) {
+  if (body.size() < 2) return false;
+  size_t n = ((uint8_t)body[0] << 8) | (uint8_t)body[1];
+  if (2 + n > body.size()) return false;
+  topic   = body.substr(2, n);
+  payload = body.substr(2 + n);
+  return true;
+}
+
+static void brokerRun(Broker* b) {
+  int fd = accept(b->listenFd, nullptr, nullptr);
+  if (fd < 0) {
+    b->done = true;
+    return;
+  }
+  timeval tv = { 5, 0 };
+  setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+
+  uint8_t     type;
+  std::string body, topic, payload;
+  bool        commandSent = false;
+  while (readPacket(fd, type, body)) {
+    switch (type & 0xF0) {
+      case 0x10: {
+        std::lock_guard<std::mutex> g(b->lock);
+        b->gotConnect = true;
+        sendPacket(fd, 0x20, std::string("\0\0", 2));
+        break;
+      }
+      case 0x80:
+        if (body.size() >= 2) {
+          {
+            std::lock_guard<std::mutex> g(b->lock);
+            b->gotSub = true;
+          }
+          sendPacket(fd, 0x90, body.substr(0, 2) + '\0');
+        }
+        break;
+      case 0x30:
+        if (!splitPublish(body, topic, payload)) break;
+        {
+          std::lock_guard<std::mutex> g(b->lock);
+          if (topic == "t/status") b->status = payload;
+          if (topic == "t/0/result") b->result = payload;
+        }
+        if (topic == "t/0/result") goto out;
+        break;
+    }
+    std::lock_guard<std::mutex> g(b->lock);
+    if (!commandSent && b->gotSub && b->status == "online") {
+      sendPacket(fd, 0x30, str16("t/0/cmd/rules") + "on");
+      commandSent = true;
+    }
+  }
+out:
+  close(fd);
+  b->done = true;
+}
+
+static int listenLocal(uint16_t& port) {
+  int fd = socket(AF_INET, SOCK_STREAM, 0);
+  sockaddr_in a = {};
+  a.sin_family      = AF_INET;
+  a.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+  socklen_t n = sizeof(a);
+  if (fd < 0 || bind(fd, (sockaddr*)&a, n) != 0 || listen(fd, 1) != 0 ||
+      getsockname(fd, (sockaddr*)&a, &n) != 0) {
+    if (fd >= 0) close(fd);
+    return -1;
+  }
+  port = ntohs(a.sin_port);
+  return fd;
+}
+
+// Chama o serviço até `until` ou `ms`; devolve a chamada mais longa
+static unsigned long serviceFor(unsigned long ms, const std::function<bool()>& until) {
+  unsigned long worst = 0;
+  unsigned long t0    = millis();
+  while (millis() - t0 < ms && !until()) {
+    unsigned long a = millis();
+    mqttService();
+    unsigned long d = millis() - a;
+    if (d > worst) worst = d;
+    delay(1);
+  }
+  return worst;
+}
+
+int main() {
+  hostDefaults(cfg);
+  cfg.mqtt.enabled = true;
+  strcpy(cfg.mqtt.host, "127.0.0.1");
+  strcpy(cfg.mqtt.prefix, "t");
+  cfg.mqtt.qos      = 0;
+  cfg.mqtt.stateSec = 0;
+
+  // porta sem ninguém escutando: recusa, volta a MQ_DOWN e espera
+  uint16_t closedPort = 0;
+  int      tmp        = listenLocal(closedPort);
+  CHECK(tmp >= 0);
+  close(tmp);
+  cfg.mqtt.port = closedPort;
+  mqttBegin();
+  unsigned long worst = serviceFor(300, [] { return false; });
+  CHECK(!mqttConnected());
+  CHECK(worst < SERVICE_MAX_MS);
+
+  Broker b;
+  b.listenFd = listenLocal(b.port);
+  CHECK(b.listenFd >= 0);
+  std::thread th(brokerRun, &b);
+
+  cfg.mqtt.port = b.port;
+  mqttReconfigure();
+  worst = serviceFor(5000, [&] { return b.done.load(); });
+  // o resultado ainda pode estar saindo
+  if (!b.done) serviceFor(500, [&] { return b.done.load(); });
+  if (!b.done) shutdown(b.listenFd, SHUT_RDWR);
+  th.join();
+  close(b.listenFd);
+
+  CHECK(b.gotConnect);
+  CHECK(b.gotSub);
+  CHECK(b.status == "online");
+  CHECK(b.result == "{\"cmd\":\"rules\",\"result\":\"on\"}");
+  CHECK(cfg.channels[0].customEnabled);
+  CHECK(worst < SERVICE_MAX_MS);
+  printf("mqtt_test: chamada mais longa %lu ms\n", worst);
+
+  return checkReport("mqtt_test");
+}
@@ -0,0 +1,115 @@
+// program_test.cpp (host)
+// Tabela de programa em flash: importação convertida aos poucos por
+// progService() (e o erro de linha relatado em /program) e progTick() nos
+// dias de troca do horário de verão (EUA). 02:30 não existe na primavera e
+// 01:30 se repete no outono; cada registro dispara uma vez. O relógio é o
+// do TimeLib (setTime), pois progTick() não roda sob o relógio simulado.
+
+#include <Arduino.h>
+#include <TimeLib.h>
+#include <vector>
+#include "config.h"
+#include "output.h"
+#include "program_table.h"
+#include "time_utils.h"
+#include "tz_rules.h"
+#include "../fw_globals.h"
+#include "check.h"
+
+struct Fire {
+  long   day;     // dia local do disparo
+  time_t local;
+};
+
+static std::vector<Fire> s_fires;
+
+static void onTrigger(int, unsigned long) {
+  time_t local = tzToLocal(now());
+  s_fires.push_back({ localEpochDay(local), local });
+}
+
+static time_t utcOf(int y, int mo, int d, int h, int mi, int s) {
+  time_t local = (time_t)daysFromCivil(y, mo, d) * 86400L + h * 3600L + mi * 60L + s;
+  return local - tzOffsetAt(local);
+}
+
+// Envia o texto em pedaços, como o upload, e converte até o fim
+static bool import(const char* text, String& json) {
+  if (!progImportBegin(0)) return false;
+  size_t n = strlen(text);
+  for (size_t i = 0; i < n; i += 7) {
+    progImportChunk((const uint8_t*)text + i, n - i < 7 ? n - i : 7);
+  }
+  if (!progImportEnd()) return false;
+  DynamicJsonDocument doc(256);
+  for (int k = 0; k < 1000; k++) {
+    progService();
+    doc.clear();
+    progToJson(0, doc.to<JsonObject>());
+    if (!doc["importing"].as<bool>()) break;
+  }
+  json = "";
+  serializeJson(doc, json);
+  return true;
+}
+
+// Um segundo por vez de `from` até `to`, como o motor
+static void run(time_t from, time_t to) {
+  for (time_t t = from; t < to; t++) {
+    setTime(t);
+    chState.lastTriggerMs[0] = 0;   // cooldown em ms reais: fora do teste
+    progTick(cfg, onTrigger);
+    progService();
+  }
+}
+
+static void testImport() {
+  String js;
+  CHECK(import("# semana\n0 01:30:00 00:00:05\n0 02:30:00 00:00:05\n3 12:00:00 00:00:05", js));
+  CHECK(js.indexOf("\"records\":3") >= 0);
+  CHECK(js.indexOf("\"import_ok\":true") >= 0);
+
+  // erro na linha 3: a tabela anterior fica
+  CHECK(import("0 01:00:00 00:00:05\n0 02:00:00 00:00:05\n0 01:00:00 00:00:05\n", js));
+  CHECK(js.indexOf("\"records\":3") >= 0);
+  CHECK(js.indexOf("\"import_ok\":false") >= 0);
+  CHECK(js.indexOf("Linha 3: fora de ordem") >= 0);
+}
+
+static void testDst() {
+  CHECK(tzSet("EST5EDT,M3.2.0,M11.1.0"));
+
+  // primavera: 02:30 de domingo cai no salto e dispara às 03:00
+  s_fires.clear();
+  run(utcOf(2026, 3, 7, 12, 0, 0), utcOf(2026, 3, 9, 12, 0, 0));
+  CHECK_EQ("primavera", (long)s_fires.size(), 2L);
+  if (s_fires.size() == 2) {
+    CHECK_EQ("primavera 01:30", (long)localSecOfDay(s_fires[0].local), 1L * 3600L + 30L * 60L);
+    CHECK_EQ("primavera 02:30", (long)localSecOfDay(s_fires[1].local), 3L * 3600L);
+    CHECK_EQ("primavera dia", s_fires[1].day, daysFromCivil(2026, 3, 8));
+  }
+
+  // outono: 01:30 acontece duas vezes no relógio local e dispara uma
+  s_fires.clear();
+  run(utcOf(2026, 10, 31, 12, 0, 0), utcOf(2026, 11, 2, 12, 0, 0));
+  CHECK_EQ("outono", (long)s_fires.size(), 2L);
+  if (s_fires.size() == 2) {
+    CHECK_EQ("outono 01:30", (long)localSecOfDay(s_fires[0].local), 1L * 3600L + 30L * 60L);
+    CHECK_EQ("outono 02:30", (long)localSecOfDay(s_fires[1].local), 2L * 3600L + 30L * 60L);
+  }
+
+  // semana comum: quarta 12:00
+  s_fires.clear();
+  run(utcOf(2026, 11, 4, 11, 0, 0), utcOf(2026, 11, 4, 13, 0, 0));
+  CHECK_EQ("quarta", (long)s_fires.size(), 1L);
+}
+
+int main() {
+  hostDefaults(cfg);
+  progBegin();
+  progClear(0);
+  testImport();
+  testDst();
+  progClear(0);
+  return checkReport("program_test");
+}
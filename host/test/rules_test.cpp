@@ -0,0 +1,98 @@
+// rules_test.cpp (host)
+// Programas DC(...) no motor de regras, no relógio virtual do hal: fases
+// menores que FEED_COOLDOWN são recusadas na compilação, a borda DC não se
+// perde quando uma regra de prioridade maior dispara no mesmo tick, e uma
+// troca recusada (cooldown) não registra evento nem consome a borda.
+
+#include <Arduino.h>
+#include "config.h"
+#include "custom_rules.h"
+#include "exceptions.h"
+#include "hal.h"
+#include "output.h"
+#include "time_utils.h"
+#include "tz_rules.h"
+#include "check.h"
+
+static const int PIN = 5;
+
+static time_t utcOf(int y, int mo, int d, int h, int mi, int s) {
+  time_t local = (time_t)daysFromCivil(y, mo, d) * 86400L + h * 3600L + mi * 60L + s;
+  return local - tzOffsetAt(local);
+}
+
+static bool setup(Config& c, const char* rules) {
+  memset(&c, 0, sizeof(c));
+  c.channelCount = 1;
+  defaultChannel(c.channels[0], PIN);
+  c.channels[0].customEnabled = true;
+  snprintf(c.channels[0].customSchedule, sizeof(c.channels[0].customSchedule), "%s", rules);
+  memset(&chState, 0, sizeof(chState));
+  ruleLastCheck = 0;
+  int    errPos;
+  String errMsg;
+  return compileCustomRules(c.channels[0], errPos, errMsg);
+}
+
+// Um segundo por vez até `untilUtc`, como o motor; devolve quantas regras
+// dispararam (log e eventos ficam de fora sob o relógio simulado)
+static int run(Config& c, time_t untilUtc) {
+  int fired = 0;
+  while (halUtcNow() < untilUtc) {
+    String ev = checkCustomRules(c, [&](int ch, bool on, unsigned long dur) {
+      return on ? startOutput(c, ch, dur) : stopOutput(c, ch);
+    });
+    if (ev.length()) fired++;
+    halSimAdvance(1);
+  }
+  return fired;
+}
+
+static void testCooldownSegments() {
+  Config* c = new Config;
+  CHECK(!setup(*c, "DC(5s/1m)"));
+  CHECK(!setup(*c, "DC(1m/9s)"));
+  CHECK(setup(*c, "DC(10s/1m)"));
+  delete c;
+}
+
+// DL às 00:02:00 ganha da borda DC+ do mesmo segundo (pino já desligado,
+// nada a fazer); a borda fica pendente e liga no segundo seguinte
+static void testEdgeKept() {
+  Config* c = new Config;
+  CHECK(setup(*c, "DC(1m/1m) DL00:02:00"));
+  halSimBegin(utcOf(2026, 5, 4, 0, 0, 30), nullptr);
+  run(*c, utcOf(2026, 5, 4, 0, 1, 30));
+  CHECK_EQ("fase off", halOutputRead(PIN), LOW);
+  run(*c, utcOf(2026, 5, 4, 0, 2, 1));
+  CHECK_EQ("DL no tick da borda", halOutputRead(PIN), LOW);
+  run(*c, utcOf(2026, 5, 4, 0, 2, 2));
+  CHECK_EQ("borda DC+ pendente", halOutputRead(PIN), HIGH);
+  halSimEnd();
+  delete c;
+}
+
+// Cooldown ativo na borda DC+: a regra só conta quando a troca acontece
+static void testRefusedNotLogged() {
+  Config* c = new Config;
+  CHECK(setup(*c, "DC(1m/1m)"));
+  halSimBegin(utcOf(2026, 5, 4, 0, 1, 30), nullptr);
+  run(*c, utcOf(2026, 5, 4, 0, 1, 59));
+  CHECK_EQ("fase off", halOutputRead(PIN), LOW);
+  chState.lastTriggerMs[0] = halMillis();   // acabou de acionar
+  CHECK_EQ("sem disparo", run(*c, utcOf(2026, 5, 4, 0, 2, 5)), 0);
+  CHECK_EQ("recusada pelo cooldown", halOutputRead(PIN), LOW);
+  CHECK_EQ("um disparo", run(*c, utcOf(2026, 5, 4, 0, 2, 15)), 1);
+  CHECK_EQ("após o cooldown", halOutputRead(PIN), HIGH);
+  halSimEnd();
+  delete c;
+}
+
+int main() {
+  CHECK(tzSet("<-03>3"));
+  excBegin();
+  testCooldownSegments();
+  testEdgeKept();
+  testRefusedNotLogged();
+  return checkReport("rules_test");
+}
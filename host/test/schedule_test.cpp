@@ -0,0 +1,240 @@
+// schedule_test.cpp (host)
+// Varredura de checkSchedules() no relógio virtual do hal: vários anos com
+// dias bissextos e viradas de ano, dias de troca do horário de verão, travas
+// curtas, saltos e recuos do relógio, canais alternando para as regras e
+// dias com horários de substituição do calendário de exceções.
+// Cada slot deve disparar exatamente uma vez por dia local.
+
+#include <Arduino.h>
+#include <limits.h>
+#include <vector>
+#include "config.h"
+#include "exceptions.h"
+#include "hal.h"
+#include "output.h"
+#include "schedule.h"
+#include "time_utils.h"
+#include "tz_rules.h"
+#include "check.h"
+
+struct Fire {
+  int    ch;
+  long   day;     // dia local do disparo
+  time_t local;
+  long   dur;
+};
+
+static std::vector<Fire> s_fires;
+
+static void onTrigger(int ch, unsigned long dur) {
+  time_t local = tzToLocal(halUtcNow());
+  s_fires.push_back({ ch, localEpochDay(local), local, (long)dur });
+}
+
+static time_t utcOf(int y, int mo, int d, int h, int mi, int s) {
+  time_t local = (time_t)daysFromCivil(y, mo, d) * 86400L + h * 3600L + mi * 60L + s;
+  return local - tzOffsetAt(local);
+}
+
+// Config com um canal e os slots dados (segundos do dia local)
+static void setup(Config& c, std::initializer_list<int> slots) {
+  memset(&c, 0, sizeof(c));
+  c.channelCount = 1;
+  defaultChannel(c.channels[0], 5);
+  for (int t : slots) c.channels[0].schedules[c.channels[0].scheduleCount++] = { t, 1, -1 };
+  memset(&chState, 0, sizeof(chState));
+  scheduleTick = {};
+  s_fires.clear();
+}
+
+// Avança de `step` em `step` segundos até `untilUtc`, chamando o motor
+static void run(Config& c, time_t untilUtc, long step) {
+  while (halUtcNow() < untilUtc) {
+    checkSchedules(c, onTrigger);
+    halSimAdvance(step);
+  }
+}
+
+// Um disparo por slot em cada dia local de [firstDay, lastDay], nunca mais
+// que isso em dia algum e em ordem
+static void expectDaily(const char* what, int slots, long firstDay, long lastDay) {
+  std::vector<int> count(lastDay - firstDay + 3, 0);
+  long prev = LONG_MIN;
+  for (const Fire& f : s_fires) {
+    if (f.day < prev) { CHECK_EQ(what, f.day, prev); return; }
+    prev = f.day;
+    long k = f.day - firstDay + 1;
+    if (k < 0 || k >= (long)count.size()) { CHECK_EQ(what, f.day, firstDay); return; }
+    count[k]++;
+  }
+  for (size_t k = 0; k < count.size(); k++) {
+    bool inside = k >= 1 && (long)k <= lastDay - firstDay + 1;   // 0 e o último: vizinhos
+    if (count[k] > slots || (inside && count[k] != slots)) {
+      CHECK_EQ(what, (long)count[k], (long)slots);
+      return;
+    }
+  }
+}
+
+// 2023-03-01 .. 2029-03-01 em passos de 60 s (janela de recuperação):
+// bissextos 2024 e 2028, seis viradas de ano
+static void testYears(const char* tz) {
+  CHECK(tzSet(tz));
+  Config* c = new Config;
+  setup(*c, { 0, 12 * 3600, 23 * 3600 + 57 * 60 });   // > FEED_COOLDOWN entre si
+  time_t from = utcOf(2023, 3, 1, 0, 0, 30);
+  time_t to   = utcOf(2029, 3, 1, 0, 0, 0);
+  halSimBegin(from, nullptr);
+  run(*c, to, 60);
+  halSimEnd();
+  String what = String("anos ") + tz;
+  // 01/03/2023 perde o 00:00:00 (antes de `from`); os dias seguintes, completos
+  expectDaily(what.c_str(), 3, daysFromCivil(2023, 3, 2), daysFromCivil(2029, 2, 28));
+  CHECK_EQ(what.c_str(), (long)s_fires.size(), (daysFromCivil(2029, 3, 1) - daysFromCivil(2023, 3, 1)) * 3L - 1);
+  delete c;
+}
+
+// Horário de verão (EUA): 02:30 não existe na primavera e 01:30 se repete
+// no outono; ambos disparam uma vez. Passo de 1 s.
+static void testDst() {
+  CHECK(tzSet("EST5EDT,M3.2.0,M11.1.0"));
+  Config* c = new Config;
+
+  setup(*c, { 2 * 3600 + 30 * 60 });
+  halSimBegin(utcOf(2026, 3, 7, 12, 0, 0), nullptr);
+  run(*c, utcOf(2026, 3, 10, 12, 0, 0), 1);
+  halSimEnd();
+  CHECK_EQ("dst primavera", (long)s_fires.size(), 3L);
+  if (s_fires.size() == 3) {
+    CHECK_EQ("dst primavera dia", s_fires[0].day, daysFromCivil(2026, 3, 8));
+    CHECK_EQ("dst primavera hora", (long)localSecOfDay(s_fires[0].local), 3L * 3600L);
+  }
+
+  setup(*c, { 1 * 3600 + 30 * 60 });
+  halSimBegin(utcOf(2026, 10, 31, 12, 0, 0), nullptr);
+  run(*c, utcOf(2026, 11, 3, 12, 0, 0), 1);
+  halSimEnd();
+  CHECK_EQ("dst outono", (long)s_fires.size(), 3L);
+  delete c;
+}
+
+// Travas curtas recuperam; saltos grandes e recuos não disparam nem repetem
+static void testJumps() {
+  CHECK(tzSet("<-03>3"));
+  Config* c = new Config;
+  const int SLOT = 8 * 3600;
+
+  // trava de 90 s por cima do slot: recuperado uma vez
+  setup(*c, { SLOT });
+  halSimBegin(utcOf(2026, 5, 4, 7, 59, 0), nullptr);
+  checkSchedules(*c, onTrigger);
+  halSimAdvance(90);
+  checkSchedules(*c, onTrigger);
+  run(*c, utcOf(2026, 5, 4, 9, 0, 0), 1);
+  halSimEnd();
+  CHECK_EQ("trava curta", (long)s_fires.size(), 1L);
+
+  // salto de 2 h por cima do slot: perdido (não recupera horas)
+  setup(*c, { SLOT });
+  halSimBegin(utcOf(2026, 5, 4, 7, 0, 0), nullptr);
+  checkSchedules(*c, onTrigger);
+  halSimAdvance(2 * 3600);
+  run(*c, utcOf(2026, 5, 4, 12, 0, 0), 1);
+  halSimEnd();
+  CHECK_EQ("salto grande", (long)s_fires.size(), 0L);
+
+  // recuo de 1 h depois do slot: não repete; no dia seguinte volta
+  setup(*c, { SLOT });
+  halSimBegin(utcOf(2026, 5, 4, 7, 59, 50), nullptr);
+  run(*c, utcOf(2026, 5, 4, 8, 30, 0), 1);
+  HalSimState st;
+  halSimSave(st);
+  st.utc -= 3600;
+  halSimResume(st, nullptr);
+  run(*c, utcOf(2026, 5, 5, 8, 0, 30), 1);
+  halSimEnd();
+  CHECK_EQ("recuo", (long)s_fires.size(), 2L);
+  if (s_fires.size() == 2) CHECK_EQ("recuo dia", s_fires[1].day, daysFromCivil(2026, 5, 5));
+  delete c;
+}
+
+// Regras ativas no horário do slot: não dispara nem ao desativar depois
+static void testCustomToggle() {
+  CHECK(tzSet("<-03>3"));
+  Config* c = new Config;
+  setup(*c, { 8 * 3600 });
+  halSimBegin(utcOf(2026, 5, 4, 7, 0, 0), nullptr);
+  run(*c, utcOf(2026, 5, 4, 7, 59, 0), 1);
+  c->channels[0].customEnabled = true;
+  run(*c, utcOf(2026, 5, 4, 8, 1, 0), 1);
+  c->channels[0].customEnabled = false;
+  run(*c, utcOf(2026, 5, 5, 9, 0, 0), 1);
+  halSimEnd();
+  CHECK_EQ("regras ativas", (long)s_fires.size(), 1L);
+  if (s_fires.size() == 1) CHECK_EQ("regras dia", s_fires[0].day, daysFromCivil(2026, 5, 5));
+  delete c;
+}
+
+// Dia com horários de substituição: o slot comum não dispara, os dois
+// horários próprios sim (com a duração deles), cada um uma vez
+static void testReplacement() {
+  CHECK(tzSet("<-03>3"));
+  Config* c = new Config;
+  setup(*c, { 8 * 3600 });
+  halSimBegin(utcOf(2026, 5, 4, 7, 0, 0), nullptr);
+  int    errPos;
+  String errMsg;
+  CHECK(!excSet("2026-05-05=0+07:00:00/00:00:30", errPos, errMsg));
+  CHECK(!excSet("2026-05-05=07:00:00/00:06:00", errPos, errMsg));
+  CHECK(excSet("2026-05-05=07:00:00/00:00:30+18:00:00/00:01:00@0", errPos, errMsg));
+  CHECK(excToString() == "2026-05-05=07:00:00/00:00:30+18:00:00/00:01:00@0");
+
+  run(*c, utcOf(2026, 5, 5, 6, 0, 0), 1);
+  int dur;
+  CHECK_EQ("próxima substituição", nextTriggerIn(*c, 0, &dur), 3600L);
+  CHECK_EQ("duração da próxima", (long)dur, 30L);
+
+  // trava de 90 s por cima das 18:00: recuperado uma vez
+  run(*c, utcOf(2026, 5, 5, 17, 59, 0), 1);
+  halSimAdvance(90);
+  run(*c, utcOf(2026, 5, 6, 9, 0, 0), 1);
+  halSimEnd();
+  CHECK_EQ("substituição", (long)s_fires.size(), 4L);
+  if (s_fires.size() == 4) {
+    CHECK_EQ("dia comum", (long)localSecOfDay(s_fires[0].local), 8L * 3600L);
+    CHECK_EQ("substituição 07:00", (long)localSecOfDay(s_fires[1].local), 7L * 3600L);
+    CHECK_EQ("duração 07:00", s_fires[1].dur, 30L);
+    CHECK_EQ("substituição 18:00", s_fires[2].day, daysFromCivil(2026, 5, 5));
+    CHECK_EQ("duração 18:00", s_fires[2].dur, 60L);
+    CHECK_EQ("dia seguinte", s_fires[3].day, daysFromCivil(2026, 5, 6));
+  }
+
+  // recuo do relógio pela meia-noite (00:00:30 -> 23:58:00): o horário das
+  // 23:59 do dia anterior não dispara de novo
+  setup(*c, {});
+  halSimBegin(utcOf(2026, 5, 5, 23, 0, 0), nullptr);
+  CHECK(excSet("2026-05-05=23:59:00/00:00:30@0", errPos, errMsg));
+  run(*c, utcOf(2026, 5, 6, 0, 0, 30), 1);
+  HalSimState st;
+  halSimSave(st);
+  st.utc -= 150;
+  halSimResume(st, nullptr);
+  run(*c, utcOf(2026, 5, 6, 0, 5, 0), 1);
+  halSimEnd();
+  CHECK_EQ("substituição após recuo", (long)s_fires.size(), 1L);
+
+  CHECK(excSet("", errPos, errMsg));
+  delete c;
+}
+
+int main() {
+  excBegin();
+  testYears("<-04>4");
+  testYears("<+0930>-9:30");
+  testYears("EST5EDT,M3.2.0,M11.1.0");
+  testDst();
+  testJumps();
+  testCustomToggle();
+  testReplacement();
+  return checkReport("schedule_test");
+}
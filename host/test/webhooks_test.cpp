@@ -0,0 +1,146 @@
+// webhooks_test.cpp (host)
+// webhooksService() contra um servidor HTTP mínimo numa thread (127.0.0.1,
+// porta livre). O primeiro POST recebe 500 e o mesmo lote tem de voltar,
+// após a espera, e ser aceito com 204. Abertura, envio e resposta correm
+// pela máquina de estados: nenhuma chamada pode passar de SERVICE_MAX_MS.
+
+#include <Arduino.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <unistd.h>
+#include <atomic>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "config.h"
+#include "events.h"
+#include "webhooks.h"
+#include "../fw_globals.h"
+#include "check.h"
+
+static constexpr unsigned long SERVICE_MAX_MS = 50;
+
+struct StandIn {
+  int                      listenFd = -1;
+  uint16_t                 port     = 0;
+  std::atomic<bool>        done{ false };
+  std::mutex               lock;
+  std::vector<std::string> bodies;   // corpo de cada POST recebido
+  std::string              head;     // cabeçalho do último
+};
+
+// Cabeçalho até a linha vazia e o corpo pelo Content-Length
+static bool readRequest(int fd, std::string& head, std::string& body) {
+  std::string buf;
+  char        tmp[512];
+  size_t      end;
+  while ((end = buf.find("\r\n\r\n")) == std::string::npos) {
+    ssize_t r = recv(fd, tmp, sizeof(tmp), 0);
+    if (r <= 0) return false;
+    buf.append(tmp, r);
+  }
+  head = buf.substr(0, end);
+  body = buf.substr(end + 4);
+  size_t cl = head.find("Content-Length: ");
+  size_t n  = cl == std::string::npos ? 0 : (size_t)atol(head.c_str() + cl + 16);
+  while (body.size() < n) {
+    ssize_t r = recv(fd, tmp, sizeof(tmp), 0);
+    if (r <= 0) return false;
+    body.append(tmp, r);
+  }
+  return true;
+}
+
+static void standInRun(StandIn* s) {
+  static const char* REPLY[] = {
+    "HTTP/1.1 500 Internal Server Error\r\nContent-Length: 0\r\nConnection: close\r\n\r\n",
+    "HTTP/1.1 204 No Content\r\nConnection: close\r\n\r\n",
+  };
+  for (const char* reply : REPLY) {
+    int fd = accept(s->listenFd, nullptr, nullptr);
+    if (fd < 0) break;
+    timeval tv = { 5, 0 };
+    setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+    std::string head, body;
+    if (readRequest(fd, head, body)) {
+      std::lock_guard<std::mutex> g(s->lock);
+      s->head = head;
+      s->bodies.push_back(body);
+    }
+    send(fd, reply, strlen(reply), MSG_NOSIGNAL);
+    close(fd);
+  }
+  s->done = true;
+}
+
+static int listenLocal(uint16_t& port) {
+  int fd = socket(AF_INET, SOCK_STREAM, 0);
+  sockaddr_in a = {};
+  a.sin_family      = AF_INET;
+  a.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+  socklen_t n = sizeof(a);
+  if (fd < 0 || bind(fd, (sockaddr*)&a, n) != 0 || listen(fd, 1) != 0 ||
+      getsockname(fd, (sockaddr*)&a, &n) != 0) {
+    if (fd >= 0) close(fd);
+    return -1;
+  }
+  port = ntohs(a.sin_port);
+  return fd;
+}
+
+// "chave":valor numérico em webhooksJson() (primeiro destino)
+static long jsonNum(const String& js, const char* key) {
+  String k   = String("\"") + key + "\":";
+  int    pos = js.indexOf(k);
+  return pos < 0 ? -1 : atol(js.c_str() + pos + k.length());
+}
+
+int main() {
+  hostDefaults(cfg);
+
+  StandIn s;
+  s.listenFd = listenLocal(s.port);
+  CHECK(s.listenFd >= 0);
+  std::thread th(standInRun, &s);
+
+  snprintf(cfg.webhooks[0], WEBHOOK_URL_LEN, "http://127.0.0.1:%u/hook", s.port);
+  webhooksBegin();
+  eventPush(EVT_OUTPUT, 0, true, false, nullptr);
+  eventPush(EVT_OUTPUT, 0, false, false, nullptr);
+
+  // 500, espera WEBHOOK_BACKOFF_MIN_MS e reenvia
+  unsigned long worst = 0;
+  unsigned long t0    = millis();
+  while (millis() - t0 < WEBHOOK_BACKOFF_MIN_MS + 3000) {
+    unsigned long a = millis();
+    webhooksService();
+    unsigned long d = millis() - a;
+    if (d > worst) worst = d;
+    if (s.done && jsonNum(webhooksJson(), "last_status") == 204) break;
+    delay(1);
+  }
+  if (!s.done) shutdown(s.listenFd, SHUT_RDWR);
+  th.join();
+  close(s.listenFd);
+
+  String js = webhooksJson();
+  CHECK_EQ("POSTs", s.bodies.size(), 2);
+  if (s.bodies.size() == 2) {
+    CHECK(s.bodies[0] == s.bodies[1]);   // mesmo lote no reenvio
+    CHECK(s.bodies[1].find("\"events\":[{\"seq\":") != std::string::npos);
+    CHECK(s.bodies[1].find("\"on\":false") != std::string::npos);
+  }
+  CHECK(s.head.find("POST /hook HTTP/1.1") == 0);
+  CHECK_EQ("failures",    jsonNum(js, "failures"), 1);
+  CHECK_EQ("batches",     jsonNum(js, "batches"), 1);
+  CHECK_EQ("events",      jsonNum(js, "events"), 2);
+  CHECK_EQ("last_status", jsonNum(js, "last_status"), 204);
+  CHECK_EQ("pending",     jsonNum(js, "pending"), 0);
+  CHECK(worst < SERVICE_MAX_MS);
+  printf("webhooks_test: chamada mais longa %lu ms\n", worst);
+
+  return checkReport("webhooks_test");
+}
@@ -0,0 +1,27 @@
+// timer_host.cpp (host)
+// O firmware inteiro (setup()/loop() do .ino) como processo do Linux, com
+// o HTTP num socket de verdade (stubs/WebServer.cpp). É o servidor do teste
+// de carga (loadtest.py); serve também para abrir a UI num navegador.
+//
+//   HOST_HTTP_PORT=8080 HOST_FS=dir build/timer_host
+//
+// SIGINT/SIGTERM terminam no fim da volta atual do loop().
+
+#include <Arduino.h>
+#include <signal.h>
+
+void setup();
+void loop();
+
+static volatile sig_atomic_t s_stop = 0;
+
+static void onSignal(int) { s_stop = 1; }
+
+int main() {
+  signal(SIGINT, onSignal);
+  signal(SIGTERM, onSignal);
+  signal(SIGPIPE, SIG_IGN);
+  setup();
+  while (!s_stop) loop();
+  return 0;
+}
@@ -0,0 +1,174 @@
+// logbuf.cpp
+
+#include "logbuf.h"
+#include "hal.h"
+#include "time_utils.h"
+#include "tz_rules.h"
+#include <TimeLib.h>
+
+// Textos por LogId. Códigos: %c canal, %a / %b inteiros, %A / %B inteiros
+// em décimos de milésimo (4 casas), %h duração de b em HH:MM:SS, %s texto.
+static const char* const FORMATS[] = {
+  "CH%c Saída LIGADA",
+  "CH%c Saída DESLIGADA",
+  "CH%c FeedNow %s acionado",
+  "CH%c StopFeedNow %s acionado",
+  "CH%c CustomRules ativadas (%s)",
+  "CH%c CustomRules desativadas (%s)",
+  "CH%c %a agendamentos salvos (%s)",
+  "Botão %s: Saída LIGADA",
+  "Botão %s: Saída DESLIGADA",
+  "Botão %s: regras ativadas",
+  "Botão %s: regras desativadas",
+  "Botão %s: sem efeito",
+  "Relógio ajustado (%a s); disparos perdidos ignorados.",
+  "CH%c Agendamento #%a acionado (duração %h).",
+  "CH%c Agendamento #%a suprimido (exceção do calendário).",
+  "CH%c Agendamento #%a ignorado (cooldown).",
+  "CH%c Substituição #%a acionada (duração %h).",
+  "CH%c Substituição #%a ignorada (cooldown).",
+  "CH%c Regra %s detectada para LIGAR saída.",
+  "CH%c Regra %s detectada para DESLIGAR saída.",
+  "CH%c Programa: registro #%a acionado (duração %h).",
+  "CH%c Programa: registro #%a ignorado (%s).",
+  "CH%c Programa importado: %a registros",
+  "Sync: travado no líder %s",
+  "Sync: líder sem resposta; mantendo o relógio local",
+  "MQTT conectado a %s",
+  "MQTT desconectado (%s)",
+  "MQTT: canal %a inválido em comando",
+  "MQTT: assinatura recusada",
+  "Webhook %a normalizado",
+  "Webhook %a falhou (HTTP %b); reenviando com espera",
+  "Webhook %a falhou (sem resposta); reenviando com espera",
+  "Sensor %s sem resposta; leituras suspensas",
+  "Tabela solar %a calculada em %b ms",
+  "Canais em uso: %a",
+  "Saída desligada para troca de pino",
+  "CH%c Pino alterado para GPIO %a",
+  "CH%c Duração manual ajustada para %h",
+  "CH%c Carga ajustada para %a W",
+  "Fuso alterado para %s",
+  "Sensores: intervalo %a s, entrada analógica %b",
+  "MQTT ativado: %s:%a",
+  "MQTT desativado",
+  "Webhooks atualizados",
+  "Sincronismo: %s",
+  "Beacon: %a s, %b canais",
+  "Localização: %A, %B",
+  "CH%c Regras customizadas salvas",
+  "Calendário de exceções salvo",
+  "Modbus TCP: porta %a (0 = desligado)",
+};
+static_assert(sizeof(FORMATS) / sizeof(FORMATS[0]) == LOG_COUNT, "um texto por LogId");
+
+static LogRec   s_ring[LOG_RING_LEN];
+static uint32_t s_head      = 0;   // seq do último registro reservado
+static uint32_t s_serialCur = 0;
+
+void logEvent(LogId id, int ch, int32_t a, int32_t b, const char* s) {
+  if (halSimulating()) return;
+#ifdef ESP8266
+  uint32_t seq = ++s_head;   // núcleo único e nenhum registro em ISR
+#else
+  uint32_t seq = __atomic_add_fetch(&s_head, 1, __ATOMIC_RELAXED);
+#endif
+  LogRec& r = s_ring[seq & (LOG_RING_LEN - 1)];
+  __atomic_store_n(&r.seq, 0, __ATOMIC_RELAXED);
+  __atomic_thread_fence(__ATOMIC_RELEASE);
+  r.utc = (uint32_t)halUtcNow();
+  r.a   = a;
+  r.b   = b;
+  r.id  = id;
+  r.ch  = (int8_t)ch;
+  uint8_t i = 0;
+  if (s) while (i < LOG_TEXT_LEN - 1 && s[i]) { r.s[i] = s[i]; i++; }
+  r.s[i] = '\0';
+  __atomic_store_n(&r.seq, seq, __ATOMIC_RELEASE);
+}
+
+bool logNext(uint32_t& cursor, LogRec& out, uint32_t& lost) {
+  for (;;) {
+    uint32_t head = __atomic_load_n(&s_head, __ATOMIC_ACQUIRE);
+    if (cursor == head) return false;
+    // atrasado demais: pula para o meio do anel, longe dos escritores
+    if (head - cursor > LOG_RING_LEN) {
+      lost  += head - cursor - LOG_RING_LEN / 2;
+      cursor = head - LOG_RING_LEN / 2;
+    }
+    uint32_t      want = cursor + 1;
+    const LogRec& r    = s_ring[want & (LOG_RING_LEN - 1)];
+    uint32_t      s1   = __atomic_load_n(&r.seq, __ATOMIC_ACQUIRE);
+    if (s1 == want) {
+      out = r;
+      __atomic_thread_fence(__ATOMIC_ACQUIRE);
+      if (__atomic_load_n(&r.seq, __ATOMIC_RELAXED) == s1) {
+        cursor = want;
+        return true;
+      }
+    } else if (s1 == 0 || (int32_t)(s1 - want) < 0) {
+      return false;              // ainda em escrita: lê na próxima chamada
+    }
+    lost++;                      // sobrescrito por uma volta do anel
+    cursor = want;
+  }
+}
+
+uint32_t logHead() {
+  return __atomic_load_n(&s_head, __ATOMIC_ACQUIRE);
+}
+
+// Acrescenta com limite; mantém buf terminado.
+static void put(char* buf, size_t len, size_t& n, const char* s) {
+  while (*s && n + 1 < len) buf[n++] = *s++;
+  buf[n] = '\0';
+}
+
+static void putFixed4(char* buf, size_t len, size_t& n, int32_t v) {
+  char     tmp[16];
+  uint32_t mag = v < 0 ? (uint32_t)(-(int64_t)v) : (uint32_t)v;
+  snprintf(tmp, sizeof(tmp), "%s%lu.%04lu", v < 0 ? "-" : "",
+           (unsigned long)(mag / 10000), (unsigned long)(mag % 10000));
+  put(buf, len, n, tmp);
+}
+
+size_t logFormat(const LogRec& r, char* buf, size_t len) {
+  if (!len) return 0;
+  time_t t = tzToLocal((time_t)r.utc);
+  char   tmp[16];
+  size_t n = 0;
+  snprintf(tmp, sizeof(tmp), "%02d:%02d:%02d -> ", hour(t), minute(t), second(t));
+  put(buf, len, n, tmp);
+
+  const char* f = r.id < LOG_COUNT ? FORMATS[r.id] : "evento %a";
+  for (; *f && n + 1 < len; f++) {
+    if (*f != '%' || !f[1]) {
+      buf[n++] = *f;
+      buf[n]   = '\0';
+      continue;
+    }
+    switch (*++f) {
+      case 'c': snprintf(tmp, sizeof(tmp), "%d", r.ch);         put(buf, len, n, tmp); break;
+      case 'a': snprintf(tmp, sizeof(tmp), "%ld", (long)r.a);   put(buf, len, n, tmp); break;
+      case 'b': snprintf(tmp, sizeof(tmp), "%ld", (long)r.b);   put(buf, len, n, tmp); break;
+      case 'A': putFixed4(buf, len, n, r.a);                   break;
+      case 'B': putFixed4(buf, len, n, r.b);                   break;
+      case 'h': formatHHMMSS((int)r.b, tmp, sizeof(tmp));       put(buf, len, n, tmp); break;
+      case 's': put(buf, len, n, r.s);                         break;
+      default:  buf[n++] = *f; buf[n] = '\0';                  break;
+    }
+  }
+  buf[n] = '\0';
+  return n;
+}
+
+void logService() {
+  LogRec   r;
+  uint32_t lost = 0;
+  char     line[LOG_LINE_MAX];
+  for (uint8_t i = 0; i < LOG_SERIAL_BATCH && logNext(s_serialCur, r, lost); i++) {
+    logFormat(r, line, sizeof(line));
+    Serial.println(line);
+  }
+  if (lost) Serial.printf("(%lu linhas de log perdidas)\n", (unsigned long)lost);
+}
@@ -0,0 +1,110 @@
+// logbuf.h
+#ifndef LOGBUF_H
+#define LOGBUF_H
+
+#include <Arduino.h>
+
+// Log de eventos em binário, com formatação adiada.
+// Quem registra só grava um id de formato e os argumentos crus (canal, dois
+// inteiros e um texto curto) num anel fixo: sem String, sem heap, sem
+// Serial, com custo fixo no disparo de agendamentos e regras. O texto é
+// montado por quem lê: logService() escoa para a Serial no loop e /events
+// entrega as linhas novas.
+//
+// O anel não tem trava. O escritor reserva um número de sequência, zera o
+// carimbo do registro, grava os campos e só então publica o carimbo; o
+// leitor copia e confere o carimbo antes e depois (seqlock), descartando
+// registros sobrescritos durante a cópia. Leitores atrasados mais de
+// LOG_RING_LEN registros voltam à metade do anel, perdem os mais antigos e
+// recebem a contagem em `lost`. Nada é registrado durante a simulação.
+
+static constexpr uint8_t LOG_RING_LEN     = 32;   // potência de 2
+static constexpr uint8_t LOG_TEXT_LEN     = 30;   // texto curto, truncado (registro de 48 bytes)
+static constexpr uint8_t LOG_SERIAL_BATCH = 4;    // linhas por logService()
+static constexpr size_t  LOG_LINE_MAX     = 96;   // linha formatada
+
+enum LogId : uint8_t {
+  // saída
+  LOG_OUTPUT_ON = 0,
+  LOG_OUTPUT_OFF,
+  // comandos (s = origem)
+  LOG_FEED_NOW,
+  LOG_STOP_NOW,
+  LOG_RULES_ON,
+  LOG_RULES_OFF,
+  LOG_SCHEDULES_SAVED,       // a = quantidade
+  LOG_BUTTON_ON,             // s = gesto
+  LOG_BUTTON_OFF,
+  LOG_BUTTON_RULES_ON,
+  LOG_BUTTON_RULES_OFF,
+  LOG_BUTTON_NOOP,
+  // motor
+  LOG_CLOCK_STEP,            // a = salto (s)
+  LOG_SCHED_FIRED,           // a = slot, b = duração (s)
+  LOG_SCHED_SUPPRESSED,      // a = slot
+  LOG_SCHED_COOLDOWN,        // a = slot
+  LOG_SCHED_REPLACED,        // a = horário de substituição, b = duração (s)
+  LOG_SCHED_REP_COOLDOWN,    // a = horário de substituição
+  LOG_RULE_ON,               // s = evento
+  LOG_RULE_OFF,
+  LOG_PROG_FIRED,            // a = registro, b = duração (s)
+  LOG_PROG_SKIPPED,          // a = registro, s = motivo
+  LOG_PROG_IMPORTED,         // a = registros
+  // rede e periféricos
+  LOG_SYNC_LOCKED,           // s = IP do líder
+  LOG_SYNC_HOLDOVER,
+  LOG_MQTT_UP,               // s = host
+  LOG_MQTT_DOWN,             // s = motivo
+  LOG_MQTT_BAD_CHANNEL,      // a = canal
+  LOG_MQTT_SUB_REFUSED,
+  LOG_WEBHOOK_OK,            // a = destino
+  LOG_WEBHOOK_FAIL_HTTP,     // a = destino, b = status
+  LOG_WEBHOOK_FAIL_NORESP,   // a = destino
+  LOG_SENSOR_LOST,           // s = sensor
+  LOG_SUN_TABLE,             // a = ano, b = ms
+  // configuração pela web
+  LOG_CFG_CHANNELS,          // a = canais
+  LOG_CFG_PIN_STOP,
+  LOG_CFG_PIN,               // a = GPIO
+  LOG_CFG_MANUAL_DURATION,   // b = duração (s)
+  LOG_CFG_LOAD,              // a = W
+  LOG_CFG_TZ,                // s = TZ
+  LOG_CFG_SENSORS,           // a = período, b = pino
+  LOG_CFG_MQTT_ON,           // s = host, a = porta
+  LOG_CFG_MQTT_OFF,
+  LOG_CFG_WEBHOOKS,
+  LOG_CFG_SYNC,              // s = papel
+  LOG_CFG_BEACON,            // a = s, b = canais
+  LOG_CFG_LOCATION,          // a, b = lat, lon × 10000
+  LOG_CFG_RULES,
+  LOG_CFG_EXCEPTIONS,
+  LOG_CFG_MODBUS,            // a = porta
+  LOG_COUNT
+};
+
+struct LogRec {
+  uint32_t seq;              // carimbo (0 = em escrita)
+  uint32_t utc;
+  int32_t  a;
+  int32_t  b;
+  uint8_t  id;               // LogId
+  int8_t   ch;               // -1 = sem canal
+  char     s[LOG_TEXT_LEN];
+};
+
+// Registra um evento (qualquer contexto; texto truncado em LOG_TEXT_LEN-1).
+void logEvent(LogId id, int ch = -1, int32_t a = 0, int32_t b = 0, const char* s = nullptr);
+
+// Próximo registro após `cursor` (que é avançado). false se não há novos.
+bool logNext(uint32_t& cursor, LogRec& out, uint32_t& lost);
+
+// Sequência do último registro (0 = nenhum)
+uint32_t logHead();
+
+// "HH:MM:SS -> texto" (hora local); devolve o comprimento.
+size_t logFormat(const LogRec& r, char* buf, size_t len);
+
+// No loop: escoa até LOG_SERIAL_BATCH linhas para a Serial.
+void logService();
+
+#endif // LOGBUF_H
@@ -0,0 +1,178 @@
+// metrics.cpp
+
+#include "metrics.h"
+#include "button.h"
+#include "config.h"
+#include "sensors.h"
+
+struct RuleCost {
+  uint32_t evals;
+  uint32_t maxCycles;
+  uint8_t  codeLen;
+};
+
+struct RouteStats {
+  const char* name;
+  LatencyHist hist;
+};
+
+static RouteStats    s_routes[METRICS_MAX_ROUTES];
+static int           s_routeCount = 0;
+
+static LatencyHist   s_loopGap;              // intervalo entre loops (µs)
+static unsigned long s_lastLoopUs  = 0;
+static uint32_t      s_heapMin     = 0xFFFFFFFFUL;
+
+static uint32_t      s_trigCount   = 0;
+static uint32_t      s_trigLate    = 0;      // disparos com atraso > 0
+static long          s_trigLateMax = 0;
+
+static RuleCost      s_ruleCost[MAX_CHANNELS][MAX_EXPR_RULES];
+
+struct SensorCost {
+  uint32_t reads;
+  uint32_t errors;
+  uint32_t lastUs;
+  uint32_t maxUs;
+};
+static SensorCost    s_sensorCost[SENSOR__COUNT];
+
+static void histAdd(LatencyHist& h, unsigned long us) {
+  int b = 0;
+  while (b < METRICS_BUCKETS - 1 && us >= (2UL << b)) b++;
+  h.buckets[b]++;
+  h.count++;
+  h.sumUs += us;
+  if (us > h.maxUs) h.maxUs = us;
+}
+
+// limite superior (µs) do bucket onde cai o percentil pct
+static uint32_t histPercentile(const LatencyHist& h, int pct) {
+  if (h.count == 0) return 0;
+  uint32_t rank = (uint32_t)(((uint64_t)h.count * pct + 99) / 100);
+  uint32_t acc  = 0;
+  for (int b = 0; b < METRICS_BUCKETS; b++) {
+    acc += h.buckets[b];
+    if (acc >= rank) return (b == METRICS_BUCKETS - 1) ? h.maxUs : (2UL << b);
+  }
+  return h.maxUs;
+}
+
+static void histJson(String& out, const LatencyHist& h) {
+  out += "\"count\":" + String(h.count);
+  out += ",\"avg_us\":" + String(h.count ? (unsigned long)(h.sumUs / h.count) : 0UL);
+  out += ",\"p50_us\":" + String(histPercentile(h, 50));
+  out += ",\"p99_us\":" + String(histPercentile(h, 99));
+  out += ",\"max_us\":" + String(h.maxUs);
+}
+
+int metricsRoute(const char* name) {
+  for (int i = 0; i < s_routeCount; i++) {
+    if (strcmp(s_routes[i].name, name) == 0) return i;
+  }
+  if (s_routeCount >= METRICS_MAX_ROUTES) return -1;
+  s_routes[s_routeCount].name = name;
+  memset(&s_routes[s_routeCount].hist, 0, sizeof(LatencyHist));
+  return s_routeCount++;
+}
+
+void metricsRecord(int id, unsigned long us) {
+  if (id < 0 || id >= s_routeCount) return;
+  histAdd(s_routes[id].hist, us);
+  uint32_t heap = ESP.getFreeHeap();
+  if (heap < s_heapMin) s_heapMin = heap;
+}
+
+void metricsLoopTick() {
+  unsigned long nowUs = micros();
+  if (s_lastLoopUs) histAdd(s_loopGap, nowUs - s_lastLoopUs);
+  s_lastLoopUs = nowUs;
+  uint32_t heap = ESP.getFreeHeap();
+  if (heap < s_heapMin) s_heapMin = heap;
+}
+
+void metricsTriggerLateness(long lateSec) {
+  s_trigCount++;
+  if (lateSec > 0) s_trigLate++;
+  if (lateSec > s_trigLateMax) s_trigLateMax = lateSec;
+}
+
+void metricsRuleCost(int ch, int rule, uint8_t codeLen, uint32_t cycles) {
+  if (ch < 0 || ch >= MAX_CHANNELS || rule < 0 || rule >= MAX_EXPR_RULES) return;
+  RuleCost& r = s_ruleCost[ch][rule];
+  if (r.codeLen != codeLen) r = { 0, 0, codeLen };   // regra recompilada
+  r.evals++;
+  if (cycles > r.maxCycles) r.maxCycles = cycles;
+}
+
+void metricsSensorRead(uint8_t sensor, unsigned long us, bool ok) {
+  if (sensor >= SENSOR__COUNT) return;
+  SensorCost& s = s_sensorCost[sensor];
+  s.reads++;
+  if (!ok) s.errors++;
+  s.lastUs = us;
+  if (us > s.maxUs) s.maxUs = us;
+}
+
+void metricsReset() {
+  for (int i = 0; i < s_routeCount; i++) memset(&s_routes[i].hist, 0, sizeof(LatencyHist));
+  memset(&s_loopGap, 0, sizeof(s_loopGap));
+  s_lastLoopUs  = 0;
+  s_heapMin     = ESP.getFreeHeap();
+  s_trigCount   = 0;
+  s_trigLate    = 0;
+  s_trigLateMax = 0;
+  memset(s_ruleCost, 0, sizeof(s_ruleCost));
+  memset(s_sensorCost, 0, sizeof(s_sensorCost));
+}
+
+String metricsJson() {
+  String out;
+  out.reserve(256 + s_routeCount * 110);
+  out += "{\"uptime_ms\":" + String(millis());
+  out += ",\"heap_free\":" + String(ESP.getFreeHeap());
+  out += ",\"heap_min_free\":" + String(s_heapMin);
+  out += ",\"loop_gap\":{";
+  histJson(out, s_loopGap);
+  out += "},\"triggers\":{\"count\":" + String(s_trigCount);
+  out += ",\"late\":" + String(s_trigLate);
+  out += ",\"late_max_s\":" + String(s_trigLateMax);
+  out += "},\"button\":{\"dropped_edges\":" + String(buttonDroppedEdges());
+  out += ",\"max_dispatch_us\":" + String(buttonMaxDispatchUs());
+  out += "},\"rule_vm\":[";
+  bool first = true;
+  for (int ch = 0; ch < MAX_CHANNELS; ch++) {
+    for (int i = 0; i < MAX_EXPR_RULES; i++) {
+      const RuleCost& r = s_ruleCost[ch][i];
+      if (!r.evals) continue;
+      if (!first) out += ",";
+      first = false;
+      out += "{\"ch\":" + String(ch) + ",\"rule\":" + String(i) +
+             ",\"code_bytes\":" + String(r.codeLen) +
+             ",\"evals\":" + String(r.evals) +
+             ",\"max_cycles\":" + String(r.maxCycles) + "}";
+    }
+  }
+  out += "],\"sensors\":{";
+  for (uint8_t i = 0; i < SENSOR__COUNT; i++) {
+    const SensorCost& s = s_sensorCost[i];
+    if (i) out += ",";
+    out += "\"";
+    out += sensorName((SensorId)i);
+    out += "\":{\"reads\":" + String(s.reads) +
+           ",\"errors\":" + String(s.errors) +
+           ",\"last_us\":" + String(s.lastUs) +
+           ",\"max_us\":" + String(s.maxUs) + "}";
+  }
+  out += "},\"routes\":{";
+  for (int i = 0; i < s_routeCount; i++) {
+    if (i) out += ",";
+    out += "\"";
+    out += s_routes[i].name;
+    out += "\":{";
+    histJson(out, s_routes[i].hist);
+    out += "}";
+  }
+  out += "}}";
+  return out;
+}
@@ -0,0 +1,41 @@
+// metrics.h
+#ifndef METRICS_H
+#define METRICS_H
+
+#include <Arduino.h>
+
+// Instrumentação leve para medir, no próprio dispositivo, o custo dos handlers
+// HTTP e o quanto eles atrasam o motor. Cada rota mantém um histograma log2
+// de latência em µs (p50/p99 aproximados pelo limite superior do bucket).
+// Exposto em JSON por GET /metrics para comparação entre versões.
+
+static constexpr int METRICS_MAX_ROUTES = 32;
+static constexpr int METRICS_BUCKETS    = 18;  // < 2^1 µs ... < 2^17 µs, resto
+
+struct LatencyHist {
+  uint32_t count;
+  uint32_t maxUs;
+  uint64_t sumUs;
+  uint32_t buckets[METRICS_BUCKETS];
+};
+
+// Registra uma rota (nome estático) e retorna seu id (-1 se a tabela encheu).
+int  metricsRoute(const char* name);
+void metricsRecord(int id, unsigned long us);
+
+// Chamado no início de cada loop(): intervalo entre iterações e heap mínimo.
+void metricsLoopTick();
+
+// Atraso (s) entre o horário previsto de um agendamento e o disparo real.
+void metricsTriggerLateness(long lateSec);
+
+// Custo de uma avaliação de regra EH/EL (bytes de bytecode, ciclos de CPU).
+void metricsRuleCost(int ch, int rule, uint8_t codeLen, uint32_t cycles);
+
+// Duração de uma leitura de sensor (I2C/ADC) e se teve sucesso.
+void metricsSensorRead(uint8_t sensor, unsigned long us, bool ok);
+
+void   metricsReset();
+String metricsJson();
+
+#endif // METRICS_H
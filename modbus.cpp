@@ -0,0 +1,429 @@
+// modbus.cpp
+
+#include "modbus.h"
+#include "controller.h"
+#include "output.h"
+#include "schedule.h"
+#include "program_table.h"
+#include "stats.h"
+#include "logbuf.h"
+#include "hal.h"
+#include "time_utils.h"
+#include "tz_rules.h"
+
+#ifdef ESP8266
+  #include <ESP8266WiFi.h>
+#else
+  #include <WiFi.h>
+#endif
+
+// Configuração definida em main.cpp
+extern Config cfg;
+
+static constexpr uint16_t MB_BITS     = MAX_CHANNELS * MODBUS_CH_BITS;
+static constexpr uint16_t MB_INPUTS   = MODBUS_IN_CH_BASE + MAX_CHANNELS * MODBUS_IN_CH_REGS;
+static constexpr uint16_t MB_HOLDS    = MAX_CHANNELS * MODBUS_HOLD_CH_REGS;
+static constexpr uint16_t MB_CH_HOLDS = MODBUS_HOLD_SLOTS + 3 * MAX_SLOTS;   // em uso por canal
+static_assert(MB_CH_HOLDS <= MODBUS_HOLD_CH_REGS, "slots cabem no bloco do canal");
+
+// códigos de exceção
+enum : uint8_t {
+  MB_ILLEGAL_FUNCTION = 0x01,
+  MB_ILLEGAL_ADDRESS  = 0x02,
+  MB_ILLEGAL_VALUE    = 0x03,
+  MB_DEVICE_FAILURE   = 0x04,
+  MB_DEVICE_BUSY      = 0x06
+};
+
+// Imagem dos registros: escrita pelo motor, lida pelos pedidos (seqlock)
+struct RegImage {
+  uint8_t  coils[(MB_BITS + 7) / 8];
+  uint8_t  discrete[(MB_BITS + 7) / 8];
+  uint16_t input[MB_INPUTS];
+  uint16_t holding[MB_HOLDS];
+};
+
+struct MbConn {
+  WiFiClient    client;
+  bool          used;
+  uint16_t      n;
+  unsigned long lastMs;
+  uint8_t       buf[MODBUS_ADU_MAX];
+};
+
+static RegImage      s_img;
+static uint32_t      s_seq        = 0;   // ímpar = imagem em escrita
+static bool          s_dirty      = true;
+static time_t        s_pubUtc     = 0;
+static uint32_t      s_pubMask    = 0;
+static uint32_t      s_upSec      = 0;
+static unsigned long s_upMs       = 0;
+static uint32_t      s_requests   = 0;
+static uint32_t      s_exceptions = 0;
+
+static WiFiServer    s_server(MODBUS_PORT);
+static uint16_t      s_port = 0;         // porta em escuta (0 = parado)
+static MbConn        s_conn[MODBUS_MAX_CLIENTS];
+
+static uint16_t get16(const uint8_t* p) { return (uint16_t)(p[0] << 8 | p[1]); }
+
+static void put16(uint8_t* p, uint16_t v) {
+  p[0] = v >> 8;
+  p[1] = v & 0xFF;
+}
+
+static void putReg32(uint16_t* r, uint32_t v) {
+  r[0] = v >> 16;
+  r[1] = v & 0xFFFF;
+}
+
+static void setBit(uint8_t* bits, uint16_t i, bool v) {
+  if (v) bits[i >> 3] |=  (1 << (i & 7));
+  else   bits[i >> 3] &= ~(1 << (i & 7));
+}
+
+static bool getBit(const uint8_t* bits, uint16_t i) {
+  return (bits[i >> 3] >> (i & 7)) & 1;
+}
+
+static uint16_t sat16(uint32_t v) { return v > 0xFFFF ? 0xFFFF : (uint16_t)v; }
+
+// Bloco de holding do canal a partir da config
+static void fillHolding(const ChannelConfig& c, uint16_t* r) {
+  memset(r, 0, MB_CH_HOLDS * sizeof(uint16_t));
+  r[0] = sat16(c.manualDurationSec);
+  r[1] = c.loadWatts;
+  r[2] = c.scheduleCount;
+  for (int i = 0; i < c.scheduleCount; i++) {
+    uint16_t* s = r + MODBUS_HOLD_SLOTS + 3 * i;
+    s[0] = c.schedules[i].timeSec / 60;
+    s[1] = c.schedules[i].timeSec % 60;
+    s[2] = c.schedules[i].durationSec;
+  }
+}
+
+// ===== Imagem (motor) =====
+
+static void publish() {
+  time_t        utc   = halUtcNow();
+  unsigned long nowMs = halMillis();
+  long          today = localEpochDay(tzToLocal(utc));
+
+#ifdef ESP8266
+  s_seq++;   // núcleo único
+#else
+  __atomic_add_fetch(&s_seq, 1, __ATOMIC_RELAXED);
+#endif
+  __atomic_thread_fence(__ATOMIC_RELEASE);
+
+  memset(&s_img, 0, sizeof(s_img));
+  putReg32(s_img.input + 0, (uint32_t)utc);
+  putReg32(s_img.input + 2, s_upSec);
+  s_img.input[4] = cfg.channelCount;
+  s_img.input[5] = (uint16_t)s_requests;
+  s_img.input[6] = (uint16_t)s_exceptions;
+
+  for (int ch = 0; ch < cfg.channelCount; ch++) {
+    const ChannelConfig& c = cfg.channels[ch];
+    uint16_t b  = ch * MODBUS_CH_BITS;
+    bool     on = channelActive(ch);
+    setBit(s_img.coils, b + 0, on);
+    setBit(s_img.coils, b + 1, c.customEnabled);
+    setBit(s_img.discrete, b + 0, on);
+    setBit(s_img.discrete, b + 1, (chState.manualMask >> ch) & 1UL);
+    setBit(s_img.discrete, b + 2, outputInCooldown(ch, nowMs));
+    setBit(s_img.discrete, b + 3, c.feederPin >= 0);
+
+    uint16_t* in   = s_img.input + MODBUS_IN_CH_BASE + ch * MODBUS_IN_CH_REGS;
+    long      next = nextTriggerIn(cfg, ch);
+    putReg32(in + 0, next >= 0 ? (uint32_t)next : 0xFFFFFFFFUL);
+    unsigned long offAt = chState.offAtMs[ch];
+    long remain = on && offAt ? (long)(offAt - nowMs) / 1000L : 0;
+    in[2] = remain > 0 ? sat16(remain) : 0;
+    in[3] = chState.countDay[ch] == today ? chState.onCount[ch] : 0;
+    in[4] = c.scheduleCount;
+    in[5] = sat16(progCount(ch));
+
+    fillHolding(c, s_img.holding + ch * MODBUS_HOLD_CH_REGS);
+  }
+
+  __atomic_store_n(&s_seq, s_seq + 1, __ATOMIC_RELEASE);
+  s_pubUtc  = utc;
+  s_pubMask = chState.activeMask | chState.manualMask << 16;
+  s_dirty   = false;
+}
+
+void modbusPublish() {
+  if (!s_port || halSimulating()) return;
+  unsigned long nowMs = millis();
+  s_upSec += (nowMs - s_upMs) / 1000UL;
+  s_upMs  += ((nowMs - s_upMs) / 1000UL) * 1000UL;
+  // recalcula uma vez por segundo ou quando uma saída muda
+  if (!s_dirty && halUtcNow() == s_pubUtc &&
+      (chState.activeMask | chState.manualMask << 16) == s_pubMask) {
+    return;
+  }
+  publish();
+}
+
+// Copia da imagem dentro do seqlock (refaz se o motor publicou no meio)
+template <typename F>
+static void readImage(F copy) {
+  for (uint8_t tries = 0; tries < 8; tries++) {
+    uint32_t s1 = __atomic_load_n(&s_seq, __ATOMIC_ACQUIRE);
+    if (s1 & 1) continue;
+    copy();
+    __atomic_thread_fence(__ATOMIC_ACQUIRE);
+    if (__atomic_load_n(&s_seq, __ATOMIC_RELAXED) == s1) return;
+  }
+  copy();   // motor no mesmo núcleo: na prática nunca chega aqui
+}
+
+// ===== Escritas (controlador) =====
+
+static uint8_t ctlException(CtlResult r) {
+  switch (r) {
+    case CTL_COOLDOWN: return MB_DEVICE_BUSY;
+    case CTL_NO_PIN:   return MB_DEVICE_FAILURE;
+    default:           return 0;   // já ligada/desligada: idempotente
+  }
+}
+
+static bool coilWritable(uint16_t addr) {
+  return addr / MODBUS_CH_BITS < cfg.channelCount && addr % MODBUS_CH_BITS < 4;
+}
+
+static uint8_t writeCoil(uint16_t addr, bool on) {
+  int ch = addr / MODBUS_CH_BITS;
+  switch (addr % MODBUS_CH_BITS) {
+    case 0:
+      return ctlException(on ? ctlFeedNow(ch, "modbus") : ctlStop(ch, "modbus"));
+    case 1:
+      if (on != cfg.channels[ch].customEnabled) ctlToggleRules(ch, "modbus");
+      return 0;
+    case 2:
+      return on ? ctlException(ctlFeedNow(ch, "modbus")) : 0;
+    case 3:
+      return on ? ctlException(ctlStop(ch, "modbus")) : 0;
+  }
+  return MB_ILLEGAL_ADDRESS;
+}
+
+// Aplica `qty` registros (big-endian em data) ao bloco de um canal
+static uint8_t writeHolding(uint16_t addr, uint16_t qty, const uint8_t* data) {
+  int      ch  = addr / MODBUS_HOLD_CH_REGS;
+  uint16_t off = addr % MODBUS_HOLD_CH_REGS;
+  if (ch >= cfg.channelCount || off + qty > MB_CH_HOLDS) return MB_ILLEGAL_ADDRESS;
+
+  ChannelConfig& c = cfg.channels[ch];
+  uint16_t r[MB_CH_HOLDS];
+  fillHolding(c, r);
+  for (uint16_t i = 0; i < qty; i++) r[off + i] = get16(data + 2 * i);
+
+  // valida tudo antes de aplicar
+  if (r[0] == 0 || r[0] > MAX_FEED_DURATION) return MB_ILLEGAL_VALUE;
+  if (r[1] > STATS_MAX_WATTS)                return MB_ILLEGAL_VALUE;
+  if (r[2] > MAX_SLOTS)                      return MB_ILLEGAL_VALUE;
+  for (int i = 0; i < r[2]; i++) {
+    const uint16_t* s = r + MODBUS_HOLD_SLOTS + 3 * i;
+    if (s[0] >= 1440 || s[1] >= 60 || s[2] == 0 || s[2] > MAX_FEED_DURATION) {
+      return MB_ILLEGAL_VALUE;
+    }
+  }
+
+  bool save = false;
+  if (r[0] != c.manualDurationSec) {
+    c.manualDurationSec = r[0];
+    logEvent(LOG_CFG_MANUAL_DURATION, ch, 0, r[0]);
+    save = true;
+  }
+  if (r[1] != c.loadWatts) {
+    c.loadWatts = r[1];
+    logEvent(LOG_CFG_LOAD, ch, r[1]);
+    save = true;
+  }
+  if (off + qty > 2) {
+    // slots: uma única troca pelo controlador (também grava a config)
+    String list;
+    list.reserve(r[2] * 18);
+    for (int i = 0; i < r[2]; i++) {
+      const uint16_t* s = r + MODBUS_HOLD_SLOTS + 3 * i;
+      char item[20];
+      snprintf(item, sizeof(item), "%s%02u:%02u:%02u|", i ? "," : "",
+               s[0] / 60, s[0] % 60, s[1]);
+      list += item;
+      list += formatHHMMSS(s[2]);
+    }
+    ctlSetSchedules(ch, list, "modbus");
+  } else if (save) {
+    saveConfig(cfg);
+  }
+  return 0;
+}
+
+// ===== Quadros =====
+
+static size_t exception(uint8_t* out, uint8_t fc, uint8_t code) {
+  out[0] = fc | 0x80;
+  out[1] = code;
+  return 2;
+}
+
+// PDU de pedido -> PDU de resposta; retorna o tamanho
+static size_t handlePdu(const uint8_t* pdu, size_t len, uint8_t* out) {
+  uint8_t fc = pdu[0];
+  if (fc > 0x06 && fc != 0x0F && fc != 0x10) return exception(out, fc, MB_ILLEGAL_FUNCTION);
+  if (fc == 0 || len < 5)                    return exception(out, fc, MB_ILLEGAL_VALUE);
+  uint16_t addr = get16(pdu + 1);
+  uint16_t qty  = get16(pdu + 3);
+
+  switch (fc) {
+    case 0x01:   // read coils
+    case 0x02: { // read discrete inputs
+      if (qty == 0 || qty > 2000) return exception(out, fc, MB_ILLEGAL_VALUE);
+      if ((uint32_t)addr + qty > MB_BITS) return exception(out, fc, MB_ILLEGAL_ADDRESS);
+      uint8_t bytes = (qty + 7) / 8;
+      out[0] = fc;
+      out[1] = bytes;
+      readImage([&]() {
+        const uint8_t* src = fc == 0x01 ? s_img.coils : s_img.discrete;
+        memset(out + 2, 0, bytes);
+        for (uint16_t i = 0; i < qty; i++) setBit(out + 2, i, getBit(src, addr + i));
+      });
+      return 2 + bytes;
+    }
+    case 0x03:   // read holding registers
+    case 0x04: { // read input registers
+      uint16_t count = fc == 0x03 ? MB_HOLDS : MB_INPUTS;
+      if (qty == 0 || qty > 125) return exception(out, fc, MB_ILLEGAL_VALUE);
+      if ((uint32_t)addr + qty > count) return exception(out, fc, MB_ILLEGAL_ADDRESS);
+      out[0] = fc;
+      out[1] = qty * 2;
+      readImage([&]() {
+        const uint16_t* src = (fc == 0x03 ? s_img.holding : s_img.input) + addr;
+        for (uint16_t i = 0; i < qty; i++) put16(out + 2 + 2 * i, src[i]);
+      });
+      return 2 + qty * 2;
+    }
+    case 0x05: { // write single coil (qty = valor)
+      if (qty != 0xFF00 && qty != 0x0000) return exception(out, fc, MB_ILLEGAL_VALUE);
+      if (!coilWritable(addr)) return exception(out, fc, MB_ILLEGAL_ADDRESS);
+      uint8_t err = writeCoil(addr, qty == 0xFF00);
+      if (err) return exception(out, fc, err);
+      memcpy(out, pdu, 5);
+      return 5;
+    }
+    case 0x06: { // write single register (qty = valor)
+      uint8_t err = writeHolding(addr, 1, pdu + 3);
+      if (err) return exception(out, fc, err);
+      memcpy(out, pdu, 5);
+      return 5;
+    }
+    case 0x0F:   // write multiple coils
+    case 0x10: { // write multiple registers
+      bool    coils = fc == 0x0F;
+      uint8_t bytes = len > 5 ? pdu[5] : 0;
+      if (qty == 0 || qty > (coils ? 1968 : 123) ||
+          bytes != (coils ? (qty + 7) / 8 : qty * 2) || len < 6u + bytes) {
+        return exception(out, fc, MB_ILLEGAL_VALUE);
+      }
+      uint8_t err = 0;
+      if (coils) {
+        for (uint16_t i = 0; i < qty; i++) {
+          if (!coilWritable(addr + i)) return exception(out, fc, MB_ILLEGAL_ADDRESS);
+        }
+        for (uint16_t i = 0; i < qty && !err; i++) err = writeCoil(addr + i, getBit(pdu + 6, i));
+      } else {
+        err = writeHolding(addr, qty, pdu + 6);
+      }
+      if (err) return exception(out, fc, err);
+      memcpy(out, pdu, 5);
+      return 5;
+    }
+  }
+  return exception(out, fc, MB_ILLEGAL_FUNCTION);   // 0x00
+}
+
+size_t modbusHandle(const uint8_t* req, size_t len, uint8_t* resp) {
+  // MBAP: transação, protocolo (0), tamanho (unidade + PDU), unidade
+  if (len < 8 || get16(req + 2) != 0 || get16(req + 4) + 6u != len) return 0;
+  memcpy(resp, req, 7);
+  size_t n = handlePdu(req + 7, len - 7, resp + 7);
+  put16(resp + 4, n + 1);
+  s_requests++;
+  if (resp[7] & 0x80) s_exceptions++;
+  else if (req[7] == 0x05 || req[7] == 0x06 || req[7] == 0x0F || req[7] == 0x10) {
+    publish();   // leitura seguinte já vê a escrita
+  }
+  return 7 + n;
+}
+
+// ===== Conexões =====
+
+static void drop(MbConn& k) {
+  k.client.stop();
+  k.used = false;
+  k.n    = 0;
+}
+
+static void serviceConn(MbConn& k, unsigned long nowMs) {
+  if (!k.client.connected()) {
+    drop(k);
+    return;
+  }
+  // só o que já chegou; nunca espera pelo resto do quadro
+  int avail = k.client.available();
+  if (avail > 0) {
+    size_t room = sizeof(k.buf) - k.n;
+    int    got  = k.client.read(k.buf + k.n, (size_t)avail < room ? (size_t)avail : room);
+    if (got > 0) {
+      k.n      += got;
+      k.lastMs  = nowMs;
+    }
+  }
+  if (k.n >= 7) {
+    size_t need = 6 + get16(k.buf + 4);
+    if (get16(k.buf + 2) != 0 || need < 8 || need > MODBUS_ADU_MAX) {
+      drop(k);   // não é Modbus TCP
+      return;
+    }
+    if (k.n >= need) {
+      uint8_t resp[MODBUS_ADU_MAX];
+      size_t  r = modbusHandle(k.buf, need, resp);
+      if (r) k.client.write(resp, r);
+      memmove(k.buf, k.buf + need, k.n - need);
+      k.n -= need;
+    }
+  }
+  if (nowMs - k.lastMs > MODBUS_IDLE_MS) drop(k);
+}
+
+void modbusService() {
+  uint16_t want = WiFi.status() == WL_CONNECTED ? cfg.modbusPort : 0;
+  if (want != s_port) {
+    for (MbConn& k : s_conn) if (k.used) drop(k);
+    if (s_port) s_server.stop();
+    if (want)   s_server.begin(want);
+    s_port  = want;
+    s_dirty = true;
+    if (want) publish();
+  }
+  if (!s_port) return;
+
+  unsigned long nowMs = millis();
+  if (s_server.hasClient()) {
+    WiFiClient c = s_server.available();
+    MbConn*    k = nullptr;
+    for (MbConn& q : s_conn) if (!q.used) { k = &q; break; }
+    if (k) {
+      k->client = c;
+      k->client.setNoDelay(true);
+      k->used   = true;
+      k->n      = 0;
+      k->lastMs = nowMs;
+    } else {
+      c.stop();   // sem vaga
+    }
+  }
+  for (MbConn& k : s_conn) if (k.used) serviceConn(k, nowMs);
+}
@@ -0,0 +1,63 @@
+// modbus.h
+#ifndef MODBUS_H
+#define MODBUS_H
+
+#include "config.h"
+
+// Servidor Modbus TCP para CLP/SCADA (porta cfg.modbusPort, 0 = desligado).
+// O motor publica o estado numa imagem de registros com seqlock
+// (modbusPublish, a cada passo do motor, recalculada só quando muda o
+// segundo ou uma saída); as leituras só copiam palavras dessa imagem.
+// As escritas passam pelo controlador (controller.h), como HTTP e MQTT.
+// Até MODBUS_MAX_CLIENTS conexões; cada passada de modbusService() lê o
+// que já chegou sem esperar e atende no máximo um quadro por conexão.
+//
+// Endereços (base 0), canal ch:
+//   Coils (FC 1, 5, 15)               ch*8 + 0  saída (1 = FeedNow, 0 = Stop)
+//                                     ch*8 + 1  regras customizadas
+//                                     ch*8 + 2  pulso FeedNow (lê 0)
+//                                     ch*8 + 3  pulso Stop (lê 0)
+//   Discrete inputs (FC 2)            ch*8 + 0  saída ligada
+//                                     ch*8 + 1  ativação manual
+//                                     ch*8 + 2  em cooldown
+//                                     ch*8 + 3  pino atribuído
+//   Input registers (FC 4)            0-1 utc (s), 2-3 uptime (s), 4 canais,
+//                                     5 pedidos atendidos, 6 exceções
+//                                     16 + ch*8 + 0-1  próximo acionamento em s
+//                                                      (0xFFFFFFFF = nenhum em 24 h)
+//                                                 + 2  restante ligado (s)
+//                                                 + 3  ativações hoje
+//                                                 + 4  slots
+//                                                 + 5  registros do programa em flash
+//   Holding registers (FC 3, 6, 16)   ch*64 + 0  duração manual (s)
+//                                           + 1  carga (W)
+//                                           + 2  slots em uso (0..MAX_SLOTS)
+//                                           + 3 + 3*i  slot i: minuto do dia,
+//                                                      segundo, duração (s)
+// Valores de 32 bits: palavra alta primeiro. Escritas em holding valem
+// por canal (sem cruzar ch*64) e são validadas antes de aplicar; slots
+// vão para ctlSetSchedules() de uma vez. A unidade (unit id) é ignorada.
+// Teste no Linux: mbpoll -m tcp -a 1 -0 -t 4 -r 0 -c 12 <ip>
+
+static constexpr uint16_t MODBUS_PORT          = 502;
+static constexpr uint8_t  MODBUS_MAX_CLIENTS   = 2;
+static constexpr size_t   MODBUS_ADU_MAX       = 260;   // MBAP (7) + PDU (253)
+static constexpr unsigned long MODBUS_IDLE_MS  = 60000; // conexão ociosa é fechada
+
+static constexpr uint16_t MODBUS_CH_BITS       = 8;     // coils/discretes por canal
+static constexpr uint16_t MODBUS_IN_CH_BASE    = 16;
+static constexpr uint16_t MODBUS_IN_CH_REGS    = 8;
+static constexpr uint16_t MODBUS_HOLD_CH_REGS  = 64;
+static constexpr uint16_t MODBUS_HOLD_SLOTS    = 3;     // primeiro registro dos slots
+
+// No motor, depois de engineTick(): atualiza a imagem de registros.
+void modbusPublish();
+
+// Tarefa do loop: abre/fecha a porta conforme cfg e a rede, atende pedidos.
+void modbusService();
+
+// Processa um quadro Modbus TCP completo (MBAP + PDU) e escreve a resposta
+// em `resp`; retorna o tamanho (0 = quadro inválido, sem resposta).
+size_t modbusHandle(const uint8_t* req, size_t len, uint8_t* resp);
+
+#endif // MODBUS_H
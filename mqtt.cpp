@@ -0,0 +1,549 @@
+// mqtt.cpp
+
+#include "mqtt.h"
+#include "events.h"
+#include "logbuf.h"
+#include "controller.h"
+#include "output.h"
+#include "sensors.h"
+#include "hal.h"
+#include "time_utils.h"
+#include "tcp_async.h"
+
+#ifdef ESP8266
+  #include <ESP8266WiFi.h>
+#else
+  #include <WiFi.h>
+#endif
+
+// Configuração definida em main.cpp
+extern Config cfg;
+
+// tipos de pacote (byte fixo, já com os flags obrigatórios)
+static constexpr uint8_t PKT_CONNECT    = 0x10;
+static constexpr uint8_t PKT_CONNACK    = 0x20;
+static constexpr uint8_t PKT_PUBLISH    = 0x30;
+static constexpr uint8_t PKT_PUBACK     = 0x40;
+static constexpr uint8_t PKT_SUBSCRIBE  = 0x82;
+static constexpr uint8_t PKT_SUBACK     = 0x90;
+static constexpr uint8_t PKT_PINGREQ    = 0xC0;
+static constexpr uint8_t PKT_PINGRESP   = 0xD0;
+static constexpr uint8_t PKT_DISCONNECT = 0xE0;
+
+static constexpr size_t  MQTT_TX_MAX = MQTT_TOPIC_MAX + MQTT_PAYLOAD_MAX + 8;
+
+enum MqttState : uint8_t { MQ_DOWN, MQ_CONNECTING, MQ_WAIT_CONNACK, MQ_UP };
+
+struct MqttMsg {
+  uint16_t      id;          // packet id (QoS 1); 0 = ainda não enviada
+  uint8_t       qos;
+  bool          retain;
+  unsigned long sentMs;
+  char          topic[MQTT_TOPIC_MAX];
+  char          payload[MQTT_PAYLOAD_MAX];
+};
+
+// corpo de um pacote em montagem (cabeçalho fixo é escrito no envio)
+struct Pkt {
+  uint8_t buf[MQTT_TX_MAX];
+  size_t  len;
+};
+
+static TcpConn       s_net;
+static MqttState     s_state      = MQ_DOWN;
+static MqttMsg       s_q[MQTT_QUEUE_LEN];
+static uint8_t       s_qHead      = 0;
+static uint8_t       s_qCount     = 0;
+static uint8_t       s_rx[MQTT_RX_MAX];
+static uint16_t      s_rxLen      = 0;
+static Pkt           s_pkt;
+static uint16_t      s_nextId     = 1;
+static unsigned long s_nextTryMs  = 0;
+static unsigned long s_backoffMs  = 1000;
+static unsigned long s_connMs     = 0;
+static unsigned long s_lastTxMs   = 0;
+static unsigned long s_pingMs     = 0;
+static bool          s_pingOut    = false;
+static unsigned long s_stateMs    = 0;
+static uint32_t      s_evCursor   = 0;
+static char          s_clientId[32];
+static char          s_defPrefix[32];
+
+static uint32_t      s_sent       = 0;
+static uint32_t      s_received   = 0;
+static uint32_t      s_dropped    = 0;
+static uint32_t      s_lost       = 0;
+static uint32_t      s_connects   = 0;
+
+static const char* prefix() {
+  return cfg.mqtt.prefix[0] ? cfg.mqtt.prefix : s_defPrefix;
+}
+
+// ===== Fila de saída =====
+
+static void enqueue(const char* topic, const char* payload, bool retain) {
+  if (s_qCount == MQTT_QUEUE_LEN) {
+    s_qHead = (s_qHead + 1) % MQTT_QUEUE_LEN;   // descarta a mais antiga
+    s_qCount--;
+    s_dropped++;
+  }
+  MqttMsg& m = s_q[(s_qHead + s_qCount) % MQTT_QUEUE_LEN];
+  m.id     = 0;
+  m.qos    = cfg.mqtt.qos;
+  m.retain = retain;
+  m.sentMs = 0;
+  snprintf(m.topic,   sizeof(m.topic),   "%s/%s", prefix(), topic);
+  snprintf(m.payload, sizeof(m.payload), "%s", payload);
+  s_qCount++;
+}
+
+static void dequeue() {
+  s_qHead = (s_qHead + 1) % MQTT_QUEUE_LEN;
+  s_qCount--;
+}
+
+// ===== Pacotes =====
+
+static void pktU8(uint8_t v) {
+  if (s_pkt.len < sizeof(s_pkt.buf)) s_pkt.buf[s_pkt.len++] = v;
+}
+
+static void pktU16(uint16_t v) {
+  pktU8(v >> 8);
+  pktU8(v & 0xFF);
+}
+
+static void pktRaw(const char* s, size_t n) {
+  for (size_t i = 0; i < n; i++) pktU8((uint8_t)s[i]);
+}
+
+static void pktStr(const char* s) {
+  size_t n = strlen(s);
+  pktU16((uint16_t)n);
+  pktRaw(s, n);
+}
+
+static bool pktSend(uint8_t type) {
+  uint8_t head[5];
+  size_t  n   = 0;
+  size_t  rem = s_pkt.len;
+  head[n++] = type;
+  do {
+    uint8_t b = rem & 0x7F;
+    rem >>= 7;
+    head[n++] = rem ? (b | 0x80) : b;
+  } while (rem);
+  // espaço para o pacote inteiro antes de escrever a primeira parte
+  bool ok = tcpWritable(s_net) >= n + s_pkt.len &&
+            tcpWrite(s_net, head, n) &&
+            (s_pkt.len == 0 || tcpWrite(s_net, s_pkt.buf, s_pkt.len));
+  s_lastTxMs = millis();
+  s_pkt.len  = 0;
+  return ok;
+}
+
+static uint16_t nextPacketId() {
+  uint16_t id = s_nextId++;
+  if (!s_nextId) s_nextId = 1;
+  return id;
+}
+
+// Encerra a conexão e agenda nova tentativa; `why` vai para o log
+static void drop(const char* why) {
+  if (why) logEvent(LOG_MQTT_DOWN, -1, 0, 0, why);
+  tcpClose(s_net);
+  s_state     = MQ_DOWN;
+  s_rxLen     = 0;
+  s_pingOut   = false;
+  s_nextTryMs = millis() + s_backoffMs;
+  s_backoffMs = s_backoffMs * 2 > MQTT_BACKOFF_MAX_MS ? MQTT_BACKOFF_MAX_MS : s_backoffMs * 2;
+  // QoS 1 pendente é reenviada com DUP na próxima sessão
+  if (s_qCount) s_q[s_qHead].sentMs = 0;
+}
+
+static bool sendPublish(const char* topic, const char* payload, uint8_t qos,
+                        bool retain, bool dup, uint16_t id) {
+  s_pkt.len = 0;
+  pktStr(topic);
+  if (qos) pktU16(id);
+  pktRaw(payload, strlen(payload));
+  uint8_t type = PKT_PUBLISH | (dup ? 0x08 : 0) | (qos << 1) | (retain ? 0x01 : 0);
+  if (!pktSend(type)) return false;
+  s_sent++;
+  return true;
+}
+
+static bool sendConnect() {
+  const MqttConfig& q = cfg.mqtt;
+  char will[MQTT_TOPIC_MAX];
+  snprintf(will, sizeof(will), "%s/status", prefix());
+
+  uint8_t flags = 0x02 | 0x04 | (q.qos << 3) | 0x20;   // clean session + LWT retido
+  if (q.user[0]) flags |= 0x80;
+  if (q.user[0] && q.pass[0]) flags |= 0x40;
+
+  s_pkt.len = 0;
+  pktStr("MQTT");
+  pktU8(4);                      // 3.1.1
+  pktU8(flags);
+  pktU16(MQTT_KEEPALIVE_SEC);
+  pktStr(s_clientId);
+  pktStr(will);
+  pktStr("offline");
+  if (flags & 0x80) pktStr(q.user);
+  if (flags & 0x40) pktStr(q.pass);
+  return pktSend(PKT_CONNECT);
+}
+
+static bool sendSubscribe() {
+  char filter[MQTT_TOPIC_MAX];
+  snprintf(filter, sizeof(filter), "%s/+/cmd/#", prefix());
+  s_pkt.len = 0;
+  pktU16(nextPacketId());
+  pktStr(filter);
+  pktU8(cfg.mqtt.qos);
+  return pktSend(PKT_SUBSCRIBE);
+}
+
+// ===== Comandos recebidos =====
+
+static const char* resultName(CtlResult r) {
+  switch (r) {
+    case CTL_OK:       return "ok";
+    case CTL_ACTIVE:   return "active";
+    case CTL_COOLDOWN: return "cooldown";
+    case CTL_IDLE:     return "idle";
+    case CTL_NO_PIN:   return "no_pin";
+  }
+  return "error";
+}
+
+static void reply(int ch, const char* cmd, const char* result) {
+  char topic[16];
+  char payload[64];
+  snprintf(topic,   sizeof(topic),   "%d/result", ch);
+  snprintf(payload, sizeof(payload), "{\"cmd\":\"%s\",\"result\":\"%s\"}", cmd, result);
+  enqueue(topic, payload, false);
+}
+
+// topic = "P/<ch>/cmd/<nome>"
+static void onCommand(const char* topic, const char* payload) {
+  const char* pre = prefix();
+  size_t      n   = strlen(pre);
+  if (strncmp(topic, pre, n) != 0 || topic[n] != '/') return;
+  const char* p = topic + n + 1;
+
+  if (*p < '0' || *p > '9') return;
+  int ch = 0;
+  while (*p >= '0' && *p <= '9' && ch < 100) ch = ch * 10 + (*p++ - '0');
+  if (strncmp(p, "/cmd/", 5) != 0) return;
+  const char* cmd = p + 5;
+  if (ch >= cfg.channelCount) {
+    logEvent(LOG_MQTT_BAD_CHANNEL, -1, ch);
+    return;
+  }
+
+  if (strcmp(cmd, "feed") == 0) {
+    reply(ch, cmd, resultName(ctlFeedNow(ch, "mqtt")));
+  } else if (strcmp(cmd, "stop") == 0) {
+    reply(ch, cmd, resultName(ctlStop(ch, "mqtt")));
+  } else if (strcmp(cmd, "rules") == 0) {
+    bool cur  = cfg.channels[ch].customEnabled;
+    bool want = strcmp(payload, "on") == 0 ? true
+              : strcmp(payload, "off") == 0 ? false
+              : !cur;
+    if (want != cur) ctlToggleRules(ch, "mqtt");
+    reply(ch, cmd, cfg.channels[ch].customEnabled ? "on" : "off");
+  } else if (strcmp(cmd, "schedules") == 0) {
+    char buf[8];
+    snprintf(buf, sizeof(buf), "%d", ctlSetSchedules(ch, String(payload), "mqtt"));
+    reply(ch, cmd, buf);
+  } else {
+    reply(ch, cmd, "unknown");
+  }
+}
+
+// ===== Recepção =====
+
+static void handlePacket(uint8_t type, uint8_t* p, uint32_t len) {
+  switch (type & 0xF0) {
+    case PKT_CONNACK:
+      if (s_state != MQ_WAIT_CONNACK) return;
+      if (len < 2 || p[1] != 0) {
+        drop(len >= 2 ? (String("recusado, código ") + p[1]).c_str() : "CONNACK inválido");
+        return;
+      }
+      s_state     = MQ_UP;
+      s_backoffMs = 1000;
+      s_connects++;
+      logEvent(LOG_MQTT_UP, -1, 0, 0, cfg.mqtt.host);
+      sendSubscribe();
+      {
+        char topic[MQTT_TOPIC_MAX];
+        snprintf(topic, sizeof(topic), "%s/status", prefix());
+        sendPublish(topic, "online", 0, true, false, 0);
+      }
+      s_stateMs = millis() - (unsigned long)cfg.mqtt.stateSec * 1000UL;   // estado já
+      break;
+
+    case PKT_PUBLISH: {
+      uint8_t qos = (type >> 1) & 0x03;
+      if (len < 2) return;
+      uint16_t tlen = (p[0] << 8) | p[1];
+      uint32_t hdr  = 2 + tlen + (qos ? 2 : 0);
+      if (hdr > len || tlen >= MQTT_TOPIC_MAX) return;
+      uint16_t id = qos ? (p[2 + tlen] << 8) | p[3 + tlen] : 0;
+
+      char topic[MQTT_TOPIC_MAX];
+      memcpy(topic, p + 2, tlen);
+      topic[tlen] = '\0';
+      char payload[MQTT_PAYLOAD_MAX];
+      uint32_t plen = len - hdr;
+      if (plen >= sizeof(payload)) plen = sizeof(payload) - 1;
+      memcpy(payload, p + hdr, plen);
+      payload[plen] = '\0';
+
+      if (qos == 1) {
+        s_pkt.len = 0;
+        pktU16(id);
+        pktSend(PKT_PUBACK);
+      }
+      s_received++;
+      onCommand(topic, payload);
+      break;
+    }
+
+    case PKT_PUBACK:
+      if (len >= 2 && s_qCount && s_q[s_qHead].qos &&
+          s_q[s_qHead].id == ((p[0] << 8) | p[1])) {
+        dequeue();
+      }
+      break;
+
+    case PKT_SUBACK:
+      if (len >= 3 && p[2] == 0x80) logEvent(LOG_MQTT_SUB_REFUSED);
+      break;
+
+    case PKT_PINGRESP:
+      s_pingOut = false;
+      break;
+  }
+}
+
+static void receive() {
+  s_rxLen += tcpRead(s_net, s_rx + s_rxLen, MQTT_RX_MAX - s_rxLen);
+
+  while (s_rxLen >= 2 && s_state != MQ_DOWN) {
+    // comprimento restante: 1..4 bytes de 7 bits
+    uint32_t rem   = 0;
+    uint8_t  shift = 0;
+    uint16_t i     = 1;
+    bool     done  = false;
+    while (i < s_rxLen && i <= 4) {
+      uint8_t b = s_rx[i++];
+      rem |= (uint32_t)(b & 0x7F) << shift;
+      shift += 7;
+      if (!(b & 0x80)) { done = true; break; }
+    }
+    if (!done) {
+      if (i > 4) drop("pacote malformado");
+      return;
+    }
+    uint32_t total = i + rem;
+    if (total > MQTT_RX_MAX) {
+      drop("pacote grande demais");
+      return;
+    }
+    if (s_rxLen < total) return;
+
+    handlePacket(s_rx[0], s_rx + i, rem);
+    if (s_state == MQ_DOWN) return;
+    memmove(s_rx, s_rx + total, s_rxLen - total);
+    s_rxLen -= total;
+  }
+}
+
+// ===== Publicações do motor =====
+
+static void drainEvents() {
+  Event e;
+  while (s_qCount < MQTT_QUEUE_LEN && eventNext(s_evCursor, e, s_lost)) {
+    char topic[16];
+    char payload[MQTT_PAYLOAD_MAX];
+    snprintf(topic, sizeof(topic), "%u/event", e.ch);
+    if (e.type == EVT_OUTPUT) {
+      snprintf(payload, sizeof(payload),
+               "{\"t\":%ld,\"type\":\"output\",\"on\":%s,\"manual\":%s}",
+               (long)e.utc, e.on ? "true" : "false", e.manual ? "true" : "false");
+    } else {
+      snprintf(payload, sizeof(payload),
+               "{\"t\":%ld,\"type\":\"rule\",\"rule\":\"%s\",\"on\":%s}",
+               (long)e.utc, e.name, e.on ? "true" : "false");
+    }
+    enqueue(topic, payload, false);
+  }
+}
+
+static void publishState() {
+  char   payload[MQTT_PAYLOAD_MAX];
+  size_t n = snprintf(payload, sizeof(payload), "{\"t\":%ld,\"on\":[", (long)halUtcNow());
+  for (int ch = 0; ch < cfg.channelCount && n < sizeof(payload); ch++) {
+    n += snprintf(payload + n, sizeof(payload) - n, ch ? ",%d" : "%d", channelActive(ch) ? 1 : 0);
+  }
+  if (n < sizeof(payload)) n += snprintf(payload + n, sizeof(payload) - n, "],\"rules\":[");
+  for (int ch = 0; ch < cfg.channelCount && n < sizeof(payload); ch++) {
+    n += snprintf(payload + n, sizeof(payload) - n, ch ? ",%d" : "%d",
+                  cfg.channels[ch].customEnabled ? 1 : 0);
+  }
+  if (n < sizeof(payload)) n += snprintf(payload + n, sizeof(payload) - n, "]");
+  int32_t t;
+  if (n < sizeof(payload) && sensorValue(SENSOR_RTC, t)) {
+    n += snprintf(payload + n, sizeof(payload) - n, ",\"temp\":%ld.%ld",
+                  (long)t / 10, (long)(t < 0 ? -t : t) % 10);
+  }
+  if (n < sizeof(payload)) snprintf(payload + n, sizeof(payload) - n, "}");
+  enqueue("state", payload, true);
+}
+
+// Envia a frente da fila (até MQTT_SEND_PER_CALL mensagens)
+static void flushQueue() {
+  unsigned long nowMs = millis();
+  for (uint8_t k = 0; k < MQTT_SEND_PER_CALL && s_qCount; k++) {
+    if (tcpWritable(s_net) < MQTT_TX_MAX + 5) return;   // pilha cheia: no próximo ciclo
+    MqttMsg& m = s_q[s_qHead];
+    if (m.qos == 0) {
+      if (!sendPublish(m.topic, m.payload, 0, m.retain, false, 0)) {
+        drop("falha de escrita");
+        return;
+      }
+      dequeue();
+      continue;
+    }
+    // QoS 1: uma em voo por vez, na ordem da fila
+    if (m.sentMs && nowMs - m.sentMs < MQTT_RETRY_MS) return;
+    bool dup = m.id != 0;
+    if (!dup) m.id = nextPacketId();
+    if (!sendPublish(m.topic, m.payload, 1, m.retain, dup, m.id)) {
+      drop("falha de escrita");
+      return;
+    }
+    m.sentMs = nowMs | 1UL;
+    return;
+  }
+}
+
+// ===== API =====
+
+void mqttBegin() {
+  String mac = WiFi.macAddress();
+  mac.replace(":", "");
+  mac.toLowerCase();
+  snprintf(s_clientId,  sizeof(s_clientId),  "temporizador-%s", mac.c_str());
+  snprintf(s_defPrefix, sizeof(s_defPrefix), "temporizador/%s", mac.c_str() + (mac.length() > 6 ? mac.length() - 6 : 0));
+  s_evCursor  = eventHead();
+  s_nextTryMs = millis();
+}
+
+void mqttReconfigure() {
+  if (s_state == MQ_UP) {
+    s_pkt.len = 0;
+    pktSend(PKT_DISCONNECT);
+  }
+  tcpClose(s_net);
+  s_state     = MQ_DOWN;
+  s_rxLen     = 0;
+  s_pingOut   = false;
+  s_backoffMs = 1000;
+  s_nextTryMs = millis();
+  s_qHead     = 0;
+  s_qCount    = 0;
+  s_evCursor  = eventHead();
+}
+
+void mqttService() {
+  if (!cfg.mqtt.enabled || !cfg.mqtt.host[0]) return;
+  unsigned long nowMs = millis();
+
+  drainEvents();
+
+  switch (s_state) {
+    case MQ_DOWN:
+      if ((long)(nowMs - s_nextTryMs) < 0 || WiFi.status() != WL_CONNECTED) return;
+      if (!tcpOpen(s_net, cfg.mqtt.host, cfg.mqtt.port, MQTT_CONNECT_TIMEOUT_MS)) {
+        drop(nullptr);
+        return;
+      }
+      s_state = MQ_CONNECTING;
+      return;
+
+    // DNS e SYN andam na pilha TCP; aqui só se confere o resultado
+    case MQ_CONNECTING: {
+      TcpState st = tcpPoll(s_net);
+      if (st == TCP_CONNECTING) return;
+      if (st != TCP_OPEN) {
+        drop(nullptr);   // broker fora do ar: tenta de novo sem encher o log
+        return;
+      }
+      s_net.client.setNoDelay(true);
+      s_state  = MQ_WAIT_CONNACK;
+      s_connMs = nowMs;
+      s_rxLen  = 0;
+      if (!sendConnect()) drop("falha de escrita");
+      return;
+    }
+
+    case MQ_WAIT_CONNACK:
+      receive();
+      if (s_state == MQ_WAIT_CONNACK && nowMs - s_connMs > MQTT_CONNACK_TIMEOUT_MS) {
+        drop("sem CONNACK");
+      }
+      return;
+
+    case MQ_UP:
+      break;
+  }
+
+  if (tcpPoll(s_net) != TCP_OPEN) {
+    drop(s_net.overflow ? "recepção cheia" : "conexão perdida");
+    return;
+  }
+  receive();
+  if (s_state != MQ_UP) return;
+
+  // keepalive: PINGREQ na metade do intervalo; sem resposta em um intervalo, cai
+  if (s_pingOut && nowMs - s_pingMs > MQTT_KEEPALIVE_SEC * 1000UL) {
+    drop("sem PINGRESP");
+    return;
+  }
+  if (!s_pingOut && nowMs - s_lastTxMs > MQTT_KEEPALIVE_SEC * 500UL) {
+    s_pkt.len = 0;
+    if (!pktSend(PKT_PINGREQ)) {
+      drop("falha de escrita");
+      return;
+    }
+    s_pingOut = true;
+    s_pingMs  = nowMs;
+  }
+
+  if (cfg.mqtt.stateSec && nowMs - s_stateMs >= cfg.mqtt.stateSec * 1000UL) {
+    s_stateMs = nowMs;
+    publishState();
+  }
+  flushQueue();
+}
+
+bool mqttConnected() {
+  return s_state == MQ_UP;
+}
+
+void mqttStatusJson(JsonObject dst) {
+  dst["enabled"]   = cfg.mqtt.enabled;
+  dst["connected"] = s_state == MQ_UP;
+  dst["prefix"]    = prefix();
+  dst["queued"]    = s_qCount;
+  dst["sent"]      = s_sent;
+  dst["received"]  = s_received;
+  dst["dropped"]   = s_dropped;
+  dst["lost"]      = s_lost;
+  dst["connects"]  = s_connects;
+}
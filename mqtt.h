@@ -0,0 +1,51 @@
+// mqtt.h
+#ifndef MQTT_H
+#define MQTT_H
+
+#include "config.h"
+#include <ArduinoJson.h>
+
+// Cliente MQTT 3.1.1 mínimo (QoS 0 e 1) sobre tcp_async.h, dirigido pelo loop.
+// Tópicos, com P = cfg.mqtt.prefix:
+//   P/status              "online" / "offline" (retido; "offline" via LWT)
+//   P/state               estado compacto a cada stateSec (retido)
+//   P/<ch>/event          transições de saída e disparos de regra (events.h)
+//   P/<ch>/cmd/feed       liga pela duração manual        -> ctlFeedNow
+//   P/<ch>/cmd/stop       desliga                         -> ctlStop
+//   P/<ch>/cmd/rules      "toggle" | "on" | "off"         -> ctlToggleRules
+//   P/<ch>/cmd/schedules  "HH:MM:SS|HH:MM:SS,..."         -> ctlSetSchedules
+//   P/<ch>/result         resposta de cada comando
+// Envio por uma fila fixa de MQTT_QUEUE_LEN mensagens; cheia, descarta a
+// mais antiga. Com QoS 1 a mensagem da frente fica na fila até o PUBACK e é
+// reenviada (DUP) após MQTT_RETRY_MS ou reconexão.
+// Reconexão com espera exponencial (1 s .. 60 s). Nada bloqueia: DNS e
+// abertura do TCP correm na pilha (MQTT_CONNECT_TIMEOUT_MS para os dois) e
+// um pacote só é escrito quando cabe inteiro no buffer de envio.
+
+static constexpr uint8_t       MQTT_QUEUE_LEN          = 8;
+static constexpr uint16_t      MQTT_TOPIC_MAX          = 80;
+static constexpr uint16_t      MQTT_PAYLOAD_MAX        = 192;
+static constexpr uint16_t      MQTT_RX_MAX             = 512;    // maior pacote aceito
+static constexpr uint16_t      MQTT_KEEPALIVE_SEC      = 30;
+static constexpr unsigned long MQTT_CONNECT_TIMEOUT_MS = 5000;
+static constexpr unsigned long MQTT_CONNACK_TIMEOUT_MS = 5000;
+static constexpr unsigned long MQTT_RETRY_MS           = 10000;
+static constexpr unsigned long MQTT_BACKOFF_MAX_MS     = 60000;
+static constexpr uint8_t       MQTT_SEND_PER_CALL      = 2;
+
+// Após a rede
+void mqttBegin();
+
+// No loop: conexão, recepção, fila e eventos. Retorna rápido se desativado.
+void mqttService();
+
+// Após /setMqtt: encerra a sessão atual e reconecta com a nova config.
+void mqttReconfigure();
+
+// true com a sessão estabelecida (CONNACK aceito)
+bool mqttConnected();
+
+// Contadores para /status
+void mqttStatusJson(JsonObject dst);
+
+#endif // MQTT_H
@@ -0,0 +1,141 @@
+// output.cpp
+
+#include "output.h"
+#include "time_utils.h"
+#include "hal.h"
+#include "status_led.h"
+#include "tz_rules.h"
+#include "stats.h"
+#include "events.h"
+#include "logbuf.h"
+
+ChannelState chState;
+
+// LED: "saída ativa" quando qualquer canal está ligado
+static void updateLed() {
+  if (!halSimulating()) ledSetFlag(LED_F_OUTPUT, chState.activeMask != 0);
+}
+
+void outputsBegin(const Config& c) {
+  memset(&chState, 0, sizeof(chState));
+  for (int ch = 0; ch < c.channelCount; ch++) {
+    int pin = c.channels[ch].feederPin;
+    if (pin < 0) continue;
+    pinMode(pin, OUTPUT);
+    digitalWrite(pin, LOW);
+  }
+}
+
+bool outputInCooldown(int ch, unsigned long nowMs) {
+  unsigned long last = chState.lastTriggerMs[ch];
+  return last && nowMs - last < (unsigned long)FEED_COOLDOWN * 1000UL;
+}
+
+// Troca do pino e das máscaras, sob halLock(); sem chamadas fora da IRAM
+// no caminho real (o do botão).
+static bool IRAM_ATTR switchOn(const Config& c, int ch, unsigned long durationSec, bool manual,
+                               bool isr) {
+  if (ch < 0 || ch >= c.channelCount) return false;
+  int pin = c.channels[ch].feederPin;
+  if (pin < 0) return false;
+
+  bool changed = false;
+  halLock();
+  unsigned long nowMs = halMillis();
+  unsigned long last  = chState.lastTriggerMs[ch];
+  bool cooldown = last && nowMs - last < (unsigned long)FEED_COOLDOWN * 1000UL;
+  if (!channelActive(ch) && !cooldown) {
+    halOutputWrite(pin, true);
+    chState.activeMask       |= 1UL << ch;
+    chState.lastTriggerMs[ch] = nowMs;
+    chState.offAtMs[ch]       = 0;
+    if (durationSec > 0 && durationSec <= (unsigned long)MAX_FEED_DURATION) {
+      chState.offAtMs[ch]     = (nowMs + durationSec * 1000UL) | 1UL;
+    }
+    if (manual) chState.manualMask |=  (1UL << ch);
+    else        chState.manualMask &= ~(1UL << ch);
+    if (isr)    chState.isrMask    |=  (1UL << ch);
+    changed = true;
+  }
+  halUnlock();
+  return changed;
+}
+
+static bool IRAM_ATTR switchOff(const Config& c, int ch, bool isr) {
+  if (ch < 0 || ch >= c.channelCount) return false;
+
+  bool changed = false;
+  halLock();
+  if (channelActive(ch)) {
+    halOutputWrite(c.channels[ch].feederPin, false);
+    chState.activeMask &= ~(1UL << ch);
+    chState.manualMask &= ~(1UL << ch);
+    chState.offAtMs[ch] = 0;
+    if (isr) chState.isrMask |= 1UL << ch;
+    changed = true;
+  }
+  halUnlock();
+  return changed;
+}
+
+void outputNote(int ch, bool on, bool manual) {
+  halLock();
+  chState.isrMask &= ~(1UL << ch);
+  halUnlock();
+  time_t utc = halUtcNow();
+  if (on) {
+    long today = localEpochDay(tzToLocal(utc));
+    if (chState.countDay[ch] != today) {
+      chState.countDay[ch] = today;
+      chState.onCount[ch]  = 0;
+    }
+    chState.onCount[ch]++;
+  }
+  chState.changedUtc[ch] = utc;
+  statsOnChange(ch, on, utc);
+  eventPush(EVT_OUTPUT, ch, on, manual, nullptr);
+  updateLed();
+}
+
+bool outputOn(const Config& c, int ch, unsigned long durationSec, bool manual) {
+  if (!switchOn(c, ch, durationSec, manual, false)) return false;
+  outputNote(ch, true, manual);
+  return true;
+}
+
+bool outputOff(const Config& c, int ch) {
+  if (!switchOff(c, ch, false)) return false;
+  outputNote(ch, false, false);
+  return true;
+}
+
+bool IRAM_ATTR outputOnIsr(const Config& c, int ch, unsigned long durationSec) {
+  return switchOn(c, ch, durationSec, true, true);
+}
+
+bool IRAM_ATTR outputOffIsr(const Config& c, int ch) {
+  return switchOff(c, ch, true);
+}
+
+bool startOutput(const Config& c, int ch, unsigned long durationSec, bool manual) {
+  if (!outputOn(c, ch, durationSec, manual)) return false;
+  logEvent(LOG_OUTPUT_ON, ch);
+  return true;
+}
+
+bool stopOutput(const Config& c, int ch) {
+  if (!outputOff(c, ch)) return false;
+  logEvent(LOG_OUTPUT_OFF, ch);
+  return true;
+}
+
+void serviceOutputTimers(const Config& c) {
+  uint32_t mask = chState.activeMask & ~chState.isrMask;
+  if (!mask) return;
+  unsigned long nowMs = halMillis();
+  for (int ch = 0; mask; ch++, mask >>= 1) {
+    if (!(mask & 1UL)) continue;
+    unsigned long offAt = chState.offAtMs[ch];
+    if (offAt && (long)(nowMs - offAt) >= 0) stopOutput(c, ch);
+  }
+}
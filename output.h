@@ -0,0 +1,60 @@
+// output.h
+#ifndef OUTPUT_H
+#define OUTPUT_H
+
+#include "config.h"
+
+// Estado de execução dos canais, em arrays paralelos (um índice por canal)
+// para que os motores percorram todos os canais numa única passada por tick.
+// Alterado no loop e pelo botão (máscaras, lastTriggerMs, offAtMs, ver
+// outputOnIsr): trocar esses campos sob halLock()/halUnlock().
+struct ChannelState {
+  uint32_t      activeMask;                   // bit ch = saída ligada
+  unsigned long lastTriggerMs[MAX_CHANNELS];  // cooldown (0 = nunca)
+  unsigned long offAtMs[MAX_CHANNELS];        // 0 = sem desligamento automático
+  time_t        ruleHighDT[MAX_CHANNELS];     // UTC, para IH
+  time_t        ruleLowDT[MAX_CHANNELS];      // UTC, para IL
+  uint32_t      manualMask;                   // bit ch = ativação atual é manual
+  uint32_t      isrMask;                      // bit ch = trocado pelo botão, falta outputNote()
+  time_t        changedUtc[MAX_CHANNELS];     // UTC da última mudança (on_for/off_for)
+  long          countDay[MAX_CHANNELS];       // dia local de onCount
+  uint16_t      onCount[MAX_CHANNELS];        // ativações em countDay
+  uint32_t      dcPrimed;                     // bit ch = dcState válido
+  uint32_t      dcState;                      // bit ch = último estado calculado dos DC
+  time_t        exprSince[MAX_CHANNELS][MAX_EXPR_RULES]; // UTC desde quando EH/EL "for" é verdadeira
+};
+extern ChannelState chState;
+
+inline bool channelActive(int ch) {
+  return (chState.activeMask >> ch) & 1UL;
+}
+
+// Configura os pinos dos canais em uso e zera o estado.
+void outputsBegin(const Config& c);
+
+// Aciona/desliga o canal sem log nem String. Retornam false se nada mudou
+// (já ativa, cooldown, já desligada ou canal sem pino). durationSec >
+// MAX_FEED_DURATION significa "até uma regra desligar". manual marca a
+// ativação como vinda de FeedNow/botão (variável `manual` das regras EH/EL).
+bool outputOn(const Config& c, int ch, unsigned long durationSec, bool manual = false);
+bool outputOff(const Config& c, int ch);
+
+// Variantes do botão, chamadas em interrupção (IRAM no ESP8266): só o pino
+// e as máscaras de chState. O resto da mudança (contagem do dia, stats,
+// evento, LED) fica para outputNote(), chamado depois no loop.
+bool outputOnIsr(const Config& c, int ch, unsigned long durationSec);
+bool outputOffIsr(const Config& c, int ch);
+void outputNote(int ch, bool on, bool manual);
+
+// Idem, com registro no log de eventos.
+bool startOutput(const Config& c, int ch, unsigned long durationSec, bool manual = false);
+bool stopOutput(const Config& c, int ch);
+
+// Desliga os canais cujo tempo expirou (exceto os com outputNote() pendente,
+// para que a ligação seja registrada antes do desligamento).
+void serviceOutputTimers(const Config& c);
+
+// Indica se o canal está dentro do intervalo FEED_COOLDOWN.
+bool outputInCooldown(int ch, unsigned long nowMs);
+
+#endif // OUTPUT_H
@@ -0,0 +1,529 @@
+// program_table.cpp
+
+#include "program_table.h"
+#include "time_utils.h"
+#include "tz_rules.h"
+#include "hal.h"
+#include "output.h"
+#include "exceptions.h"
+#include "logbuf.h"
+#include "metrics.h"
+#include <FS.h>
+
+#ifdef ESP8266
+  #include <LittleFS.h>
+  #define FS_INSTANCE LittleFS
+#else
+  #include <SPIFFS.h>
+  #define FS_INSTANCE SPIFFS
+#endif
+
+static constexpr uint32_t PROG_MAGIC   = 0x31525054UL;   // "TPR1"
+static constexpr uint16_t PROG_VERSION = 1;
+static constexpr size_t   PROG_HEADER  = 8;
+
+struct ProgHeader {
+  uint32_t magic;
+  uint16_t version;
+  uint16_t recSize;
+};
+static_assert(sizeof(ProgHeader) == PROG_HEADER, "cabeçalho de 8 bytes");
+static_assert(sizeof(ProgRecord) == 8, "registro de 8 bytes");
+
+struct ProgPage {
+  int32_t    first;   // índice do primeiro registro (-1 = vazia)
+  uint8_t    n;
+  ProgRecord rec[PROG_PAGE_RECS];
+};
+
+struct ProgState {
+  uint32_t count;
+  uint32_t cursor;     // próximo registro a disparar
+  int32_t  lastWeek;   // último segundo da semana avaliado
+  time_t   lastUtc;    // instante UTC em que lastWeek valeu
+  bool     seek;       // cursor a reposicionar por progService()
+  bool     parked;     // canal em regras customizadas
+  ProgPage page[2];
+  uint32_t fired;
+  uint32_t loads;
+  uint32_t stalls;
+};
+
+struct ProgImport {
+  File       src;       // texto recebido ("/prog<ch>.txt")
+  File       f;         // tabela em montagem ("/prog<ch>.tmp")
+  int        ch;
+  bool       active;    // recebendo ou convertendo
+  bool       parsing;   // recebido: progService() converte
+  bool       failed;
+  int8_t     result;    // última importação: 1 ok, -1 erro, 0 nenhuma
+  uint32_t   line;
+  uint32_t   count;
+  int32_t    lastWeek;
+  uint8_t    len;
+  char       buf[PROG_LINE_MAX];
+  uint8_t    outN;
+  ProgRecord out[PROG_PAGE_RECS];
+  char       err[48];
+};
+
+static ProgState  s_prog[MAX_CHANNELS];
+static ProgImport s_imp;
+static time_t     s_prevUtc = 0;
+static time_t     s_maxLocal = 0;   // maior hora local já avaliada
+
+static String pathOf(int ch, const char* ext) {
+  return "/prog" + String(ch) + ext;
+}
+
+static void invalidatePages(ProgState& st) {
+  st.page[0].first = st.page[1].first = -1;
+  st.page[0].n     = st.page[1].n     = 0;
+}
+
+// Lê cabeçalho e tamanho; 0 se o arquivo não existe ou é inválido
+static uint32_t openTable(int ch) {
+  String path = pathOf(ch, ".bin");
+  if (!FS_INSTANCE.exists(path)) return 0;
+  File f = FS_INSTANCE.open(path, "r");
+  if (!f) return 0;
+  ProgHeader h;
+  size_t   size = f.size();
+  bool     ok   = f.read((uint8_t*)&h, sizeof(h)) == sizeof(h) &&
+                  h.magic == PROG_MAGIC && h.version == PROG_VERSION &&
+                  h.recSize == sizeof(ProgRecord) &&
+                  (size - PROG_HEADER) % sizeof(ProgRecord) == 0;
+  f.close();
+  if (!ok) return 0;
+  uint32_t n = (size - PROG_HEADER) / sizeof(ProgRecord);
+  return n <= PROG_MAX_RECORDS ? n : 0;
+}
+
+static void loadChannel(int ch) {
+  ProgState& st = s_prog[ch];
+  st.count  = openTable(ch);
+  st.cursor = 0;
+  st.seek   = true;
+  st.parked = false;
+  invalidatePages(st);
+}
+
+void progBegin() {
+  memset(s_prog, 0, sizeof(s_prog));
+  for (int ch = 0; ch < MAX_CHANNELS; ch++) loadChannel(ch);
+}
+
+uint32_t progCount(int ch) {
+  return (ch >= 0 && ch < MAX_CHANNELS) ? s_prog[ch].count : 0;
+}
+
+// ===== Tempo =====
+
+static int32_t weekSecOf(time_t local) {
+  long dow = (localEpochDay(local) + 4) % 7;   // 01/01/1970 foi quinta
+  if (dow < 0) dow += 7;
+  return (int32_t)(dow * 86400L + localSecOfDay(local));
+}
+
+// Segundos de `from` até `to` avançando na semana
+static int32_t weekAhead(int32_t from, int32_t to) {
+  int32_t d = to - from;
+  return d < 0 ? d + (int32_t)PROG_WEEK_SEC : d;
+}
+
+// ===== Cache =====
+
+static const ProgRecord* cached(const ProgState& st, uint32_t idx) {
+  for (const ProgPage& p : st.page) {
+    if (p.first >= 0 && idx >= (uint32_t)p.first && idx < (uint32_t)p.first + p.n) {
+      return &p.rec[idx - p.first];
+    }
+  }
+  return nullptr;
+}
+
+static bool readAt(File& f, uint32_t idx, ProgRecord* dst, size_t n) {
+  if (!f.seek(PROG_HEADER + idx * sizeof(ProgRecord))) return false;
+  size_t bytes = n * sizeof(ProgRecord);
+  return f.read((uint8_t*)dst, bytes) == bytes;
+}
+
+// Garante a página `pg` em RAM sem descartar a página `keep`
+static void ensurePage(File& f, ProgState& st, uint32_t pg, uint32_t keep) {
+  int32_t first = (int32_t)(pg * PROG_PAGE_RECS);
+  for (const ProgPage& p : st.page) if (p.first == first) return;
+  ProgPage& dst = st.page[st.page[0].first == (int32_t)(keep * PROG_PAGE_RECS) ? 1 : 0];
+  uint32_t  n   = st.count - first;
+  if (n > PROG_PAGE_RECS) n = PROG_PAGE_RECS;
+  dst.first = -1;
+  if (!readAt(f, first, dst.rec, n)) return;
+  dst.n     = n;
+  dst.first = first;
+  st.loads++;
+}
+
+// Primeiro registro depois de `week` (cíclico: 0 se nenhum)
+static uint32_t searchAfter(File& f, const ProgState& st, int32_t week) {
+  uint32_t lo = 0, hi = st.count;
+  while (lo < hi) {
+    uint32_t   mid = (lo + hi) / 2;
+    ProgRecord r;
+    if (!readAt(f, mid, &r, 1)) return 0;
+    if ((int32_t)r.weekSec <= week) lo = mid + 1;
+    else                            hi = mid;
+  }
+  return lo < st.count ? lo : 0;
+}
+
+static void parseStep();   // em Importação
+
+void progService() {
+  if (s_imp.parsing) parseStep();
+
+  for (int ch = 0; ch < MAX_CHANNELS; ch++) {
+    ProgState& st = s_prog[ch];
+    if (!st.count || st.parked) continue;
+    if (s_imp.active && s_imp.ch == ch) continue;
+
+    uint32_t pages = (st.count + PROG_PAGE_RECS - 1) / PROG_PAGE_RECS;
+    uint32_t cur   = st.cursor / PROG_PAGE_RECS;
+    uint32_t next  = (cur + 1) % pages;
+    bool     ready = !st.seek && cached(st, st.cursor) &&
+                     cached(st, next * PROG_PAGE_RECS);
+    if (ready) continue;
+
+    File f = FS_INSTANCE.open(pathOf(ch, ".bin"), "r");
+    if (!f) continue;
+    if (st.seek) {
+      st.cursor = searchAfter(f, st, st.lastWeek);
+      st.seek   = false;
+      cur       = st.cursor / PROG_PAGE_RECS;
+      next      = (cur + 1) % pages;
+    }
+    ensurePage(f, st, cur, next);
+    ensurePage(f, st, next, cur);
+    f.close();
+  }
+}
+
+// ===== Disparo =====
+
+static void requestSeek(ProgState& st, int32_t week, time_t utc) {
+  st.lastWeek = week;
+  st.lastUtc  = utc;
+  st.seek     = true;
+}
+
+void progTick(const Config& cfg,
+              std::function<void(int, unsigned long)> onTrigger) {
+  if (!onTrigger || halSimulating()) return;
+
+  // avalia uma vez por segundo UTC, como checkSchedules()
+  time_t utcT = halUtcNow();
+  if (utcT == s_prevUtc) return;
+  long step = (long)(utcT - s_prevUtc);
+  bool jump = s_prevUtc == 0 || step < 0 || step > SCHEDULE_CATCHUP_SEC;
+  s_prevUtc = utcT;
+
+  time_t        nowT    = tzToLocal(utcT);
+  int32_t       nowWeek = weekSecOf(nowT);
+  unsigned long nowMs   = halMillis();
+
+  // Fim do horário de verão: o UTC avança e a hora local recua. A hora
+  // repetida já foi avaliada na primeira passada; os cursores ficam onde
+  // estão até a hora local passar de s_maxLocal.
+  bool repeat = !jump && nowT <= s_maxLocal;
+  if (!repeat) s_maxLocal = nowT;
+
+  for (int ch = 0; ch < cfg.channelCount; ch++) {
+    ProgState& st = s_prog[ch];
+    if (!st.count) continue;
+    if (cfg.channels[ch].customEnabled) {
+      st.parked = true;
+      continue;
+    }
+    if (jump || st.parked) {
+      // boot, salto de relógio ou volta das regras: nada a recuperar
+      st.parked = false;
+      requestSeek(st, repeat ? weekSecOf(s_maxLocal) : nowWeek, utcT);
+      continue;
+    }
+    if (repeat) {
+      st.lastUtc = utcT;       // parado na semana local, não atrasado
+      continue;
+    }
+    if (st.seek) {
+      st.lastWeek = nowWeek;   // ainda posicionando
+      st.lastUtc  = utcT;
+      continue;
+    }
+    // página atrasada além da janela de recuperação (medida em UTC: a hora
+    // pulada no início do horário de verão é recuperada): reposiciona
+    if (utcT - st.lastUtc > SCHEDULE_CATCHUP_SEC) {
+      requestSeek(st, nowWeek, utcT);
+      continue;
+    }
+
+    // registros em (lastWeek, nowWeek], só a partir das páginas em RAM
+    int32_t  span  = weekAhead(st.lastWeek, nowWeek);
+    uint32_t limit = st.count < PROG_FIRE_MAX ? st.count : PROG_FIRE_MAX;
+    bool     stall = false;
+    for (uint32_t n = 0; n < limit; n++) {
+      const ProgRecord* r = cached(st, st.cursor);
+      if (!r) {
+        stall = true;
+        break;
+      }
+      int32_t ahead = weekAhead(st.lastWeek, (int32_t)r->weekSec);
+      if (ahead == 0 || ahead > span) break;
+
+      time_t occ = nowT - weekAhead((int32_t)r->weekSec, nowWeek);
+      if (excForDay(localEpochDay(occ), ch).blackout) {
+        logEvent(LOG_PROG_SKIPPED, ch, st.cursor, 0, "exceção");
+      } else if (outputInCooldown(ch, nowMs)) {
+        logEvent(LOG_PROG_SKIPPED, ch, st.cursor, 0, "cooldown");
+      } else {
+        st.fired++;
+        metricsTriggerLateness((long)(nowT - occ));
+        logEvent(LOG_PROG_FIRED, ch, st.cursor, r->durationSec);
+        onTrigger(ch, r->durationSec);
+        chState.lastTriggerMs[ch] = nowMs;
+      }
+      st.cursor = (st.cursor + 1) % st.count;
+    }
+    // página ausente: mantém a janela aberta até progService() carregar
+    if (stall) {
+      st.stalls++;
+    } else {
+      st.lastWeek = nowWeek;
+      st.lastUtc  = utcT;
+    }
+  }
+}
+
+long progNextIn(int ch, time_t local, int* durationSec) {
+  if (durationSec) *durationSec = 0;
+  if (ch < 0 || ch >= MAX_CHANNELS) return -1;
+  const ProgState& st = s_prog[ch];
+  if (!st.count || st.seek || st.parked) return -1;
+  const ProgRecord* r = cached(st, st.cursor);
+  if (!r) return -1;
+  if (durationSec) *durationSec = r->durationSec;
+  return weekAhead(weekSecOf(local), (int32_t)r->weekSec);
+}
+
+void progClear(int ch) {
+  if (ch < 0 || ch >= MAX_CHANNELS) return;
+  FS_INSTANCE.remove(pathOf(ch, ".bin"));
+  loadChannel(ch);
+}
+
+// ===== Importação =====
+
+static bool fail(const char* msg) {
+  if (!s_imp.failed) {
+    snprintf(s_imp.err, sizeof(s_imp.err), "Linha %lu: %s",
+             (unsigned long)s_imp.line, msg);
+  }
+  s_imp.failed = true;
+  return false;
+}
+
+static bool flushOut() {
+  if (!s_imp.outN) return true;
+  size_t bytes = s_imp.outN * sizeof(ProgRecord);
+  s_imp.outN = 0;
+  if (s_imp.f.write((const uint8_t*)s_imp.out, bytes) != bytes) return fail("falha de escrita");
+  return true;
+}
+
+// "<dia> <HH:MM:SS> <duração HH:MM:SS>"
+static bool parseLine() {
+  char* p = s_imp.buf;
+  while (*p == ' ' || *p == '\t') p++;
+  if (*p == '\0' || *p == '#') return true;
+
+  int d, h, m, sec, dh, dm, ds;
+  if (sscanf(p, "%d %d:%d:%d %d:%d:%d", &d, &h, &m, &sec, &dh, &dm, &ds) != 7) {
+    return fail("formato inválido");
+  }
+  if (d < 0 || d > 6 || h < 0 || h > 23 || m < 0 || m > 59 || sec < 0 || sec > 59) {
+    return fail("horário inválido");
+  }
+  long dur = dh * 3600L + dm * 60L + ds;
+  if (dh < 0 || dm < 0 || dm > 59 || ds < 0 || ds > 59 || dur <= 0 || dur > MAX_FEED_DURATION) {
+    return fail("duração inválida");
+  }
+  int32_t week = d * 86400L + h * 3600L + m * 60L + sec;
+  if (week < s_imp.lastWeek) return fail("fora de ordem");
+  if (s_imp.count >= PROG_MAX_RECORDS) return fail("registros demais");
+
+  ProgRecord& r = s_imp.out[s_imp.outN++];
+  r.weekSec     = week;
+  r.durationSec = dur;
+  r.reserved    = 0;
+  s_imp.lastWeek = week;
+  s_imp.count++;
+  return s_imp.outN < PROG_PAGE_RECS || flushOut();
+}
+
+static void parseBytes(const uint8_t* data, size_t len) {
+  for (size_t i = 0; i < len && !s_imp.failed; i++) {
+    char c = (char)data[i];
+    if (c == '\r') continue;
+    if (c == '\n') {
+      s_imp.buf[s_imp.len] = '\0';
+      parseLine();
+      s_imp.len = 0;
+      s_imp.line++;
+    } else if (s_imp.len < PROG_LINE_MAX - 1) {
+      s_imp.buf[s_imp.len++] = c;
+    } else {
+      fail("linha longa demais");
+    }
+  }
+}
+
+// Fecha os arquivos da importação; com `ok`, a tabela nova substitui a atual
+static void finishImport() {
+  if (!s_imp.failed && s_imp.len) {   // última linha sem '\n'
+    s_imp.buf[s_imp.len] = '\0';
+    parseLine();
+  }
+  if (!s_imp.failed && !s_imp.count) fail("nenhum registro");
+  if (!s_imp.failed) flushOut();
+  s_imp.src.close();
+  s_imp.f.close();
+  s_imp.active  = false;
+  s_imp.parsing = false;
+  FS_INSTANCE.remove(pathOf(s_imp.ch, ".txt"));
+
+  String tmp = pathOf(s_imp.ch, ".tmp");
+  if (s_imp.failed) {
+    s_imp.failed = false;
+    s_imp.result = -1;
+    FS_INSTANCE.remove(tmp);
+    return;
+  }
+  String path = pathOf(s_imp.ch, ".bin");
+  FS_INSTANCE.remove(path);
+  if (!FS_INSTANCE.rename(tmp, path)) {
+    strncpy(s_imp.err, "Falha ao gravar tabela", sizeof(s_imp.err));
+    s_imp.result = -1;
+    return;
+  }
+  s_imp.result = 1;
+  loadChannel(s_imp.ch);
+  logEvent(LOG_PROG_IMPORTED, s_imp.ch, s_imp.count);
+}
+
+// Até PROG_PARSE_BYTES do texto recebido por passada de progService()
+static void parseStep() {
+  uint8_t buf[PROG_PARSE_BYTES];
+  size_t  n = s_imp.src.read(buf, sizeof(buf));
+  parseBytes(buf, n);
+  if (n < sizeof(buf) || s_imp.failed) finishImport();
+}
+
+bool progImportBegin(int ch) {
+  progImportAbort();
+  memset(s_imp.buf, 0, sizeof(s_imp.buf));
+  s_imp.ch       = ch;
+  s_imp.failed   = false;
+  s_imp.parsing  = false;
+  s_imp.result   = 0;
+  s_imp.line     = 1;
+  s_imp.count    = 0;
+  s_imp.lastWeek = 0;
+  s_imp.len      = 0;
+  s_imp.outN     = 0;
+  s_imp.err[0]   = '\0';
+  if (ch < 0 || ch >= MAX_CHANNELS) return false;
+  s_imp.src = FS_INSTANCE.open(pathOf(ch, ".txt"), "w");
+  if (!s_imp.src) {
+    strncpy(s_imp.err, "Falha ao criar arquivo", sizeof(s_imp.err));
+    s_imp.failed = true;
+    return false;
+  }
+  s_imp.active = true;
+  return true;
+}
+
+bool progImportChunk(const uint8_t* data, size_t len) {
+  if (!s_imp.active || s_imp.parsing || s_imp.failed) return false;
+  if (s_imp.src.write(data, len) != len) {
+    strncpy(s_imp.err, "Falha de escrita", sizeof(s_imp.err));
+    s_imp.failed = true;
+  }
+  return !s_imp.failed;
+}
+
+bool progImportEnd() {
+  if (!s_imp.active || s_imp.parsing) {
+    // sem arquivo, ou progImportBegin() falhou (erro já descrito)
+    if (!s_imp.failed) strncpy(s_imp.err, "Nenhum arquivo recebido", sizeof(s_imp.err));
+    s_imp.failed = false;
+    return false;
+  }
+  s_imp.src.close();
+  String txt = pathOf(s_imp.ch, ".txt");
+  if (!s_imp.failed) {
+    s_imp.src = FS_INSTANCE.open(txt, "r");
+    s_imp.f   = FS_INSTANCE.open(pathOf(s_imp.ch, ".tmp"), "w");
+    if (!s_imp.src || !s_imp.f) strncpy(s_imp.err, "Falha ao criar arquivo", sizeof(s_imp.err));
+    s_imp.failed = !s_imp.src || !s_imp.f;
+  }
+  ProgHeader h = { PROG_MAGIC, PROG_VERSION, sizeof(ProgRecord) };
+  if (!s_imp.failed && s_imp.f.write((const uint8_t*)&h, sizeof(h)) != sizeof(h)) {
+    strncpy(s_imp.err, "Falha de escrita", sizeof(s_imp.err));
+    s_imp.failed = true;
+  }
+  if (s_imp.failed) {
+    s_imp.src.close();
+    s_imp.f.close();
+    s_imp.active = false;
+    s_imp.failed = false;
+    FS_INSTANCE.remove(txt);
+    FS_INSTANCE.remove(pathOf(s_imp.ch, ".tmp"));
+    return false;
+  }
+  s_imp.parsing = true;   // progService() converte aos poucos
+  return true;
+}
+
+void progImportAbort() {
+  if (!s_imp.active) return;
+  s_imp.src.close();
+  s_imp.f.close();
+  s_imp.active  = false;
+  s_imp.parsing = false;
+  FS_INSTANCE.remove(pathOf(s_imp.ch, ".txt"));
+  FS_INSTANCE.remove(pathOf(s_imp.ch, ".tmp"));
+}
+
+const char* progImportError() {
+  return s_imp.err;
+}
+
+void progToJson(int ch, JsonObject dst) {
+  const ProgState& st = s_prog[ch];
+  int  dur;
+  long next = progNextIn(ch, localNow(), &dur);
+  dst["channel"] = ch;
+  dst["records"] = st.count;
+  dst["cursor"]  = st.cursor;
+  if (next >= 0) {
+    dst["next_in"]      = next;
+    dst["next_duration"] = dur;
+  } else {
+    dst["next_in"] = nullptr;
+  }
+  dst["fired"]     = st.fired;
+  dst["loads"]     = st.loads;
+  dst["stalls"]    = st.stalls;
+  dst["importing"] = s_imp.active && s_imp.ch == ch;
+  if (!s_imp.active && s_imp.ch == ch && s_imp.result) {
+    dst["import_ok"] = s_imp.result > 0;
+    if (s_imp.result < 0) dst["import_error"] = s_imp.err;
+  }
+}
@@ -0,0 +1,85 @@
+// program_table.h
+#ifndef PROGRAM_TABLE_H
+#define PROGRAM_TABLE_H
+
+#include "config.h"
+#include <ArduinoJson.h>
+#include <functional>
+
+// Programas semanais grandes (irrigação, dosagem) fora da Config: um
+// arquivo por canal, "/prog<ch>.bin", com registros de largura fixa
+// ordenados pelo segundo da semana local (0 = domingo 00:00:00):
+//   cabeçalho (8 bytes): u32 magic "TPR1", u16 versão, u16 tamanho do registro
+//   registro  (8 bytes): u32 segundo da semana, u16 duração (s), u16 reservado
+// A quantidade sai do tamanho do arquivo, até PROG_MAX_RECORDS.
+//
+// A RAM é fixa por canal: duas páginas de PROG_PAGE_RECS registros. Um
+// cursor aponta o próximo registro a disparar; a tarefa progService()
+// mantém carregadas a página do cursor e a seguinte (pré-busca), e faz a
+// busca binária no arquivo após boot, importação ou salto de relógio.
+// progTick(), chamado pelo motor, só lê as páginas em RAM: se o registro
+// do cursor não está carregado, o disparo espera a próxima passada (conta
+// em `stalls`) dentro da janela de SCHEDULE_CATCHUP_SEC.
+//
+// Importação em streaming (POST /importProgram?ch=N, upload de arquivo):
+// uma linha por registro, "<dia 0-6> <HH:MM:SS> <duração HH:MM:SS>", em
+// ordem não decrescente; linhas vazias e iniciadas por '#' são ignoradas.
+// O upload só copia o texto para "/prog<ch>.txt"; a conversão corre depois
+// em progService(), PROG_PARSE_BYTES por passada, para não segurar o motor.
+// As linhas viram registros numa página de buffer gravada em
+// "/prog<ch>.tmp", que só substitui a tabela ao final sem erros; o
+// resultado aparece em progToJson() ("importing", "import_ok",
+// "import_error").
+//
+// O progresso é medido na semana local, mas a janela de recuperação conta
+// segundos UTC: a hora pulada no início do horário de verão dispara, e a
+// hora repetida no fim dele não dispara de novo.
+//
+// Como os agendamentos: vale só com customEnabled == false, respeita o
+// cooldown e não dispara em dia bloqueado no calendário de exceções. A
+// simulação (/simulate) não percorre estas tabelas.
+
+static constexpr uint8_t  PROG_PAGE_RECS   = 16;
+static constexpr uint32_t PROG_MAX_RECORDS = 16384;
+static constexpr uint32_t PROG_WEEK_SEC    = 7UL * 86400UL;
+static constexpr uint8_t  PROG_LINE_MAX    = 48;
+static constexpr uint8_t  PROG_FIRE_MAX    = 32;   // disparos por tick e canal
+static constexpr uint16_t PROG_PARSE_BYTES = 512;  // texto convertido por passada
+
+struct ProgRecord {
+  uint32_t weekSec;
+  uint16_t durationSec;
+  uint16_t reserved;
+};
+
+// Após loadConfig (FS montado): abre as tabelas existentes.
+void progBegin();
+
+// Tarefa do loop: converte a importação recebida, reposiciona cursores e
+// pré-carrega páginas.
+void progService();
+
+// Motor: dispara os registros que caíram na janela desde o último tick.
+void progTick(const Config& cfg,
+              std::function<void(int ch, unsigned long durationSec)> onTrigger);
+
+// Registros na tabela do canal (0 = sem tabela)
+uint32_t progCount(int ch);
+
+// Segundos até o registro do cursor, só pela RAM (-1 se não há/não carregado)
+long progNextIn(int ch, time_t local, int* durationSec = nullptr);
+
+// Importação (uma por vez). progImportEnd() true = recebida e na fila de
+// conversão; em erro, progImportError() descreve a falha (ou a linha).
+bool        progImportBegin(int ch);
+bool        progImportChunk(const uint8_t* data, size_t len);
+bool        progImportEnd();
+void        progImportAbort();
+const char* progImportError();
+
+// Remove a tabela do canal
+void progClear(int ch);
+
+void progToJson(int ch, JsonObject dst);
+
+#endif // PROGRAM_TABLE_H
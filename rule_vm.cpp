@@ -0,0 +1,278 @@
+// rule_vm.cpp
+
+#include "rule_vm.h"
+
+enum ExprOp : uint8_t {
+  OP_PUSH8 = 0,   // + int8
+  OP_PUSH32,      // + int32 (little-endian)
+  OP_VAR,         // + índice ExprVar
+  OP_NOT, OP_NEG,
+  OP_MUL, OP_DIV, OP_MOD,
+  OP_ADD, OP_SUB,
+  OP_LT, OP_LE, OP_GT, OP_GE,
+  OP_EQ, OP_NE,
+  OP_AND, OP_OR
+};
+
+static const char* const EXPR_VAR_NAMES[EV__COUNT] = {
+  "hour", "minute", "second", "tod", "wday", "day", "month", "year",
+  "out", "on_for", "off_for", "manual", "count",
+  "temp", "temp_ok", "ext", "ext_ok"
+};
+
+// ===== Compilador (descida recursiva) =====
+
+struct ExprParser {
+  const char*  base;
+  const char*  p;
+  ExprRule*    out;
+  int          depth;      // profundidade atual da pilha
+  int          nest;       // parênteses/unários abertos (limita a recursão)
+  int          errPos;
+  const char*  errMsg;
+};
+
+static bool fail(ExprParser& ps, const char* msg) {
+  if (!ps.errMsg) {
+    ps.errPos = ps.p - ps.base;
+    ps.errMsg = msg;
+  }
+  return false;
+}
+
+static void skipSpaces(ExprParser& ps) {
+  while (*ps.p == ' ') ps.p++;
+}
+
+static bool emit(ExprParser& ps, uint8_t b) {
+  if (ps.out->len >= EXPR_MAX_CODE) return fail(ps, "expressão longa demais");
+  ps.out->code[ps.out->len++] = b;
+  return true;
+}
+
+// empilha (+1) ou consome (-n+1) valores, controlando a profundidade
+static bool stackAdjust(ExprParser& ps, int delta) {
+  ps.depth += delta;
+  if (ps.depth > EXPR_MAX_STACK) return fail(ps, "expressão aninhada demais");
+  return true;
+}
+
+static bool emitConst(ExprParser& ps, int32_t v) {
+  if (v >= -128 && v <= 127) {
+    if (!emit(ps, OP_PUSH8) || !emit(ps, (uint8_t)(int8_t)v)) return false;
+  } else {
+    if (!emit(ps, OP_PUSH32)) return false;
+    for (int i = 0; i < 4; i++) {
+      if (!emit(ps, (uint8_t)((uint32_t)v >> (8 * i)))) return false;
+    }
+  }
+  return stackAdjust(ps, 1);
+}
+
+static bool readUInt(ExprParser& ps, int32_t& v) {
+  if (*ps.p < '0' || *ps.p > '9') return fail(ps, "número esperado");
+  v = 0;
+  while (*ps.p >= '0' && *ps.p <= '9') {
+    if (v > 100000000) return fail(ps, "número grande demais");
+    v = v * 10 + (*ps.p++ - '0');
+  }
+  return true;
+}
+
+static bool parseOr(ExprParser& ps);
+
+// número, N.D (décimos), HH:MM[:SS], duração (h/m/s), variável, (expr), !x, -x
+static bool parseUnary(ExprParser& ps) {
+  skipSpaces(ps);
+  char c = *ps.p;
+
+  if ((c == '!' || c == '-' || c == '(') && ++ps.nest > 2 * EXPR_MAX_STACK) {
+    return fail(ps, "expressão aninhada demais");
+  }
+
+  if (c == '!' || c == '-') {
+    ps.p++;
+    if (!parseUnary(ps)) return false;
+    ps.nest--;
+    return emit(ps, c == '!' ? OP_NOT : OP_NEG);
+  }
+
+  if (c == '(') {
+    ps.p++;
+    if (!parseOr(ps)) return false;
+    skipSpaces(ps);
+    if (*ps.p != ')') return fail(ps, "')' esperado");
+    ps.p++;
+    ps.nest--;
+    return true;
+  }
+
+  if (c >= '0' && c <= '9') {
+    int32_t v;
+    if (!readUInt(ps, v)) return false;
+    if (*ps.p == ':') {                       // HH:MM[:SS]
+      int32_t mm, ss = 0;
+      ps.p++;
+      if (!readUInt(ps, mm)) return false;
+      if (*ps.p == ':') {
+        ps.p++;
+        if (!readUInt(ps, ss)) return false;
+      }
+      if (v > 23 || mm > 59 || ss > 59) return fail(ps, "horário inválido");
+      v = v * 3600 + mm * 60 + ss;
+    } else if (*ps.p == '.') {                // N.D em décimos
+      ps.p++;
+      if (*ps.p < '0' || *ps.p > '9') return fail(ps, "dígito decimal esperado");
+      v = v * 10 + (*ps.p++ - '0');
+      if (*ps.p >= '0' && *ps.p <= '9') return fail(ps, "use uma casa decimal");
+    } else {
+      int32_t unit = 1;
+      if      (*ps.p == 'h') unit = 3600;
+      else if (*ps.p == 'm') unit = 60;
+      if (unit > 1 || *ps.p == 's') ps.p++;
+      if (v > 0x7FFFFFFF / unit) return fail(ps, "duração grande demais");
+      v *= unit;
+    }
+    return emitConst(ps, v);
+  }
+
+  if ((c >= 'a' && c <= 'z') || c == '_') {
+    const char* start = ps.p;
+    while ((*ps.p >= 'a' && *ps.p <= 'z') || *ps.p == '_') ps.p++;
+    size_t n = ps.p - start;
+    for (uint8_t i = 0; i < EV__COUNT; i++) {
+      if (strlen(EXPR_VAR_NAMES[i]) == n && strncmp(EXPR_VAR_NAMES[i], start, n) == 0) {
+        if (!emit(ps, OP_VAR) || !emit(ps, i)) return false;
+        return stackAdjust(ps, 1);
+      }
+    }
+    ps.p = start;
+    return fail(ps, "variável desconhecida");
+  }
+
+  return fail(ps, "operando esperado");
+}
+
+// Operadores binários por nível de precedência (maior = mais forte)
+struct BinOp {
+  const char* tok;
+  uint8_t     level;
+  ExprOp      op;
+};
+
+static const BinOp BIN_OPS[] = {
+  { "||", 1, OP_OR },  { "&&", 2, OP_AND },
+  { "==", 3, OP_EQ },  { "!=", 3, OP_NE },
+  { "<=", 4, OP_LE },  { ">=", 4, OP_GE }, { "<", 4, OP_LT }, { ">", 4, OP_GT },
+  { "+", 5, OP_ADD },  { "-", 5, OP_SUB },
+  { "*", 6, OP_MUL },  { "/", 6, OP_DIV }, { "%", 6, OP_MOD }
+};
+
+static const BinOp* peekOp(ExprParser& ps, uint8_t level) {
+  skipSpaces(ps);
+  for (const BinOp& b : BIN_OPS) {
+    if (b.level != level) continue;
+    size_t n = strlen(b.tok);
+    if (strncmp(ps.p, b.tok, n) == 0) return &b;
+  }
+  return nullptr;
+}
+
+static bool parseLevel(ExprParser& ps, uint8_t level) {
+  if (level > 6) return parseUnary(ps);
+  if (!parseLevel(ps, level + 1)) return false;
+  const BinOp* b;
+  while ((b = peekOp(ps, level)) != nullptr) {
+    ps.p += strlen(b->tok);
+    if (!parseLevel(ps, level + 1)) return false;
+    if (!emit(ps, b->op)) return false;
+    stackAdjust(ps, -1);
+  }
+  return true;
+}
+
+static bool parseOr(ExprParser& ps) {
+  return parseLevel(ps, 1);
+}
+
+bool exprCompile(const char* src, ExprRule& out, int& consumed,
+                 int& errPos, const char*& errMsg) {
+  ExprParser ps = { src, src, &out, 0, 0, 0, nullptr };
+  out.len     = 0;
+  out.holdSec = 0;
+  bool ok = parseOr(ps);
+  if (ok) {
+    skipSpaces(ps);
+    // sufixo "for 5m"
+    if (strncmp(ps.p, "for", 3) == 0 && (ps.p[3] == ' ' || (ps.p[3] >= '0' && ps.p[3] <= '9'))) {
+      ps.p += 3;
+      skipSpaces(ps);
+      int32_t v;
+      ok = readUInt(ps, v);
+      if (ok) {
+        int32_t unit = 1;
+        if      (*ps.p == 'h') unit = 3600;
+        else if (*ps.p == 'm') unit = 60;
+        if (unit > 1 || *ps.p == 's') ps.p++;
+        if (v > 65535 / unit) ok = fail(ps, "duração 'for' grande demais (máx. 18h)");
+        else                  out.holdSec = (uint16_t)(v * unit);
+        skipSpaces(ps);
+      }
+    }
+  }
+  if (ok && *ps.p != ')' && *ps.p != '\0') ok = fail(ps, "operador esperado");
+  if (!ok) {
+    errPos = ps.errPos;
+    errMsg = ps.errMsg;
+    return false;
+  }
+  consumed = ps.p - src;
+  return true;
+}
+
+// ===== VM =====
+
+int32_t exprEval(const ExprRule& r, const int32_t* vars) {
+  int32_t        st[EXPR_MAX_STACK];
+  int            sp = 0;
+  const uint8_t* pc = r.code;
+  const uint8_t* end = r.code + r.len;
+
+  // o compilador garante profundidade <= EXPR_MAX_STACK e operandos presentes
+  while (pc < end) {
+    uint8_t op = *pc++;
+    if (op == OP_PUSH8)  { st[sp++] = (int8_t)*pc++; continue; }
+    if (op == OP_PUSH32) {
+      st[sp++] = (int32_t)((uint32_t)pc[0] | ((uint32_t)pc[1] << 8) |
+                           ((uint32_t)pc[2] << 16) | ((uint32_t)pc[3] << 24));
+      pc += 4;
+      continue;
+    }
+    if (op == OP_VAR)    { st[sp++] = vars[*pc++]; continue; }
+    if (op == OP_NOT)    { st[sp - 1] = !st[sp - 1]; continue; }
+    if (op == OP_NEG)    { st[sp - 1] = (int32_t)(0U - (uint32_t)st[sp - 1]); continue; }
+
+    int32_t b = st[--sp];
+    int32_t a = st[sp - 1];
+    int32_t v;
+    switch (op) {
+      // aritmética com estouro em complemento de 2; /0 e %0 resultam 0
+      case OP_MUL: v = (int32_t)((uint32_t)a * (uint32_t)b); break;
+      case OP_DIV: v = (b == 0) ? 0 : (b == -1) ? (int32_t)(0U - (uint32_t)a) : a / b; break;
+      case OP_MOD: v = (b == 0 || b == -1) ? 0 : a % b; break;
+      case OP_ADD: v = (int32_t)((uint32_t)a + (uint32_t)b); break;
+      case OP_SUB: v = (int32_t)((uint32_t)a - (uint32_t)b); break;
+      case OP_LT:  v = a <  b; break;
+      case OP_LE:  v = a <= b; break;
+      case OP_GT:  v = a >  b; break;
+      case OP_GE:  v = a >= b; break;
+      case OP_EQ:  v = a == b; break;
+      case OP_NE:  v = a != b; break;
+      case OP_AND: v = a && b; break;
+      case OP_OR:  v = a || b; break;
+      default:     v = 0; break;
+    }
+    st[sp - 1] = v;
+  }
+  return sp ? st[0] : 0;
+}
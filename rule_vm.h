@@ -0,0 +1,66 @@
+// rule_vm.h
+#ifndef RULE_VM_H
+#define RULE_VM_H
+
+#include <Arduino.h>
+
+// Expressões condicionais das regras EH(expr) / EL(expr), compiladas ao
+// salvar as regras em bytecode de pilha e avaliadas a cada tick por uma VM
+// sem alocação, sem saltos e sem laços: o custo é no máximo EXPR_MAX_CODE
+// passos por regra.
+//
+//   Operadores (precedência crescente): ||  &&  == !=  < <= > >=  + -  * / %  ! -
+//   Literais: 120, 07:30 (segundos desde 00:00), 2h, 30m, 45s,
+//             30.5 (uma casa decimal: vale 305, para comparar com temp/ext)
+//   Variáveis: veja EXPR_VAR_NAMES em rule_vm.cpp
+//   Sufixo "for <duração>": a condição precisa estar verdadeira sem
+//   interrupção por esse tempo antes de disparar.
+//   Ex.: EH(tod == 07:00 && off_for >= 2h)  EL(on_for > 45m && !manual)
+//        EH(temp_ok && temp > 30.0 for 5m)
+
+static constexpr uint8_t EXPR_MAX_CODE  = 48;   // bytes de bytecode por regra
+static constexpr uint8_t EXPR_MAX_STACK = 8;    // profundidade máxima da pilha
+
+enum ExprVar : uint8_t {
+  EV_HOUR = 0,   // 0–23 (hora local)
+  EV_MINUTE,     // 0–59
+  EV_SECOND,     // 0–59
+  EV_TOD,        // segundos desde 00:00 local
+  EV_WDAY,       // 0–6, 0 = domingo
+  EV_DAY,        // 1–31
+  EV_MONTH,      // 1–12
+  EV_YEAR,
+  EV_OUT,        // 1 se a saída do canal está ligada
+  EV_ON_FOR,     // s desde que ligou (0 se desligada)
+  EV_OFF_FOR,    // s desde que desligou (0 se ligada)
+  EV_MANUAL,     // 1 se a ativação atual veio de FeedNow/botão
+  EV_COUNT,      // ativações do canal hoje (dia local)
+  EV_TEMP,       // temperatura do DS3231 filtrada, décimos de °C
+  EV_TEMP_OK,    // 1 se `temp` é válida
+  EV_EXT,        // entrada analógica filtrada, décimos da unidade configurada
+  EV_EXT_OK,     // 1 se `ext` é válida
+  EV__COUNT
+};
+
+enum ExprFlag : uint8_t {
+  EXPR_F_ON = 1 << 0    // EH (liga) em vez de EL (desliga)
+};
+
+struct ExprRule {
+  uint8_t  code[EXPR_MAX_CODE];
+  uint8_t  len;
+  uint8_t  flags;       // ExprFlag
+  uint16_t holdSec;     // "for": segundos contínuos verdadeira (0 = imediato)
+};
+
+// Compila `src` (com o sufixo "for" opcional) até o ')' que fecha a
+// expressão (ou o fim da string);
+// `consumed` recebe o número de caracteres lidos, sem o ')'. Em erro
+// retorna false com posição relativa a src e mensagem curta.
+bool exprCompile(const char* src, ExprRule& out, int& consumed,
+                 int& errPos, const char*& errMsg);
+
+// Avalia com os valores de `vars` (EV__COUNT entradas); não-zero = verdadeiro.
+int32_t exprEval(const ExprRule& r, const int32_t* vars);
+
+#endif // RULE_VM_H
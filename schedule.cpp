@@ -1,38 +1,51 @@
 // schedule.cpp
 #include "schedule.h"
 #include "time_utils.h"
+#include "tz_rules.h"
+#include "hal.h"
+#include "logbuf.h"
+#include "metrics.h"
+#include "custom_rules.h"
+#include "exceptions.h"
+#include "program_table.h"
 #include <TimeLib.h>
 
-// Estes symbols devem estar definidos em outro módulo (por exemplo, main.cpp)
-extern unsigned long lastTriggerMs;
-extern String         eventLog;
-bool saveConfig(const Config& cfg);
+#include "output.h"
 
-String getNextTriggerTimeString(const Config& cfg) {
-  if (cfg.customEnabled) {
-    return "Regras personalizadas ativas.";
-  }
-  if (cfg.scheduleCount == 0) {
-    return "Nenhum agendamento configurado.";
+ScheduleTick scheduleTick = { 0, 0 };
+
+long nextTriggerIn(const Config& cfg, int ch, int* durationSec) {
+  const ChannelConfig& c = cfg.channels[ch];
+  time_t nowT = localNow();
+  if (durationSec) *durationSec = 0;
+  if (c.customEnabled) {
+    // próxima expressão CH(...) pela varredura das máscaras
+    time_t next = nextCronTrigger(c, nowT, true);
+    return (next && next - nowT < 24L * 3600L) ? (long)(next - nowT) : -1;
   }
 
-  int   nowSec    = getCurrentTimeInSec();
+  long  today     = localEpochDay(nowT);
+  int   nowSec    = localSecOfDay(nowT);
   int   secondsInDay = 24 * 3600;
   long  bestDiff  = secondsInDay + 1;
   int   bestDur   = 0;
 
-  for (int i = 0; i < cfg.scheduleCount; i++) {
-    const auto& s = cfg.schedules[i];
+  for (int i = 0; i < c.scheduleCount; i++) {
+    const auto& s = c.schedules[i];
     // se já disparou hoje ou horário igual ao atual mas já disparou, pula
-    int today = getCurrentDayOfYear();
-    if (s.lastTriggerDay == today && s.timeSec == nowSec) continue;
+    if (s.lastFireDay == today && s.timeSec == nowSec) continue;
 
     long diff;
+    long day;
     if (s.timeSec > nowSec) {
       diff = s.timeSec - nowSec;
+      day  = today;
     } else {
       diff = (secondsInDay - nowSec) + s.timeSec;
+      day  = today + 1;
     }
+    // slot suprimido pelo calendário de exceções nesse dia
+    if (!((excForDay(day, ch).slotMask >> i) & 1)) continue;
 
     if (diff < bestDiff) {
       bestDiff = diff;
@@ -40,9 +53,47 @@ String getNextTriggerTimeString(const Config& cfg) {
     }
   }
 
-  if (bestDiff <= secondsInDay) {
-    String diffStr = formatHHMMSS((int)bestDiff);
-    String durStr  = formatHHMMSS(bestDur);
+  // horários de substituição de hoje (ainda por vir) e de amanhã
+  for (long day = today; day <= today + 1; day++) {
+    const ExcDay& e = excForDay(day, ch);
+    for (int i = 0; i < e.repCount; i++) {
+      int  t    = e.rep[i].timeSec;
+      long diff = day == today ? t - nowSec : (secondsInDay - nowSec) + t;
+      if (diff <= 0 || diff > secondsInDay) continue;
+      if (diff < bestDiff) {
+        bestDiff = diff;
+        bestDur  = e.rep[i].durationSec;
+      }
+    }
+  }
+
+  // tabela de programa em flash: registro do cursor, se já está em RAM
+  int  progDur;
+  long prog = progNextIn(ch, nowT, &progDur);
+  if (prog >= 0 && prog < bestDiff) {
+    bestDiff = prog;
+    bestDur  = progDur;
+  }
+
+  if (bestDiff > secondsInDay) return -1;
+  if (durationSec) *durationSec = bestDur;
+  return bestDiff;
+}
+
+String getNextTriggerTimeString(const Config& cfg, int ch) {
+  const ChannelConfig& c = cfg.channels[ch];
+  int  dur;
+  long next = nextTriggerIn(cfg, ch, &dur);
+  if (c.customEnabled) {
+    if (next >= 0) return "Próxima em: " + formatHHMMSS((int)next) + " (regra CH)";
+    return "Regras personalizadas ativas.";
+  }
+  if (c.scheduleCount == 0 && !progCount(ch)) {
+    return "Nenhum agendamento configurado.";
+  }
+  if (next >= 0) {
+    String diffStr = formatHHMMSS((int)next);
+    String durStr  = formatHHMMSS(dur);
     return "Próxima em: " + diffStr + " (duração " + durStr + ")";
   }
 
@@ -50,48 +101,115 @@ String getNextTriggerTimeString(const Config& cfg) {
 }
 
 void checkSchedules(Config& cfg,
-                    std::function<void(unsigned long)> onTrigger) {
-  // não processa se custom rules ativas
-  if (cfg.customEnabled) return;
-  if (!onTrigger)        return;
-
-  time_t nowT   = now();
-  int today     = getCurrentDayOfYear();
-  int nowSec    = getCurrentTimeInSec();
-  unsigned long nowMs = millis();
-
-  for (int i = 0; i < cfg.scheduleCount; i++) {
-    auto& s = cfg.schedules[i];
-
-    // horário exato e ainda não disparou hoje?
-    if (s.timeSec == nowSec && s.lastTriggerDay != today) {
-      // respeita cooldown
-      if (lastTriggerMs == 0 || nowMs - lastTriggerMs >= (unsigned long)FEED_COOLDOWN * 1000UL) {
+                    std::function<void(int, unsigned long)> onTrigger) {
+  // avalia uma vez por segundo UTC
+  time_t& prevUtc   = scheduleTick.prevUtc;
+  time_t& prevLocal = scheduleTick.prevLocal;
+  time_t utcT = halUtcNow();
+  if (utcT == prevUtc) return;
+
+  time_t nowT     = tzToLocal(utcT);
+  long   today    = localEpochDay(nowT);
+  time_t dayStart = (time_t)today * 86400L;
+  unsigned long nowMs = halMillis();
+
+  // Janela local (winFrom, nowT] coberta neste tick. Avanços curtos do relógio
+  // UTC (loop travado, horário pulado pelo DST) recuperam os slots da janela;
+  // saltos grandes ou recuos avaliam apenas o segundo atual.
+  time_t winFrom = nowT - 1;
+  long   stepUtc = (long)(utcT - prevUtc);
+  if (prevUtc != 0) {
+    if (stepUtc > 0 && stepUtc <= SCHEDULE_CATCHUP_SEC) {
+      if (prevLocal < nowT) winFrom = prevLocal;
+    } else {
+      logEvent(LOG_CLOCK_STEP, -1, stepUtc);
+    }
+  }
+  // avança o tick antes de qualquer saída antecipada: um segundo sem
+  // avaliação (sem onTrigger, canal em regras) não vira janela de recuperação
+  prevUtc   = utcT;
+  prevLocal = nowT;
+  if (!onTrigger) return;
+
+  // uma passada por todos os canais; grava a config no máximo uma vez
+  bool fired = false;
+  for (int ch = 0; ch < cfg.channelCount; ch++) {
+    ChannelConfig& c = cfg.channels[ch];
+    if (c.customEnabled) continue;
+
+    // horários de substituição do calendário (dias da janela: hoje ou, na
+    // virada, ontem); o disparo fica em RAM, marcado por dia. Como
+    // lastFireDay, repDay só avança: um recuo de relógio pela meia-noite
+    // não rearma os horários do dia anterior.
+    long& repDay = scheduleTick.repDay[ch];
+    if (repDay > today + 1) repDay = 0;   // carimbo no futuro (relógio errado antes)
+    for (long day = localEpochDay(winFrom + 1); day <= today; day++) {
+      if (day < repDay) continue;
+      const ExcDay& e = excForDay(day, ch);
+      uint8_t        n   = e.repCount;
+      const ExcSlot* rep = e.rep;
+      if (day > repDay) {
+        repDay                    = day;
+        scheduleTick.repFired[ch] = 0;
+      }
+      for (int i = 0; i < n; i++) {
+        time_t occ = (time_t)day * 86400L + rep[i].timeSec;
+        if (occ <= winFrom || occ > nowT) continue;
+        if ((scheduleTick.repFired[ch] >> i) & 1) continue;
+        if (outputInCooldown(ch, nowMs)) {
+          logEvent(LOG_SCHED_REP_COOLDOWN, ch, i);
+          continue;
+        }
+        scheduleTick.repFired[ch] |= 1 << i;
+        if (!halSimulating()) metricsTriggerLateness((long)(nowT - occ));
+        logEvent(LOG_SCHED_REPLACED, ch, i, rep[i].durationSec);
+        onTrigger(ch, rep[i].durationSec);
+        chState.lastTriggerMs[ch] = nowMs;
+      }
+    }
+
+    for (int i = 0; i < c.scheduleCount; i++) {
+      auto& s = c.schedules[i];
+
+      // carimbo no futuro (relógio errado antes de uma correção): descarta
+      if (s.lastFireDay > today + 1) s.lastFireDay = -1;
+
+      // ocorrência mais recente do slot até agora (hoje ou ontem)
+      time_t occ = dayStart + s.timeSec;
+      if (occ > nowT) occ -= 86400L;
+      long occDay = localEpochDay(occ);
+
+      // dentro da janela e ainda não disparou nesse dia? (monotônico: recuos
+      // de relógio e horas repetidas do DST não disparam de novo)
+      if (occ <= winFrom || occDay <= s.lastFireDay) continue;
+
+      // feriado/manutenção: consome o slot do dia sem acionar
+      if (!((excForDay(occDay, ch).slotMask >> i) & 1)) {
+        s.lastFireDay = occDay;
+        logEvent(LOG_SCHED_SUPPRESSED, ch, i);
+        continue;
+      }
+
+      // respeita cooldown do canal
+      if (!outputInCooldown(ch, nowMs)) {
         // marca disparo
-        s.lastTriggerDay = today;
-        // log
-        String log = timeStr(nowT)
-                   + " -> Agendamento #" + String(i)
-                   + " acionado (duração " + formatHHMMSS(s.durationSec) + ").";
-        Serial.println(log);
-        eventLog += log + "\n";
+        s.lastFireDay = occDay;
+        fired = true;
+        if (!halSimulating()) metricsTriggerLateness((long)(nowT - occ));
+        logEvent(LOG_SCHED_FIRED, ch, i, s.durationSec);
 
         // executa ação externa (por exemplo startOutput)
-        onTrigger(s.durationSec);
+        onTrigger(ch, s.durationSec);
 
-        // persiste alterações
-        saveConfig(cfg);
-
-        // atualiza cooldown
-        lastTriggerMs = nowMs;
+        // atualiza cooldown (também quando a saída já estava ativa)
+        chState.lastTriggerMs[ch] = nowMs;
       }
       else {
-        String log = timeStr(nowT)
-                   + " -> Agendamento #" + String(i)
-                   + " ignorado (cooldown).";
-        Serial.println(log);
-        eventLog += log + "\n";
+        logEvent(LOG_SCHED_COOLDOWN, ch, i);
       }
     }
   }
+
+  // persiste alterações
+  if (fired) saveConfig(cfg);
 }
@@ -5,16 +5,39 @@
 #include "config.h"
 #include <functional>
 
-// Retorna uma string descrevendo quanto falta para o próximo agendamento.
-// Exemplo: "Próxima em: 01:23:45 (duração 00:05:00)"
-String getNextTriggerTimeString(const Config& cfg);
+// Último segundo avaliado por checkSchedules e horários de substituição já
+// disparados no dia (salvos/restaurados pelo simulador)
+struct ScheduleTick {
+  time_t  prevUtc;
+  time_t  prevLocal;
+  long    repDay[MAX_CHANNELS];     // dia-época de repFired (só avança)
+  uint8_t repFired[MAX_CHANNELS];   // bit i: ExcDay::rep[i] já disparou
+};
+extern ScheduleTick scheduleTick;
 
-// Verifica todos os agendamentos em cfg.schedules.
-// Para cada slot cujo horário coincidir exatamente com o tempo atual e que ainda não tenha disparado hoje,
-// chama onTrigger(cfg.schedules[i].durationSec), registra o log e salva cfg.
-// Respeita o cooldown cfg.FEED_COOLDOWN.
-// Se cfg.customEnabled == true, nada é feito.
+// Retorna uma string descrevendo quanto falta para o próximo agendamento
+// do canal `ch`. Exemplo: "Próxima em: 01:23:45 (duração 00:05:00)"
+String getNextTriggerTimeString(const Config& cfg, int ch);
+
+// Segundos até o próximo acionamento do canal (slot, tabela de programa ou
+// CH(...)), ou -1 se não há nenhum nas próximas 24 h. `durationSec` recebe a duração do slot
+// (0 para regras CH).
+long nextTriggerIn(const Config& cfg, int ch, int* durationSec = nullptr);
+
+// Verifica os agendamentos de todos os canais numa única passada (uma vez
+// por segundo). Para cada slot cujo horário caiu na janela desde o último
+// tick (até SCHEDULE_CATCHUP_SEC após travas ou horário pulado pelo DST) e
+// que ainda não disparou nesse dia-época, chama
+// onTrigger(ch, schedules[i].durationSec), registra o log e salva cfg uma
+// vez ao final. Saltos grandes ou recuos do relógio não recuperam disparos
+// nem repetem os já feitos.
+// Slots suprimidos pelo calendário de exceções (exceptions.h) são
+// consumidos no dia sem acionar a saída; num dia com horários de
+// substituição, esses disparam no lugar dos slots, pela mesma janela.
+// Respeita o cooldown FEED_COOLDOWN de cada canal.
+// Canais com customEnabled == true são ignorados; o tick avança mesmo assim,
+// então slots que passaram com as regras ativas não disparam ao desativá-las.
 void checkSchedules(Config& cfg,
-                    std::function<void(unsigned long durationSec)> onTrigger);
+                    std::function<void(int ch, unsigned long durationSec)> onTrigger);
 
 #endif // SCHEDULE_H
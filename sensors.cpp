@@ -0,0 +1,141 @@
+// sensors.cpp
+
+#include "sensors.h"
+#include "hal.h"
+#include "logbuf.h"
+#include "metrics.h"
+#include <Wire.h>
+#include <math.h>
+
+static constexpr uint8_t  DS3231_ADDR        = 0x68;
+static constexpr uint8_t  DS3231_REG_TEMP    = 0x11;   // MSB inteiro, LSB bits 7:6 = 0,25 °C
+static constexpr uint16_t SENSOR_I2C_TIMEOUT_MS = 5;    // limite por transação
+
+static const char* const SENSOR_NAMES[SENSOR__COUNT] = { "temp", "ext" };
+
+struct SensorState {
+  bool          present;
+  bool          ok;            // `value` publicado é válido
+  uint8_t       fails;         // falhas seguidas
+  uint8_t       count;         // amostras no anel
+  uint8_t       idx;
+  int16_t       ring[SENSOR_AVG_N];
+  int32_t       sum;
+  int32_t       raw;           // última amostra
+  int32_t       value;         // média após histerese
+  unsigned long nextMs;
+  unsigned long lastOkMs;
+};
+
+static SensorState s_sensor[SENSOR__COUNT];
+static uint8_t     s_next = 0;   // rodízio
+
+static bool readRtc(int32_t& tenths) {
+  Wire.beginTransmission(DS3231_ADDR);
+  Wire.write(DS3231_REG_TEMP);
+  if (Wire.endTransmission(false) != 0) return false;
+  if (Wire.requestFrom(DS3231_ADDR, (uint8_t)2) != 2) return false;
+  int8_t  msb = (int8_t)Wire.read();
+  uint8_t lsb = (uint8_t)Wire.read();
+  int32_t quarters = (int32_t)msb * 4 + (lsb >> 6);
+  tenths = (quarters * 10 + (quarters >= 0 ? 2 : -2)) / 4;
+  return true;
+}
+
+static bool readExt(const Config& cfg, int32_t& tenths) {
+  float v = analogRead(cfg.extPin) * cfg.extScale + cfg.extOffset;
+  if (!isfinite(v) || fabsf(v) > 3000.0f) return false;   // cabe no anel int16
+  tenths = lroundf(v * 10.0f);
+  return true;
+}
+
+static void addSample(SensorState& s, int32_t v) {
+  if (s.count == SENSOR_AVG_N) s.sum -= s.ring[s.idx];
+  else                         s.count++;
+  s.ring[s.idx] = (int16_t)v;
+  s.sum += v;
+  s.idx = (s.idx + 1) % SENSOR_AVG_N;
+  s.raw = v;
+
+  int32_t avg = (s.sum >= 0 ? s.sum + s.count / 2 : s.sum - s.count / 2) / s.count;
+  if (!s.ok || avg - s.value >= SENSOR_HYST || s.value - avg >= SENSOR_HYST) {
+    s.value = avg;
+  }
+  s.ok = true;
+}
+
+void sensorsBegin(const Config& cfg, bool rtcPresent) {
+  memset(s_sensor, 0, sizeof(s_sensor));
+  s_sensor[SENSOR_RTC].present = rtcPresent;
+  s_sensor[SENSOR_EXT].present = cfg.extPin >= 0;
+  if (rtcPresent) {
+    // uma transação travada não segura o loop além do limite
+#ifdef ESP8266
+    Wire.setClockStretchLimit(SENSOR_I2C_TIMEOUT_MS * 1000UL);
+#else
+    Wire.setTimeOut(SENSOR_I2C_TIMEOUT_MS);
+#endif
+  }
+  if (cfg.extPin >= 0) pinMode(cfg.extPin, INPUT);
+}
+
+void sensorsService(const Config& cfg) {
+  s_sensor[SENSOR_EXT].present = cfg.extPin >= 0;
+  unsigned long nowMs = millis();
+
+  for (uint8_t n = 0; n < SENSOR__COUNT; n++) {
+    uint8_t      id = (s_next + n) % SENSOR__COUNT;
+    SensorState& s  = s_sensor[id];
+    if (!s.present || (long)(nowMs - s.nextMs) < 0) continue;
+
+    int32_t       v;
+    unsigned long t0 = micros();
+    bool ok = (id == SENSOR_RTC) ? readRtc(v) : readExt(cfg, v);
+    unsigned long us = micros() - t0;
+    metricsSensorRead(id, us, ok);
+
+    if (ok) {
+      s.fails    = 0;
+      s.lastOkMs = nowMs;
+      addSample(s, v);
+    } else if (s.fails < SENSOR_FAIL_MAX && ++s.fails == SENSOR_FAIL_MAX) {
+      if (s.ok) logEvent(LOG_SENSOR_LOST, -1, 0, 0, SENSOR_NAMES[id]);
+      s.ok    = false;
+      s.count = 0;
+      s.sum   = 0;
+      s.idx   = 0;
+    }
+
+    unsigned long period = (s.fails >= SENSOR_FAIL_MAX)
+                           ? SENSOR_BACKOFF_SEC * 1000UL
+                           : (unsigned long)cfg.sensorPeriodSec * 1000UL;
+    s.nextMs = nowMs + period;
+    s_next   = (id + 1) % SENSOR__COUNT;
+    return;   // uma leitura por chamada
+  }
+}
+
+const char* sensorName(SensorId id) {
+  return SENSOR_NAMES[id];
+}
+
+bool sensorValue(SensorId id, int32_t& tenths) {
+  const SensorState& s = s_sensor[id];
+  if (!s.present || !s.ok) return false;
+  tenths = s.value;
+  return true;
+}
+
+void sensorsToJson(JsonObject dst) {
+  unsigned long nowMs = millis();
+  for (uint8_t id = 0; id < SENSOR__COUNT; id++) {
+    const SensorState& s = s_sensor[id];
+    if (!s.present) continue;
+    JsonObject o = dst.createNestedObject(SENSOR_NAMES[id]);
+    o["ok"] = s.ok;
+    if (!s.ok) continue;
+    o["value"] = s.value / 10.0f;
+    o["raw"]   = s.raw / 10.0f;
+    o["age_s"] = (nowMs - s.lastOkMs) / 1000UL;
+  }
+}
@@ -0,0 +1,45 @@
+// sensors.h
+#ifndef SENSORS_H
+#define SENSORS_H
+
+#include "config.h"
+#include <ArduinoJson.h>
+
+// Amostragem de sensores sem bloquear o loop: no máximo uma leitura por
+// chamada de sensorsService() (rodízio entre os sensores vencidos), cada
+// uma curta e medida (I2C: 2 bytes do DS3231; ADC: um analogRead).
+// Filtro: média móvel de SENSOR_AVG_N amostras num anel fixo, seguida de
+// histerese de SENSOR_HYST décimos (o valor publicado só muda quando a
+// média se afasta dele pelo menos isso). Valores em décimos (°C × 10 para
+// o DS3231; unidade configurada × 10 para a entrada analógica).
+// Após SENSOR_FAIL_MAX falhas seguidas o sensor fica inválido e passa a
+// ser tentado a cada SENSOR_BACKOFF_SEC.
+
+enum SensorId : uint8_t {
+  SENSOR_RTC = 0,   // temperatura interna do DS3231 (variável `temp`)
+  SENSOR_EXT,       // entrada analógica com escala linear (variável `ext`)
+  SENSOR__COUNT
+};
+
+static constexpr uint8_t  SENSOR_AVG_N        = 8;
+static constexpr int32_t  SENSOR_HYST         = 3;
+static constexpr uint8_t  SENSOR_FAIL_MAX     = 3;
+static constexpr uint16_t SENSOR_BACKOFF_SEC  = 60;
+static constexpr uint16_t SENSOR_MIN_PERIOD   = 1;
+static constexpr uint16_t SENSOR_MAX_PERIOD   = 3600;
+
+// rtcPresent: DS3231 detectado no barramento (Wire já iniciado)
+void sensorsBegin(const Config& cfg, bool rtcPresent);
+
+// No loop: lê no máximo um sensor vencido.
+void sensorsService(const Config& cfg);
+
+// Valor filtrado (décimos); false se o sensor está ausente ou inválido.
+bool sensorValue(SensorId id, int32_t& tenths);
+
+const char* sensorName(SensorId id);
+
+// Leituras para /status
+void sensorsToJson(JsonObject dst);
+
+#endif // SENSORS_H
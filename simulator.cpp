@@ -0,0 +1,168 @@
+// simulator.cpp
+
+#include "simulator.h"
+#include "hal.h"
+#include "schedule.h"
+#include "custom_rules.h"
+#include "tz_rules.h"
+#include "output.h"
+#include "engine.h"
+#include "sun_times.h"
+#include <TimeLib.h>
+#include <new>
+
+static String*       s_trace       = nullptr;
+static int           s_lines       = 0;
+static unsigned long s_transitions = 0;
+
+static void onTrace(time_t utc, int pin, bool on) {
+  s_transitions++;
+  if (!s_trace || s_lines >= SIM_MAX_TRACE) return;
+  time_t t = tzToLocal(utc);
+  char buf[48];
+  snprintf(buf, sizeof(buf), "%04d-%02d-%02d %02d:%02d:%02d GPIO%d %s\n",
+           year(t), month(t), day(t), hour(t), minute(t), second(t),
+           pin, on ? "LIGA" : "DESLIGA");
+  *s_trace += buf;
+  s_lines++;
+}
+
+// Estado de uma simulação entre fatias: cópia da config, estado do motor,
+// tabela solar e relógio virtual. Fora da fatia o motor global guarda o estado real.
+struct SimJob {
+  Config*       cfg;
+  ChannelState  state;
+  ScheduleTick  tick;
+  time_t        ruleCheck;
+  SunTable      sun;         // tabela solar do ano simulado (AH/AL)
+  HalSimState   hal;
+  unsigned long seconds;
+  unsigned long budgetMs;
+  int           lines;       // linhas já escritas no trace
+  SimResult     res;
+};
+
+static void jobInit(SimJob& j, Config& sim, time_t startUtc,
+                    unsigned long seconds, unsigned long budgetMs) {
+  for (int ch = 0; ch < sim.channelCount; ch++) {
+    ChannelConfig& c = sim.channels[ch];
+    for (int i = 0; i < c.scheduleCount; i++) c.schedules[i].lastFireDay = -1;
+  }
+  j.cfg       = &sim;
+  memset(&j.state, 0, sizeof(j.state));
+  j.tick      = { 0, 0 };
+  j.ruleCheck = 0;
+  j.sun.year  = 0;
+  j.hal       = { startUtc, 1, 0 };   // ms = 1: 0 é "nunca" para lastTriggerMs
+  j.seconds   = seconds;
+  j.budgetMs  = budgetMs;
+  j.lines     = 0;
+  j.res       = { 0, 0, 0, false };
+}
+
+// Avança o job por até sliceMs de tempo real trocando o estado global do
+// motor pelo do job; retorna true quando terminou (fim ou orçamento).
+static bool jobSlice(SimJob& j, unsigned long sliceMs, String& trace) {
+  // salva o estado real do motor
+  ChannelState  savedState   = chState;
+  ScheduleTick  savedTick    = scheduleTick;
+  time_t        savedCheck   = ruleLastCheck;
+  SunTable*     savedSun     = sunSwapTable(&j.sun);
+
+  chState        = j.state;
+  scheduleTick   = j.tick;
+  ruleLastCheck  = j.ruleCheck;
+
+  s_trace       = &trace;
+  s_lines       = j.lines;
+  s_transitions = j.res.transitions;
+  halSimResume(j.hal, onTrace);
+
+  unsigned long wall0 = millis();
+  unsigned long step  = 0;
+  while (j.res.simulatedSec < j.seconds) {
+    engineTick(*j.cfg);
+    halSimAdvance(1);
+    j.res.simulatedSec++;
+    // confere fatia e orçamento a cada 256 passos (millis() real)
+    if ((++step & 0xFF) == 0) {
+      unsigned long spent = millis() - wall0;
+      if (j.res.wallMs + spent >= j.budgetMs) { j.res.truncated = true; break; }
+      if (spent >= sliceMs) break;
+      yield();
+    }
+  }
+
+  halSimSave(j.hal);
+  halSimEnd();
+  j.res.wallMs     += millis() - wall0;
+  j.res.transitions = s_transitions;
+  j.lines           = s_lines;
+  s_trace           = nullptr;
+
+  // restaura o estado real
+  j.state        = chState;
+  j.tick         = scheduleTick;
+  j.ruleCheck    = ruleLastCheck;
+  chState        = savedState;
+  scheduleTick   = savedTick;
+  ruleLastCheck  = savedCheck;
+  sunSwapTable(savedSun);
+  return j.res.truncated || j.res.simulatedSec >= j.seconds;
+}
+
+SimResult simulateRun(Config& sim,
+                      time_t startUtc,
+                      unsigned long seconds,
+                      unsigned long budgetMs,
+                      String& trace) {
+#ifndef HOST_BUILD
+  if (budgetMs > SIM_MAX_BUDGET_MS) budgetMs = SIM_MAX_BUDGET_MS;
+#endif
+  SimJob* j = new SimJob;   // ChannelState é grande para a pilha do loop
+  jobInit(*j, sim, startUtc, seconds, budgetMs);
+  jobSlice(*j, budgetMs, trace);
+  SimResult res = j->res;
+  delete j;
+  return res;
+}
+
+// ===== Job fatiado =====
+
+static SimJob*     s_job      = nullptr;
+static SimJobState s_jobState = SIM_IDLE;
+static SimResult   s_jobRes   = { 0, 0, 0, false };
+static String      s_jobTrace;
+
+bool simulateStart(const Config& base, int ch, const ChannelConfig& override,
+                   time_t startUtc, unsigned long seconds, unsigned long budgetMs) {
+  if (s_job) return false;
+  if (budgetMs > SIM_MAX_BUDGET_MS) budgetMs = SIM_MAX_BUDGET_MS;
+  Config* sim = new (std::nothrow) Config(base);
+  if (!sim) return false;
+  s_job = new (std::nothrow) SimJob;
+  if (!s_job) { delete sim; return false; }
+  sim->channels[ch] = override;
+  jobInit(*s_job, *sim, startUtc, seconds, budgetMs);
+  s_jobTrace  = "";
+  s_jobRes    = s_job->res;
+  s_jobState  = SIM_RUNNING;
+  return true;
+}
+
+void simulateService() {
+  if (!s_job) return;
+  bool done = jobSlice(*s_job, SIM_SLICE_MS, s_jobTrace);
+  s_jobRes  = s_job->res;
+  if (!done) return;
+  delete s_job->cfg;
+  delete s_job;
+  s_job      = nullptr;
+  s_jobState = SIM_DONE;
+}
+
+SimJobState simulateStatus(SimResult& res, const String*& trace) {
+  res   = s_jobRes;
+  trace = &s_jobTrace;
+  return s_jobState;
+}
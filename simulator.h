@@ -0,0 +1,54 @@
+// simulator.h
+#ifndef SIMULATOR_H
+#define SIMULATOR_H
+
+#include "config.h"
+
+// Resultado de uma simulação (relógio virtual acelerado, ver hal.h)
+struct SimResult {
+  unsigned long simulatedSec;  // segundos simulados efetivamente
+  unsigned long wallMs;        // tempo real gasto
+  unsigned long transitions;   // mudanças das saídas (todos os canais)
+  bool          truncated;     // orçamento de tempo real esgotado antes do fim
+};
+
+static constexpr unsigned long SIM_MAX_BUDGET_MS = 5000;  // CPU máxima de uma simulação
+static constexpr unsigned long SIM_SLICE_MS      = 4;     // fatia por chamada de simulateService()
+static constexpr int           SIM_MAX_TRACE     = 200;   // linhas de trace
+
+// Reproduz `seconds` segundos a partir de startUtc sobre `sim`, uma cópia
+// descartável da config feita pelo chamador, executando o mesmo engineTick()
+// do loop. A saída real não é acionada e nada é persistido; o estado global
+// do motor é restaurado ao final.
+// Cada transição da saída vira uma linha "AAAA-MM-DD HH:MM:SS GPIOn LIGA|DESLIGA"
+// em `trace` (até SIM_MAX_TRACE linhas).
+// Bloqueia até o fim ou até budgetMs: usado no host (host/sim), onde o
+// orçamento não é limitado a SIM_MAX_BUDGET_MS.
+SimResult simulateRun(Config& sim,
+                      time_t startUtc,
+                      unsigned long seconds,
+                      unsigned long budgetMs,
+                      String& trace);
+
+// ===== Job fatiado (GET /simulate no dispositivo) =====
+// O dispositivo não bloqueia o loop: simulateStart() copia a config no heap
+// (com `override` no lugar do canal ch) e simulateService(), uma tarefa do
+// loop, avança no máximo SIM_SLICE_MS por chamada. Entre as fatias o motor
+// real volta a rodar com o seu próprio estado; budgetMs limita a CPU somada
+// das fatias. Um job por vez; o resultado fica até o próximo simulateStart().
+
+enum SimJobState : uint8_t {
+  SIM_IDLE = 0,   // nenhum job desde o boot
+  SIM_RUNNING,
+  SIM_DONE
+};
+
+// false se já há um job em andamento ou sem memória para a cópia
+bool simulateStart(const Config& base, int ch, const ChannelConfig& override,
+                   time_t startUtc, unsigned long seconds, unsigned long budgetMs);
+void simulateService();
+
+// Estado do job; `res` e `trace` valem o parcial durante SIM_RUNNING
+SimJobState simulateStatus(SimResult& res, const String*& trace);
+
+#endif // SIMULATOR_H
@@ -0,0 +1,261 @@
+// stats.cpp
+
+#include "stats.h"
+#include "time_utils.h"
+#include "tz_rules.h"
+#include "hal.h"
+#include "output.h"
+#include <FS.h>
+
+#ifdef ESP8266
+  #include <LittleFS.h>
+  #define FS_INSTANCE LittleFS
+#else
+  #include <SPIFFS.h>
+  #define FS_INSTANCE SPIFFS
+#endif
+
+static constexpr uint32_t STATS_MAGIC      = 0x31545453UL;   // "STT1"
+static constexpr time_t   STATS_MAX_CREDIT = 2L * 86400L;    // saltos de relógio maiores são descartados
+
+struct ChannelStats {
+  uint16_t hourSec[STATS_HOURS];
+  uint16_t hourCount[STATS_HOURS];
+  uint32_t daySec[STATS_DAYS];
+  uint16_t dayCount[STATS_DAYS];
+  uint32_t monthSec[STATS_MONTHS];
+  uint16_t monthCount[STATS_MONTHS];
+  uint32_t totalSec;
+  uint32_t totalCount;
+};
+
+// chave do bucket mais recente de cada anel (horas/dias locais desde a
+// época, ano*12 + mês-1); o bucket de uma chave k é k % tamanho
+struct StatsData {
+  uint32_t     magic;
+  uint16_t     size;
+  uint16_t     channels;
+  int32_t      hourKey;
+  int32_t      dayKey;
+  int32_t      monthKey;
+  ChannelStats ch[MAX_CHANNELS];
+};
+
+static StatsData s_data;
+static time_t    s_onUtc[MAX_CHANNELS];   // início do trecho ligado ainda não creditado
+static bool      s_dirty    = false;
+static int32_t   s_tickHour = 0;
+
+static int32_t monthKeyOf(long day) {
+  int y, m, d;
+  civilFromDays(day, y, m, d);
+  return y * 12 + (m - 1);
+}
+
+// Avança os anéis até o instante local `local`, zerando os buckets pulados
+static void advanceTo(time_t local) {
+  int32_t h  = (int32_t)(local / 3600);
+  int32_t dd = (int32_t)localEpochDay(local);
+  int32_t mo = monthKeyOf(dd);
+
+  if (h > s_data.hourKey) {
+    int32_t first = h - STATS_HOURS + 1;
+    if (first <= s_data.hourKey + 1) first = s_data.hourKey + 1;
+    for (int32_t k = first; k <= h; k++) {
+      for (int ch = 0; ch < MAX_CHANNELS; ch++) {
+        s_data.ch[ch].hourSec[k % STATS_HOURS]   = 0;
+        s_data.ch[ch].hourCount[k % STATS_HOURS] = 0;
+      }
+    }
+    s_data.hourKey = h;
+  }
+  if (dd > s_data.dayKey) {
+    int32_t first = dd - STATS_DAYS + 1;
+    if (first <= s_data.dayKey + 1) first = s_data.dayKey + 1;
+    for (int32_t k = first; k <= dd; k++) {
+      for (int ch = 0; ch < MAX_CHANNELS; ch++) {
+        s_data.ch[ch].daySec[k % STATS_DAYS]   = 0;
+        s_data.ch[ch].dayCount[k % STATS_DAYS] = 0;
+      }
+    }
+    s_data.dayKey = dd;
+  }
+  if (mo > s_data.monthKey) {
+    int32_t first = mo - STATS_MONTHS + 1;
+    if (first <= s_data.monthKey + 1) first = s_data.monthKey + 1;
+    for (int32_t k = first; k <= mo; k++) {
+      for (int ch = 0; ch < MAX_CHANNELS; ch++) {
+        s_data.ch[ch].monthSec[k % STATS_MONTHS]   = 0;
+        s_data.ch[ch].monthCount[k % STATS_MONTHS] = 0;
+      }
+    }
+    s_data.monthKey = mo;
+  }
+}
+
+// Soma sec/count aos buckets do instante local `local` (se ainda na janela)
+static void addAt(int ch, time_t local, uint32_t sec, uint16_t count) {
+  advanceTo(local);
+  int32_t h  = (int32_t)(local / 3600);
+  int32_t dd = (int32_t)localEpochDay(local);
+  int32_t mo = monthKeyOf(dd);
+  ChannelStats& c = s_data.ch[ch];
+  if (s_data.hourKey - h < STATS_HOURS) {
+    c.hourSec[h % STATS_HOURS]   += sec;
+    c.hourCount[h % STATS_HOURS] += count;
+  }
+  if (s_data.dayKey - dd < STATS_DAYS) {
+    c.daySec[dd % STATS_DAYS]   += sec;
+    c.dayCount[dd % STATS_DAYS] += count;
+  }
+  if (s_data.monthKey - mo < STATS_MONTHS) {
+    c.monthSec[mo % STATS_MONTHS]   += sec;
+    c.monthCount[mo % STATS_MONTHS] += count;
+  }
+  c.totalSec   += sec;
+  c.totalCount += count;
+  s_dirty = true;
+}
+
+// Credita [fromUtc, toUtc) dividido pelas horas locais que atravessa
+static void credit(int ch, time_t fromUtc, time_t toUtc) {
+  if (toUtc <= fromUtc) return;
+  if (toUtc - fromUtc > STATS_MAX_CREDIT) fromUtc = toUtc - STATS_MAX_CREDIT;
+  while (fromUtc < toUtc) {
+    time_t local = tzToLocal(fromUtc);
+    time_t seg   = (local / 3600 + 1) * 3600 - local;
+    if (seg > toUtc - fromUtc) seg = toUtc - fromUtc;
+    addAt(ch, local, (uint32_t)seg, 0);
+    fromUtc += seg;
+  }
+}
+
+void statsOnChange(int ch, bool on, time_t utc) {
+  if (halSimulating()) return;
+  if (on) {
+    s_onUtc[ch] = utc;
+    addAt(ch, tzToLocal(utc), 0, 1);
+  } else if (s_onUtc[ch]) {
+    credit(ch, s_onUtc[ch], utc);
+    s_onUtc[ch] = 0;
+  }
+}
+
+// ===== Persistência =====
+
+void statsBegin() {
+  memset(&s_data, 0, sizeof(s_data));
+  memset(s_onUtc, 0, sizeof(s_onUtc));
+  File f = FS_INSTANCE.open(STATS_PATH, "r");
+  if (!f) return;
+  bool ok = f.read((uint8_t*)&s_data, sizeof(s_data)) == sizeof(s_data) &&
+            s_data.magic == STATS_MAGIC && s_data.size == sizeof(s_data) &&
+            s_data.channels == MAX_CHANNELS;
+  f.close();
+  if (!ok) {
+    Serial.println("stats.bin inválido; estatísticas zeradas");
+    memset(&s_data, 0, sizeof(s_data));
+  }
+}
+
+static void statsSave() {
+  if (!halPersistAllowed()) return;
+  s_data.magic    = STATS_MAGIC;
+  s_data.size     = sizeof(s_data);
+  s_data.channels = MAX_CHANNELS;
+  File f = FS_INSTANCE.open(STATS_PATH, "w");
+  if (!f) {
+    Serial.println("Não foi possível gravar stats.bin");
+    return;
+  }
+  f.write((const uint8_t*)&s_data, sizeof(s_data));
+  f.close();
+  s_dirty = false;
+}
+
+// credita os trechos ligados até agora e avança os anéis
+static void flushOpen(time_t utc) {
+  for (int ch = 0; ch < MAX_CHANNELS; ch++) {
+    if (!s_onUtc[ch] || utc <= s_onUtc[ch]) continue;
+    credit(ch, s_onUtc[ch], utc);
+    s_onUtc[ch] = utc;
+  }
+  advanceTo(tzToLocal(utc));
+}
+
+void statsTick() {
+  time_t  utc  = halUtcNow();
+  int32_t hour = (int32_t)(tzToLocal(utc) / 3600);
+  if (hour == s_tickHour) return;
+  s_tickHour = hour;
+
+  flushOpen(utc);
+  if (s_dirty) statsSave();
+}
+
+// ===== JSON =====
+
+template <typename T>
+static void ringJson(String& out, const char* name, const T* ring, int size, int32_t head) {
+  out += ",\"";
+  out += name;
+  out += "\":[";
+  for (int i = 0; i < size; i++) {
+    if (i) out += ",";
+    out += String((uint32_t)ring[(head + 1 + i) % size]);
+  }
+  out += "]";
+}
+
+static void energyJson(String& out, const char* name, uint32_t sec, uint16_t watts) {
+  out += ",\"";
+  out += name;
+  out += "\":";
+  out += String((float)sec * watts / 3600.0f, 1);
+}
+
+String statsJson(const Config& cfg) {
+  String out;
+  out.reserve(128 + cfg.channelCount * 900);
+  out += "{\"channels\":[";
+  for (int ch = 0; ch < cfg.channelCount; ch++) {
+    flushOpen(halUtcNow());
+    ChannelStats c     = s_data.ch[ch];
+    int32_t      hKey  = s_data.hourKey;
+    int32_t      dKey  = s_data.dayKey;
+    int32_t      mKey  = s_data.monthKey;
+
+    uint32_t week = 0;
+    for (int i = 0; i < STATS_WEEK_DAYS; i++) {
+      week += c.daySec[(dKey - i) % STATS_DAYS];
+    }
+    uint32_t today = c.daySec[dKey % STATS_DAYS];
+    uint32_t month = c.monthSec[mKey % STATS_MONTHS];
+    uint16_t watts = cfg.channels[ch].loadWatts;
+
+    if (ch) out += ",";
+    out += "{\"ch\":" + String(ch);
+    out += ",\"on\":" + String(channelActive(ch) ? "true" : "false");
+    out += ",\"watts\":" + String(watts);
+    out += ",\"total_s\":" + String(c.totalSec);
+    out += ",\"total_count\":" + String(c.totalCount);
+    out += ",\"today_s\":" + String(today);
+    out += ",\"week_s\":" + String(week);
+    out += ",\"month_s\":" + String(month);
+    if (watts) {
+      energyJson(out, "today_wh", today, watts);
+      energyJson(out, "week_wh",  week,  watts);
+      energyJson(out, "month_wh", month, watts);
+      energyJson(out, "total_wh", c.totalSec, watts);
+    }
+    ringJson(out, "hours",        c.hourSec,    STATS_HOURS,  hKey);
+    ringJson(out, "hour_counts",  c.hourCount,  STATS_HOURS,  hKey);
+    ringJson(out, "days",         c.daySec,     STATS_DAYS,   dKey);
+    ringJson(out, "day_counts",   c.dayCount,   STATS_DAYS,   dKey);
+    ringJson(out, "months",       c.monthSec,   STATS_MONTHS, mKey);
+    ringJson(out, "month_counts", c.monthCount, STATS_MONTHS, mKey);
+    out += "}";
+  }
+  out += "]}";
+  return out;
+}
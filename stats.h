@@ -0,0 +1,35 @@
+// stats.h
+#ifndef STATS_H
+#define STATS_H
+
+#include "config.h"
+
+// Tempo ligado e ativações por canal, em buckets circulares de hora, dia e
+// mês locais (mais totais). outputOn/outputOff alimentam o acumulador: a
+// ativação conta no bucket do instante em que liga e o intervalo ligado é
+// creditado ao desligar (e a cada virada de hora, para saídas que ficam
+// ligadas), dividido nas horas locais que atravessa. Os buckets avançam
+// com o relógio e os que saem da janela são zerados; nada de histórico é
+// varrido. Gravado em STATS_PATH no máximo uma vez por hora.
+
+static constexpr char STATS_PATH[]  = "/stats.bin";
+static constexpr int  STATS_HOURS   = 24;
+static constexpr int  STATS_DAYS    = 31;
+static constexpr int  STATS_MONTHS  = 12;
+static constexpr int  STATS_WEEK_DAYS = 7;
+static constexpr int  STATS_MAX_WATTS = 20000;
+
+// Carrega STATS_PATH (FS já montado por loadConfig)
+void statsBegin();
+
+// Chamado do loop via outputNote() (fora de halLock()); ignora a simulação.
+void statsOnChange(int ch, bool on, time_t utc);
+
+// No loop: na virada da hora credita as saídas ligadas, avança os buckets
+// e grava se algo mudou.
+void statsTick();
+
+// Buckets do mais antigo ao atual; Wh pela carga configurada (loadWatts).
+String statsJson(const Config& cfg);
+
+#endif // STATS_H
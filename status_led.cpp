@@ -0,0 +1,174 @@
+// status_led.cpp
+
+#include "status_led.h"
+#include "hal.h"
+#ifndef ESP8266
+#include <Ticker.h>
+#endif
+
+#ifdef ESP8266
+  #include <ESP8266WiFi.h>
+#else
+  #include <WiFi.h>
+#endif
+
+// bit i aceso no passo i (LSB primeiro)
+struct LedPattern {
+  uint32_t bits;
+  uint8_t  len;
+};
+
+static const LedPattern PAT_CONNECTED = { 0x00000001UL, 1 };   // aceso fixo
+static const LedPattern PAT_NO_WIFI   = { 0x000003FFUL, 20 };  // 1 s / 1 s
+static const LedPattern PAT_OUTPUT    = { 0x00000003UL, 4 };   // 200 ms / 200 ms
+static const LedPattern PAT_RULES     = { 0x3FFFFFFEUL, 30 };  // aceso, apaga 100 ms a cada 3 s
+
+static int               s_pin       = -1;
+static bool              s_activeLow = true;
+#ifdef ESP8266
+static uint8_t           s_tickDiv   = 0;     // ticks do hal desde o último passo
+#else
+static Ticker            s_ticker;
+#endif
+
+static volatile uint8_t  s_flags     = 0;
+static volatile uint8_t  s_error     = LED_ERR_NONE;
+static volatile uint32_t s_bits      = 0;
+static volatile uint8_t  s_len       = 1;
+static volatile uint8_t  s_step      = 0;
+
+#ifdef ESP8266
+static WiFiEventHandler  s_onGotIp, s_onDisconnect;
+#else
+static portMUX_TYPE      s_mux       = portMUX_INITIALIZER_UNLOCKED;
+#endif
+
+// Seção crítica própria (não halLock(): esta é desligada sob o simulador,
+// e os eventos de Wi-Fi e o passo do padrão continuam chegando nesse
+// intervalo). ESP8266: núcleo único e passo na interrupção do timer1,
+// basta mascarar interrupções; ESP32: o Ticker e os
+// eventos de Wi-Fi rodam em outras tarefas, possivelmente no outro núcleo.
+static uint32_t IRAM_ATTR ledLock() {
+#ifdef ESP8266
+  return xt_rsil(15);
+#else
+  portENTER_CRITICAL(&s_mux);
+  return 0;
+#endif
+}
+
+static void IRAM_ATTR ledUnlock(uint32_t ps) {
+#ifdef ESP8266
+  xt_wsr_ps(ps);
+#else
+  (void)ps;
+  portEXIT_CRITICAL(&s_mux);
+#endif
+}
+
+// N piscadas de 200 ms e pausa de 1,2 s
+static LedPattern errorPattern(uint8_t code) {
+  LedPattern p = { 0, 0 };
+  for (uint8_t i = 0; i < code && i < 4; i++) {
+    p.bits |= 0x3UL << p.len;
+    p.len  += 4;
+  }
+  p.len += 12;
+  return p;
+}
+
+// escolhe o padrão apenas quando algum estado muda (sob ledLock())
+static void selectPattern() {
+  LedPattern p;
+  uint8_t f = s_flags;
+  if (s_error != LED_ERR_NONE)  p = errorPattern(s_error);
+  else if (f & LED_F_OUTPUT)    p = PAT_OUTPUT;
+  else if (!(f & LED_F_WIFI))   p = PAT_NO_WIFI;
+  else if (f & LED_F_RULES)     p = PAT_RULES;
+  else                          p = PAT_CONNECTED;
+
+  if (p.bits == s_bits && p.len == s_len) return;
+  s_bits = p.bits;
+  s_len  = p.len;
+  s_step = 0;
+}
+
+static void IRAM_ATTR onStep() {
+  uint32_t ps   = ledLock();
+  uint8_t  step = s_step;
+  bool     on   = (s_bits >> step) & 1UL;
+  s_step = (step + 1 < s_len) ? step + 1 : 0;
+  ledUnlock(ps);
+  digitalWrite(s_pin, (on != s_activeLow) ? HIGH : LOW);
+}
+
+#ifdef ESP8266
+// interrupção do timer1 a cada HAL_TICK_MS: um passo a cada LED_STEP_MS
+static void IRAM_ATTR onHalTick() {
+  if (++s_tickDiv < LED_STEP_MS / HAL_TICK_MS) return;
+  s_tickDiv = 0;
+  onStep();
+}
+#endif
+
+void ledBegin(int pin, bool activeLow) {
+  s_pin       = pin;
+  s_activeLow = activeLow;
+  pinMode(pin, OUTPUT);
+  digitalWrite(pin, activeLow ? HIGH : LOW);
+
+  // eventos de Wi-Fi em vez de WiFi.status() a cada loop
+#ifdef ESP8266
+  s_onGotIp      = WiFi.onStationModeGotIP([](const WiFiEventStationModeGotIP&) {
+    ledSetFlag(LED_F_WIFI, true);
+  });
+  s_onDisconnect = WiFi.onStationModeDisconnected([](const WiFiEventStationModeDisconnected&) {
+    ledSetFlag(LED_F_WIFI, false);
+  });
+#else
+  WiFi.onEvent([](WiFiEvent_t, WiFiEventInfo_t) { ledSetFlag(LED_F_WIFI, true);  },
+               ARDUINO_EVENT_WIFI_STA_GOT_IP);
+  WiFi.onEvent([](WiFiEvent_t, WiFiEventInfo_t) { ledSetFlag(LED_F_WIFI, false); },
+               ARDUINO_EVENT_WIFI_STA_DISCONNECTED);
+#endif
+  ledSetFlag(LED_F_WIFI, WiFi.status() == WL_CONNECTED);
+
+  uint32_t ps = ledLock();
+  selectPattern();
+  ledUnlock(ps);
+#ifdef ESP8266
+  halTickAttach(onHalTick);
+#else
+  s_ticker.attach_ms(LED_STEP_MS, onStep);
+#endif
+}
+
+// Leitura, alteração e troca de padrão numa só seção crítica: um evento de
+// Wi-Fi e a saída mudando ao mesmo tempo não perdem um ao outro.
+void ledSetFlag(LedFlag flag, bool on) {
+  uint32_t ps = ledLock();
+  uint8_t  f  = on ? (s_flags | flag) : (s_flags & ~flag);
+  if (f != s_flags) {
+    s_flags = f;
+    if (s_pin >= 0) selectPattern();
+  }
+  ledUnlock(ps);
+}
+
+void ledSetError(LedError code) {
+  uint32_t ps = ledLock();
+  if (code != s_error) {
+    s_error = code;
+    if (s_pin >= 0) selectPattern();
+  }
+  ledUnlock(ps);
+}
+
+void ledClearError(LedError code) {
+  uint32_t ps = ledLock();
+  if (code == s_error) {
+    s_error = LED_ERR_NONE;
+    if (s_pin >= 0) selectPattern();
+  }
+  ledUnlock(ps);
+}
@@ -0,0 +1,38 @@
+// status_led.h
+#ifndef STATUS_LED_H
+#define STATUS_LED_H
+
+#include <Arduino.h>
+
+// LED de status dirigido por timer, não pelo loop: no ESP8266 o tick do
+// timer1 dividido com o botão (hal.h), no ESP32 um Ticker (esp_timer).
+// Cada padrão é uma sequência de bits tocada a LED_STEP_MS por passo; o
+// padrão só é trocado quando um dos estados abaixo muda (eventos de Wi-Fi,
+// saída ligada/desligada, regras, erros). Prioridade, da maior para a menor:
+//   erro > saída ativa > sem Wi-Fi > regras armadas > conectado
+
+static constexpr uint32_t LED_STEP_MS = 100;
+
+enum LedFlag : uint8_t {
+  LED_F_WIFI   = 1 << 0,   // conectado
+  LED_F_OUTPUT = 1 << 1,   // saída ativa
+  LED_F_RULES  = 1 << 2    // regras customizadas ativas
+};
+
+// Códigos de erro: N piscadas curtas seguidas de pausa
+enum LedError : uint8_t {
+  LED_ERR_NONE  = 0,
+  LED_ERR_CLOCK = 1,   // sem NTP e sem RTC válido: hora desconhecida
+  LED_ERR_FS    = 2    // falha ao gravar a configuração
+};
+
+// activeLow: LED acende com LOW (placas ESP8266/Sonoff)
+void ledBegin(int pin, bool activeLow);
+
+// Seguros em timer/callbacks (só operações inteiras, em seção crítica)
+void ledSetFlag(LedFlag flag, bool on);
+void ledSetError(LedError code);
+// Apaga o erro só se ainda for `code` (outro erro posterior permanece)
+void ledClearError(LedError code);
+
+#endif // STATUS_LED_H
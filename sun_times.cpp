@@ -0,0 +1,133 @@
+// sun_times.cpp
+
+#include "sun_times.h"
+#include "time_utils.h"
+#include "hal.h"
+#include "logbuf.h"
+#include <math.h>
+#include <FS.h>
+
+#ifdef ESP8266
+  #include <LittleFS.h>
+  #define FS_INSTANCE LittleFS
+#else
+  #include <SPIFFS.h>
+  #define FS_INSTANCE SPIFFS
+#endif
+
+static constexpr uint32_t SUN_MAGIC = 0x314E5553UL;   // "SUN1"
+
+struct SunFileHeader {
+  uint32_t magic;
+  int16_t  year;
+  int16_t  days;
+  float    lat;
+  float    lon;
+};
+
+static bool    s_hasLocation = false;
+static float   s_lat         = 0;
+static float   s_lon         = 0;
+static SunTable  s_table;                  // tabela do motor real
+static SunTable* s_tab       = &s_table;   // tabela em uso
+
+// NOAA (equação do tempo e declinação por série de Fourier)
+static void computeDay(long epochDay, int16_t& rise, int16_t& set) {
+  int y, m, d;
+  civilFromDays(epochDay, y, m, d);
+  bool  leap  = (y % 4 == 0 && y % 100 != 0) || y % 400 == 0;
+  float doy   = (float)calculateDayOfYear(y, m, d);
+  float gamma = 2.0f * (float)M_PI / (leap ? 366.0f : 365.0f) * (doy - 1.0f);
+
+  float eqtime = 229.18f * (0.000075f + 0.001868f * cosf(gamma) - 0.032077f * sinf(gamma)
+                            - 0.014615f * cosf(2 * gamma) - 0.040849f * sinf(2 * gamma));
+  float decl   = 0.006918f - 0.399912f * cosf(gamma) + 0.070257f * sinf(gamma)
+               - 0.006758f * cosf(2 * gamma) + 0.000907f * sinf(2 * gamma)
+               - 0.002697f * cosf(3 * gamma) + 0.00148f * sinf(3 * gamma);
+
+  float latR  = s_lat * (float)M_PI / 180.0f;
+  float zen   = 90.833f * (float)M_PI / 180.0f;    // refração + raio do disco
+  float cosHa = cosf(zen) / (cosf(latR) * cosf(decl)) - tanf(latR) * tanf(decl);
+  if (cosHa > 1.0f || cosHa < -1.0f) {
+    rise = set = SUN_NEVER;
+    return;
+  }
+  float ha   = acosf(cosHa) * 180.0f / (float)M_PI;
+  float noon = 720.0f - 4.0f * s_lon - eqtime;
+  rise = (int16_t)lroundf(noon - 4.0f * ha);
+  set  = (int16_t)lroundf(noon + 4.0f * ha);
+}
+
+static bool loadCache(int year) {
+  File f = FS_INSTANCE.open(SUN_CACHE_PATH, "r");
+  if (!f) return false;
+  SunFileHeader h;
+  bool ok = f.read((uint8_t*)&h, sizeof(h)) == sizeof(h) &&
+            h.magic == SUN_MAGIC && h.year == year && h.days == SUN_TABLE_DAYS &&
+            h.lat == s_lat && h.lon == s_lon &&
+            f.read((uint8_t*)s_tab->rise, sizeof(s_tab->rise)) == sizeof(s_tab->rise) &&
+            f.read((uint8_t*)s_tab->set,  sizeof(s_tab->set))  == sizeof(s_tab->set);
+  f.close();
+  return ok;
+}
+
+static void saveCache(int year) {
+  if (!halPersistAllowed()) return;
+  File f = FS_INSTANCE.open(SUN_CACHE_PATH, "w");
+  if (!f) return;
+  SunFileHeader h = { SUN_MAGIC, (int16_t)year, SUN_TABLE_DAYS, s_lat, s_lon };
+  f.write((const uint8_t*)&h, sizeof(h));
+  f.write((const uint8_t*)s_tab->rise, sizeof(s_tab->rise));
+  f.write((const uint8_t*)s_tab->set,  sizeof(s_tab->set));
+  f.close();
+}
+
+static void ensureYear(int year) {
+  SunTable& t = *s_tab;
+  if (t.year == year && t.lat == s_lat && t.lon == s_lon) return;
+  t.firstDay = daysFromCivil(year, 1, 1) - 1;
+  t.year     = year;
+  t.lat      = s_lat;
+  t.lon      = s_lon;
+  // também sob simulação: ler não altera nada e poupa o cálculo num job
+  // no ano do cache (gravar, não: saveCache)
+  if (loadCache(year)) return;
+
+  unsigned long t0 = millis();
+  for (int i = 0; i < SUN_TABLE_DAYS; i++) computeDay(t.firstDay + i, t.rise[i], t.set[i]);
+  logEvent(LOG_SUN_TABLE, -1, year, (int32_t)(millis() - t0));
+  saveCache(year);
+}
+
+SunTable* sunSwapTable(SunTable* t) {
+  SunTable* prev = s_tab;
+  s_tab = t;
+  return prev;
+}
+
+void sunSetLocation(float lat, float lon) {
+  s_lat         = lat;
+  s_lon         = lon;
+  s_hasLocation = true;
+  s_tab->year   = 0;   // outras tabelas comparam lat/lon em ensureYear()
+}
+
+bool sunHasLocation() {
+  return s_hasLocation;
+}
+
+bool sunEventUtc(long localDay, SunEvent ev, time_t& utc) {
+  if (!s_hasLocation) return false;
+  long idx = localDay - s_tab->firstDay;
+  if (s_tab->year == 0 || idx < 0 || idx >= SUN_TABLE_DAYS ||
+      s_tab->lat != s_lat || s_tab->lon != s_lon) {
+    int y, m, d;
+    civilFromDays(localDay, y, m, d);
+    ensureYear(y);
+    idx = localDay - s_tab->firstDay;
+  }
+  int16_t min = (ev == SUN_RISE) ? s_tab->rise[idx] : s_tab->set[idx];
+  if (min == SUN_NEVER) return false;
+  utc = (time_t)localDay * 86400L + (long)min * 60L;
+  return true;
+}
@@ -0,0 +1,47 @@
+// sun_times.h
+#ifndef SUN_TIMES_H
+#define SUN_TIMES_H
+
+#include <Arduino.h>
+#include <time.h>
+
+// Nascer/pôr do sol para as regras AH(sunset-00:20) / AL(sunrise+01:00).
+// Os horários do ano inteiro (de 31/12 do ano anterior a 01/01 do seguinte)
+// são calculados uma vez (NOAA, ~1–2 min de precisão) numa tabela de
+// minutos desde 00:00 UTC de cada data, gravada em SUN_CACHE_PATH. A
+// tabela só é refeita na virada do ano ou quando a localização muda; a
+// consulta por tick é um acesso a array, sem ponto flutuante.
+
+static constexpr char    SUN_CACHE_PATH[] = "/sun.bin";
+static constexpr int     SUN_TABLE_DAYS   = 368;     // 31/12 anterior + ano + 01/01 seguinte
+static constexpr int16_t SUN_NEVER        = INT16_MIN;  // sol não nasce/põe (polar)
+
+enum SunEvent : uint8_t {
+  SUN_RISE = 0,
+  SUN_SET  = 1
+};
+
+// Tabela de um ano. O simulador guarda a sua no job e a troca pela do
+// motor durante cada fatia (sunSwapTable), para que uma simulação em outro
+// ano não refaça a tabela real a cada fatia, nem o contrário.
+struct SunTable {
+  int     year;                  // 0 = nenhuma
+  long    firstDay;              // dia-época de rise[0] (31/12 anterior)
+  float   lat, lon;              // localização usada no cálculo
+  int16_t rise[SUN_TABLE_DAYS];  // minutos desde 00:00 UTC da data
+  int16_t set[SUN_TABLE_DAYS];
+};
+
+// Passa a usar `t` (year = 0 para começar vazia); retorna a tabela anterior.
+SunTable* sunSwapTable(SunTable* t);
+
+// Define a localização (graus; sul e oeste negativos) e invalida a tabela.
+void sunSetLocation(float lat, float lon);
+bool sunHasLocation();
+
+// Instante UTC do evento na data local `localDay` (dia-época). Recalcula a
+// tabela (e regrava o cache) só se a data cair fora do ano carregado.
+// false sem localização ou se o evento não ocorre nesse dia.
+bool sunEventUtc(long localDay, SunEvent ev, time_t& utc);
+
+#endif // SUN_TIMES_H
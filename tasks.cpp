@@ -0,0 +1,151 @@
+// tasks.cpp
+
+#include "tasks.h"
+
+struct Task {
+  const char*   name;
+  TaskFn        fn;
+  unsigned long periodMs;
+  unsigned long deadlineMs;
+  unsigned long dueMs;
+  bool          wake;        // dueMs veio de taskWakeIn()
+  uint8_t       prio;
+  // contabilidade
+  uint32_t      runs;
+  uint32_t      misses;
+  uint32_t      maxUs;
+  uint32_t      maxLateMs;
+  uint64_t      cpuUs;
+};
+
+static Task          s_task[TASK_MAX];
+static uint8_t       s_count   = 0;
+static uint64_t      s_idleUs  = 0;
+static unsigned long s_sinceMs = 0;   // início da contabilidade
+
+int taskAdd(const char* name, TaskFn fn, unsigned long periodMs, TaskPrio prio,
+            unsigned long deadlineMs) {
+  if (s_count >= TASK_MAX || !fn) return -1;
+  Task& t = s_task[s_count];
+  memset(&t, 0, sizeof(t));
+  t.name       = name;
+  t.fn         = fn;
+  t.periodMs   = periodMs ? periodMs : 1;
+  t.deadlineMs = deadlineMs ? deadlineMs : t.periodMs;
+  t.dueMs      = millis() + t.periodMs;
+  t.prio       = prio;
+  return s_count++;
+}
+
+void taskSetPeriod(int id, unsigned long periodMs) {
+  if (id < 0 || id >= s_count) return;
+  Task& t = s_task[id];
+  t.periodMs = periodMs ? periodMs : 1;
+  if (!t.wake && (long)(t.dueMs - (millis() + t.periodMs)) > 0) t.dueMs = millis() + t.periodMs;
+}
+
+void taskWakeIn(int id, unsigned long ms) {
+  if (id < 0 || id >= s_count) return;
+  s_task[id].dueMs = millis() + ms;
+  s_task[id].wake  = true;
+}
+
+// Vencida de maior prioridade; no empate, a mais atrasada.
+static int pickDue(unsigned long nowMs) {
+  int pick = -1;
+  for (uint8_t i = 0; i < s_count; i++) {
+    const Task& t = s_task[i];
+    if ((long)(nowMs - t.dueMs) < 0) continue;
+    if (pick < 0 || t.prio < s_task[pick].prio ||
+        (t.prio == s_task[pick].prio && (long)(t.dueMs - s_task[pick].dueMs) < 0)) {
+      pick = i;
+    }
+  }
+  return pick;
+}
+
+static void runTask(Task& t, unsigned long nowMs) {
+  unsigned long late = nowMs - t.dueMs;
+  if (late > t.maxLateMs) t.maxLateMs = late;
+  if (late > t.deadlineMs) t.misses++;
+
+  // agenda antes de executar: a tarefa pode chamar taskWakeIn()
+  if (t.wake) {
+    t.wake  = false;
+    t.dueMs = nowMs;
+  }
+  t.dueMs += t.periodMs;
+  if ((long)(nowMs - t.dueMs) >= 0) t.dueMs = nowMs + t.periodMs;   // não acumula
+
+  uint32_t t0 = micros();
+  t.fn();
+  uint32_t us = micros() - t0;
+  t.runs++;
+  t.cpuUs += us;
+  if (us > t.maxUs) t.maxUs = us;
+}
+
+void tasksRun() {
+  if (!s_sinceMs) s_sinceMs = millis();
+
+  // uma passada: cada tarefa vencida no máximo uma vez, depois devolve o
+  // controle ao core (WiFi/watchdog no ESP8266)
+  for (uint8_t n = 0; n < s_count; n++) {
+    unsigned long nowMs = millis();
+    int i = pickDue(nowMs);
+    if (i < 0) break;
+    runTask(s_task[i], nowMs);
+  }
+
+  // nada vencido: dorme até a próxima
+  unsigned long nowMs = millis();
+  unsigned long wait  = TASK_IDLE_MAX_MS;
+  for (uint8_t i = 0; i < s_count; i++) {
+    long d = (long)(s_task[i].dueMs - nowMs);
+    if (d <= 0) return;
+    if ((unsigned long)d < wait) wait = d;
+  }
+  uint32_t t0 = micros();
+  delay(wait);
+  s_idleUs += micros() - t0;
+}
+
+void tasksReset() {
+  for (uint8_t i = 0; i < s_count; i++) {
+    Task& t = s_task[i];
+    t.runs = t.misses = t.maxUs = t.maxLateMs = 0;
+    t.cpuUs = 0;
+  }
+  s_idleUs  = 0;
+  s_sinceMs = millis();
+}
+
+static String pct(uint64_t partUs, uint64_t totalUs) {
+  return totalUs ? String((float)(partUs * 100.0 / totalUs), 2) : String("0");
+}
+
+String tasksJson() {
+  static const char* const PRIO[] = { "high", "normal", "low" };
+  uint64_t totalUs = (uint64_t)(millis() - s_sinceMs) * 1000ULL;
+  String out;
+  out.reserve(128 + s_count * 180);
+  out += "{\"window_ms\":" + String(millis() - s_sinceMs);
+  out += ",\"idle_pct\":" + pct(s_idleUs, totalUs);
+  out += ",\"tasks\":[";
+  for (uint8_t i = 0; i < s_count; i++) {
+    const Task& t = s_task[i];
+    if (i) out += ",";
+    out += "{\"name\":\"" + String(t.name) + "\"";
+    out += ",\"prio\":\"" + String(PRIO[t.prio <= TASK_LOW ? t.prio : TASK_LOW]) + "\"";
+    out += ",\"period_ms\":" + String(t.periodMs);
+    out += ",\"deadline_ms\":" + String(t.deadlineMs);
+    out += ",\"runs\":" + String(t.runs);
+    out += ",\"cpu_pct\":" + pct(t.cpuUs, totalUs);
+    out += ",\"avg_us\":" + String(t.runs ? (uint32_t)(t.cpuUs / t.runs) : 0);
+    out += ",\"max_us\":" + String(t.maxUs);
+    out += ",\"max_late_ms\":" + String(t.maxLateMs);
+    out += ",\"misses\":" + String(t.misses) + "}";
+  }
+  out += "]}";
+  return out;
+}
@@ -0,0 +1,44 @@
+// tasks.h
+#ifndef TASKS_H
+#define TASKS_H
+
+#include <Arduino.h>
+
+// Executor cooperativo do loop(). Cada subsistema registra uma tarefa com
+// período, prioridade e prazo; tasksRun() executa as vencidas (maior
+// prioridade primeiro, depois a mais atrasada) e, sem nada vencido, dorme
+// com delay() até a próxima, no máximo TASK_IDLE_MAX_MS.
+// Períodos são de taxa fixa: um atraso não acumula execuções, apenas conta
+// como perda de prazo quando o início passa de `deadlineMs` após o previsto.
+// Cada tarefa acumula execuções, tempo de CPU (µs), pior duração e pior
+// atraso; GET /tasks expõe os números e a fração ociosa do loop.
+
+typedef void (*TaskFn)();
+
+enum TaskPrio : uint8_t {
+  TASK_HIGH = 0,   // motor, HTTP, controle
+  TASK_NORMAL,     // rede
+  TASK_LOW         // manutenção
+};
+
+static constexpr uint8_t       TASK_MAX         = 16;
+static constexpr unsigned long TASK_IDLE_MAX_MS = 10;
+
+// Registra (nome estático); primeira execução após um período.
+// deadlineMs = 0 usa o próprio período. Retorna o id (-1 se a tabela encheu).
+int taskAdd(const char* name, TaskFn fn, unsigned long periodMs, TaskPrio prio,
+            unsigned long deadlineMs = 0);
+
+void taskSetPeriod(int id, unsigned long periodMs);
+
+// Próxima execução daqui a `ms` (só a próxima; depois volta ao período).
+// Chamado pela própria tarefa para acordar num instante preciso.
+void taskWakeIn(int id, unsigned long ms);
+
+// Única chamada do loop().
+void tasksRun();
+
+void   tasksReset();
+String tasksJson();
+
+#endif // TASKS_H
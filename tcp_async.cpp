@@ -0,0 +1,100 @@
+// tcp_async.cpp
+
+#include "tcp_async.h"
+
+// ===== Callbacks (contexto da pilha TCP) =====
+
+static void onConnect(void* arg, AsyncClient*) {
+  TcpConn* c = (TcpConn*)arg;
+  if (c->state == TCP_CONNECTING) c->state = TCP_OPEN;
+}
+
+static void onGone(void* arg, AsyncClient*) {
+  TcpConn* c = (TcpConn*)arg;
+  if (c->state != TCP_IDLE) c->state = TCP_CLOSED;
+}
+
+static void onError(void* arg, AsyncClient* client, int8_t) {
+  onGone(arg, client);
+}
+
+static void onData(void* arg, AsyncClient* client, void* data, size_t len) {
+  TcpConn*       c = (TcpConn*)arg;
+  if (c->state != TCP_OPEN) return;
+  const uint8_t* p = (const uint8_t*)data;
+  uint16_t       h = c->rxHead;
+  for (size_t i = 0; i < len; i++) {
+    uint16_t next = (h + 1) & (TCP_RX_LEN - 1);
+    if (next == c->rxTail) {          // o loop não acompanhou: derruba
+      c->overflow = true;
+      c->state    = TCP_CLOSED;
+      break;
+    }
+    c->rx[h] = p[i];
+    h        = next;
+  }
+  c->rxHead = h;
+}
+
+// ===== API (loop) =====
+
+bool tcpOpen(TcpConn& c, const char* host, uint16_t port, unsigned long timeoutMs) {
+  if (!c.hooked) {
+    c.client.onConnect(onConnect, &c);
+    c.client.onDisconnect(onGone, &c);
+    c.client.onError(onError, &c);
+    c.client.onData(onData, &c);
+    c.hooked = true;
+  }
+  tcpClose(c);
+  c.openMs    = millis();
+  c.timeoutMs = timeoutMs;
+  c.state     = TCP_CONNECTING;
+  if (!c.client.connect(host, port)) {
+    c.state = TCP_IDLE;
+    return false;
+  }
+  return true;
+}
+
+TcpState tcpPoll(TcpConn& c) {
+  if (c.state == TCP_CONNECTING && millis() - c.openMs > c.timeoutMs) {
+    c.state = TCP_CLOSED;
+    c.client.close(true);
+  }
+  return (TcpState)c.state;
+}
+
+size_t tcpWritable(TcpConn& c) {
+  return c.state == TCP_OPEN ? c.client.space() : 0;
+}
+
+bool tcpWrite(TcpConn& c, const uint8_t* data, size_t len) {
+  if (tcpWritable(c) < len) return false;
+  if (c.client.add((const char*)data, len) != len) return false;
+  return c.client.send();
+}
+
+size_t tcpAvailable(const TcpConn& c) {
+  return (uint16_t)(c.rxHead - c.rxTail) & (TCP_RX_LEN - 1U);
+}
+
+size_t tcpRead(TcpConn& c, uint8_t* buf, size_t len) {
+  size_t   n = 0;
+  uint16_t t = c.rxTail;
+  while (n < len && t != c.rxHead) {
+    buf[n++] = c.rx[t];
+    t        = (t + 1) & (TCP_RX_LEN - 1);
+  }
+  c.rxTail = t;
+  return n;
+}
+
+void tcpClose(TcpConn& c) {
+  uint8_t was = c.state;
+  c.state = TCP_IDLE;              // callbacks atrasados não mudam mais nada
+  if (was == TCP_CONNECTING || was == TCP_OPEN || c.client.connected()) c.client.close(true);
+  c.rxHead   = 0;
+  c.rxTail   = 0;
+  c.overflow = false;
+}
@@ -0,0 +1,56 @@
+// tcp_async.h
+#ifndef TCP_ASYNC_H
+#define TCP_ASYNC_H
+
+#include <Arduino.h>
+#ifdef ESP8266
+  #include <ESPAsyncTCP.h>
+#else
+  #include <AsyncTCP.h>
+#endif
+
+// Conexão TCP de cliente que não bloqueia o loop, sobre AsyncClient
+// (AsyncTCP no ESP32, ESPAsyncTCP no ESP8266): DNS, abertura e envio são
+// assíncronos. Os callbacks da pilha (task async_tcp no ESP32, contexto do
+// SDK no ESP8266) só marcam o estado e copiam os bytes recebidos num anel
+// de TCP_RX_LEN (produtor único, consumidor único); o loop consulta com
+// tcpPoll()/tcpRead() como faria com um WiFiClient, sem esperar.
+// Usado por mqtt.cpp e webhooks.cpp.
+
+static constexpr uint16_t TCP_RX_LEN = 1024;   // potência de 2
+
+enum TcpState : uint8_t {
+  TCP_IDLE = 0,
+  TCP_CONNECTING,   // DNS ou SYN em andamento
+  TCP_OPEN,
+  TCP_CLOSED        // fechada pelo par, erro, timeout de abertura ou anel cheio
+};
+
+struct TcpConn {
+  AsyncClient       client;
+  volatile uint8_t  state;
+  volatile bool     overflow;
+  uint8_t           rx[TCP_RX_LEN];
+  volatile uint16_t rxHead;
+  volatile uint16_t rxTail;
+  unsigned long     openMs;
+  unsigned long     timeoutMs;
+  bool              hooked;      // callbacks registrados
+};
+
+// Inicia a abertura; false se nem começou (ex.: sem memória para o pcb).
+// timeoutMs limita DNS + SYN, conferido em tcpPoll().
+bool     tcpOpen(TcpConn& c, const char* host, uint16_t port, unsigned long timeoutMs);
+// Estado atual; aplica o timeout de abertura.
+TcpState tcpPoll(TcpConn& c);
+// Espaço livre no buffer de envio da pilha (0 fora de TCP_OPEN).
+size_t   tcpWritable(TcpConn& c);
+// Tudo ou nada: copia `len` bytes para a pilha e envia; false sem espaço.
+bool     tcpWrite(TcpConn& c, const uint8_t* data, size_t len);
+// Bytes recebidos ainda não lidos / leitura de até `len` deles.
+size_t   tcpAvailable(const TcpConn& c);
+size_t   tcpRead(TcpConn& c, uint8_t* buf, size_t len);
+// Fecha (se aberta) e volta a TCP_IDLE, descartando o que não foi lido.
+void     tcpClose(TcpConn& c);
+
+#endif // TCP_ASYNC_H
@@ -1,6 +1,8 @@
 // time_utils.cpp
 
 #include "time_utils.h"
+#include "tz_rules.h"
+#include "hal.h"
 #include <RTClib.h>
 #include <TimeLib.h>
 
@@ -9,10 +11,10 @@
 extern RTC_DS3231 rtc;
 extern bool rtcInitialized;
 
-static constexpr int YEAR_MIN = 2000;
+static constexpr int YEAR_MIN = 2020;   // RTC sem bateria volta a 2000-01-01
 
 String formatHHMMSS(int secs) {
-  char buf[9];
+  char buf[16];   // horas podem passar de 99 (até 596523)
   formatHHMMSS(secs, buf, sizeof(buf));
   return String(buf);
 }
@@ -35,23 +37,58 @@ int parseHHMMSS(const String& s) {
   return -1;
 }
 
+time_t localNow() {
+  return tzToLocal(halUtcNow());
+}
+
 int getCurrentTimeInSec() {
-  return hour() * 3600 + minute() * 60 + second();
+  return localSecOfDay(localNow());
+}
+
+// algoritmo "days from civil" (H. Hinnant)
+long daysFromCivil(int y, int m, int d) {
+  y -= m <= 2;
+  long era = (y >= 0 ? y : y - 399) / 400;
+  long yoe = y - era * 400;
+  long doy = (153L * (m + (m > 2 ? -3 : 9)) + 2) / 5 + d - 1;
+  long doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+  return era * 146097L + doe - 719468L;
+}
+
+void civilFromDays(long days, int& y, int& m, int& d) {
+  days += 719468L;
+  long era = (days >= 0 ? days : days - 146096L) / 146097L;
+  long doe = days - era * 146097L;
+  long yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;
+  long doy = doe - (365 * yoe + yoe / 4 - yoe / 100);
+  long mp  = (5 * doy + 2) / 153;
+  d = (int)(doy - (153 * mp + 2) / 5 + 1);
+  m = (int)(mp < 10 ? mp + 3 : mp - 9);
+  y = (int)(yoe + era * 400 + (m <= 2));
 }
 
 int calculateDayOfYear(int y, int m, int d) {
-  static const int mdays[] = { 0,31,28,31,30,31,30,31,31,30,31,30,31 };
-  int days = 0;
+  // dias acumulados antes de cada mês (ano comum)
+  static const int cumDays[] = { 0,31,59,90,120,151,181,212,243,273,304,334 };
   bool leap = ( (y % 4 == 0 && y % 100 != 0) || (y % 400 == 0) );
-  for (int i = 1; i < m; ++i) {
-    days += (i == 2 && leap) ? 29 : mdays[i];
-  }
-  days += d;
-  return days;
+  return cumDays[m - 1] + d + ((leap && m > 2) ? 1 : 0);
+}
+
+long localEpochDay(time_t local) {
+  // divisão com piso: datas antes de 1970 não ocorrem, mas não custa nada
+  return (long)(local >= 0 ? local / 86400L : (local - 86399L) / 86400L);
+}
+
+int localSecOfDay(time_t local) {
+  return (int)(local - (time_t)localEpochDay(local) * 86400L);
+}
+
+long getCurrentEpochDay() {
+  return localEpochDay(localNow());
 }
 
 int getCurrentDayOfYear() {
-  time_t t = now();
+  time_t t = localNow();
   return calculateDayOfYear(year(t), month(t), day(t));
 }
 
@@ -87,22 +124,24 @@ time_t parseDateTime(const String& s) {
   return (time_t)0;
 }
 
-void syncTimeLibWithRTC() {
-  if (!rtcInitialized) return;
+bool syncTimeLibWithRTC() {
+  if (!rtcInitialized) return false;
   DateTime dt = rtc.now();
   int yr = dt.year();
   time_t nowUnix = time(nullptr);
   int curYear = year(nowUnix);
-  // valida ano
-  if (yr < YEAR_MIN || yr > curYear + 1) {
+  // valida ano (o limite superior só com o relógio do sistema já acertado:
+  // sem NTP ele ainda está em 1970 e recusaria qualquer RTC)
+  if (yr < YEAR_MIN || (curYear >= YEAR_MIN && yr > curYear + 1)) {
     Serial.printf("RTC data inválida: %04d-%02d-%02d\n", yr, dt.month(), dt.day());
-    return;
+    return false;
   }
   setTime(dt.unixtime());
+  return true;
 }
 
 String getCurrentDateTimeString() {
-  time_t t = now();
+  time_t t = localNow();
   char buf[20];
   snprintf(buf, sizeof(buf), "%04d-%02d-%02d %02d:%02d:%02d",
            year(t), month(t), day(t),
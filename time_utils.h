@@ -14,13 +14,26 @@ void   formatHHMMSS(int secs, char* buf, size_t bufSize);
 // parse "HH:MM:SS" para segundos
 int parseHHMMSS(const String& s);
 
-// retorna segundos desde meia-noite
+// hora local: TimeLib guarda UTC; o fuso vem de tz_rules (O(1) por chamada)
+time_t localNow();
+
+// retorna segundos desde meia-noite (hora local)
 int getCurrentTimeInSec();
 
+// dias desde 1970-01-01 <-> data civil (gregoriano), sem laços por mês
+long daysFromCivil(int y, int m, int d);
+void civilFromDays(long days, int& y, int& m, int& d);
+
 // calcula dia do ano (1–366)
 int calculateDayOfYear(int year, int month, int day);
 int getCurrentDayOfYear();
 
+// dia-época (dias desde 1970-01-01) e segundo do dia de um time_t local;
+// contínuos na virada de ano, base do controle "já disparou hoje"
+long localEpochDay(time_t local);
+int  localSecOfDay(time_t local);
+long getCurrentEpochDay();
+
 // converte time_t para "HH:MM:SS"
 String timeStr(const time_t &t);
 // converte time_t para "HH:MM"
@@ -29,10 +42,11 @@ String hhmmStr(const time_t &t);
 // parse "YYYY-MM-DD HH:MM" para time_t
 time_t parseDateTime(const String& s);
 
-// sincroniza TimeLib com RTC DS3231 (ignora datas inválidas)
-void syncTimeLibWithRTC();
+// sincroniza TimeLib com RTC DS3231 (RTC em UTC; ignora datas inválidas);
+// true se a hora do RTC foi aplicada
+bool syncTimeLibWithRTC();
 
-// RETORNA "YYYY-MM-DD HH:MM:SS"
+// RETORNA "YYYY-MM-DD HH:MM:SS" (hora local)
 String getCurrentDateTimeString();
 
 #endif // TIME_UTILS_H
\ No newline at end of file
@@ -0,0 +1,234 @@
+// tz_rules.cpp
+
+#include "tz_rules.h"
+#include "time_utils.h"
+#include <limits.h>
+
+// Regra de data POSIX: Jn (1–365, ignora 29/02), n (0–365) ou Mm.w.d
+struct TzDateRule {
+  char kind;      // 'J', 'N' ou 'M'
+  int  a, b, c;   // Jn/n: a=n; Mm.w.d: a=m, b=w, c=d
+  long timeSec;   // hora local da transição (padrão 02:00:00)
+};
+
+struct TzTransition {
+  time_t at;          // instante UTC da transição
+  long   offsetAfter; // offset UTC -> local após a transição
+};
+
+// ===== Estado do fuso ativo =====
+static char         s_posix[TZ_MAX_LEN] = "<-04>4";
+static long         s_stdOffset = -4L * 3600L;
+static long         s_dstOffset = -4L * 3600L;
+static bool         s_hasDst    = false;
+static TzDateRule   s_start, s_end;
+
+static TzTransition s_table[TZ_MAX_TRANSITIONS];
+static int          s_tableLen  = 0;
+static int          s_tableYear = 0;       // primeiro ano coberto pela tabela
+
+// janela de validade do offset em cache: [s_validFrom, s_validUntil)
+static time_t       s_validFrom  = 0;
+static time_t       s_validUntil = 0;
+static long         s_curOffset  = -4L * 3600L;
+
+// ===== Parser =====
+
+// nome: alfabético (>= 3 letras) ou entre < >
+static bool parseName(const char*& p) {
+  if (*p == '<') {
+    const char* q = strchr(p, '>');
+    if (!q || q - p < 4) return false;
+    p = q + 1;
+    return true;
+  }
+  const char* s = p;
+  while (isalpha((unsigned char)*p)) p++;
+  return (p - s) >= 3;
+}
+
+// [+|-]hh[:mm[:ss]] -> segundos (com sinal)
+static bool parseHms(const char*& p, long& out, int maxHours) {
+  int sign = 1;
+  if (*p == '+' || *p == '-') { if (*p == '-') sign = -1; p++; }
+  if (!isdigit((unsigned char)*p)) return false;
+  long h = 0, m = 0, s = 0;
+  while (isdigit((unsigned char)*p)) h = h * 10 + (*p++ - '0');
+  if (*p == ':') {
+    p++;
+    if (!isdigit((unsigned char)*p)) return false;
+    while (isdigit((unsigned char)*p)) m = m * 10 + (*p++ - '0');
+    if (*p == ':') {
+      p++;
+      if (!isdigit((unsigned char)*p)) return false;
+      while (isdigit((unsigned char)*p)) s = s * 10 + (*p++ - '0');
+    }
+  }
+  if (h > maxHours || m > 59 || s > 59) return false;
+  out = sign * (h * 3600L + m * 60L + s);
+  return true;
+}
+
+static bool parseInt(const char*& p, int& out) {
+  if (!isdigit((unsigned char)*p)) return false;
+  out = 0;
+  while (isdigit((unsigned char)*p)) out = out * 10 + (*p++ - '0');
+  return true;
+}
+
+static bool parseDateRule(const char*& p, TzDateRule& r) {
+  if (*p == 'M') {
+    p++;
+    r.kind = 'M';
+    if (!parseInt(p, r.a) || *p++ != '.') return false;
+    if (!parseInt(p, r.b) || *p++ != '.') return false;
+    if (!parseInt(p, r.c)) return false;
+    if (r.a < 1 || r.a > 12 || r.b < 1 || r.b > 5 || r.c > 6) return false;
+  } else if (*p == 'J') {
+    p++;
+    r.kind = 'J';
+    if (!parseInt(p, r.a) || r.a < 1 || r.a > 365) return false;
+  } else {
+    r.kind = 'N';
+    if (!parseInt(p, r.a) || r.a > 365) return false;
+  }
+  r.timeSec = 2L * 3600L;
+  if (*p == '/') {
+    p++;
+    if (!parseHms(p, r.timeSec, 167)) return false;
+  }
+  return true;
+}
+
+static bool parsePosix(const char* s, long& stdOff, long& dstOff, bool& hasDst,
+                       TzDateRule& start, TzDateRule& end) {
+  if (!s || !*s || strlen(s) >= (size_t)TZ_MAX_LEN) return false;
+  const char* p = s;
+  long off;
+
+  if (!parseName(p) || !parseHms(p, off, 24)) return false;
+  stdOff = -off;                  // POSIX: positivo a oeste de Greenwich
+  dstOff = stdOff;
+  hasDst = false;
+  if (*p == '\0') return true;
+
+  if (!parseName(p)) return false;
+  hasDst = true;
+  dstOff = stdOff + 3600L;
+  if (*p && *p != ',') {
+    if (!parseHms(p, off, 24)) return false;
+    dstOff = -off;
+  }
+
+  if (*p == '\0') {
+    // sem regras explícitas: padrão dos EUA (mesmo default da glibc)
+    start = { 'M', 3, 2, 0, 2L * 3600L };
+    end   = { 'M', 11, 1, 0, 2L * 3600L };
+    return true;
+  }
+  if (*p++ != ',' || !parseDateRule(p, start)) return false;
+  if (*p++ != ',' || !parseDateRule(p, end))   return false;
+  return *p == '\0';
+}
+
+// ===== Tabela de transições =====
+
+static bool isLeap(int y) {
+  return (y % 4 == 0 && y % 100 != 0) || (y % 400 == 0);
+}
+
+// dia (desde a época) em que a regra cai no ano y
+static long ruleDay(const TzDateRule& r, int y) {
+  long jan1 = daysFromCivil(y, 1, 1);
+  if (r.kind == 'J') {
+    int n = r.a - 1;
+    if (isLeap(y) && r.a >= 60) n++;
+    return jan1 + n;
+  }
+  if (r.kind == 'N') return jan1 + r.a;
+
+  static const int mdays[] = { 31,28,31,30,31,30,31,31,30,31,30,31 };
+  int  len   = mdays[r.a - 1] + ((r.a == 2 && isLeap(y)) ? 1 : 0);
+  long first = daysFromCivil(y, r.a, 1);
+  int  wday1 = (int)((first + 4) % 7);        // 1970-01-01 foi quinta (4)
+  long d     = first + (r.c - wday1 + 7) % 7 + (r.b - 1) * 7;
+  while (d - first >= len) d -= 7;            // w=5 -> última ocorrência
+  return d;
+}
+
+static void buildTable(int year) {
+  s_tableLen  = 0;
+  s_tableYear = year;
+  if (!s_hasDst) return;
+
+  for (int y = year; y <= year + 1; y++) {
+    // a hora de início é dada em horário padrão; a de fim em horário de verão
+    time_t on  = (time_t)ruleDay(s_start, y) * 86400L + s_start.timeSec - s_stdOffset;
+    time_t off = (time_t)ruleDay(s_end,   y) * 86400L + s_end.timeSec   - s_dstOffset;
+    TzTransition a = { on,  s_dstOffset };
+    TzTransition b = { off, s_stdOffset };
+    if (on <= off) { s_table[s_tableLen++] = a; s_table[s_tableLen++] = b; }
+    else           { s_table[s_tableLen++] = b; s_table[s_tableLen++] = a; }
+  }
+}
+
+// Recalcula a janela [s_validFrom, s_validUntil) que contém utc.
+static void refreshWindow(time_t utc) {
+  if (!s_hasDst) {
+    s_curOffset  = s_stdOffset;
+    s_validFrom  = (time_t)LONG_MIN;
+    s_validUntil = (time_t)LONG_MAX;
+    return;
+  }
+
+  int y = year(utc);
+  if (s_tableLen == 0 || y < s_tableYear || y > s_tableYear + 1) {
+    buildTable(y);
+  }
+
+  // antes da primeira transição vale o offset oposto ao dela
+  int i = 0;
+  while (i < s_tableLen && s_table[i].at <= utc) i++;
+  s_curOffset  = (i == 0) ? (s_table[0].offsetAfter == s_dstOffset ? s_stdOffset : s_dstOffset)
+                          : s_table[i - 1].offsetAfter;
+  s_validFrom  = (i == 0) ? (time_t)daysFromCivil(s_tableYear, 1, 1) * 86400L - 86400L
+                          : s_table[i - 1].at;
+  s_validUntil = (i < s_tableLen) ? s_table[i].at
+                                  : (time_t)daysFromCivil(s_tableYear + 2, 1, 1) * 86400L;
+}
+
+// ===== API =====
+
+bool tzValidate(const char* posix) {
+  long a, b; bool d; TzDateRule s, e;
+  return parsePosix(posix, a, b, d, s, e);
+}
+
+bool tzSet(const char* posix) {
+  long stdOff, dstOff; bool hasDst; TzDateRule start, end;
+  if (!parsePosix(posix, stdOff, dstOff, hasDst, start, end)) return false;
+
+  strncpy(s_posix, posix, sizeof(s_posix) - 1);
+  s_posix[sizeof(s_posix) - 1] = '\0';
+  s_stdOffset = stdOff;
+  s_dstOffset = dstOff;
+  s_hasDst    = hasDst;
+  s_start     = start;
+  s_end       = end;
+  s_tableLen  = 0;
+  s_validFrom = s_validUntil = 0;   // força recálculo no próximo acesso
+  return true;
+}
+
+const char* tzCurrent() {
+  return s_posix;
+}
+
+long tzOffsetAt(time_t utc) {
+  if (utc < s_validFrom || utc >= s_validUntil) refreshWindow(utc);
+  return s_curOffset;
+}
+
+time_t tzToLocal(time_t utc) {
+  return utc + tzOffsetAt(utc);
+}
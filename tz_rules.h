@@ -0,0 +1,43 @@
+// tz_rules.h
+#ifndef TZ_RULES_H
+#define TZ_RULES_H
+
+#include <Arduino.h>
+#include <time.h>
+
+// Fuso horário em tempo de execução a partir de uma string TZ POSIX, por exemplo:
+//   "<-04>4"                             UTC–4 fixo (padrão)
+//   "<-03>3"                             Brasília, sem horário de verão
+//   "EST5EDT,M3.2.0,M11.1.0"             EUA (leste)
+//   "CET-1CEST,M3.5.0,M10.5.0/3"         Europa central
+//
+// A string é compilada numa pequena tabela de transições UTC (ano corrente e
+// seguinte). A conversão UTC -> local a cada tick é uma comparação contra a
+// janela de validade do offset atual; a tabela só é refeita quando o relógio
+// sai da faixa coberta (virada de ano ou correção grande de relógio).
+//
+// Comportamento nos dias de transição (agendamentos em horário local, ver
+// checkSchedules):
+//  - horário pulado (ex.: 02:30 quando o relógio salta 02:00 -> 03:00):
+//    o slot dispara uma única vez, no instante da transição;
+//  - horário repetido (ex.: 01:30 quando o relógio volta 02:00 -> 01:00):
+//    o slot dispara apenas na primeira ocorrência.
+
+static constexpr int TZ_MAX_LEN         = 48;  // inclui '\0'
+static constexpr int TZ_MAX_TRANSITIONS = 4;   // 2 por ano x 2 anos
+
+// Valida e ativa uma string TZ POSIX. Retorna false (mantendo o fuso
+// anterior) se a string for inválida.
+bool tzSet(const char* posix);
+
+// Apenas valida a sintaxe, sem alterar o fuso ativo.
+bool tzValidate(const char* posix);
+
+// String TZ atualmente ativa.
+const char* tzCurrent();
+
+// Offset UTC -> local (segundos) em vigor no instante utc.
+long   tzOffsetAt(time_t utc);
+time_t tzToLocal(time_t utc);
+
+#endif // TZ_RULES_H
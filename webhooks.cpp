@@ -0,0 +1,343 @@
+// webhooks.cpp
+
+#include "webhooks.h"
+#include "events.h"
+#include "logbuf.h"
+#include "hal.h"
+#include "time_utils.h"
+#include "tcp_async.h"
+
+#ifdef ESP8266
+  #include <ESP8266WiFi.h>
+#else
+  #include <WiFi.h>
+#endif
+
+// Configuração definida em main.cpp
+extern Config cfg;
+
+struct Target {
+  bool          valid;
+  char          host[64];
+  uint16_t      port;
+  char          path[WEBHOOK_URL_LEN];
+  uint32_t      cursor;          // último evento entregue
+  uint32_t      batchEnd;        // último evento do lote em voo
+  uint8_t       batchCount;
+  unsigned long pendingSinceMs;  // primeiro evento ainda não enviado (0 = nenhum)
+  unsigned long nextMs;          // próxima tentativa após falha
+  unsigned long backoffMs;
+  bool          failing;
+
+  uint32_t      batches;
+  uint32_t      events;
+  uint32_t      failures;
+  uint32_t      dropped;
+  uint16_t      lastStatus;
+  uint32_t      lastMs;
+  uint32_t      avgMs;           // média exponencial (1/8)
+  uint32_t      maxMs;
+};
+
+enum WhState : uint8_t { WH_IDLE, WH_CONNECTING, WH_SENDING, WH_WAIT };
+
+static TcpConn       s_net;
+static String        s_req;            // pedido do POST em voo
+static size_t        s_reqOff  = 0;    // bytes já entregues à pilha
+static Target        s_target[WEBHOOK_MAX_TARGETS];
+static WhState       s_state   = WH_IDLE;
+static uint8_t       s_active  = 0;    // destino do POST em voo
+static uint8_t       s_next    = 0;    // rodízio
+static unsigned long s_startMs = 0;
+static char          s_line[32];       // linha de status da resposta
+static uint8_t       s_lineLen = 0;
+static char          s_device[16];
+
+// "http://host[:porta][/caminho]"
+static bool parseUrl(const char* url, char* host, size_t hostSize, uint16_t& port,
+                     char* path, size_t pathSize, String& err) {
+  if (strncmp(url, "http://", 7) != 0) {
+    err = strncmp(url, "https://", 8) == 0 ? "https não suportado" : "URL deve começar com http://";
+    return false;
+  }
+  const char* h     = url + 7;
+  const char* slash = strchr(h, '/');
+  const char* end   = slash ? slash : h + strlen(h);
+  const char* colon = (const char*)memchr(h, ':', end - h);
+  const char* hEnd  = colon ? colon : end;
+  if (hEnd == h || (size_t)(hEnd - h) >= hostSize) {
+    err = "Host inválido";
+    return false;
+  }
+  long p = 80;
+  if (colon) {
+    p = 0;
+    for (const char* c = colon + 1; c < end; c++) {
+      if (*c < '0' || *c > '9' || p > 65535) { p = 0; break; }
+      p = p * 10 + (*c - '0');
+    }
+    if (p < 1 || p > 65535) {
+      err = "Porta inválida";
+      return false;
+    }
+  }
+  for (const char* c = url; *c; c++) {
+    if (*c <= ' ' || *c == '"' || *c == '<') {
+      err = "Caractere inválido na URL";
+      return false;
+    }
+  }
+  memcpy(host, h, hEnd - h);
+  host[hEnd - h] = '\0';
+  port = (uint16_t)p;
+  snprintf(path, pathSize, "%s", slash ? slash : "/");
+  return true;
+}
+
+bool webhookUrlValid(const String& url, String& err) {
+  char     host[64];
+  char     path[WEBHOOK_URL_LEN];
+  uint16_t port;
+  if (url.length() >= WEBHOOK_URL_LEN) {
+    err = "URL longa demais";
+    return false;
+  }
+  return parseUrl(url.c_str(), host, sizeof(host), port, path, sizeof(path), err);
+}
+
+void webhooksReconfigure() {
+  if (s_state != WH_IDLE) tcpClose(s_net);
+  s_state = WH_IDLE;
+  s_req   = String();
+  uint32_t head = eventHead();
+  for (int i = 0; i < WEBHOOK_MAX_TARGETS; i++) {
+    Target& t = s_target[i];
+    memset(&t, 0, sizeof(t));
+    String err;
+    t.valid = cfg.webhooks[i][0] &&
+              parseUrl(cfg.webhooks[i], t.host, sizeof(t.host), t.port,
+                       t.path, sizeof(t.path), err);
+    t.cursor    = head;   // só eventos novos
+    t.backoffMs = WEBHOOK_BACKOFF_MIN_MS;
+  }
+}
+
+void webhooksBegin() {
+  String mac = WiFi.macAddress();
+  mac.replace(":", "");
+  snprintf(s_device, sizeof(s_device), "%s", mac.c_str());
+  webhooksReconfigure();
+}
+
+// Monta o lote a partir do cursor (sem avançá-lo: só avança após 2xx)
+static String buildBatch(Target& t) {
+  String body;
+  body.reserve(96 + WEBHOOK_BATCH_MAX * 96);
+  body += "{\"device\":\"";
+  body += s_device;
+  body += "\",\"dropped\":";
+  body += String(t.dropped);
+  body += ",\"events\":[";
+
+  uint32_t cur  = t.cursor;
+  uint32_t lost = 0;
+  Event    e;
+  t.batchCount = 0;
+  while (t.batchCount < WEBHOOK_BATCH_MAX && eventNext(cur, e, lost)) {
+    if (t.batchCount++) body += ",";
+    body += "{\"seq\":" + String(e.seq);
+    body += ",\"t\":" + String((long)e.utc);
+    body += ",\"ch\":" + String(e.ch);
+    body += e.type == EVT_OUTPUT ? ",\"type\":\"output\"" : ",\"type\":\"rule\"";
+    body += e.on ? ",\"on\":true" : ",\"on\":false";
+    if (e.type == EVT_OUTPUT) {
+      body += e.manual ? ",\"manual\":true" : ",\"manual\":false";
+    } else {
+      body += ",\"rule\":\"";
+      body += e.name;
+      body += "\"";
+    }
+    body += "}";
+  }
+  body += "]}";
+  t.batchEnd = cur;
+  t.dropped += lost;
+  return body;
+}
+
+static void finish(uint16_t status) {
+  Target&       t  = s_target[s_active];
+  unsigned long ms = millis() - s_startMs;
+  tcpClose(s_net);
+  s_req        = String();
+  s_state      = WH_IDLE;
+  t.lastStatus = status;
+
+  if (status >= 200 && status < 300) {
+    t.cursor         = t.batchEnd;
+    t.pendingSinceMs = 0;
+    t.backoffMs      = WEBHOOK_BACKOFF_MIN_MS;
+    t.batches++;
+    t.events += t.batchCount;
+    t.lastMs  = ms;
+    t.avgMs   = t.batches == 1 ? ms : (t.avgMs * 7 + ms) / 8;
+    if (ms > t.maxMs) t.maxMs = ms;
+    if (t.failing) logEvent(LOG_WEBHOOK_OK, -1, s_active);
+    t.failing = false;
+    return;
+  }
+
+  t.failures++;
+  if (!t.failing) {
+    if (status) logEvent(LOG_WEBHOOK_FAIL_HTTP, -1, s_active, status);
+    else        logEvent(LOG_WEBHOOK_FAIL_NORESP, -1, s_active);
+  }
+  t.failing   = true;
+  t.nextMs    = millis() + t.backoffMs;
+  t.backoffMs = t.backoffMs * 2 > WEBHOOK_BACKOFF_MAX_MS ? WEBHOOK_BACKOFF_MAX_MS : t.backoffMs * 2;
+}
+
+static void start(uint8_t i) {
+  Target& t = s_target[i];
+  s_active  = i;
+  s_startMs = millis();
+  s_lineLen = 0;
+
+  String body = buildBatch(t);
+  if (!t.batchCount) {            // nada novo (corrida com o leitor de eventHead)
+    t.cursor         = t.batchEnd;
+    t.pendingSinceMs = 0;
+    return;
+  }
+
+  s_req = String();
+  s_req.reserve(160 + strlen(t.path) + body.length());
+  s_req += "POST ";
+  s_req += t.path;
+  s_req += " HTTP/1.1\r\nHost: ";
+  s_req += t.host;
+  s_req += "\r\nContent-Type: application/json\r\nContent-Length: ";
+  s_req += String(body.length());
+  s_req += "\r\nConnection: close\r\n\r\n";
+  s_req += body;
+  s_reqOff = 0;
+
+  if (!tcpOpen(s_net, t.host, t.port, WEBHOOK_CONNECT_TIMEOUT_MS)) {
+    finish(0);   // agenda a nova tentativa
+    return;
+  }
+  s_state = WH_CONNECTING;
+}
+
+// Entrega à pilha o que couber do pedido; o resto fica para a próxima volta
+static void sendSome() {
+  size_t n = s_req.length() - s_reqOff;
+  size_t w = tcpWritable(s_net);
+  if (n > w) n = w;
+  if (n && tcpWrite(s_net, (const uint8_t*)s_req.c_str() + s_reqOff, n)) s_reqOff += n;
+  if (s_reqOff == s_req.length()) {
+    s_req   = String();
+    s_state = WH_WAIT;
+  }
+}
+
+// Lê a linha de status aos poucos: "HTTP/1.1 204 No Content"
+static void readStatus() {
+  uint8_t buf[32];
+  size_t  n;
+  while ((n = tcpRead(s_net, buf, sizeof(buf))) > 0) {
+    for (size_t i = 0; i < n; i++) {
+      if (buf[i] == '\n') {
+        s_line[s_lineLen] = '\0';
+        const char* sp = strchr(s_line, ' ');
+        finish(sp ? (uint16_t)atoi(sp + 1) : 0);
+        return;
+      }
+      if (s_lineLen < sizeof(s_line) - 1) s_line[s_lineLen++] = (char)buf[i];
+    }
+  }
+}
+
+// Avança o POST em voo uma etapa
+static void step() {
+  TcpState st = tcpPoll(s_net);
+  switch (s_state) {
+    case WH_CONNECTING:
+      if (st == TCP_CONNECTING) return;
+      if (st != TCP_OPEN) {
+        finish(0);
+        return;
+      }
+      s_net.client.setNoDelay(true);
+      s_state = WH_SENDING;
+      // fall through
+    case WH_SENDING:
+      if (st == TCP_OPEN) sendSome();
+      break;
+    case WH_WAIT:
+      readStatus();   // o que chegou antes do fechamento ainda está no anel
+      if (s_state == WH_IDLE) return;
+      break;
+    case WH_IDLE:
+      return;
+  }
+  if (s_state != WH_IDLE &&
+      (tcpPoll(s_net) != TCP_OPEN || millis() - s_startMs > WEBHOOK_RESPONSE_TIMEOUT_MS)) {
+    finish(0);
+  }
+}
+
+void webhooksService() {
+  if (s_state != WH_IDLE) {
+    step();
+    return;
+  }
+  if (WiFi.status() != WL_CONNECTED) return;
+
+  unsigned long nowMs = millis();
+  uint32_t      head  = eventHead();
+  for (uint8_t n = 0; n < WEBHOOK_MAX_TARGETS; n++) {
+    uint8_t i = (s_next + n) % WEBHOOK_MAX_TARGETS;
+    Target& t = s_target[i];
+    if (!t.valid) continue;
+    if (head == t.cursor) {
+      t.pendingSinceMs = 0;
+      continue;
+    }
+    if (!t.pendingSinceMs) t.pendingSinceMs = nowMs | 1UL;
+    // agrupa: espera mais eventos até o lote encher ou a janela fechar
+    if (head - t.cursor < WEBHOOK_BATCH_MAX && nowMs - t.pendingSinceMs < WEBHOOK_COALESCE_MS) continue;
+    if (t.failing && (long)(nowMs - t.nextMs) < 0) continue;
+
+    s_next = (i + 1) % WEBHOOK_MAX_TARGETS;
+    start(i);
+    return;   // um POST por vez
+  }
+}
+
+String webhooksJson() {
+  String   out = "{\"targets\":[";
+  uint32_t head = eventHead();
+  for (int i = 0; i < WEBHOOK_MAX_TARGETS; i++) {
+    const Target& t = s_target[i];
+    if (i) out += ",";
+    out += "{\"url\":\"";
+    out += cfg.webhooks[i];
+    out += "\",\"valid\":" + String(t.valid ? "true" : "false");
+    out += ",\"failing\":" + String(t.failing ? "true" : "false");
+    uint32_t pending = t.valid ? head - t.cursor : 0;
+    if (pending > EVENT_QUEUE_LEN) pending = EVENT_QUEUE_LEN;
+    out += ",\"pending\":"     + String(pending);
+    out += ",\"batches\":"     + String(t.batches);
+    out += ",\"events\":"      + String(t.events);
+    out += ",\"failures\":"    + String(t.failures);
+    out += ",\"dropped\":"     + String(t.dropped);
+    out += ",\"last_status\":" + String(t.lastStatus);
+    out += ",\"last_ms\":"     + String(t.lastMs);
+    out += ",\"avg_ms\":"      + String(t.avgMs);
+    out += ",\"max_ms\":"      + String(t.maxMs);
+    out += "}";
+  }
+  out += "]}";
+  return out;
+}
@@ -0,0 +1,45 @@
+// webhooks.h
+#ifndef WEBHOOKS_H
+#define WEBHOOKS_H
+
+#include "config.h"
+
+// Entrega de eventos (events.h) por HTTP POST a até WEBHOOK_MAX_TARGETS
+// destinos, sem bloquear o loop. Cada destino lê o anel de eventos com o
+// próprio cursor, que é o limite da fila: um destino fora do ar mais de
+// EVENT_QUEUE_LEN eventos atrás perde os mais antigos (contador `dropped`).
+// Eventos próximos são agrupados (WEBHOOK_COALESCE_MS, até
+// WEBHOOK_BATCH_MAX por lote) num único POST:
+//   {"device":"<MAC>","dropped":N,"events":[{"seq":..,"t":..,"ch":..,
+//    "type":"output"|"rule","on":..,"manual":..,"rule":".."}]}
+// Só um POST em voo por vez (uma TcpConn de tcp_async.h). Abertura, envio e
+// resposta são etapas da máquina de estados: cada chamada do serviço só
+// confere a conexão, escreve o que cabe no buffer da pilha ou lê o que já
+// chegou. Falha (conexão, timeout ou status fora de 2xx) reenvia o mesmo
+// lote com espera exponencial (WEBHOOK_BACKOFF_MIN_MS .. _MAX_MS).
+// Só http:// (sem TLS); DNS + abertura do TCP são limitados a
+// WEBHOOK_CONNECT_TIMEOUT_MS, o POST inteiro a WEBHOOK_RESPONSE_TIMEOUT_MS.
+
+static constexpr uint8_t       WEBHOOK_BATCH_MAX          = 8;
+static constexpr unsigned long WEBHOOK_COALESCE_MS        = 500;
+static constexpr unsigned long WEBHOOK_CONNECT_TIMEOUT_MS = 3000;
+static constexpr unsigned long WEBHOOK_RESPONSE_TIMEOUT_MS = 5000;
+static constexpr unsigned long WEBHOOK_BACKOFF_MIN_MS     = 2000;
+static constexpr unsigned long WEBHOOK_BACKOFF_MAX_MS     = 300000;
+
+// Após a rede
+void webhooksBegin();
+
+// No loop
+void webhooksService();
+
+// Após /setWebhooks: relê as URLs; entregas em curso são abandonadas.
+void webhooksReconfigure();
+
+// Valida "http://host[:porta][/caminho]"; false com mensagem em `err`.
+bool webhookUrlValid(const String& url, String& err);
+
+// Contadores por destino (latência, entregas, falhas, descartes)
+String webhooksJson();
+
+#endif // WEBHOOKS_H
@@ -188,6 +188,17 @@ const char htmlPage[] PROGMEM = R"rawliteral(
     <div id="wifiQuality">Wi‑Fi: %WIFI_QUALITY%%</div>
   </section>
 
+  <section class="card">
+    <label for="channelSelect">Canal:</label>
+    <select id="channelSelect" class="form-control" style="margin-bottom:10px;"></select>
+    <form id="channelCountForm">
+      <label for="channelCountInput">Canais em uso (1–%MAX_CHANNELS%):</label>
+      <input type="number" id="channelCountInput" value="%CHANNEL_COUNT%" min="1" max="%MAX_CHANNELS%">
+      <button type="submit" class="secondary">Salvar Canais</button>
+      <div id="channelCountMessage" class="message"></div>
+    </form>
+  </section>
+
   <section class="card">
     <button id="manualActivateOutput">Ativar Saída Agora</button>
     <button id="manualDeactivateOutput" class="warning" style="display: none;">Desativar Saída</button>
@@ -203,6 +214,102 @@ const char htmlPage[] PROGMEM = R"rawliteral(
     </form>
   </section>
 
+  <section class="card">
+    <form id="loadWattsForm">
+      <label for="loadWattsInput">Carga da Saída (W, para estimar consumo):</label>
+      <input type="number" id="loadWattsInput" min="0" max="20000" value="%WATTS%" />
+      <button type="submit">Salvar Carga</button>
+      <div id="loadWattsMessage" class="message"></div>
+    </form>
+    <p id="statsSummary"><small>Tempo ligado: carregando...</small></p>
+  </section>
+
+  <section class="card">
+    <p id="sensorReadings"><small>Sensores: carregando...</small></p>
+    <form id="sensorsForm">
+      <label for="sensorPeriodInput">Intervalo de Leitura dos Sensores (s):</label>
+      <input type="number" id="sensorPeriodInput" min="1" max="3600" value="%SENSOR_PERIOD%" />
+      <label for="extPinInput">Entrada Analógica (GPIO, -1 = desativada):</label>
+      <input type="number" id="extPinInput" value="%EXT_PIN%" />
+      <label for="extScaleInput">Escala / Offset (ext = leitura × escala + offset):</label>
+      <input type="number" id="extScaleInput" step="any" value="%EXT_SCALE%" />
+      <input type="number" id="extOffsetInput" step="any" value="%EXT_OFFSET%" />
+      <button type="submit">Salvar Sensores</button>
+      <div id="sensorsMessage" class="message"></div>
+    </form>
+  </section>
+
+  <section class="card">
+    <p id="mqttStatus"><small>MQTT: carregando...</small></p>
+    <form id="mqttForm">
+      <label><input type="checkbox" id="mqttEnabledInput" %MQTT_ENABLED% /> MQTT ativado</label>
+      <label for="mqttHostInput">Servidor / Porta:</label>
+      <input type="text" id="mqttHostInput" maxlength="63" value="%MQTT_HOST%" placeholder="192.168.0.10" />
+      <input type="number" id="mqttPortInput" min="1" max="65535" value="%MQTT_PORT%" />
+      <label for="mqttUserInput">Usuário / Senha (em branco mantém a atual):</label>
+      <input type="text" id="mqttUserInput" maxlength="31" value="%MQTT_USER%" />
+      <input type="password" id="mqttPassInput" maxlength="31" />
+      <label for="mqttPrefixInput">Tópico Base (vazio = temporizador/&lt;MAC&gt;):</label>
+      <input type="text" id="mqttPrefixInput" maxlength="47" value="%MQTT_PREFIX%" />
+      <label for="mqttQosInput">QoS (0/1) / Estado a cada (s, 0 = nunca):</label>
+      <input type="number" id="mqttQosInput" min="0" max="1" value="%MQTT_QOS%" />
+      <input type="number" id="mqttStateSecInput" min="0" max="43200" value="%MQTT_STATE_SEC%" />
+      <button type="submit">Salvar MQTT</button>
+      <div id="mqttMessage" class="message"></div>
+    </form>
+    <details>
+      <summary>Ajuda: Tópicos MQTT</summary>
+      <ul>
+        <li><code>&lt;base&gt;/state</code> (retido): saídas, regras e temperatura; <code>&lt;base&gt;/status</code>: <code>online</code>/<code>offline</code>.</li>
+        <li><code>&lt;base&gt;/&lt;canal&gt;/event</code>: cada transição de saída e disparo de regra.</li>
+        <li>Comandos em <code>&lt;base&gt;/&lt;canal&gt;/cmd/feed</code>, <code>/stop</code>, <code>/rules</code> (<code>toggle</code>, <code>on</code>, <code>off</code>) e <code>/schedules</code> (<code>HH:MM:SS|HH:MM:SS,...</code>); resposta em <code>&lt;base&gt;/&lt;canal&gt;/result</code>.</li>
+      </ul>
+    </details>
+  </section>
+
+  <section class="card">
+    <p id="webhooksStatus"><small>Webhooks: carregando...</small></p>
+    <form id="webhooksForm">
+      <label for="webhook0Input">Webhooks (POST JSON a cada transição/regra; vazio = desativado):</label>
+      <input type="text" id="webhook0Input" maxlength="95" value="%WEBHOOK0%" placeholder="http://192.168.0.10:8080/eventos" />
+      <input type="text" id="webhook1Input" maxlength="95" value="%WEBHOOK1%" />
+      <button type="submit">Salvar Webhooks</button>
+      <div id="webhooksMessage" class="message"></div>
+    </form>
+  </section>
+
+  <section class="card">
+    <p id="syncStatus"><small>Sincronismo: carregando...</small></p>
+    <form id="syncForm">
+      <label for="syncRoleInput">Sincronismo entre Unidades (UDP na rede local):</label>
+      <select id="syncRoleInput">
+        <option value="off" %SYNC_OFF_SEL%>Desligado</option>
+        <option value="leader" %SYNC_LEADER_SEL%>Líder (referência de hora)</option>
+        <option value="follower" %SYNC_FOLLOWER_SEL%>Seguidor</option>
+      </select>
+      <button type="submit">Salvar Sincronismo</button>
+      <div id="syncMessage" class="message"></div>
+    </form>
+  </section>
+
+  <section class="card">
+    <p><small>Nome na rede: <b>%HOSTNAME%.local</b></small></p>
+    <form id="beaconForm">
+      <label for="beaconSecInput">Beacon Multicast (239.255.42.99:4124, segundos; 0 = desligado):</label>
+      <input type="number" id="beaconSecInput" value="%BEACON_SEC%" min="0" max="3600">
+      <label for="beaconChInput">Canais no beacon:</label>
+      <input type="number" id="beaconChInput" value="%BEACON_CH%" min="0" max="%MAX_CHANNELS%">
+      <button type="submit">Salvar Beacon</button>
+      <div id="beaconMessage" class="message"></div>
+    </form>
+    <form id="modbusForm">
+      <label for="modbusPortInput">Modbus TCP (porta; 502 = padrão, 0 = desligado):</label>
+      <input type="number" id="modbusPortInput" value="%MODBUS_PORT%" min="0" max="65535">
+      <button type="submit">Salvar Modbus</button>
+      <div id="modbusMessage" class="message"></div>
+    </form>
+  </section>
+
   <section class="card">
     <form id="outputPinForm">
       <label for="outputPinInput">Pino de Saída (GPIO):</label>
@@ -236,6 +343,34 @@ const char htmlPage[] PROGMEM = R"rawliteral(
     </details>
   </section>
 
+  <section class="card">
+    <form id="timezoneForm">
+      <label for="timezoneInput">Fuso Horário (TZ POSIX):</label>
+      <input type="text" id="timezoneInput" value="%TZ%" maxlength="47">
+      <button type="submit">Salvar Fuso</button>
+      <div id="timezoneMessage" class="message"></div>
+    </form>
+    <form id="locationForm">
+      <label for="latInput">Latitude / Longitude (graus, regras AH/AL):</label>
+      <input type="number" id="latInput" value="%LAT%" min="-90" max="90" step="0.0001" placeholder="-23.5505">
+      <input type="number" id="lonInput" value="%LON%" min="-180" max="180" step="0.0001" placeholder="-46.6333">
+      <button type="submit">Salvar Localização</button>
+      <div id="locationMessage" class="message"></div>
+    </form>
+    <details>
+        <summary>Ajuda: Formato TZ POSIX</summary>
+        <div>
+            <ul>
+                <li><code>&lt;-04&gt;4</code>: UTC–4 fixo (padrão).</li>
+                <li><code>&lt;-03&gt;3</code>: Brasília, sem horário de verão.</li>
+                <li><code>EST5EDT,M3.2.0,M11.1.0</code>: EUA (leste), com horário de verão.</li>
+                <li><code>CET-1CEST,M3.5.0,M10.5.0/3</code>: Europa central.</li>
+            </ul>
+            <p><small>Nos dias de transição, agendamentos em horários pulados disparam no instante da mudança; em horários repetidos disparam só na primeira ocorrência.</small></p>
+        </div>
+    </details>
+  </section>
+
   <section class="card">
     <form id="scheduleForm">
       <label for="newScheduleTime">Novo Horário de Ativação (HH:MM:SS)</label>
@@ -249,6 +384,43 @@ const char htmlPage[] PROGMEM = R"rawliteral(
     <div id="scheduleFormMessage" class="message"></div>
   </section>
 
+  <section class="card">
+    <label for="exceptionsInput">Exceções (feriados/manutenção, todos os canais):</label>
+    <textarea id="exceptionsInput" rows="3" placeholder="Ex: 2026-12-25 2026-12-31=0@1">%EXCEPTIONS%</textarea>
+    <button id="saveExceptions">Salvar Exceções</button>
+    <div id="exceptionsMessage" class="message"></div>
+    <details>
+        <summary>Ajuda: Calendário de Exceções</summary>
+        <div>
+            <ul>
+                <li><code>AAAA-MM-DD</code> ou <code>AAAA-MM-DD..AAAA-MM-DD</code>: dia(s) bloqueado(s) - nenhum agendamento dispara e as regras não ligam a saída.</li>
+                <li><code>AAAA-MM-DD=0+2</code>: só os agendamentos #0 e #2 disparam nesse dia.</li>
+                <li><code>AAAA-MM-DD=07:00:00/00:00:30+17:00:00/00:01:00</code>: no lugar dos agendamentos, só estes horários (início/duração, até 4) disparam nesse dia.</li>
+                <li><code>...@1+2</code>: aplica a exceção só aos canais 1 e 2. Ex.: <code>2026-11-02@1</code>.</li>
+            </ul>
+            <p><small>Datas do ano atual até 3 anos à frente. O acionamento manual não é afetado.</small></p>
+        </div>
+    </details>
+  </section>
+
+  <section class="card">
+    <label for="programFile">Programa semanal grande (arquivo, canal selecionado):</label>
+    <input type="file" id="programFile" accept=".txt,.csv">
+    <button id="importProgram">Importar Programa</button>
+    <button id="clearProgram">Remover Programa</button>
+    <div id="programMessage" class="message"></div>
+    <details>
+        <summary>Ajuda: Programa em Arquivo</summary>
+        <div>
+            <ul>
+                <li>Uma linha por acionamento: <code>dia HH:MM:SS duração</code>, dia 0 = domingo ... 6 = sábado. Ex.: <code>1 08:00:00 00:00:30</code>.</li>
+                <li>Linhas em ordem crescente de dia e horário; linhas vazias e iniciadas por <code>#</code> são ignoradas.</li>
+            </ul>
+            <p><small>Fica na flash, fora da configuração; vale junto com os agendamentos quando as regras avançadas estão desativadas.</small></p>
+        </div>
+    </details>
+  </section>
+
   <section class="card">
     <label for="customRulesInput">Regras Avançadas (Editar):</label>
     <textarea id="customRulesInput" rows="4" placeholder="Ex: IH00:00:30 IL00:01:00">%CUSTOM_RULES%</textarea>
@@ -269,6 +441,11 @@ const char htmlPage[] PROGMEM = R"rawliteral(
                 <li><code>SL AAAA-MM-DD HH:MM</code>: <strong>Específico Baixo (Desligar Saída)</strong> - Desliga a saída na data e hora exatas. (Segundos não são usados aqui).</li>
                 <li><code>IH HH:MM:SS</code>: <strong>Intervalo Alto (Desligar após Ligado)</strong> - Se a saída estiver LIGADA, ela será DESLIGADA após o intervalo de tempo especificado.</li>
                 <li><code>IL HH:MM:SS</code>: <strong>Intervalo Baixo (Ligar após Desligado)</strong> - Se a saída estiver DESLIGADA, ela será LIGADA após o intervalo de tempo especificado.</li>
+                <li><code>CH(min hora dia mês semana)</code> / <code>CL(...)</code>: <strong>Cron (Ligar / Desligar)</strong> - Liga/desliga no início de cada minuto que casa com a expressão. Campos aceitam <code>*</code>, <code>N</code>, <code>A-B</code>, <code>*/P</code> e listas com vírgula; semana 0–7 (0 e 7 = Domingo). Ex.: <code>CH(*/15 6-17 * * 1-5) IH00:05:00</code> liga a cada 15 min das 06:00 às 17:45, de segunda a sexta, por 5 min.</li>
+                <li><code>EH(expr)</code> / <code>EL(expr)</code>: <strong>Condição (Ligar / Desligar)</strong> - Liga/desliga quando a expressão é verdadeira. Variáveis: <code>hour minute second tod wday day month year out on_for off_for manual count</code>; operadores <code>|| &amp;&amp; == != &lt; &lt;= &gt; &gt;= + - * / % !</code>; literais <code>07:30</code>, <code>2h</code>, <code>30m</code>, <code>45s</code>. Ex.: <code>EH(tod == 07:00 &amp;&amp; off_for &gt;= 2h)</code>, <code>EL(on_for &gt; 45m &amp;&amp; !manual)</code>. Até 4 por canal.</li>
+                <li><strong>Sensores</strong> nas condições: <code>temp</code> (DS3231) e <code>ext</code> (entrada analógica) em décimos, comparados com literais de uma casa decimal; <code>temp_ok</code>/<code>ext_ok</code> indicam leitura válida. O sufixo <code>for</code> exige a condição verdadeira sem interrupção. Ex.: <code>EH(temp_ok &amp;&amp; temp &gt; 30.0 for 5m)</code>, <code>EL(temp &lt; 28.5 for 5m)</code>.</li>
+                <li><code>DC(on/off[/on/off...][@HH:MM] [HH:MM-HH:MM])</code>: <strong>Ciclo</strong> - Liga/desliga em fases fixas (durações <code>30s</code>, <code>10m</code>, <code>1h30m</code>), contadas a partir da âncora (padrão: início da janela ou 00:00) e só dentro da janela diária. Cada fase tem ao menos 10 s (intervalo mínimo entre acionamentos). Ex.: <code>DC(5m/25m 06:00-18:00)</code>. A fase é calculada pelo relógio: após reinício ou ajuste de hora o ciclo continua no ponto certo.</li>
+                <li><code>AH(sunrise|sunset[+-HH:MM])</code> / <code>AL(...)</code>: <strong>Sol</strong> - Liga/desliga no nascer ou pôr do sol, com deslocamento opcional (até 12 h). Ex.: <code>AH(sunset-00:20) AL(sunrise+01:00)</code>. Requer a localização salva acima; em latitudes onde o sol não nasce/põe no dia, a regra não dispara.</li>
             </ul>
             <p><small>Consulte a documentação completa para mais exemplos e detalhes.</small></p>
         </div>
@@ -282,6 +459,29 @@ const char htmlPage[] PROGMEM = R"rawliteral(
   <div id="customRuleCountdown"></div>
 
   <script>
+  // canal exibido nesta página; todas as chamadas levam ?ch=
+  const CHANNEL = %CHANNEL%, CHANNEL_COUNT = %CHANNEL_COUNT%;
+  function chUrl(path){ return path + '?ch=' + CHANNEL; }
+
+  (function initChannels(){
+    const sel = document.getElementById('channelSelect');
+    for (let i = 0; i < CHANNEL_COUNT; i++) {
+      const o = document.createElement('option');
+      o.value = i; o.textContent = 'Canal ' + (i + 1);
+      if (i === CHANNEL) o.selected = true;
+      sel.appendChild(o);
+    }
+    sel.onchange = () => { location.href = '/?ch=' + sel.value; };
+  })();
+
+  document.getElementById('channelCountForm').onsubmit = e => {
+    e.preventDefault();
+    const n = document.getElementById('channelCountInput').value;
+    fetch('/setChannelCount',{method:'POST',headers:{'Content-Type':'application/x-www-form-urlencoded'},body:'count='+encodeURIComponent(n)})
+      .then(r=>{if(r.ok)location.href='/?ch='+Math.min(CHANNEL,n-1);else {r.text().then(txt => showMessage('channelCountMessage','Erro: ' + txt,'error'));}})
+      .catch(_=>showMessage('channelCountMessage','Erro ao salvar','error'));
+  };
+
    function pad(n){ return n.toString().padStart(2,'0'); }
   function parseHHMMSS_to_secs(s){ const p=s.split(':').map(Number); return p[0]*3600+p[1]*60+p[2]; }
   function formatHHMMSS(secs){
@@ -350,11 +550,105 @@ const char htmlPage[] PROGMEM = R"rawliteral(
     e.preventDefault();
     const d=document.getElementById('manualInterval').value, rx=/^([0-9]{2}):([0-9]{2}):([0-9]{2})$/;
     if(!rx.test(d)){showMessage('manualDurationMessage','Use formato HH:MM:SS','error');return;} // ID da mensagem atualizado
-    fetch('/setManualDuration',{method:'POST',headers:{'Content-Type':'application/x-www-form-urlencoded'},body:`manualDuration=${d}`})
+    fetch(chUrl('/setManualDuration'),{method:'POST',headers:{'Content-Type':'application/x-www-form-urlencoded'},body:`manualDuration=${d}`})
       .then(r=>{if(r.ok){showMessage('manualDurationMessage','Duração salva','success');manualIntervalSecs=parseHHMMSS_to_secs(d); } else {r.text().then(txt => showMessage('manualDurationMessage','Erro: ' + txt,'error'));}})
       .catch(_=>showMessage('manualDurationMessage','Erro ao salvar','error'));
   };
 
+  function fmtSecs(s){const h=Math.floor(s/3600),m=Math.floor(s%3600/60);return `${h}h${String(m).padStart(2,'0')}`;}
+  function updateStats(){
+    fetch('/stats').then(r=>r.json()).then(j=>{
+      const c=j.channels[CHANNEL]; if(!c) return;
+      let t=`Tempo ligado: hoje ${fmtSecs(c.today_s)}, 7 dias ${fmtSecs(c.week_s)}, mês ${fmtSecs(c.month_s)} (${c.total_count} ativações)`;
+      if(c.watts) t+=` | Consumo: hoje ${c.today_wh} Wh, mês ${(c.month_wh/1000).toFixed(2)} kWh`;
+      document.getElementById('statsSummary').innerHTML=`<small>${t}</small>`;
+    }).catch(_=>{});
+  }
+  updateStats();
+  setInterval(updateStats, 60000);
+
+  document.getElementById('sensorsForm').onsubmit = e => {
+    e.preventDefault();
+    const body = ['period','extPin','extScale','extOffset'].map(k => k + '=' + encodeURIComponent(document.getElementById((k === 'period' ? 'sensorPeriod' : k) + 'Input').value)).join('&');
+    fetch('/setSensors',{method:'POST',headers:{'Content-Type':'application/x-www-form-urlencoded'},body})
+      .then(r=>{if(r.ok){showMessage('sensorsMessage','Sensores salvos','success');} else {r.text().then(txt => showMessage('sensorsMessage','Erro: ' + txt,'error'));}})
+      .catch(_=>showMessage('sensorsMessage','Erro ao salvar','error'));
+  };
+
+  document.getElementById('mqttForm').onsubmit = e => {
+    e.preventDefault();
+    const v = id => encodeURIComponent(document.getElementById(id).value);
+    const body = 'enabled=' + (document.getElementById('mqttEnabledInput').checked ? 1 : 0) +
+      '&host=' + v('mqttHostInput') + '&port=' + v('mqttPortInput') +
+      '&user=' + v('mqttUserInput') + '&pass=' + v('mqttPassInput') +
+      '&prefix=' + v('mqttPrefixInput') + '&qos=' + v('mqttQosInput') + '&stateSec=' + v('mqttStateSecInput');
+    fetch('/setMqtt',{method:'POST',headers:{'Content-Type':'application/x-www-form-urlencoded'},body})
+      .then(r=>{if(r.ok){showMessage('mqttMessage','MQTT salvo','success');} else {r.text().then(txt => showMessage('mqttMessage','Erro: ' + txt,'error'));}})
+      .catch(_=>showMessage('mqttMessage','Erro ao salvar','error'));
+  };
+
+  function updateWebhooks(){
+    fetch('/webhooks').then(r=>r.json()).then(j=>{
+      const parts = j.targets.map((t,i)=>!t.valid ? null :
+        `${i+1}: ${t.failing ? 'falhando' : 'ok'}, ${t.events} eventos, ${t.avg_ms} ms, ${t.failures} falhas, ${t.dropped} descartados`).filter(x=>x);
+      document.getElementById('webhooksStatus').innerHTML = `<small>Webhooks: ${parts.length ? parts.join(' | ') : 'nenhum'}</small>`;
+    }).catch(_=>{});
+  }
+  updateWebhooks();
+  setInterval(updateWebhooks, 30000);
+
+  document.getElementById('webhooksForm').onsubmit = e => {
+    e.preventDefault();
+    const body = [0,1].map(i => 'url' + i + '=' + encodeURIComponent(document.getElementById('webhook' + i + 'Input').value)).join('&');
+    fetch('/setWebhooks',{method:'POST',headers:{'Content-Type':'application/x-www-form-urlencoded'},body})
+      .then(r=>{if(r.ok){showMessage('webhooksMessage','Webhooks salvos','success');updateWebhooks();} else {r.text().then(txt => showMessage('webhooksMessage','Erro: ' + txt,'error'));}})
+      .catch(_=>showMessage('webhooksMessage','Erro ao salvar','error'));
+  };
+
+  function updateSync(){
+    fetch('/sync').then(r=>r.json()).then(j=>{
+      let t = 'Sincronismo: ';
+      if (j.role === 'off') t += 'desligado';
+      else if (j.role === 'leader') t += `líder, ${j.peers.length} seguidor(es)` + j.peers.map(p=>` | ${p.ip}: ${p.skew_us} µs`).join('');
+      else t += j.locked ? `seguidor de ${j.leader || '(procurando)'}, desvio ${j.offset_us} µs, atraso ${j.delay_us} µs` : 'seguidor procurando líder';
+      if (j.role !== 'off') t += ` | motor ${j.edge_avg_us} µs após a virada`;
+      document.getElementById('syncStatus').innerHTML = `<small>${t}</small>`;
+    }).catch(_=>{});
+  }
+  updateSync();
+  setInterval(updateSync, 10000);
+
+  document.getElementById('syncForm').onsubmit = e => {
+    e.preventDefault();
+    fetch('/setSync',{method:'POST',headers:{'Content-Type':'application/x-www-form-urlencoded'},body:'role=' + document.getElementById('syncRoleInput').value})
+      .then(r=>{if(r.ok){showMessage('syncMessage','Sincronismo salvo','success');updateSync();} else {r.text().then(txt => showMessage('syncMessage','Erro: ' + txt,'error'));}})
+      .catch(_=>showMessage('syncMessage','Erro ao salvar','error'));
+  };
+
+  document.getElementById('beaconForm').onsubmit = e => {
+    e.preventDefault();
+    const body = 'sec=' + encodeURIComponent(document.getElementById('beaconSecInput').value) +
+                 '&channels=' + encodeURIComponent(document.getElementById('beaconChInput').value);
+    fetch('/setBeacon',{method:'POST',headers:{'Content-Type':'application/x-www-form-urlencoded'},body})
+      .then(r=>{if(r.ok){showMessage('beaconMessage','Beacon salvo','success');} else {r.text().then(txt => showMessage('beaconMessage','Erro: ' + txt,'error'));}})
+      .catch(_=>showMessage('beaconMessage','Erro ao salvar','error'));
+  };
+
+  document.getElementById('modbusForm').onsubmit = e => {
+    e.preventDefault();
+    fetch('/setModbus',{method:'POST',headers:{'Content-Type':'application/x-www-form-urlencoded'},body:'port=' + encodeURIComponent(document.getElementById('modbusPortInput').value)})
+      .then(r=>{if(r.ok){showMessage('modbusMessage','Modbus salvo','success');} else {r.text().then(txt => showMessage('modbusMessage','Erro: ' + txt,'error'));}})
+      .catch(_=>showMessage('modbusMessage','Erro ao salvar','error'));
+  };
+
+  document.getElementById('loadWattsForm').onsubmit = e => {
+    e.preventDefault();
+    const w = document.getElementById('loadWattsInput').value;
+    fetch(chUrl('/setLoadWatts'),{method:'POST',headers:{'Content-Type':'application/x-www-form-urlencoded'},body:'watts='+encodeURIComponent(w)})
+      .then(r=>{if(r.ok){showMessage('loadWattsMessage','Carga salva','success');updateStats();} else {r.text().then(txt => showMessage('loadWattsMessage','Erro: ' + txt,'error'));}})
+      .catch(_=>showMessage('loadWattsMessage','Erro ao salvar','error'));
+  };
+
   document.getElementById('outputPinForm').onsubmit = e => { // ID do formulário atualizado
     e.preventDefault();
     const pin = document.getElementById('outputPinInput').value; // ID do input atualizado
@@ -362,7 +656,7 @@ const char htmlPage[] PROGMEM = R"rawliteral(
       showMessage('outputPinMessage', 'Número do pino inválido', 'error'); // ID da mensagem atualizado
       return;
     }
-    fetch('/setFeederPin', { // Endpoint mantido como /setFeederPin por simplicidade no backend
+    fetch(chUrl('/setFeederPin'), { // Endpoint mantido como /setFeederPin por simplicidade no backend
       method: 'POST',
       headers: {'Content-Type': 'application/x-www-form-urlencoded'},
       body: `feederPin=${pin}`
@@ -377,29 +671,78 @@ const char htmlPage[] PROGMEM = R"rawliteral(
     .catch(_ => showMessage('outputPinMessage', 'Erro ao salvar pino', 'error'));
   };
 
+  document.getElementById('timezoneForm').onsubmit = e => {
+    e.preventDefault();
+    const tz = document.getElementById('timezoneInput').value.trim();
+    if (!tz) { showMessage('timezoneMessage', 'Informe a string TZ', 'error'); return; }
+    fetch('/setTimezone', {method:'POST',headers:{'Content-Type':'application/x-www-form-urlencoded'},body:'tz='+encodeURIComponent(tz)})
+      .then(r=>{if(r.ok){showMessage('timezoneMessage','Fuso salvo','success');updateNextTrigger();} else {r.text().then(txt => showMessage('timezoneMessage','Erro: ' + txt,'error'));}})
+      .catch(_=>showMessage('timezoneMessage','Erro ao salvar','error'));
+  };
+
+  document.getElementById('locationForm').onsubmit = e => {
+    e.preventDefault();
+    const lat = document.getElementById('latInput').value, lon = document.getElementById('lonInput').value;
+    if (lat === '' || lon === '') { showMessage('locationMessage', 'Informe latitude e longitude', 'error'); return; }
+    fetch('/setLocation', {method:'POST',headers:{'Content-Type':'application/x-www-form-urlencoded'},body:'lat='+encodeURIComponent(lat)+'&lon='+encodeURIComponent(lon)})
+      .then(r=>r.text().then(txt=>{if(r.ok){showMessage('locationMessage',txt,'success');updateNextTrigger();} else {showMessage('locationMessage','Erro: ' + txt,'error');}}))
+      .catch(_=>showMessage('locationMessage','Erro ao salvar','error'));
+  };
+
   document.getElementById('saveSchedules').onclick=()=>{
     const body='schedules='+encodeURIComponent(schedules.map(o=>`${o.time}|${o.interval}`).join(','));
-    fetch('/setSchedules',{method:'POST',headers:{'Content-Type':'application/x-www-form-urlencoded'},body})
+    fetch(chUrl('/setSchedules'),{method:'POST',headers:{'Content-Type':'application/x-www-form-urlencoded'},body})
       .then(r=>{if(r.ok){showMessage('scheduleFormMessage','Agendamentos salvos','success');updateNextTrigger();} else {r.text().then(txt => showMessage('scheduleFormMessage','Erro: ' + txt,'error'));}})
       .catch(_=>showMessage('scheduleFormMessage','Erro ao salvar','error'));
   };
 
   document.getElementById('saveRules').onclick=()=>{
     const rules=document.getElementById('customRulesInput').value;
-    fetch('/setCustomRules',{method:'POST',headers:{'Content-Type':'application/x-www-form-urlencoded'},body:'rules='+encodeURIComponent(rules)})
+    fetch(chUrl('/setCustomRules'),{method:'POST',headers:{'Content-Type':'application/x-www-form-urlencoded'},body:'rules='+encodeURIComponent(rules)})
       .then(r=>{if(r.ok)showMessage('customRulesMessage','Regras salvas','success');else {r.text().then(txt => showMessage('customRulesMessage','Erro: ' + txt,'error'));}})
       .catch(_=>showMessage('customRulesMessage','Erro ao salvar','error'));
   };
 
+  document.getElementById('saveExceptions').onclick=()=>{
+    const exc=document.getElementById('exceptionsInput').value;
+    fetch('/setExceptions',{method:'POST',headers:{'Content-Type':'application/x-www-form-urlencoded'},body:'exceptions='+encodeURIComponent(exc)})
+      .then(r=>{if(r.ok){showMessage('exceptionsMessage','Exceções salvas','success');updateNextTrigger();} else {r.text().then(txt => showMessage('exceptionsMessage','Erro: ' + txt,'error'));}})
+      .catch(_=>showMessage('exceptionsMessage','Erro ao salvar','error'));
+  };
+
+  document.getElementById('importProgram').onclick=()=>{
+    const file=document.getElementById('programFile').files[0];
+    if(!file){showMessage('programMessage','Escolha um arquivo','error');return;}
+    const fd=new FormData(); fd.append('program',file);
+    fetch(chUrl('/importProgram'),{method:'POST',body:fd})
+      .then(r=>r.text().then(txt=>{showMessage('programMessage',r.ok?txt:'Erro: '+txt,r.ok?'success':'error');if(r.ok)waitProgram();}))
+      .catch(_=>showMessage('programMessage','Erro ao importar','error'));
+  };
+
+  // a conversão do arquivo segue no aparelho; acompanha por /program
+  function waitProgram(){
+    fetch(chUrl('/program')).then(r=>r.json()).then(p=>{
+      if(p.importing){setTimeout(waitProgram,1000);return;}
+      if(p.import_ok===false)showMessage('programMessage','Erro: '+p.import_error,'error');
+      else {showMessage('programMessage',p.records+' registros importados','success');updateNextTrigger();}
+    }).catch(_=>setTimeout(waitProgram,2000));
+  }
+
+  document.getElementById('clearProgram').onclick=()=>{
+    fetch(chUrl('/clearProgram'),{method:'POST'})
+      .then(r=>r.text().then(txt=>{showMessage('programMessage',r.ok?txt:'Erro: '+txt,r.ok?'success':'error');if(r.ok)updateNextTrigger();}))
+      .catch(_=>showMessage('programMessage','Erro ao remover','error'));
+  };
+
   document.getElementById('toggleRules').onclick=()=>{
-    fetch('/toggleCustomRules',{method:'POST'}).then(r=>{if(r.ok)location.reload();else {r.text().then(txt => showMessage('customRulesMessage','Erro: ' + txt,'error'));}}).catch(_=>showMessage('customRulesMessage','Erro ao alternar','error'));
+    fetch(chUrl('/toggleCustomRules'),{method:'POST'}).then(r=>{if(r.ok)location.reload();else {r.text().then(txt => showMessage('customRulesMessage','Erro: ' + txt,'error'));}}).catch(_=>showMessage('customRulesMessage','Erro ao alternar','error'));
   };
 
   const manualActivateButton = document.getElementById('manualActivateOutput'); // ID do botão atualizado
   const manualDeactivateButton = document.getElementById('manualDeactivateOutput'); // ID do botão atualizado
 
   manualActivateButton.onclick = () => {
-    fetch('/feedNow', { method: 'POST' }) // Endpoint /feedNow mantido
+    fetch(chUrl('/feedNow'), { method: 'POST' }) // Endpoint /feedNow mantido
         .then(r => {
             if (r.ok) {
                 showMessage('manualOutputMessage', 'Saída ativada', 'success'); // ID da mensagem atualizado
@@ -412,7 +755,7 @@ const char htmlPage[] PROGMEM = R"rawliteral(
   };
 
   manualDeactivateButton.onclick = () => {
-    fetch('/stopFeedNow', { method: 'POST' }) // Endpoint /stopFeedNow mantido
+    fetch(chUrl('/stopFeedNow'), { method: 'POST' }) // Endpoint /stopFeedNow mantido
         .then(r => {
             if (r.ok) {
                 showMessage('manualOutputMessage', 'Saída desativada.', 'success'); // ID da mensagem atualizado
@@ -427,7 +770,7 @@ const char htmlPage[] PROGMEM = R"rawliteral(
   let customRuleCountdownInterval = null;
 
   function updateStatusAndRuleCountdown() {
-    fetch('/status')
+    fetch(chUrl('/status'))
         .then(res => res.json())
         .then(data => {
             if (data.is_feeding) { // is_feeding no backend representa isOutputActive
@@ -438,6 +781,13 @@ const char htmlPage[] PROGMEM = R"rawliteral(
                 manualActivateButton.disabled = false;
             }
 
+            const sens = data.sensors || {}, parts = [];
+            for (const k in sens) parts.push(sens[k].ok ? `${k} ${sens[k].value.toFixed(1)}` : `${k} sem leitura`);
+            document.getElementById('sensorReadings').innerHTML = `<small>Sensores: ${parts.length ? parts.join(', ') : 'nenhum'}</small>`;
+            const mq = data.mqtt || {};
+            document.getElementById('mqttStatus').innerHTML = `<small>MQTT: ${!mq.enabled ? 'desativado' : (mq.connected ? 'conectado' : 'desconectado')}` +
+              (mq.enabled ? ` (${mq.prefix}, fila ${mq.queued}, descartadas ${mq.dropped})` : '') + '</small>';
+
             if (customRuleCountdownInterval) clearInterval(customRuleCountdownInterval);
             const ruleCountdownElement = document.getElementById('customRuleCountdown');
 
@@ -445,7 +795,7 @@ const char htmlPage[] PROGMEM = R"rawliteral(
                 ruleCountdownElement.style.display = 'block';
                 let totalSeconds = data.custom_rule_time_remaining;
                 let ruleType = data.active_custom_rule;
-                let ruleState = ruleType === "IH" ? "LIGADO" : "DESLIGADO";
+                let ruleState = (ruleType === "IH" || (ruleType === "DC" && data.is_feeding)) ? "LIGADO" : "DESLIGADO";
 
                 ruleCountdownElement.textContent = `Regra Ativa (${ruleType}): Tempo ${ruleState} restante: ${formatHHMMSS(totalSeconds)}`;
 
@@ -475,7 +825,7 @@ const char htmlPage[] PROGMEM = R"rawliteral(
 
   let countdownInterval = null;
   function updateNextTrigger(){
-    fetch('/nextTriggerTime')
+    fetch(chUrl('/nextTriggerTime'))
         .then(res => res.text())
         .then(text => {
             if (countdownInterval) clearInterval(countdownInterval);
@@ -7,6 +7,27 @@
 #include "time_utils.h"
 #include "schedule.h"
 #include "custom_rules.h"
+#include "tz_rules.h"
+#include "simulator.h"
+#include "bench.h"
+#include "metrics.h"
+#include "admission.h"
+#include "tasks.h"
+#include "controller.h"
+#include "output.h"
+#include "sun_times.h"
+#include "exceptions.h"
+#include "stats.h"
+#include "program_table.h"
+#include "sensors.h"
+#include "mqtt.h"
+#include "webhooks.h"
+#include "clock_sync.h"
+#include "discovery.h"
+#include "modbus.h"
+#include "logbuf.h"
+#include "cbor.h"
+#include "hal.h"
 #ifdef ESP8266
   #include <ESP8266WiFi.h>
 #else
@@ -14,15 +35,11 @@
 #endif
 #include <ArduinoJson.h>
 #include <TimeLib.h>  
+#include <math.h>
 
 // Variáveis e funções definidas em main.cpp
 extern Config          cfg;
 extern WebSrv          server;
-extern String          eventLog;
-extern bool            isOutputActive;
-extern unsigned long   lastTriggerMs;
-extern void            startOutput(unsigned long durationSec);
-extern void            stopOutput();
 
 static bool isValidGpio(int pin) {
 #ifdef ESP8266
@@ -32,44 +49,281 @@ static bool isValidGpio(int pin) {
 #endif
 }
 
-void initWebServer(WebSrv& server, Config& cfg) {
-  // ---- Página raiz ----
-  server.on("/", HTTP_GET, [&]() {
-    String page = FPSTR(htmlPage);
+// Pinos com ADC utilizável junto com o Wi-Fi
+static bool isValidAdcPin(int pin) {
+#ifdef ESP8266
+  return pin == A0;
+#else
+  return pin >= 32 && pin <= 39;   // ADC1 (o ADC2 é ocupado pelo Wi-Fi)
+#endif
+}
 
-    // Wi-Fi quality
-    int rssi = WiFi.RSSI();
-    int qual = map(constrain(rssi, -90, -30), -90, -30, 0, 100);
-    page.replace("%WIFI_QUALITY%", String(qual));
+// Cópia de trabalho de um canal para validar antes de aplicar (/setCustomRules,
+// POST /config). Estática: ChannelConfig (~1,2 KB) não deve ir para a pilha
+// do loop; os handlers rodam um de cada vez.
+static ChannelConfig s_chScratch;
+
+// Corpo cru do POST /config. O core guarda corpos que não são formulário no
+// arg "plain" como C-string, que para no primeiro 0x00 (comum em CBOR); a
+// rota recebe então o corpo em blocos HTTPRaw, copiados aqui.
+static constexpr size_t RAW_BODY_MAX = 1024;   // um canal com 512 B de regras
+static uint8_t s_rawBody[RAW_BODY_MAX];
+static size_t  s_rawLen  = 0;
+static bool    s_rawOver = false;
+
+static void rawCollect(WebSrv& server) {
+  HTTPRaw& raw = server.raw();
+  if (raw.status == RAW_START) {
+    s_rawLen  = 0;
+    s_rawOver = false;
+  } else if (raw.status == RAW_WRITE) {
+    if (s_rawLen + raw.currentSize > RAW_BODY_MAX) {
+      s_rawOver = true;
+      return;
+    }
+    memcpy(s_rawBody + s_rawLen, raw.buf, raw.currentSize);
+    s_rawLen += raw.currentSize;
+  } else if (raw.status == RAW_ABORTED) {
+    s_rawLen = 0;
+  }
+}
+
+// Canal da requisição (?ch=N, padrão 0). Responde 400 e retorna -1 se inválido.
+static int argChannel(WebSrv& server, const Config& cfg) {
+  if (!server.hasArg("ch")) return 0;
+  String s = server.arg("ch");
+  int ch = s.toInt();
+  if (ch < 0 || ch >= cfg.channelCount || (ch == 0 && s != "0")) {
+    server.send(400, "text/plain", "Canal inválido (0–" + String(cfg.channelCount - 1) + ")");
+    return -1;
+  }
+  return ch;
+}
+
+// Recusa da admissão (ver admission.h): 429/503 sem corpo
+static bool admitted(WebSrv& server, AdmVerdict v, uint16_t retry) {
+  if (v == ADM_OK) return true;
+  server.sendHeader("Retry-After", String(retry ? retry : 1));
+  server.send(v == ADM_THROTTLE ? 429 : 503, "text/plain", "");
+  return false;
+}
+
+static bool admit(WebSrv& server, AdmLane lane, uint8_t cost) {
+  uint16_t   retry;
+  AdmVerdict v = admCheck(lane, cost, (uint32_t)server.client().remoteIP(), &retry);
+  return admitted(server, v, retry);
+}
+
+// Registra a rota medindo a latência do handler (ver metrics.h)
+static void onRoute(WebSrv& server, const char* path, HTTPMethod method,
+                    std::function<void()> handler) {
+  int     id = metricsRoute(path);
+  uint8_t cost;
+  AdmLane lane = admClassify(path, method != HTTP_GET, &cost);
+  server.on(path, method, [&server, id, lane, cost, handler]() {
+    if (!admit(server, lane, cost)) return;
+    unsigned long t0 = micros();
+    handler();
+    unsigned long us = micros() - t0;
+    metricsRecord(id, us);
+    admDone(lane, us);
+  });
+}
+
+// Variante com upload: `upload` recebe o corpo em blocos (multipart em
+// server.upload() ou, com `raw`, o corpo cru em server.raw()) e o handler
+// (medido) responde ao final. A admissão é decidida no início do upload,
+// para que um pedido recusado não grave nada.
+struct UploadAdmission {
+  bool       decided;
+  AdmVerdict verdict;
+  uint16_t   retry;
+};
+
+static void onRoute(WebSrv& server, const char* path, HTTPMethod method,
+                    std::function<void()> handler, std::function<void()> upload,
+                    bool raw = false) {
+  int     id = metricsRoute(path);
+  uint8_t cost;
+  AdmLane lane = admClassify(path, method != HTTP_GET, &cost);
+  UploadAdmission* adm = new UploadAdmission{ false, ADM_OK, 0 };   // vive com a rota
+  server.on(path, method, [&server, id, lane, cost, adm, handler]() {
+    bool ok = adm->decided ? admitted(server, adm->verdict, adm->retry)
+                           : admit(server, lane, cost);
+    adm->decided = false;
+    if (!ok) return;
+    unsigned long t0 = micros();
+    handler();
+    unsigned long us = micros() - t0;
+    metricsRecord(id, us);
+    admDone(lane, us);
+  }, [&server, lane, cost, adm, upload, raw]() {
+    if (raw ? server.raw().status == RAW_START : server.upload().status == UPLOAD_FILE_START) {
+      adm->decided = true;
+      adm->verdict = admCheck(lane, cost, (uint32_t)server.client().remoteIP(), &adm->retry);
+    }
+    if (adm->verdict == ADM_OK || !adm->decided) upload();
+  });
+}
+
+// ---- API binária (ver cbor.h) ----
+static bool wantsCbor(WebSrv& server) {
+  return server.arg("fmt") == "cbor" || server.header("Accept").indexOf("application/cbor") >= 0;
+}
+
+// Resposta 200 chunked: cada despejo do CborOut vai direto ao socket
+struct CborBody : public Print {
+  WebSrv& server;
+  explicit CborBody(WebSrv& s) : server(s) {
+    server.setContentLength(CONTENT_LENGTH_UNKNOWN);
+    server.send(200, "application/cbor", "");
+  }
+  size_t write(uint8_t b) override { return write(&b, 1); }
+  size_t write(const uint8_t* p, size_t n) override {
+    server.sendContent((const char*)p, n);
+    return n;
+  }
+  void end() { server.sendContent("", 0); }   // chunk final
+};
 
-    // Duração manual e pino de saída
-    page.replace("%MANUAL%", formatHHMMSS(cfg.manualDurationSec));
-    page.replace("%OUTPUT_PIN_VALUE%", String(cfg.feederPin));
+// Página em PROGMEM enviada em chunks, sem cópia na RAM: trechos fixos vão
+// direto da flash e cada %NOME% é trocado pelo que value(nome, out) devolver.
+// Nomes desconhecidos (e os '%' do CSS) seguem literais.
+static constexpr size_t PAGE_KEY_MAX = 24;
 
-    // Agendamentos
-    String schedStr;
-    for (int i = 0; i < cfg.scheduleCount; i++) {
-      if (i) schedStr += ",";
-      schedStr += formatHHMMSS(cfg.schedules[i].timeSec);
-      schedStr += "|";
-      schedStr += formatHHMMSS(cfg.schedules[i].durationSec);
+template <typename F>
+static void sendPageP(WebSrv& server, PGM_P page, F value) {
+  server.setContentLength(CONTENT_LENGTH_UNKNOWN);
+  server.send(200, "text/html", "");
+  size_t start = 0, i = 0;
+  String out;
+  for (char ch; (ch = pgm_read_byte(page + i)) != 0; i++) {
+    if (ch != '%') continue;
+    char   key[PAGE_KEY_MAX + 1];
+    size_t n = 0;
+    char   k;
+    while (n < PAGE_KEY_MAX && (k = pgm_read_byte(page + i + 1 + n)) != 0 &&
+           ((k >= 'A' && k <= 'Z') || (k >= '0' && k <= '9') || k == '_')) {
+      key[n++] = k;
     }
-    page.replace("%SCHEDULES%", schedStr);
+    key[n] = 0;
+    out = "";
+    if (!n || pgm_read_byte(page + i + 1 + n) != '%' || !value(key, out)) continue;
+    if (i > start) server.sendContent_P(page + start, i - start);
+    if (out.length()) server.sendContent(out);
+    i    += n + 1;
+    start = i + 1;
+  }
+  if (i > start) server.sendContent_P(page + start, i - start);
+  server.sendContent("", 0);   // chunk final
+}
 
-    // Regras customizadas
-    page.replace("%CUSTOM_RULES%", String(cfg.customSchedule));
-    page.replace("%TOGGLE_BUTTON%", cfg.customEnabled ? "Desativar Regras" : "Ativar Regras");
+// Regra em vigor no canal e segundos até a próxima mudança ("none", -1 sem regras)
+static const char* ruleStatus(const ChannelConfig& c, int ch, long& remaining) {
+  const char* rule = "none";
+  remaining = -1;
+  if (!c.customEnabled) return rule;
 
-    // Classe de status do LED
-    page.replace("%STATUS_CLASS%",
-                 isOutputActive ? "feeding"
-                                : (WiFi.status() == WL_CONNECTED ? "active" : ""));
+  time_t nowT = halUtcNow();   // mesmo relógio de ruleHighDT/ruleLowDT
+  char   hms[9] = "";
+  if (channelActive(ch)) {
+    const char* p = strstr(c.customSchedule, "IH");
+    if (p) strncpy(hms, p + 2, 8);
+    int ih = p ? parseHHMMSS(hms) : -1;
+    if (ih > 0) {
+      rule      = "IH";
+      remaining = ih - (nowT - chState.ruleHighDT[ch]);
+    }
+  } else {
+    const char* p = strstr(c.customSchedule, "IL");
+    if (p) strncpy(hms, p + 2, 8);
+    int il = p ? parseHHMMSS(hms) : -1;
+    if (il > 0) {
+      rule      = "IL";
+      remaining = il - (nowT - chState.ruleLowDT[ch]);
+    }
+  }
+  // programas DC: tempo até a próxima mudança de fase
+  if (strcmp(rule, "none") == 0 && c.dutyCount) {
+    time_t local = tzToLocal(nowT);
+    rule = "DC";
+    for (int i = 0; i < c.dutyCount; i++) {
+      long remain;
+      dutyStateAt(c.duty[i], local, &remain);
+      if (remaining < 0 || remain < remaining) remaining = remain;
+    }
+  }
+  if (remaining < 0) remaining = 0;
+  return rule;
+}
 
-    server.send(200, "text/html", page);
+void initWebServer(WebSrv& server, Config& cfg) {
+  // ---- Página raiz ----
+  onRoute(server, "/", HTTP_GET, [&]() {
+    int ch = argChannel(server, cfg);
+    if (ch < 0) return;
+    const ChannelConfig& c = cfg.channels[ch];
+
+    sendPageP(server, htmlPage, [&](const char* key, String& out) {
+      if (!strcmp(key, "WIFI_QUALITY")) {
+        int rssi = WiFi.RSSI();
+        out = String(map(constrain(rssi, -90, -30), -90, -30, 0, 100));
+      }
+      // Duração manual e pino de saída
+      else if (!strcmp(key, "MANUAL"))            out = formatHHMMSS(c.manualDurationSec);
+      else if (!strcmp(key, "OUTPUT_PIN_VALUE"))  out = String(c.feederPin);
+      else if (!strcmp(key, "WATTS"))             out = String(c.loadWatts);
+      else if (!strcmp(key, "TZ"))                out = cfg.tz;
+      else if (!strcmp(key, "SENSOR_PERIOD"))     out = String(cfg.sensorPeriodSec);
+      else if (!strcmp(key, "EXT_PIN"))           out = String(cfg.extPin);
+      else if (!strcmp(key, "EXT_SCALE"))         out = String(cfg.extScale, 4);
+      else if (!strcmp(key, "EXT_OFFSET"))        out = String(cfg.extOffset, 4);
+      else if (!strcmp(key, "MQTT_ENABLED"))      out = cfg.mqtt.enabled ? "checked" : "";
+      else if (!strcmp(key, "MQTT_HOST"))         out = cfg.mqtt.host;
+      else if (!strcmp(key, "MQTT_PORT"))         out = String(cfg.mqtt.port);
+      else if (!strcmp(key, "MQTT_USER"))         out = cfg.mqtt.user;
+      else if (!strcmp(key, "MQTT_PREFIX"))       out = cfg.mqtt.prefix;
+      else if (!strcmp(key, "MQTT_QOS"))          out = String(cfg.mqtt.qos);
+      else if (!strcmp(key, "MQTT_STATE_SEC"))    out = String(cfg.mqtt.stateSec);
+      else if (!strcmp(key, "WEBHOOK0"))          out = cfg.webhooks[0];
+      else if (!strcmp(key, "WEBHOOK1"))          out = cfg.webhooks[1];
+      else if (!strcmp(key, "SYNC_OFF_SEL"))      out = cfg.syncRole == SYNC_OFF      ? "selected" : "";
+      else if (!strcmp(key, "SYNC_LEADER_SEL"))   out = cfg.syncRole == SYNC_LEADER   ? "selected" : "";
+      else if (!strcmp(key, "SYNC_FOLLOWER_SEL")) out = cfg.syncRole == SYNC_FOLLOWER ? "selected" : "";
+      else if (!strcmp(key, "HOSTNAME"))          out = discoveryHostname();
+      else if (!strcmp(key, "BEACON_SEC"))        out = String(cfg.beaconSec);
+      else if (!strcmp(key, "BEACON_CH"))         out = String(cfg.beaconChannels);
+      else if (!strcmp(key, "MODBUS_PORT"))       out = String(cfg.modbusPort);
+      else if (!strcmp(key, "LAT"))               out = cfg.hasLocation ? String(cfg.latitude, 4) : String("");
+      else if (!strcmp(key, "LON"))               out = cfg.hasLocation ? String(cfg.longitude, 4) : String("");
+      // Canais
+      else if (!strcmp(key, "CHANNEL"))           out = String(ch);
+      else if (!strcmp(key, "CHANNEL_COUNT"))     out = String(cfg.channelCount);
+      else if (!strcmp(key, "MAX_CHANNELS"))      out = String(MAX_CHANNELS);
+      // Agendamentos
+      else if (!strcmp(key, "SCHEDULES")) {
+        for (int i = 0; i < c.scheduleCount; i++) {
+          if (i) out += ",";
+          out += formatHHMMSS(c.schedules[i].timeSec);
+          out += "|";
+          out += formatHHMMSS(c.schedules[i].durationSec);
+        }
+      }
+      // Regras customizadas
+      else if (!strcmp(key, "CUSTOM_RULES"))      out = c.customSchedule;
+      else if (!strcmp(key, "EXCEPTIONS"))        out = excToString();
+      else if (!strcmp(key, "TOGGLE_BUTTON"))     out = c.customEnabled ? "Desativar Regras" : "Ativar Regras";
+      // Classe de status do LED
+      else if (!strcmp(key, "STATUS_CLASS")) {
+        out = channelActive(ch) ? "feeding" : (WiFi.status() == WL_CONNECTED ? "active" : "");
+      }
+      else return false;
+      return true;
+    });
   });
 
   // ---- RSSI / Wi-Fi Quality ----
-  server.on("/rssi", HTTP_GET, [&]() {
+  onRoute(server, "/rssi", HTTP_GET, [&]() {
     int rssi = WiFi.RSSI();
     int pct  = map(constrain(rssi, -90, -30), -90, -30, 0, 100);
     String json = String("{\"rssi\":") + rssi + ",\"pct\":" + pct + "}";
@@ -77,19 +331,67 @@ void initWebServer(WebSrv& server, Config& cfg) {
   });
 
   // ---- Hora atual ----
-  server.on("/time", HTTP_GET, [&]() {
-    server.send(200, "text/plain", timeStr(now()));
+  onRoute(server, "/time", HTTP_GET, [&]() {
+    server.send(200, "text/plain", timeStr(localNow()));
   });
 
   // ---- Próximo acionamento ----
-  server.on("/nextTriggerTime", HTTP_GET, [&]() {
-    server.send(200, "text/plain", getNextTriggerTimeString(cfg));
+  // CBOR: previsão de todos os canais numa resposta
+  onRoute(server, "/nextTriggerTime", HTTP_GET, [&]() {
+    if (wantsCbor(server)) {
+      CborBody body(server);
+      CborOut  o;
+      cborBegin(o, body);
+      uint32_t utc = (uint32_t)halUtcNow();
+      cborArray(o, cfg.channelCount);
+      for (int i = 0; i < cfg.channelCount; i++) {
+        int  dur  = 0;
+        long next = nextTriggerIn(cfg, i, &dur);
+        cborArray(o, 2);
+        if (next >= 0) cborUint(o, utc + next);
+        else           cborNull(o);
+        cborUint(o, next >= 0 ? dur : 0);
+      }
+      cborFlush(o);
+      body.end();
+      return;
+    }
+    int ch = argChannel(server, cfg);
+    if (ch < 0) return;
+    server.send(200, "text/plain", getNextTriggerTimeString(cfg, ch));
   });
 
-
+  // ---- Número de canais em uso ----
+  onRoute(server, "/setChannelCount", HTTP_POST, [&]() {
+    if (!server.hasArg("count")) {
+      server.send(400, "text/plain", "Parâmetro 'count' ausente");
+      return;
+    }
+    int n = server.arg("count").toInt();
+    if (n < 1 || n > MAX_CHANNELS) {
+      server.send(400, "text/plain", "Número de canais inválido (1–" + String(MAX_CHANNELS) + ")");
+      return;
+    }
+    // canais removidos são desligados antes de sair do motor
+    for (int ch = n; ch < cfg.channelCount; ch++) stopOutput(cfg, ch);
+    for (int ch = cfg.channelCount; ch < n; ch++) {
+      int pin = cfg.channels[ch].feederPin;
+      if (pin >= 0) {
+        pinMode(pin, OUTPUT);
+        digitalWrite(pin, LOW);
+      }
+    }
+    cfg.channelCount = n;
+    saveConfig(cfg);
+    logEvent(LOG_CFG_CHANNELS, -1, n);
+    server.send(200, "text/plain", "Canais salvos");
+  });
 
   // ---- Alterar pino de saída ----
-  server.on("/setFeederPin", HTTP_POST, [&]() {
+  onRoute(server, "/setFeederPin", HTTP_POST, [&]() {
+    int ch = argChannel(server, cfg);
+    if (ch < 0) return;
+    ChannelConfig& c = cfg.channels[ch];
     if (!server.hasArg("feederPin")) {
       server.send(400, "text/plain", "Parâmetro 'feederPin' ausente");
       return;
@@ -99,90 +401,123 @@ void initWebServer(WebSrv& server, Config& cfg) {
       server.send(400, "text/plain", "Pino inválido ou reservado");
       return;
     }
+    for (int o = 0; o < cfg.channelCount; o++) {
+      if (o != ch && cfg.channels[o].feederPin == newPin) {
+        server.send(400, "text/plain", "Pino já usado pelo canal " + String(o));
+        return;
+      }
+    }
     // se mudar, desliga saída atual e reconfigura pino
-    if (cfg.feederPin != newPin) {
-      if (isOutputActive) {
-        stopOutput();
-        eventLog += timeStr(now()) + " -> Saída desligada para troca de pino\n";
+    if (c.feederPin != newPin) {
+      if (channelActive(ch)) {
+        stopOutput(cfg, ch);
+        logEvent(LOG_CFG_PIN_STOP, ch);
       }
-      cfg.feederPin = newPin;
-      pinMode(cfg.feederPin, OUTPUT);
-      digitalWrite(cfg.feederPin, LOW);
+      c.feederPin = newPin;
+      pinMode(c.feederPin, OUTPUT);
+      digitalWrite(c.feederPin, LOW);
     }
     saveConfig(cfg);
-    eventLog += timeStr(now()) + " -> Pino alterado para GPIO " + String(cfg.feederPin) + "\n";
+    logEvent(LOG_CFG_PIN, ch, c.feederPin);
     server.send(200, "text/plain", "Pino salvo");
   });
 
   // ---- Status atual ----
-server.on("/status", HTTP_GET, [&]() {
-  DynamicJsonDocument doc(256);
-  doc["is_feeding"] = isOutputActive;
-  doc["custom_rules_enabled"] = cfg.customEnabled;
-
-  String activeRule   = "none";
-  long   timeRemaining = -1;
-
-  if (cfg.customEnabled) {
-    time_t nowT = now();               // <-- agore sim existe!
-    String rules = String(cfg.customSchedule);
-    int ih = -1, il = -1;
-
-    if (isOutputActive) {
-      int p = rules.indexOf("IH");
-      if (p >= 0) ih = parseHHMMSS(rules.substring(p+2, p+10));
-      if (ih > 0) {
-        activeRule   = "IH";
-        timeRemaining = ih - (nowT - ruleHighDT);
-      }
-    } else {
-      int p = rules.indexOf("IL");
-      if (p >= 0) il = parseHHMMSS(rules.substring(p+2, p+10));
-      if (il > 0) {
-        activeRule   = "IL";
-        timeRemaining = il - (nowT - ruleLowDT);
-      }
+onRoute(server, "/status", HTTP_GET, [&]() {
+  int ch = argChannel(server, cfg);
+  if (ch < 0) return;
+  const ChannelConfig& c = cfg.channels[ch];
+
+  long        timeRemaining;
+  const char* activeRule = ruleStatus(c, ch, timeRemaining);
+
+  if (wantsCbor(server)) {
+    CborBody body(server);
+    CborOut  o;
+    cborBegin(o, body);
+    cborMap(o, 9);
+    cborUint(o, CK_CHANNEL);   cborUint(o, ch);
+    cborUint(o, CK_ON);        cborBool(o, channelActive(ch));
+    cborUint(o, CK_CUSTOM);    cborBool(o, c.customEnabled);
+    cborUint(o, CK_RULE);      cborText(o, activeRule);
+    cborUint(o, CK_REMAINING); cborInt(o, timeRemaining);
+    cborUint(o, CK_CHANNELS);  cborArray(o, cfg.channelCount);
+    for (int i = 0; i < cfg.channelCount; i++) {
+      cborArray(o, 3);
+      cborInt(o, cfg.channels[i].feederPin);
+      cborBool(o, channelActive(i));
+      cborBool(o, cfg.channels[i].customEnabled);
     }
-    if (timeRemaining < 0) timeRemaining = 0;
+    cborUint(o, CK_UTC);       cborUint(o, (uint32_t)halUtcNow());
+    cborUint(o, CK_SENSORS);   cborArray(o, SENSOR__COUNT);
+    for (uint8_t i = 0; i < SENSOR__COUNT; i++) {
+      int32_t v;
+      if (sensorValue((SensorId)i, v)) cborInt(o, v);
+      else                             cborNull(o);
+    }
+    cborUint(o, CK_MQTT);      cborBool(o, mqttConnected());
+    cborFlush(o);
+    body.end();
+    return;
   }
 
+  DynamicJsonDocument doc(576 + MAX_CHANNELS * 64);
+  doc["channel"]    = ch;
+  doc["is_feeding"] = channelActive(ch);
+  doc["custom_rules_enabled"] = c.customEnabled;
   doc["active_custom_rule"]         = activeRule;
   doc["custom_rule_time_remaining"] = timeRemaining;
 
+  // resumo de todos os canais
+  JsonArray chans = doc.createNestedArray("channels");
+  for (int i = 0; i < cfg.channelCount; i++) {
+    JsonObject o = chans.createNestedObject();
+    o["pin"]    = cfg.channels[i].feederPin;
+    o["on"]     = channelActive(i);
+    o["custom"] = cfg.channels[i].customEnabled;
+  }
+  sensorsToJson(doc.createNestedObject("sensors"));
+  mqttStatusJson(doc.createNestedObject("mqtt"));
+
   String out;
   serializeJson(doc, out);
   server.send(200, "application/json", out);
 });
 
   // ---- Ativação manual ----
-  server.on("/feedNow", HTTP_POST, [&]() {
-    unsigned long nowMs = millis();
-    if (isOutputActive) {
-      server.send(409, "text/plain", "Saída já ativa");
-      return;
+  onRoute(server, "/feedNow", HTTP_POST, [&]() {
+    int ch = argChannel(server, cfg);
+    if (ch < 0) return;
+    switch (ctlFeedNow(ch, "manual")) {
+      case CTL_ACTIVE:
+        server.send(409, "text/plain", "Saída já ativa");
+        return;
+      case CTL_COOLDOWN:
+        server.send(429, "text/plain", "Aguarde intervalo entre ativações");
+        return;
+      case CTL_NO_PIN:
+        server.send(400, "text/plain", "Canal sem pino configurado");
+        return;
+      default:
+        server.send(200, "text/plain", "Saída ativada");
     }
-    if (lastTriggerMs && nowMs - lastTriggerMs < (unsigned long)FEED_COOLDOWN * 1000UL) {
-      server.send(429, "text/plain", "Aguarde intervalo entre ativações");
-      return;
-    }
-    eventLog += timeStr(now()) + " -> FeedNow manual acionado\n";
-    startOutput(cfg.manualDurationSec);
-    server.send(200, "text/plain", "Saída ativada");
   });
 
   // ---- Desativar manual ----
-  server.on("/stopFeedNow", HTTP_POST, [&]() {
-    if (!isOutputActive) {
+  onRoute(server, "/stopFeedNow", HTTP_POST, [&]() {
+    int ch = argChannel(server, cfg);
+    if (ch < 0) return;
+    if (ctlStop(ch, "manual") == CTL_IDLE) {
       server.send(400, "text/plain", "Nenhuma saída ativa");
       return;
     }
-    eventLog += timeStr(now()) + " -> StopFeedNow manual acionado\n";
-    stopOutput();
     server.send(200, "text/plain", "Saída desativada");
   });
 
   // ---- Ajustar duração manual ----
-  server.on("/setManualDuration", HTTP_POST, [&]() {
+  onRoute(server, "/setManualDuration", HTTP_POST, [&]() {
+    int ch = argChannel(server, cfg);
+    if (ch < 0) return;
     if (!server.hasArg("manualDuration")) {
       server.send(400, "text/plain", "Parâmetro 'manualDuration' ausente");
       return;
@@ -193,83 +528,691 @@ server.on("/status", HTTP_GET, [&]() {
                   formatHHMMSS(MAX_FEED_DURATION) + ")");
       return;
     }
-    cfg.manualDurationSec = secs;
+    cfg.channels[ch].manualDurationSec = secs;
     saveConfig(cfg);
-    eventLog += timeStr(now()) + " -> Duração manual ajustada para " +
-                formatHHMMSS(secs) + "\n";
+    logEvent(LOG_CFG_MANUAL_DURATION, ch, 0, secs);
     server.send(200, "text/plain", "Duração salva");
   });
 
-  // ---- Salvar agendamentos ----
-  server.on("/setSchedules", HTTP_POST, [&]() {
-    if (!server.hasArg("schedules")) {
-      server.send(400, "text/plain", "Parâmetro 'schedules' ausente");
+  // ---- Carga da saída (W), para o consumo em /stats ----
+  onRoute(server, "/setLoadWatts", HTTP_POST, [&]() {
+    int ch = argChannel(server, cfg);
+    if (ch < 0) return;
+    if (!server.hasArg("watts")) {
+      server.send(400, "text/plain", "Parâmetro 'watts' ausente");
       return;
     }
-    String arg = server.arg("schedules");
-    cfg.scheduleCount = 0;
-    for (int i = 0; i < MAX_SLOTS && arg.length(); i++) {
-      int comma = arg.indexOf(',');
-      String tok = comma > 0 ? arg.substring(0, comma) : arg;
-      int sep = tok.indexOf('|');
-      if (sep > 0) {
-        int t = parseHHMMSS(tok.substring(0, sep));
-        int d = parseHHMMSS(tok.substring(sep + 1));
-        if (t >= 0 && d > 0 && d <= MAX_FEED_DURATION) {
-          cfg.schedules[cfg.scheduleCount++] = { t, d, -1 };
-        }
+    long w = server.arg("watts").toInt();
+    if (w < 0 || w > STATS_MAX_WATTS) {
+      server.send(400, "text/plain", "Potência inválida (0–" + String(STATS_MAX_WATTS) + " W)");
+      return;
+    }
+    cfg.channels[ch].loadWatts = (uint16_t)w;
+    saveConfig(cfg);
+    logEvent(LOG_CFG_LOAD, ch, w);
+    server.send(200, "text/plain", "Carga salva");
+  });
+
+  // ---- Fuso horário (TZ POSIX) ----
+  onRoute(server, "/setTimezone", HTTP_POST, [&]() {
+    if (!server.hasArg("tz")) {
+      server.send(400, "text/plain", "Parâmetro 'tz' ausente");
+      return;
+    }
+    String tz = server.arg("tz");
+    if (tz.length() >= sizeof(cfg.tz) || !tzSet(tz.c_str())) {
+      server.send(400, "text/plain", "String TZ POSIX inválida");
+      return;
+    }
+    tz.toCharArray(cfg.tz, sizeof(cfg.tz));
+    saveConfig(cfg);
+    logEvent(LOG_CFG_TZ, -1, 0, 0, cfg.tz);
+    server.send(200, "text/plain", "Fuso salvo");
+  });
+
+  // ---- Sensores (amostragem e entrada analógica) ----
+  onRoute(server, "/setSensors", HTTP_POST, [&]() {
+    long period = server.hasArg("period") ? server.arg("period").toInt() : cfg.sensorPeriodSec;
+    if (period < SENSOR_MIN_PERIOD || period > SENSOR_MAX_PERIOD) {
+      server.send(400, "text/plain", "Intervalo inválido (" + String(SENSOR_MIN_PERIOD) + "–" +
+                  String(SENSOR_MAX_PERIOD) + " s)");
+      return;
+    }
+    int pin = server.hasArg("extPin") ? server.arg("extPin").toInt() : cfg.extPin;
+    if (pin != -1 && !isValidAdcPin(pin)) {
+      server.send(400, "text/plain", "Pino analógico inválido");
+      return;
+    }
+    float scale  = server.hasArg("extScale")  ? server.arg("extScale").toFloat()  : cfg.extScale;
+    float offset = server.hasArg("extOffset") ? server.arg("extOffset").toFloat() : cfg.extOffset;
+    if (!isfinite(scale) || !isfinite(offset)) {
+      server.send(400, "text/plain", "Escala/offset inválidos");
+      return;
+    }
+    bool pinChanged = pin != cfg.extPin;
+    cfg.sensorPeriodSec = (uint16_t)period;
+    cfg.extPin          = pin;
+    cfg.extScale        = scale;
+    cfg.extOffset       = offset;
+    if (pinChanged && pin >= 0) pinMode(pin, INPUT);
+    saveConfig(cfg);
+    logEvent(LOG_CFG_SENSORS, -1, period, pin);
+    server.send(200, "text/plain", "Sensores salvos");
+  });
+
+  // ---- MQTT ----
+  onRoute(server, "/setMqtt", HTTP_POST, [&]() {
+    MqttConfig m = cfg.mqtt;
+    m.enabled = server.arg("enabled") == "1";
+    struct { const char* arg; char* dst; size_t size; } texts[] = {
+      { "host",   m.host,   sizeof(m.host)   },
+      { "user",   m.user,   sizeof(m.user)   },
+      { "prefix", m.prefix, sizeof(m.prefix) },
+      { "pass",   m.pass,   sizeof(m.pass)   },   // vazio mantém a senha atual
+    };
+    for (auto& t : texts) {
+      if (!server.hasArg(t.arg)) continue;
+      String v = server.arg(t.arg);
+      v.trim();
+      if (v.length() >= t.size) {
+        server.send(400, "text/plain", String("Campo '") + t.arg + "' longo demais");
+        return;
       }
-      if (comma < 0) break;
-      arg = arg.substring(comma + 1);
+      // vão para atributos HTML e tópicos: sem aspas, tags nem curingas
+      if (v.indexOf('"') >= 0 || v.indexOf('<') >= 0 ||
+          (t.dst == m.prefix && (v.indexOf('+') >= 0 || v.indexOf('#') >= 0 || v.endsWith("/")))) {
+        server.send(400, "text/plain", String("Caractere inválido em '") + t.arg + "'");
+        return;
+      }
+      if (t.dst == m.pass && v.length() == 0) continue;
+      strncpy(t.dst, v.c_str(), t.size - 1);
+      t.dst[t.size - 1] = '\0';
+    }
+    long port  = server.hasArg("port")     ? server.arg("port").toInt()     : m.port;
+    long qos   = server.hasArg("qos")      ? server.arg("qos").toInt()      : m.qos;
+    long state = server.hasArg("stateSec") ? server.arg("stateSec").toInt() : m.stateSec;
+    if (port < 1 || port > 65535 || qos < 0 || qos > 1 || state < 0 || state > 86400L / 2) {
+      server.send(400, "text/plain", "Porta, QoS (0/1) ou intervalo inválidos");
+      return;
+    }
+    if (m.enabled && !m.host[0]) {
+      server.send(400, "text/plain", "Informe o servidor MQTT");
+      return;
+    }
+    m.port     = (uint16_t)port;
+    m.qos      = (uint8_t)qos;
+    m.stateSec = (uint16_t)state;
+    cfg.mqtt   = m;
+    saveConfig(cfg);
+    mqttReconfigure();
+    if (m.enabled) logEvent(LOG_CFG_MQTT_ON, -1, m.port, 0, m.host);
+    else           logEvent(LOG_CFG_MQTT_OFF);
+    server.send(200, "text/plain", "MQTT salvo");
+  });
+
+  // ---- Webhooks ----
+  onRoute(server, "/setWebhooks", HTTP_POST, [&]() {
+    String urls[WEBHOOK_MAX_TARGETS];
+    for (int i = 0; i < WEBHOOK_MAX_TARGETS; i++) {
+      String name = "url" + String(i);
+      urls[i] = server.hasArg(name) ? server.arg(name) : String(cfg.webhooks[i]);
+      urls[i].trim();
+      String err;
+      if (urls[i].length() && !webhookUrlValid(urls[i], err)) {
+        server.send(400, "text/plain", "Webhook " + String(i + 1) + ": " + err);
+        return;
+      }
+    }
+    for (int i = 0; i < WEBHOOK_MAX_TARGETS; i++) {
+      strncpy(cfg.webhooks[i], urls[i].c_str(), WEBHOOK_URL_LEN - 1);
+      cfg.webhooks[i][WEBHOOK_URL_LEN - 1] = '\0';
     }
     saveConfig(cfg);
-    eventLog += timeStr(now()) + " -> " +
-                String(cfg.scheduleCount) + " agendamentos salvos\n";
+    webhooksReconfigure();
+    logEvent(LOG_CFG_WEBHOOKS);
+    server.send(200, "text/plain", "Webhooks salvos");
+  });
+
+  onRoute(server, "/webhooks", HTTP_GET, [&]() {
+    server.send(200, "application/json", webhooksJson());
+  });
+
+  // ---- Sincronismo entre unidades ----
+  onRoute(server, "/setSync", HTTP_POST, [&]() {
+    String role = server.arg("role");
+    uint8_t r;
+    if      (role == "off")      r = SYNC_OFF;
+    else if (role == "leader")   r = SYNC_LEADER;
+    else if (role == "follower") r = SYNC_FOLLOWER;
+    else {
+      server.send(400, "text/plain", "Papel inválido (off, leader, follower)");
+      return;
+    }
+    cfg.syncRole = r;
+    saveConfig(cfg);
+    syncBegin(cfg);
+    logEvent(LOG_CFG_SYNC, -1, 0, 0, role.c_str());
+    server.send(200, "text/plain", "Sincronismo salvo");
+  });
+
+  // ---- Descoberta (beacon multicast) ----
+  onRoute(server, "/setBeacon", HTTP_POST, [&]() {
+    if (!server.hasArg("sec")) {
+      server.send(400, "text/plain", "Parâmetro 'sec' ausente");
+      return;
+    }
+    long sec = server.arg("sec").toInt();
+    long n   = server.hasArg("channels") ? server.arg("channels").toInt() : cfg.beaconChannels;
+    if (sec != 0 && (sec < BEACON_MIN_SEC || sec > BEACON_MAX_SEC)) {
+      server.send(400, "text/plain", "Intervalo inválido (0 ou " + String(BEACON_MIN_SEC) + "–" + String(BEACON_MAX_SEC) + " s)");
+      return;
+    }
+    if (n < 0 || n > MAX_CHANNELS) {
+      server.send(400, "text/plain", "Número de canais inválido (0–" + String(MAX_CHANNELS) + ")");
+      return;
+    }
+    cfg.beaconSec      = (uint16_t)sec;
+    cfg.beaconChannels = (uint8_t)n;
+    saveConfig(cfg);
+    logEvent(LOG_CFG_BEACON, -1, sec, n);
+    server.send(200, "text/plain", "Beacon salvo");
+  });
+
+  // ---- Modbus TCP (CLP/SCADA, ver modbus.h) ----
+  onRoute(server, "/setModbus", HTTP_POST, [&]() {
+    if (!server.hasArg("port")) {
+      server.send(400, "text/plain", "Parâmetro 'port' ausente");
+      return;
+    }
+    long port = server.arg("port").toInt();
+    if (port < 0 || port > 65535 || port == 80) {
+      server.send(400, "text/plain", "Porta inválida (0 = desligado, padrão " + String(MODBUS_PORT) + ")");
+      return;
+    }
+    cfg.modbusPort = (uint16_t)port;
+    saveConfig(cfg);
+    logEvent(LOG_CFG_MODBUS, -1, port);
+    server.send(200, "text/plain", "Modbus salvo");
+  });
+
+  onRoute(server, "/sync", HTTP_GET, [&]() {
+    DynamicJsonDocument doc(384 + SYNC_MAX_PEERS * 128);
+    syncToJson(doc.to<JsonObject>());
+    String out;
+    serializeJson(doc, out);
+    server.send(200, "application/json", out);
+  });
+
+  // ---- Localização (regras AH/AL) ----
+  onRoute(server, "/setLocation", HTTP_POST, [&]() {
+    if (!server.hasArg("lat") || !server.hasArg("lon")) {
+      server.send(400, "text/plain", "Parâmetros 'lat' e 'lon' ausentes");
+      return;
+    }
+    float lat = server.arg("lat").toFloat();
+    float lon = server.arg("lon").toFloat();
+    if (lat < -90 || lat > 90 || lon < -180 || lon > 180) {
+      server.send(400, "text/plain", "Coordenadas fora da faixa");
+      return;
+    }
+    cfg.latitude    = lat;
+    cfg.longitude   = lon;
+    cfg.hasLocation = true;
+    sunSetLocation(lat, lon);
+    saveConfig(cfg);
+
+    // resposta com os eventos de hoje (hora local)
+    String msg  = "Local salvo";
+    long   today = localEpochDay(localNow());
+    time_t rise, set;
+    bool   hasRise = sunEventUtc(today, SUN_RISE, rise);
+    bool   hasSet  = sunEventUtc(today, SUN_SET, set);
+    msg += " (nascer " + (hasRise ? timeStr(tzToLocal(rise)) : String("--")) +
+           ", pôr "    + (hasSet  ? timeStr(tzToLocal(set))  : String("--")) + ")";
+    logEvent(LOG_CFG_LOCATION, -1, lroundf(lat * 10000), lroundf(lon * 10000));
+    server.send(200, "text/plain", msg);
+  });
+
+  // ---- Salvar agendamentos ----
+  onRoute(server, "/setSchedules", HTTP_POST, [&]() {
+    int ch = argChannel(server, cfg);
+    if (ch < 0) return;
+    if (!server.hasArg("schedules")) {
+      server.send(400, "text/plain", "Parâmetro 'schedules' ausente");
+      return;
+    }
+    ctlSetSchedules(ch, server.arg("schedules"), "web");
     server.send(200, "text/plain", "Agendamentos salvos");
   });
 
   // ---- Regras customizadas ----
-  server.on("/setCustomRules", HTTP_POST, [&]() {
+  onRoute(server, "/setCustomRules", HTTP_POST, [&]() {
+    int ch = argChannel(server, cfg);
+    if (ch < 0) return;
+    ChannelConfig& c = cfg.channels[ch];
     if (!server.hasArg("rules")) {
       server.send(400, "text/plain", "Parâmetro 'rules' ausente");
       return;
     }
     String r = server.arg("rules");
-    if (r.length() >= sizeof(cfg.customSchedule)) {
+    if (r.length() >= sizeof(c.customSchedule)) {
       server.send(400, "text/plain", "Regras muito longas");
       return;
     }
-    r.toCharArray(cfg.customSchedule, sizeof(cfg.customSchedule));
+    // compila numa cópia: regras inválidas não substituem as atuais
+    ChannelConfig& tmp = s_chScratch;
+    tmp = c;
+    r.toCharArray(tmp.customSchedule, sizeof(tmp.customSchedule));
+    int    errPos;
+    String errMsg;
+    if (!compileCustomRules(tmp, errPos, errMsg)) {
+      server.send(400, "text/plain", "Erro na posição " + String(errPos) + ": " + errMsg);
+      return;
+    }
+    c = tmp;
+    chState.dcPrimed &= ~(1UL << ch);   // programas DC novos: aplica a fase atual
+    memset(chState.exprSince[ch], 0, sizeof(chState.exprSince[ch]));
     saveConfig(cfg);
-    eventLog += timeStr(now()) + " -> Regras customizadas salvas\n";
+    logEvent(LOG_CFG_RULES, ch);
     server.send(200, "text/plain", "Regras salvas");
   });
 
+  // ---- Calendário de exceções (feriados/manutenção) ----
+  onRoute(server, "/exceptions", HTTP_GET, [&]() {
+    server.send(200, "text/plain", excToString());
+  });
+
+  onRoute(server, "/setExceptions", HTTP_POST, [&]() {
+    if (!server.hasArg("exceptions")) {
+      server.send(400, "text/plain", "Parâmetro 'exceptions' ausente");
+      return;
+    }
+    int    errPos;
+    String errMsg;
+    if (!excSet(server.arg("exceptions"), errPos, errMsg)) {
+      server.send(400, "text/plain", "Erro na posição " + String(errPos) + ": " + errMsg);
+      return;
+    }
+    logEvent(LOG_CFG_EXCEPTIONS);
+    server.send(200, "text/plain", "Exceções salvas");
+  });
+
+  // ---- Tabelas de programa em flash (ver program_table.h) ----
+  // POST /importProgram?ch=N com o arquivo de texto em multipart; 202 com o
+  // texto recebido, a conversão segue em progService() (ver GET /program)
+  onRoute(server, "/importProgram", HTTP_POST, [&]() {
+    int ch = argChannel(server, cfg);
+    if (ch < 0) {
+      progImportAbort();
+      return;
+    }
+    if (!progImportEnd()) {
+      server.send(400, "text/plain", progImportError());
+      return;
+    }
+    server.send(202, "text/plain", "Importação em andamento");
+  }, [&]() {
+    HTTPUpload& up = server.upload();
+    if (up.status == UPLOAD_FILE_START) {
+      int ch = server.arg("ch").toInt();
+      if (ch >= 0 && ch < cfg.channelCount) progImportBegin(ch);
+    } else if (up.status == UPLOAD_FILE_WRITE) {
+      progImportChunk(up.buf, up.currentSize);
+    } else if (up.status == UPLOAD_FILE_ABORTED) {
+      progImportAbort();
+    }
+  });
+
+  onRoute(server, "/clearProgram", HTTP_POST, [&]() {
+    int ch = argChannel(server, cfg);
+    if (ch < 0) return;
+    progClear(ch);
+    server.send(200, "text/plain", "Programa removido");
+  });
+
+  onRoute(server, "/program", HTTP_GET, [&]() {
+    int ch = argChannel(server, cfg);
+    if (ch < 0) return;
+    DynamicJsonDocument doc(256);
+    progToJson(ch, doc.to<JsonObject>());
+    String out;
+    serializeJson(doc, out);
+    server.send(200, "application/json", out);
+  });
+
   // ---- Alternar regras ----
-  server.on("/toggleCustomRules", HTTP_POST, [&]() {
-    cfg.customEnabled = !cfg.customEnabled;
-    saveConfig(cfg);
-    eventLog += timeStr(now()) + " -> CustomRules " +
-                String(cfg.customEnabled ? "ativadas\n" : "desativadas\n");
+  onRoute(server, "/toggleCustomRules", HTTP_POST, [&]() {
+    int ch = argChannel(server, cfg);
+    if (ch < 0) return;
+    bool enabled = ctlToggleRules(ch, "manual");
     server.send(200, "text/plain",
-                cfg.customEnabled ? "Regras ativadas" : "Regras desativadas");
+                enabled ? "Regras ativadas" : "Regras desativadas");
+  });
+
+  // ---- Simulação (dry-run acelerado da config atual) ----
+  // GET /simulate?start=AAAA-MM-DD HH:MM&days=N&budget=ms[&ch=N&rules=...&custom=0|1]
+  // (rules/custom substituem os do canal ch; os demais canais simulam como estão)
+  // inicia um job fatiado (ver simulator.h) e responde 202; o trace sai em
+  // GET /simulate?result=1 (202 enquanto roda, 200 no fim).
+  onRoute(server, "/simulate", HTTP_GET, [&]() {
+    if (server.hasArg("result")) {
+      SimResult      r;
+      const String*  trace;
+      SimJobState    st = simulateStatus(r, trace);
+      if (st == SIM_IDLE) {
+        server.send(404, "text/plain", "Nenhuma simulação");
+        return;
+      }
+      unsigned long rate = r.wallMs ? (unsigned long)((uint64_t)r.simulatedSec * 1000ULL / r.wallMs)
+                                    : r.simulatedSec * 1000UL;
+      String out;
+      if (st == SIM_DONE) out = *trace;
+      out += "# simulado_s=" + String(r.simulatedSec) +
+             " real_ms=" + String(r.wallMs) +
+             " sim_s_por_s=" + String(rate) +
+             " transicoes=" + String(r.transitions);
+      if (st == SIM_RUNNING) out += " em_andamento=1\n";
+      else                   out += r.truncated ? " truncado=1\n" : " truncado=0\n";
+      server.send(st == SIM_DONE ? 200 : 202, "text/plain", out);
+      return;
+    }
+
+    int ch = argChannel(server, cfg);
+    if (ch < 0) return;
+    ChannelConfig& sc = s_chScratch;
+    sc = cfg.channels[ch];
+    if (server.hasArg("rules")) {
+      String r = server.arg("rules");
+      if (r.length() >= sizeof(sc.customSchedule)) {
+        server.send(400, "text/plain", "Regras muito longas");
+        return;
+      }
+      r.toCharArray(sc.customSchedule, sizeof(sc.customSchedule));
+      int    errPos;
+      String errMsg;
+      if (!compileCustomRules(sc, errPos, errMsg)) {
+        server.send(400, "text/plain", "Erro na posição " + String(errPos) + ": " + errMsg);
+        return;
+      }
+      sc.customEnabled = true;
+    }
+    if (server.hasArg("custom")) sc.customEnabled = server.arg("custom").toInt() != 0;
+
+    time_t startUtc = halUtcNow();
+    if (server.hasArg("start")) {
+      int y, mo, d, h, mi;
+      if (sscanf(server.arg("start").c_str(), "%d-%d-%d %d:%d", &y, &mo, &d, &h, &mi) != 5) {
+        server.send(400, "text/plain", "Use start=AAAA-MM-DD HH:MM");
+        return;
+      }
+      time_t local = (time_t)daysFromCivil(y, mo, d) * 86400L + h * 3600L + mi * 60L;
+      startUtc = local - tzOffsetAt(local);
+    }
+    long days   = server.hasArg("days")   ? server.arg("days").toInt()   : 1;
+    long budget = server.hasArg("budget") ? server.arg("budget").toInt() : 2000;
+    if (days < 1 || days > 366 || budget < 1) {
+      server.send(400, "text/plain", "days (1–366) ou budget inválidos");
+      return;
+    }
+
+    if (!simulateStart(cfg, ch, sc, startUtc, (unsigned long)days * 86400UL,
+                       (unsigned long)budget)) {
+      server.send(409, "text/plain", "Simulação em andamento (ou sem memória)");
+      return;
+    }
+    server.send(202, "text/plain", "Simulação iniciada; resultado em /simulate?result=1");
   });
 
   // ---- Logs de eventos ----
-  server.on("/events", HTTP_GET, [&]() {
-    if (eventLog.length()) {
-      server.send(200, "text/plain", eventLog);
-      eventLog = "";
-    } else {
-      server.send(200, "text/plain", "");
+  // Linhas novas desde a última consulta, formatadas aqui a partir do anel
+  // CBOR: registros crus após ?since=N (cursor do cliente, não consome)
+  onRoute(server, "/events", HTTP_GET, [&]() {
+    static uint32_t cursor = 0;
+    LogRec   r;
+    uint32_t lost = 0;
+    if (wantsCbor(server)) {
+      uint32_t since = server.hasArg("since") ? strtoul(server.arg("since").c_str(), nullptr, 10) : 0;
+      if ((int32_t)(logHead() - since) < 0) since = 0;   // cursor de antes de um reinício
+      CborBody body(server);
+      CborOut  o;
+      cborBegin(o, body);
+      cborMap(o, 3);
+      cborUint(o, CK_RECORDS);
+      cborArrayOpen(o);
+      while (logNext(since, r, lost)) {
+        cborArray(o, 7);
+        cborUint(o, r.seq);
+        cborUint(o, r.utc);
+        cborUint(o, r.id);
+        cborInt(o, r.ch);
+        cborInt(o, r.a);
+        cborInt(o, r.b);
+        cborText(o, r.s);
+      }
+      cborClose(o);
+      cborUint(o, CK_HEAD); cborUint(o, since);
+      cborUint(o, CK_LOST); cborUint(o, lost);
+      cborFlush(o);
+      body.end();
+      return;
+    }
+    char     line[LOG_LINE_MAX];
+    String   out;
+    while (logNext(cursor, r, lost)) {
+      logFormat(r, line, sizeof(line));
+      out += line;
+      out += '\n';
     }
+    if (lost) out = "(" + String(lost) + " linhas perdidas)\n" + out;
+    server.send(200, "text/plain", out);
+  });
+
+  // ---- Tempo ligado / consumo por hora, dia e mês ----
+  onRoute(server, "/stats", HTTP_GET, [&]() {
+    server.send(200, "application/json", statsJson(cfg));
+  });
+
+  // ---- Métricas (latência por rota, heap, atraso de disparos) ----
+  onRoute(server, "/metrics", HTTP_GET, [&]() {
+    String out = metricsJson();
+    if (server.hasArg("reset")) metricsReset();
+    server.send(200, "application/json", out);
+  });
+
+  // ---- Tarefas do loop (CPU, atraso e prazos perdidos por tarefa) ----
+  onRoute(server, "/tasks", HTTP_GET, [&]() {
+    String out = tasksJson();
+    if (server.hasArg("reset")) tasksReset();
+    server.send(200, "application/json", out);
   });
 
+  // ---- Admissão HTTP (429/503 por faixa, orçamento da janela) ----
+  onRoute(server, "/admission", HTTP_GET, [&]() {
+    String out = admJson();
+    if (server.hasArg("reset")) admReset();
+    server.send(200, "application/json", out);
+  });
+
+  // ---- Microbenchmarks do motor (ver bench.h) ----
+  // GET /bench?case=nome[&ms=N] bloqueia o loop até 4 × N ms (um caso por
+  // pedido; a suíte inteira roda no host, host/bench)
+  onRoute(server, "/bench", HTTP_GET, [&]() {
+    if (!server.arg("case").length()) {
+      server.send(400, "text/plain", "Informe case=nome (ex.: checkSchedules)");
+      return;
+    }
+    String out = benchRun(cfg, server.arg("case"), server.arg("ms").toInt());
+    server.send(200, "application/json", out);
+  });
+
+  // ---- Configuração em CBOR (clientes de frota) ----
+  onRoute(server, "/config", HTTP_GET, [&]() {
+    if (!wantsCbor(server)) {
+      server.send(406, "text/plain", "Use Accept: application/cbor");
+      return;
+    }
+    CborBody body(server);
+    CborOut  o;
+    cborBegin(o, body);
+    cborMap(o, 3);
+    cborUint(o, CK_CHANNEL_COUNT); cborUint(o, cfg.channelCount);
+    cborUint(o, CK_TZ);            cborText(o, cfg.tz);
+    cborUint(o, CK_CHANNELS);      cborArray(o, cfg.channelCount);
+    for (int i = 0; i < cfg.channelCount; i++) {
+      const ChannelConfig& c = cfg.channels[i];
+      cborMap(o, 6);
+      cborUint(o, CK_PIN);        cborInt(o, c.feederPin);
+      cborUint(o, CK_MANUAL_SEC); cborUint(o, c.manualDurationSec);
+      cborUint(o, CK_CUSTOM);     cborBool(o, c.customEnabled);
+      cborUint(o, CK_SCHEDULES);  cborArray(o, c.scheduleCount);
+      for (int s = 0; s < c.scheduleCount; s++) {
+        cborArray(o, 2);
+        cborUint(o, c.schedules[s].timeSec);
+        cborUint(o, c.schedules[s].durationSec);
+      }
+      cborUint(o, CK_RULES);      cborText(o, c.customSchedule);
+      cborUint(o, CK_LOAD_W);     cborUint(o, c.loadWatts);
+    }
+    cborFlush(o);
+    body.end();
+  });
+
+  // Corpo CBOR {1 canal, 3 regras ativas, 17 tz, 19 duração manual,
+  // 20 [[início, duração]...], 21 regras, 22 W}. Campos de canal exigem a
+  // chave 1 antes deles (ordem canônica); tudo é validado antes de aplicar.
+  // O corpo chega por rawCollect() (binário, até RAW_BODY_MAX bytes).
+  onRoute(server, "/config", HTTP_POST, [&]() {
+    size_t   len = s_rawLen;
+    bool     over = s_rawOver;
+    s_rawLen  = 0;
+    s_rawOver = false;
+    if (over) {
+      server.send(413, "text/plain", "Corpo CBOR muito grande");
+      return;
+    }
+    CborIn   in;
+    uint32_t pairs;
+    cborInBegin(in, s_rawBody, len);
+    if (!cborReadMap(in, pairs)) {
+      server.send(400, "text/plain", "Corpo CBOR inválido (esperado um mapa)");
+      return;
+    }
+
+    int           ch = -1;
+    ChannelConfig& tmp = s_chScratch;
+    char          tz[TZ_MAX_LEN];
+    bool          haveTz = false, chFields = false, newRules = false;
+    int8_t        custom = -1;
+    const char*   err = nullptr;
+    for (uint32_t k = 0; k < pairs && !err; k++) {
+      int64_t key, v;
+      bool    b;
+      if (!cborReadInt(in, key)) break;
+      if (key != CK_CHANNEL && key != CK_TZ && ch < 0 &&
+          (key == CK_CUSTOM || key == CK_MANUAL_SEC || key == CK_LOAD_W ||
+           key == CK_SCHEDULES || key == CK_RULES)) {
+        err = "Informe o canal (chave 1) antes dos campos do canal";
+        break;
+      }
+      switch (key) {
+        case CK_CHANNEL:
+          if (ch >= 0 || !cborReadInt(in, v) || v < 0 || v >= cfg.channelCount) {
+            err = "Canal inválido";
+            break;
+          }
+          ch  = (int)v;
+          tmp = cfg.channels[ch];
+          break;
+        case CK_TZ:
+          if (!cborReadText(in, tz, sizeof(tz)) || !tzSet(tz)) err = "String TZ POSIX inválida";
+          else haveTz = true;
+          break;
+        case CK_CUSTOM:
+          if (cborReadBool(in, b)) custom = b;
+          break;
+        case CK_MANUAL_SEC:
+          if (!cborReadInt(in, v) || v <= 0 || v > MAX_FEED_DURATION) err = "Duração inválida";
+          else tmp.manualDurationSec = (unsigned long)v;
+          chFields = true;
+          break;
+        case CK_LOAD_W:
+          if (!cborReadInt(in, v) || v < 0 || v > STATS_MAX_WATTS) err = "Potência inválida";
+          else tmp.loadWatts = (uint16_t)v;
+          chFields = true;
+          break;
+        case CK_SCHEDULES: {
+          uint32_t n;
+          if (!cborReadArray(in, n) || n > MAX_SLOTS) {
+            err = "Agendamentos inválidos";
+            break;
+          }
+          tmp.scheduleCount = 0;
+          for (uint32_t i = 0; i < n && !err; i++) {
+            uint32_t two;
+            int64_t  t, d;
+            if (!cborReadArray(in, two) || two != 2 || !cborReadInt(in, t) || !cborReadInt(in, d) ||
+                t < 0 || t >= 86400 || d <= 0 || d > MAX_FEED_DURATION) {
+              err = "Agendamento inválido";
+            } else {
+              tmp.schedules[tmp.scheduleCount++] = { (int)t, (int)d, -1 };
+            }
+          }
+          chFields = true;
+          break;
+        }
+        case CK_RULES:
+          if (!cborReadText(in, tmp.customSchedule, sizeof(tmp.customSchedule))) err = "Regras muito longas";
+          newRules = chFields = true;
+          break;
+        default:
+          cborSkip(in);
+      }
+    }
+    if (!err && in.err) err = "Corpo CBOR inválido";
+
+    // regras compiladas na cópia: inválidas não substituem as atuais
+    int    errPos;
+    String errMsg;
+    if (!err && newRules && !compileCustomRules(tmp, errPos, errMsg)) {
+      errMsg = "Erro na posição " + String(errPos) + ": " + errMsg;
+      err    = errMsg.c_str();
+    }
+    if (err) {
+      if (haveTz) tzSet(cfg.tz);
+      server.send(400, "text/plain", err);
+      return;
+    }
+
+    if (haveTz) {
+      memcpy(cfg.tz, tz, strlen(tz) + 1);   // já limitado a TZ_MAX_LEN por cborReadText
+      logEvent(LOG_CFG_TZ, -1, 0, 0, cfg.tz);
+    }
+    if (chFields) {
+      ChannelConfig& c = cfg.channels[ch];
+      c = tmp;
+      if (newRules) {
+        chState.dcPrimed &= ~(1UL << ch);   // programas DC novos: aplica a fase atual
+        memset(chState.exprSince[ch], 0, sizeof(chState.exprSince[ch]));
+        logEvent(LOG_CFG_RULES, ch);
+      }
+    }
+    // alternar regras passa pelo controlador (LED e log); ele também salva
+    if (custom >= 0 && ch >= 0 && (bool)custom != cfg.channels[ch].customEnabled) {
+      ctlToggleRules(ch, "cbor");
+    } else {
+      saveConfig(cfg);
+    }
+    server.send(200, "text/plain", "Config salva");
+  }, [&]() { rawCollect(server); }, true);
+
   // ---- Not Found ----
   server.onNotFound([&]() {
     server.send(404, "text/plain", "Rota não encontrada");
   });
 
+  // Accept decide entre JSON/texto e CBOR (ver cbor.h)
+  static const char* HEADERS[] = { "Accept" };
+  server.collectHeaders(HEADERS, 1);
   server.begin();
   Serial.println("Servidor HTTP iniciado.");
 }